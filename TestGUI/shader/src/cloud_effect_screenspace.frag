@@ -17,6 +17,8 @@ uniform float cloudNoiseDetailSize;
 uniform vec3 cloudNoiseDetailOffset;
 uniform sampler3D cloudNoiseTexture;
 uniform sampler3D cloudNoiseDetailTexture;
+uniform sampler3D cloudDensityBoundsTexture;       // Max of the weighted cloudNoiseTexture in each cell (see CloudDensityBounds)
+uniform bool doEmptySpaceSkipping;
 uniform float raymarchOffset;
 uniform int raymarchOffsetDitherIndexOffset;
 uniform sampler3D atmosphericScattering;
@@ -149,6 +151,33 @@ float sampleDensityAtPoint(vec3 point)
     return (density - 0.15 * detailSubtract + densityOffset) * densityMultiplier * densityMult;   // @HARDCODE: the 0.25 * detailSubtract amount is hardcoded. Make a slider sometime eh!
 }
 
+// How far the ray can go from this point before it could possibly pass densityRequirement.
+// 0.0 if it can't skip (the cell might have cloud in it)
+float emptySpaceSkipDistance(vec3 point, vec3 rayDirection)
+{
+    // @NOTE: the bound is for the main noise only. The detail noise only subtracts, the
+    // height falloff is 0-1, and the density offset takes whichever's bigger, so the
+    // real density is never over this.
+    if (densityMultiplier < 0.0)
+        return 0.0;
+
+    const vec3 boundsSize = vec3(textureSize(cloudDensityBoundsTexture, 0));
+    const vec3 pointInCells = point.xzy / cloudNoiseMainSize * boundsSize;
+    const vec3 cell = floor(pointInCells);
+    const float maxNoise = texelFetch(cloudDensityBoundsTexture, ivec3(mod(cell, boundsSize)), 0).r;
+    const float maxDensity = max(0.0, maxNoise + max(densityOffsetInner, densityOffsetOuter)) * densityMultiplier;
+    if (maxDensity > densityRequirement)
+        return 0.0;
+
+    // Distance to where the ray leaves the cell
+    const vec3 directionInCells = rayDirection.xzy / cloudNoiseMainSize * boundsSize;
+    vec3 exitDistances = vec3(1e20);
+    for (int i = 0; i < 3; i++)
+        if (abs(directionInCells[i]) > 1e-8)
+            exitDistances[i] = ((directionInCells[i] > 0.0 ? cell[i] + 1.0 : cell[i]) - pointInCells[i]) / directionInCells[i];
+    return min(exitDistances.x, min(exitDistances.y, exitDistances.z));
+}
+
 float offsetAmount()
 {
     float ditherPattern[16] = {
@@ -395,6 +424,23 @@ void main()
         // Keep the offset relevant depending on the RAYMARCH_STEP_SIZE
         const vec3 offsetCurrentPosition = currentPosition + deltaStepIncrement * offsetAmount;
 
+        // Jump over all of the steps that'd land in an empty cell
+        // NOTE: it's whole steps, so the samples after the skip are still on the same grid as w/o it
+        if (doEmptySpaceSkipping)
+        {
+            const float skipDistance = emptySpaceSkipDistance(offsetCurrentPosition, deltaPositionNormalized);
+            if (skipDistance > 0.0)
+            {
+                const float numSkippedSteps = max(1.0, ceil(skipDistance / RAYMARCH_STEP_SIZE));
+                currentPosition += deltaStepIncrement * numSkippedSteps;
+                distanceTraveled += RAYMARCH_STEP_SIZE * numSkippedSteps;
+
+                RAYMARCH_STEP_SIZE = t0 + distanceTraveled > raymarchCascadeLevels.y ? FAR_RAYMARCH_STEP_SIZE : t0 + distanceTraveled > raymarchCascadeLevels.x ? NEAR_RAYMARCH_STEP_SIZE : SUPER_CLOSE_RAYMARCH_STEP_SIZE;
+                deltaStepIncrement = deltaPositionNormalized * RAYMARCH_STEP_SIZE;
+                continue;
+            }
+        }
+
         float density = sampleDensityAtPoint(offsetCurrentPosition);
 
         if (density > densityRequirement)
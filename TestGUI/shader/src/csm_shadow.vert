@@ -1,12 +1,14 @@
 #version 430
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
 
 layout (location=0) in vec3 vertexPosition;
-layout (location=1) in vec3 normal;
+layout (location=1) in vec2 normalOctahedral;		// Quantized (see Mesh.h)
 layout (location=2) in vec2 uvCoordinate;
 layout (location=3) in ivec4 boneIds;
 layout (location=4) in vec4 boneWeights;
 
-out vec2 texCoordToGeom;
+out vec2 texCoord;
 
 uniform mat4 modelMatrix;
 
@@ -14,6 +16,23 @@ const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
 layout (std140, binding = 1) uniform FinalBoneMatrices { mat4 finalBoneMatrices[MAX_BONES]; };
 
+layout (std140, binding = 0) uniform LightSpaceMatrices
+{
+    mat4 lightSpaceMatrices[16];
+};
+
+// NOTE: the instance is the n-th layer that's turned on in layerMask (see ShadowLayerPass.h)
+uniform uint layerMask;
+uniform bool layersAreViewports;
+
+int getLayerFromInstance()
+{
+	uint mask = layerMask;
+	for (int i = 0; i < gl_InstanceID; i++)
+		mask &= mask - 1;		// Clear the lowest bit
+	return findLSB(mask);
+}
+
 void main()
 {
 	//
@@ -24,7 +43,7 @@ void main()
 	bool first = true;
 	for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
 	{
-		if (boneIds[i] == -1)
+		if (boneWeights[i] == 0.0)
 			continue;
 		if (boneIds[i] >= MAX_BONES)
 		{
@@ -47,6 +66,15 @@ void main()
 		}
 	}
 	
-	texCoordToGeom = uvCoordinate;
-	gl_Position = modelMatrix * boneTransform * vec4(vertexPosition, 1.0);
+	int layer = getLayerFromInstance();
+	texCoord = uvCoordinate;
+	gl_Position = lightSpaceMatrices[layer] * modelMatrix * boneTransform * vec4(vertexPosition, 1.0);
+#if defined(GL_ARB_shader_viewport_layer_array)
+	if (layersAreViewports)
+		gl_ViewportIndex = layer;		// Shadow atlas tiles
+	else
+		gl_Layer = layer;
+#elif defined(GL_AMD_vertex_shader_layer)
+	gl_Layer = layer;				// NOTE: w/o the extension, the layer's attached to the FBO (or set as the viewport) by itself instead
+#endif
 }
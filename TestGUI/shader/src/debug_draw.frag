@@ -0,0 +1,36 @@
+#version 430
+
+out vec4 fragColor;
+
+in vec4 color;
+flat in uint depthTest;
+
+uniform vec2 invFullResolution;
+uniform float zNear;
+uniform float zFar;
+
+// ext: zBuffer
+uniform sampler2D depthTexture;
+
+float linearizeDepth(float depth)
+{
+	return (zNear * zFar) / ((zNear - zFar) * depth + zFar);
+}
+
+void main()
+{
+	//
+	// Depth test against the z prepass. It's done in here (instead of w/ a depth buffer) so that the
+	// lines and triangles that ignore depth can go in the same draw.
+	// NOTE: the z prepass can be at a lower res than the screen (dynamic resolution), so it's sampled w/ uv's
+	//
+	if (depthTest != 0)
+	{
+		const float sceneDepth = linearizeDepth(texture(depthTexture, gl_FragCoord.xy * invFullResolution).r);
+		const float fragmentDepth = linearizeDepth(gl_FragCoord.z);
+		if (fragmentDepth > sceneDepth * 1.002 + 0.01)		// A little slack so that lines right on a surface (e.g. colliders) don't z-fight with it
+			discard;
+	}
+
+	fragColor = color;
+}
@@ -0,0 +1,23 @@
+#version 430
+
+layout (location=0) in vec3 vertexPosition;
+layout (location=1) in vec4 vertexColor;			// unorm8 RGBA (ImU32)
+layout (location=2) in uint vertexDepthTest;
+
+out vec4 color;
+flat out uint depthTest;
+
+// Camera
+layout (std140, binding = 3) uniform CameraInformation
+{
+    mat4 cameraProjection;
+	mat4 cameraView;
+	mat4 cameraProjectionView;
+};
+
+void main()
+{
+	color = vertexColor;
+	depthTest = vertexDepthTest;
+	gl_Position = cameraProjectionView * vec4(vertexPosition, 1.0);
+}
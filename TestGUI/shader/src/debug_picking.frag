@@ -1,10 +0,0 @@
-#version 430
-
-out float FragColor;
-
-uniform uint objectID;
-
-void main()
-{
-    FragColor = float(objectID);
-}
@@ -92,6 +92,7 @@ void main()
 	mediump vec2 v_rgbM;
 
 	float avgLuminance = texture(luminanceProcessed, vec2(0.5, 0.5)).r;
-	texcoords(gl_FragCoord.xy, v_rgbNW, v_rgbNE, v_rgbSW, v_rgbSE, v_rgbM);
-	fragColor = fxaa(hdrColorBuffer, gl_FragCoord.xy, exposure * 0.5 / (avgLuminance + 0.001), v_rgbNW, v_rgbNE, v_rgbSW, v_rgbSE, v_rgbM);
+	vec2 fragCoord = texCoord / invFullResolution;		// NOTE: in the hdr buffer's pixels, since this pass can be upscaling it (dynamic resolution)
+	texcoords(fragCoord, v_rgbNW, v_rgbNE, v_rgbSW, v_rgbSE, v_rgbM);
+	fragColor = fxaa(hdrColorBuffer, fragCoord, exposure * 0.5 / (avgLuminance + 0.001), v_rgbNW, v_rgbNE, v_rgbSW, v_rgbSE, v_rgbM);
 }
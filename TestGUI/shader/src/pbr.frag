@@ -13,6 +13,7 @@ uniform sampler2D normalMap;
 uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform float ditherAlpha;
+uniform float lodFadeAlpha = 1.0;
 uniform float fadeAlpha;
 uniform vec4 tilingAndOffset;  // NOTE: x, y are tiling and z, w are offset
 /////////////////////////////////////
@@ -38,8 +39,13 @@ uniform sampler2D brdfLUT;
 // ext: Shadow
 const int MAX_SHADOWS = 8;
 uniform sampler2D spotLightShadowMaps[MAX_SHADOWS];
-uniform samplerCube pointLightShadowMaps[MAX_SHADOWS];
-uniform float pointLightShadowFarPlanes[MAX_SHADOWS];
+uniform sampler2D shadowAtlas;                  // NOTE: all of the point light shadows are in here (see ShadowAtlas)
+const int MAX_POINT_LIGHT_SHADOWS = 32;
+layout (std140, binding = 5) uniform ShadowAtlasInformation
+{
+    vec4 pointLightShadowAtlasRects[MAX_POINT_LIGHT_SHADOWS * 6];      // xy: offset, zw: size (uv space). One for each cube face
+    vec4 pointLightShadowInfo[MAX_POINT_LIGHT_SHADOWS];                // x: farPlane, y: texel size
+};
 
 // ext: csm_shadow
 uniform sampler2DArray csmShadowMap;            // NOTE: for some reason the shadow map has to be the very last???? It gets combined with the albedo if it's the first one for some reason
@@ -47,6 +53,7 @@ layout (std140, binding = 0) uniform LightSpaceMatrices { mat4 lightSpaceMatrice
 uniform float cascadePlaneDistances[16];
 uniform float cascadeShadowMapTexelSize;
 uniform int cascadeCount;   // number of frusta - 1
+uniform int cascadeStaleMask;       // Bit for each cascade that's cached from an older frame
 uniform float nearPlane;
 uniform float farPlane;
 
@@ -204,6 +211,23 @@ float shadowSampleCSMLayer(vec3 lightDir, int layer)
     return shadow;
 }
 
+// NOTE: a cached cascade (see CascadeScheduler) keeps the matrix it got rendered with, so if it's stale it might not
+// cover its whole slice of the view frustum anymore. Those fall back to the next cascade out where they don't
+bool isInsideCSMLayer(int layer, vec3 fragPosition)
+{
+    vec4 fragPosLightSpace = lightSpaceMatrices[layer] * vec4(fragPosition, 1.0);
+    vec2 projCoords = fragPosLightSpace.xy / fragPosLightSpace.w * 0.5 + 0.5;
+    float margin = 2.0 * cascadeShadowMapTexelSize;         // Room for the PCF disk
+    return all(greaterThanEqual(projCoords, vec2(margin))) && all(lessThanEqual(projCoords, vec2(1.0 - margin)));
+}
+
+int getCoveringCSMLayer(int layer, vec3 fragPosition)
+{
+    while (layer < cascadeCount && (cascadeStaleMask & (1 << layer)) != 0 && !isInsideCSMLayer(layer, fragPosition))
+        layer++;
+    return layer;
+}
+
 float shadowCalculationCSM(vec3 lightDir, vec3 fragPosition)
 {
 	// select cascade layer
@@ -227,6 +251,7 @@ float shadowCalculationCSM(vec3 lightDir, vec3 fragPosition)
     {
         return 0.0;
     }
+    layer = getCoveringCSMLayer(layer, fragPosition);
 
     // Fading between shadow cascades
     float fadingEdgeAmount = 2.5 * (layer + 1);  //(layer == cascadeCount) ? 15.0 : 2.5;        // <---- Method that I tried to implement with close fit shadows... but never really worked.
@@ -239,7 +264,7 @@ float shadowCalculationCSM(vec3 lightDir, vec3 fragPosition)
     // Sample the shadow map(s)
     float shadow1 = 0, shadow2 = 0;
     if (layer != cascadeCount && visibleAmount < 1.0)
-        shadow2 = shadowSampleCSMLayer(lightDir, layer + 1);
+        shadow2 = shadowSampleCSMLayer(lightDir, getCoveringCSMLayer(layer + 1, fragPosition));
     shadow1 = shadowSampleCSMLayer(lightDir, layer);
 
     // Mix sampled shadows       (TODO: This works, but I don't want it bc it can lop off more than half of the last cascade. This should probs account for the bounds of the shadow cascade (perhaps use projCoords.x and .y too????))
@@ -258,8 +283,42 @@ vec3 gridSamplingDisk[20] = vec3[]          // TODO: optimize this sampling disk
 );
 
 
+float samplePointLightShadowAtlas(int shadowIndex, vec3 direction)
+{
+    // Pick the cube face the same way the cubemap would (sc/tc from the GL spec table)
+    vec3 absDirection = abs(direction);
+    int face;
+    vec2 sctc;
+    float ma;
+    if (absDirection.x >= absDirection.y && absDirection.x >= absDirection.z)
+    {
+        face = direction.x > 0.0 ? 0 : 1;
+        sctc = direction.x > 0.0 ? vec2(-direction.z, -direction.y) : vec2(direction.z, -direction.y);
+        ma = absDirection.x;
+    }
+    else if (absDirection.y >= absDirection.z)
+    {
+        face = direction.y > 0.0 ? 2 : 3;
+        sctc = direction.y > 0.0 ? vec2(direction.x, direction.z) : vec2(direction.x, -direction.z);
+        ma = absDirection.y;
+    }
+    else
+    {
+        face = direction.z > 0.0 ? 4 : 5;
+        sctc = direction.z > 0.0 ? vec2(direction.x, -direction.y) : vec2(-direction.x, -direction.y);
+        ma = absDirection.z;
+    }
+
+    vec2 faceUV = sctc / ma * 0.5 + 0.5;
+    vec4 rect = pointLightShadowAtlasRects[shadowIndex * 6 + face];
+    float halfTexel = pointLightShadowInfo[shadowIndex].y * 0.5;
+    vec2 atlasUV = clamp(rect.xy + faceUV * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);      // NOTE: keep it from bleeding into the neighboring tiles
+    return texture(shadowAtlas, atlasUV).r;
+}
+
 float shadowCalculationPoint(int lightIndex, int shadowIndex, vec3 fragPosition)
 {
+    float farPlane = pointLightShadowInfo[shadowIndex].x;
     vec3 fragToLight = fragPosition - lightPositions[lightIndex].xyz;
     float currentDepth = length(fragToLight);
 
@@ -268,18 +327,18 @@ float shadowCalculationPoint(int lightIndex, int shadowIndex, vec3 fragPosition)
     float bias = max((0.00065 * currentDepth * currentDepth + 0.2) * (1.0 - dot(normalize(normalVector), normalize(fragToLight))), 0.005);
     int samples = 20;
     float viewDistance = length(viewPosition.xyz - fragPosition);
-    float diskRadius = (1.0 + (viewDistance / pointLightShadowFarPlanes[shadowIndex])) / 25.0;
+    float diskRadius = (1.0 + (viewDistance / farPlane)) / 25.0;
     for (int i = 0; i < samples; ++i)
     {
-        float closestDepth = texture(pointLightShadowMaps[shadowIndex], fragToLight + gridSamplingDisk[i] * diskRadius).r;
-        closestDepth *= pointLightShadowFarPlanes[shadowIndex];   // undo mapping [0;1]
+        float closestDepth = samplePointLightShadowAtlas(shadowIndex, fragToLight + gridSamplingDisk[i] * diskRadius);
+        closestDepth *= farPlane;   // undo mapping [0;1]
         if (currentDepth - bias > closestDepth)
             shadow += 1.0;
     }
     shadow /= float(samples);
         
     // display closestDepth as debug (to visualize depth cubemap)
-    // FragColor = vec4(vec3(closestDepth / pointLightShadowFarPlanes[shadowIndex]), 1.0);    
+    // FragColor = vec4(vec3(closestDepth / farPlane), 1.0);    
         
     return shadow;
 }
@@ -374,6 +433,14 @@ void main()
     if (ditherTransparency(ditherAlpha * 2.0) < 0.5)
         discard;
 
+    if (lodFadeAlpha < 1.0)
+    {
+        // LOD crossfade (see z_prepass.frag)
+        float ditherThreshold = -ditherTransparency(0.0);
+        if ((lodFadeAlpha >= 0.0) ? (ditherThreshold >= lodFadeAlpha) : (ditherThreshold < -lodFadeAlpha))
+            discard;
+    }
+
     vec2 adjustedTexCoord = texCoord * tilingAndOffset.xy + tilingAndOffset.zw;
 
     float mipmapLevel   = textureQueryLod(albedoMap, adjustedTexCoord).x;
@@ -421,10 +488,8 @@ void main()
             attenuation = 1.0 / (distanceToLight * distanceToLight);
             radiance = max(lightColors[i].xyz * attenuation - lightAttenuationThreshold, 0.0);
 
-            if (lightDirections[i].a == 1)
-                shadow = shadowCalculationPoint(i, shadowIndex, fragPosition);
-
-            shadowIndex++;  // Bump up if shadow was used
+            if (lightDirections[i].a > 0)
+                shadow = shadowCalculationPoint(i, int(lightDirections[i].a) - 1, fragPosition);      // NOTE: .a is the shadow atlas index + 1 for point lights
         }
         else if (lightPositions[i].w == 0.0f)
         {
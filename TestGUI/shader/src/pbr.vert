@@ -1,7 +1,7 @@
 #version 430
 
 layout (location=0) in vec3 vertexPosition;
-layout (location=1) in vec3 normal;
+layout (location=1) in vec2 normalOctahedral;		// Quantized (see Mesh.h)
 layout (location=2) in vec2 uvCoordinate;
 layout (location=3) in ivec4 boneIds;
 layout (location=4) in vec4 boneWeights;
@@ -25,6 +25,15 @@ const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
 layout (std140, binding = 1) uniform FinalBoneMatrices { mat4 finalBoneMatrices[MAX_BONES]; };
 
+vec3 octahedralDecode(vec2 f)
+{
+	vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = max(-n.z, 0.0);
+	n.x += (n.x >= 0.0) ? -t : t;
+	n.y += (n.y >= 0.0) ? -t : t;
+	return normalize(n);
+}
+
 void main()
 {
 	//
@@ -35,7 +44,7 @@ void main()
 	bool first = true;
 	for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
 	{
-		if (boneIds[i] == -1)
+		if (boneWeights[i] == 0.0)
 			continue;
 		if (boneIds[i] >= MAX_BONES)
 		{
@@ -61,7 +70,7 @@ void main()
 	//
 	// Prep for frag shader
 	//
-	normalVector = normalize(normalsModelMatrix * normTransform * normal);
+	normalVector = normalize(normalsModelMatrix * normTransform * octahedralDecode(normalOctahedral));
 	fragPosition = vec3(modelMatrix * boneTransform * vec4(vertexPosition, 1.0));
 	texCoord = uvCoordinate;
 
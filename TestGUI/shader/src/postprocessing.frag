@@ -13,6 +13,82 @@ uniform vec3 sunLightColor;
 uniform float exposure;
 uniform float bloomIntensity;
 
+uniform bool doFXAA;				// Fused FXAA. The separate FXAA pass doesn't happen when this is on
+uniform vec2 invFullResolution;
+
+//----------------------------------------------------------------
+// @Copypasta: from fxaa_postprocessing.frag
+// @NOTE: Credits: https://github.com/mattdesl/glsl-fxaa (MIT license)
+#ifndef FXAA_REDUCE_MIN
+    #define FXAA_REDUCE_MIN   (1.0/ 128.0)
+#endif
+#ifndef FXAA_REDUCE_MUL
+    #define FXAA_REDUCE_MUL   (1.0 / 8.0)
+#endif
+#ifndef FXAA_SPAN_MAX
+    #define FXAA_SPAN_MAX     8.0
+#endif
+
+
+vec4 fxaa(sampler2D tex, vec2 fragCoord, float luminance,
+            vec2 v_rgbNW, vec2 v_rgbNE, 
+            vec2 v_rgbSW, vec2 v_rgbSE, 
+            vec2 v_rgbM)
+{
+    vec4 color;
+    vec3 rgbNW = texture2D(tex, v_rgbNW).xyz * luminance;
+    vec3 rgbNE = texture2D(tex, v_rgbNE).xyz * luminance;
+    vec3 rgbSW = texture2D(tex, v_rgbSW).xyz * luminance;
+    vec3 rgbSE = texture2D(tex, v_rgbSE).xyz * luminance;
+    vec4 texColor = texture2D(tex, v_rgbM);
+    vec3 rgbM  = texColor.xyz * luminance;
+    vec3 luma = vec3(0.299, 0.587, 0.114);
+    float lumaNW = dot(rgbNW, luma);
+    float lumaNE = dot(rgbNE, luma);
+    float lumaSW = dot(rgbSW, luma);
+    float lumaSE = dot(rgbSE, luma);
+    float lumaM  = dot(rgbM,  luma);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+    
+    mediump vec2 dir;
+    dir.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+    dir.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+    
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) *
+                          (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = min(vec2(FXAA_SPAN_MAX, FXAA_SPAN_MAX),
+              max(vec2(-FXAA_SPAN_MAX, -FXAA_SPAN_MAX),
+              dir * rcpDirMin)) * invFullResolution;
+    
+    vec3 rgbA = 0.5 * (
+        texture2D(tex, fragCoord * invFullResolution + dir * (1.0 / 3.0 - 0.5)).xyz +
+        texture2D(tex, fragCoord * invFullResolution + dir * (2.0 / 3.0 - 0.5)).xyz);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (
+        texture2D(tex, fragCoord * invFullResolution + dir * -0.5).xyz +
+        texture2D(tex, fragCoord * invFullResolution + dir * 0.5).xyz);
+
+    float lumaB = dot(rgbB, luma);
+    if ((lumaB < lumaMin) || (lumaB > lumaMax))
+        color = vec4(rgbA, texColor.a);
+    else
+        color = vec4(rgbB, texColor.a);
+    return color;
+}
+
+
+void texcoords(vec2 fragCoord, out vec2 v_rgbNW,
+			out vec2 v_rgbNE, out vec2 v_rgbSW,
+			out vec2 v_rgbSE, out vec2 v_rgbM)
+{
+	v_rgbNW = (fragCoord + vec2(-1.0, -1.0)) * invFullResolution;
+	v_rgbNE = (fragCoord + vec2(1.0, -1.0)) * invFullResolution;
+	v_rgbSW = (fragCoord + vec2(-1.0, 1.0)) * invFullResolution;
+	v_rgbSE = (fragCoord + vec2(1.0, 1.0)) * invFullResolution;
+	v_rgbM = vec2(fragCoord * invFullResolution);
+}
 //----------------------------------------------------------------
 // https://github.com/TyLindberg/glsl-vignette/blob/master/simple.glsl
 float vignette(vec2 uv, float radius, float smoothness) {
@@ -27,11 +103,26 @@ void main()
 	//
 	//////////////////////////////////////////////////////////////////////////////////////////////
 
-	vec3 hdrColor = texture(hdrColorBuffer, texCoord).rgb + sunLightColor * max(texture(volumetricLighting, texCoord).r - 0.5, 0.0);
-
-	hdrColor += texture(bloomColorBuffer, texCoord).rgb * bloomIntensity;
 	float avgLuminance = texture(luminanceProcessed, vec2(0.5, 0.5)).r;
 
+	vec3 hdrColor;
+	if (doFXAA)
+	{
+		mediump vec2 v_rgbNW;
+		mediump vec2 v_rgbNE;
+		mediump vec2 v_rgbSW;
+		mediump vec2 v_rgbSE;
+		mediump vec2 v_rgbM;
+		vec2 fragCoord = texCoord / invFullResolution;		// NOTE: in the hdr buffer's pixels @Copypasta
+		texcoords(fragCoord, v_rgbNW, v_rgbNE, v_rgbSW, v_rgbSE, v_rgbM);
+		hdrColor = fxaa(hdrColorBuffer, fragCoord, exposure * 0.5 / (avgLuminance + 0.001), v_rgbNW, v_rgbNE, v_rgbSW, v_rgbSE, v_rgbM).rgb;
+	}
+	else
+		hdrColor = texture(hdrColorBuffer, texCoord).rgb;
+
+	hdrColor += sunLightColor * max(texture(volumetricLighting, texCoord).r - 0.5, 0.0);
+	hdrColor += textureLod(bloomColorBuffer, texCoord, 0.0).rgb * bloomIntensity;		// NOTE: the compute bloom texture has mips
+
 	hdrColor *= exposure * vignette(texCoord, 0.5, 0.75) * 0.5 / (avgLuminance + 0.001);
 	hdrColor = hdrColor / (hdrColor + 0.155) * 1.019;				// UE4 Tonemapper
 
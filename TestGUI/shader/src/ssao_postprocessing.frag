@@ -30,16 +30,19 @@
 const float  NUM_STEPS = 4;
 const float  NUM_DIRECTIONS = 8; // rotationTexture/g_Jitter initialization depends on this
 
+// Samples farther than 2^LOG_MAX_OFFSET pixels out read from a smaller mip of the linear depth,
+// so the wide radii don't thrash the texture cache (from Scalable Ambient Obscurance)
+#define LOG_MAX_OFFSET 3
 
 
-uniform sampler2D depthTexture;  // ext: zBuffer
+
+uniform sampler2D linearDepthTexture;		// NOTE: at the ssao resolution, w/ mips (see ssao_linear_depth.comp)
 uniform sampler2D rotationTexture;
 
 uniform vec2 fullResolution;
 uniform vec2 invFullResolution;
 uniform float cameraFOV;
-uniform float zNear;
-uniform float zFar;
+uniform int maxMipLevel;
 uniform float powExponent;
 uniform float radius;
 uniform float bias;
@@ -56,13 +59,17 @@ vec3 UVToView(vec2 uv, float eye_z)
   return vec3((uv * projInfo.xy + projInfo.zw) * eye_z, eye_z);
 }
 
-vec3 FetchViewPos(vec2 UV)
+vec3 FetchViewPos(vec2 UV, float mipLevel)
 {
-  float ViewDepth = textureLod(depthTexture,UV,0).x;
-  ViewDepth = ((zNear * zFar) / ((zNear - zFar) * ViewDepth + zFar));			// LINEARIZE DEPTH
+  float ViewDepth = textureLod(linearDepthTexture,UV,mipLevel).x;
   return UVToView(UV, ViewDepth);
 }
 
+vec3 FetchViewPos(vec2 UV)
+{
+  return FetchViewPos(UV, 0.0);
+}
+
 vec3 MinDiff(vec3 P, vec3 Pr, vec3 Pl)
 {
   vec3 V1 = Pr - P;
@@ -139,7 +146,8 @@ float ComputeCoarseAO(vec2 FullResUV, float RadiusPixels, vec4 Rand, vec3 ViewPo
 		for (float StepIndex = 0; StepIndex < NUM_STEPS; ++StepIndex)
 		{
 			vec2 SnappedUV = round(RayPixels * Direction) * invFullResolution + FullResUV;
-			vec3 S = FetchViewPos(SnappedUV);
+			float MipLevel = clamp(findMSB(int(RayPixels)) - LOG_MAX_OFFSET, 0, maxMipLevel);
+			vec3 S = FetchViewPos(SnappedUV, MipLevel);
 
 			RayPixels += StepSizePixels;
 
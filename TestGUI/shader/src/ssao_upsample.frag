@@ -0,0 +1,57 @@
+#version 430
+
+//
+// Brings the low res ssao up to the full resolution. It's a bilinear filter of the 4
+// closest low res texels, but each one gets weighted down by how far its depth is from
+// this pixel's depth, so the ao from a wall doesn't bleed onto whatever's in front of it.
+//
+
+out vec4 fragColor;
+in vec2 texCoord;
+
+uniform sampler2D depthTexture;  // ext: zBuffer
+uniform sampler2D ssaoLowResTexture;
+uniform sampler2D linearDepthTexture;
+uniform float zNear;
+uniform float zFar;
+uniform float depthSensitivity;
+
+
+void main()
+{
+	float depth = textureLod(depthTexture, texCoord, 0).x;
+	depth = (zNear * zFar) / ((zNear - zFar) * depth + zFar);			// LINEARIZE DEPTH
+
+	const ivec2 lowResSize = textureSize(ssaoLowResTexture, 0);
+	const vec2 lowResPos = texCoord * vec2(lowResSize) - 0.5;
+	const ivec2 baseTexel = ivec2(floor(lowResPos));
+	const vec2 f = fract(lowResPos);
+
+	float totalAO = 0.0;
+	float totalWeight = 0.0;
+	float closestDepthDiff = 1e30;
+	float closestAO = 1.0;
+
+	for (int y = 0; y < 2; y++)
+	for (int x = 0; x < 2; x++)
+	{
+		const ivec2 texel = clamp(baseTexel + ivec2(x, y), ivec2(0), lowResSize - 1);
+		const float ao = texelFetch(ssaoLowResTexture, texel, 0).r;
+		const float depthDiff = abs(texelFetch(linearDepthTexture, texel, 0).x - depth);
+
+		// NOTE: the depth diff is relative so far away stuff doesn't get rejected for being a little bit off
+		const float bilinearWeight = (x == 0 ? 1.0 - f.x : f.x) * (y == 0 ? 1.0 - f.y : f.y);
+		const float weight = bilinearWeight * exp(-depthSensitivity * depthDiff / depth);
+		totalAO += ao * weight;
+		totalWeight += weight;
+
+		if (depthDiff < closestDepthDiff)
+		{
+			closestDepthDiff = depthDiff;
+			closestAO = ao;
+		}
+	}
+
+	// None of them are on this surface (a thin thing that the low res missed), so just take the closest one
+	fragColor = vec4(totalWeight > 0.0001 ? totalAO / totalWeight : closestAO, 0, 0, 1);
+}
@@ -0,0 +1,87 @@
+#version 430
+
+layout (location=0) in vec2 gridPosition;		// [0-1] across the chunk (see TerrainRenderer.cpp)
+
+out vec2 texCoord;
+out vec3 fragPosition;
+out vec3 normalVector;
+
+invariant gl_Position;		// NOTE: the z prepass and the opaque pass need the exact same depth (GL_EQUAL)
+
+uniform highp mat4 modelMatrix;
+uniform mat3 normalsModelMatrix;
+
+uniform sampler2D heightmap;
+uniform vec2 heightfieldResolution;
+uniform vec3 heightfieldBoundsMin;
+uniform vec2 heightfieldSampleSpacing;
+
+uniform vec3 chunkOriginSize;		// xy: origin (in samples), z: size (in samples)
+uniform float gridDimension;		// Number of quads along a chunk's side
+uniform vec2 morphRange;			// Start and end distance (world space) of morphing into the next LOD
+uniform vec3 cameraPosition;
+
+// Camera
+layout (std140, binding = 3) uniform CameraInformation
+{
+    highp mat4 cameraProjection;
+	highp mat4 cameraView;
+	highp mat4 cameraProjectionView;
+};
+
+float sampleHeight(vec2 samplePosition)
+{
+	return texture(heightmap, (samplePosition + 0.5) / heightfieldResolution).r;
+}
+
+vec3 toLocalPosition(vec2 samplePosition, float height)
+{
+	return vec3(
+		heightfieldBoundsMin.x + samplePosition.x * heightfieldSampleSpacing.x,
+		height,
+		heightfieldBoundsMin.z + samplePosition.y * heightfieldSampleSpacing.y
+	);
+}
+
+// Slides the odd grid vertices onto the even ones, which is what the next (coarser) LOD's grid looks like
+vec2 morphVertex(vec2 gridPos, float morphK)
+{
+	vec2 fracPart = fract(gridPos * gridDimension * 0.5) * 2.0 / gridDimension;
+	return gridPos - fracPart * morphK;
+}
+
+void main()
+{
+	//
+	// Figure out how far along the morph is w/ the unmorphed position
+	//
+	vec2 samplePosition = chunkOriginSize.xy + gridPosition * chunkOriginSize.z;
+	vec3 worldPosition = vec3(modelMatrix * vec4(toLocalPosition(samplePosition, sampleHeight(samplePosition)), 1.0));
+	float morphK = clamp((distance(worldPosition, cameraPosition) - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+
+	samplePosition = chunkOriginSize.xy + morphVertex(gridPosition, morphK) * chunkOriginSize.z;
+	samplePosition = clamp(samplePosition, vec2(0.0), heightfieldResolution - 1.0);		// NOTE: chunks can hang off of the heightfield's edge. Those just get squished into the edge
+	vec3 localPosition = toLocalPosition(samplePosition, sampleHeight(samplePosition));
+
+	//
+	// Normal from the heightmap's slope
+	//
+	float heightL = sampleHeight(samplePosition - vec2(1.0, 0.0));
+	float heightR = sampleHeight(samplePosition + vec2(1.0, 0.0));
+	float heightD = sampleHeight(samplePosition - vec2(0.0, 1.0));
+	float heightU = sampleHeight(samplePosition + vec2(0.0, 1.0));
+	vec3 localNormal = vec3(
+		-(heightR - heightL) / (2.0 * heightfieldSampleSpacing.x),
+		1.0,
+		-(heightU - heightD) / (2.0 * heightfieldSampleSpacing.y)
+	);
+
+	//
+	// Prep for frag shader
+	//
+	normalVector = normalize(normalsModelMatrix * localNormal);
+	fragPosition = vec3(modelMatrix * vec4(localPosition, 1.0));
+	texCoord = samplePosition / (heightfieldResolution - 1.0);
+
+	gl_Position = cameraProjectionView * modelMatrix * vec4(localPosition, 1.0);
+}
@@ -0,0 +1,79 @@
+#version 430
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+
+layout (location=0) in vec2 gridPosition;		// [0-1] across the chunk (see TerrainRenderer.cpp)
+
+out vec2 texCoord;
+
+uniform mat4 modelMatrix;
+
+layout (std140, binding = 0) uniform LightSpaceMatrices
+{
+    mat4 lightSpaceMatrices[16];
+};
+
+// NOTE: the instance is the n-th layer that's turned on in layerMask (see ShadowLayerPass.h)
+uniform uint layerMask;
+uniform bool layersAreViewports;
+
+int getLayerFromInstance()
+{
+	uint mask = layerMask;
+	for (int i = 0; i < gl_InstanceID; i++)
+		mask &= mask - 1;		// Clear the lowest bit
+	return findLSB(mask);
+}
+
+uniform sampler2D heightmap;
+uniform vec2 heightfieldResolution;
+uniform vec3 heightfieldBoundsMin;
+uniform vec2 heightfieldSampleSpacing;
+
+uniform vec3 chunkOriginSize;
+uniform float gridDimension;
+uniform vec2 morphRange;
+uniform vec3 cameraPosition;
+
+// @Copypasta: terrain_cdlod.vert
+float sampleHeight(vec2 samplePosition)
+{
+	return texture(heightmap, (samplePosition + 0.5) / heightfieldResolution).r;
+}
+
+vec3 toLocalPosition(vec2 samplePosition, float height)
+{
+	return vec3(
+		heightfieldBoundsMin.x + samplePosition.x * heightfieldSampleSpacing.x,
+		height,
+		heightfieldBoundsMin.z + samplePosition.y * heightfieldSampleSpacing.y
+	);
+}
+
+vec2 morphVertex(vec2 gridPos, float morphK)
+{
+	vec2 fracPart = fract(gridPos * gridDimension * 0.5) * 2.0 / gridDimension;
+	return gridPos - fracPart * morphK;
+}
+
+void main()
+{
+	vec2 samplePosition = chunkOriginSize.xy + gridPosition * chunkOriginSize.z;
+	vec3 worldPosition = vec3(modelMatrix * vec4(toLocalPosition(samplePosition, sampleHeight(samplePosition)), 1.0));
+	float morphK = clamp((distance(worldPosition, cameraPosition) - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+
+	samplePosition = chunkOriginSize.xy + morphVertex(gridPosition, morphK) * chunkOriginSize.z;
+	samplePosition = clamp(samplePosition, vec2(0.0), heightfieldResolution - 1.0);
+
+	int layer = getLayerFromInstance();
+	texCoord = samplePosition / (heightfieldResolution - 1.0);
+	gl_Position = lightSpaceMatrices[layer] * modelMatrix * vec4(toLocalPosition(samplePosition, sampleHeight(samplePosition)), 1.0);
+#if defined(GL_ARB_shader_viewport_layer_array)
+	if (layersAreViewports)
+		gl_ViewportIndex = layer;		// Shadow atlas tiles
+	else
+		gl_Layer = layer;
+#elif defined(GL_AMD_vertex_shader_layer)
+	gl_Layer = layer;				// NOTE: w/o the extension, the layer's attached to the FBO (or set as the viewport) by itself instead
+#endif
+}
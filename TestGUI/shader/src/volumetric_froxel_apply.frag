@@ -0,0 +1,89 @@
+#version 430
+
+//
+// Turns the integrated froxel grid into the same screen space volumetric texture that
+// volumetric_postprocessing.frag made (incl. its falloffs and remap), w/ two 3D fetches.
+// See volumetric_froxel_integrate.comp for what the moments are.
+//
+// NOTE: filtering between slices isn't accurate enough for the 1st and 2nd moments (a near
+// slice can be as wide as its distance from the camera), so the slice the ray ends in gets
+// fetched at its front and back, and only the part of it in front of the pixel is added in.
+//
+// NOTE: there's a CPU port of this + the integrate pass in TestGUI/tests/VolumetricFroxelTests.cpp,
+// checked against the old raymarch. Keep it in sync if the math here changes.
+//
+
+out vec4 fragColor;
+in vec2 texCoord;
+
+uniform sampler3D froxelIntegrated;
+uniform vec3 mainlightDirection;
+uniform mat4 inverseProjectionMatrix;
+uniform mat4 inverseViewMatrix;
+uniform vec3 mainCameraPosition;
+uniform float farPlane;
+
+// ext: zBuffer
+uniform sampler2D depthTexture;
+
+// @Copypasta: from volumetric_postprocessing.frag
+#define NB_RAYMARCH_STEPS 10
+const float PI = 3.14159265359;
+const float G_SCATTERING = 0.7;
+const float ACCUMULATION_CEILING = 15.0;        // NOTE: with the params above, the max seems to be 15.03
+
+float computeScattering(float lightDotView)
+{
+    float result = 1.0 - G_SCATTERING * G_SCATTERING;
+    result /= (4.0 * PI * pow(1.0 + G_SCATTERING * G_SCATTERING - (2.0 * G_SCATTERING) * lightDotView, 1.5));
+    return result;
+}
+//---------------------------------------------------------
+// Distance (divided by farPlane) at a slice boundary. More slices up close
+float sliceToT(float slice, int numSlices)
+{
+	const float w = slice / float(numSlices);
+	return w * w;
+}
+//---------------------------------------------------------
+void main()
+{
+	// Get WS position based off depth texture
+	float z = texture(depthTexture, texCoord).x * 2.0 - 1.0;
+	vec4 clipSpacePosition = vec4(texCoord * 2.0 - 1.0, z, 1.0);
+	vec4 viewSpacePosition = inverseProjectionMatrix * clipSpacePosition;
+	viewSpacePosition /= viewSpacePosition.w;   // Perspective division
+	vec3 worldSpaceFragPosition = vec3(inverseViewMatrix * viewSpacePosition);
+
+	vec3 deltaPosition = worldSpaceFragPosition - mainCameraPosition;
+	float rayLength = length(deltaPosition);
+	float lightDotView = dot(deltaPosition / rayLength, -mainlightDirection);
+	float lightDotViewSubsurfaceAccuentuated = max(0.0, 1.0 - pow(1.0 - (lightDotView * 0.5 + 0.5), 5.0));
+
+	// Everything accumulated up to the (clamped) ray length
+	const int numSlices = textureSize(froxelIntegrated, 0).z;
+	const float L = max(rayLength / farPlane, 1e-6);
+	const float Lc = min(L, 1.0);
+	const int endSlice = clamp(int(sqrt(Lc) * float(numSlices)), 0, numSlices - 1);
+	const float sliceFrontT = sliceToT(float(endSlice), numSlices);
+	const float sliceBackT = sliceToT(float(endSlice + 1), numSlices);
+
+	// NOTE: z is right on the texel centers, so only xy gets filtered
+	const vec3 momentsBack = texture(froxelIntegrated, vec3(texCoord, (float(endSlice) + 0.5) / float(numSlices))).xyz;
+	const vec3 momentsFront = (endSlice > 0) ? texture(froxelIntegrated, vec3(texCoord, (float(endSlice) - 0.5) / float(numSlices))).xyz : vec3(0.0);
+
+	const float litDensity = (momentsBack.x - momentsFront.x) / (sliceBackT - sliceFrontT);
+	const float endT = min(Lc, sliceBackT);
+	const vec3 moments = momentsFront + litDensity * vec3(
+		endT - sliceFrontT,
+		(endT * endT - sliceFrontT * sliceFrontT) / 2.0,
+		(endT * endT * endT - sliceFrontT * sliceFrontT * sliceFrontT) / 3.0
+	);
+
+	// Old raymarch: sum over the steps of lit * (1 - t/Lc) * (1 - lightDotView * t/L), w/ NB_RAYMARCH_STEPS / Lc steps per unit of t
+	float weightedLit = moments.x - moments.y * (1.0 / Lc + lightDotView / L) + moments.z * lightDotView / (Lc * L);
+	float accumulatedFog = computeScattering(lightDotViewSubsurfaceAccuentuated) * max(weightedLit, 0.0) * float(NB_RAYMARCH_STEPS) / Lc;
+
+	float remappedAccum = 1.0 - pow(1.0 - clamp(accumulatedFog / ACCUMULATION_CEILING, 0, 1), 5.0);
+	fragColor = vec4(vec3(remappedAccum), 1.0);
+}
@@ -26,6 +26,7 @@ uniform sampler2DArray csmShadowMap;
 layout (std140, binding = 0) uniform LightSpaceMatrices { mat4 lightSpaceMatrices[16]; };
 uniform float cascadePlaneDistances[16];
 uniform int cascadeCount;   // number of frusta - 1
+uniform int cascadeStaleMask;       // Bit for each cascade that's cached from an older frame
 uniform float farPlane;
 
 
@@ -81,6 +82,16 @@ float simpleShadowCalculationCSM(vec3 lightDir, vec3 fragPosition)
         return 0.0;
     }
 
+    // NOTE: stale cascades might not cover their whole slice anymore (see getCoveringCSMLayer() in pbr.frag)
+    while (layer < cascadeCount && (cascadeStaleMask & (1 << layer)) != 0)
+    {
+        vec4 fragPosLightSpace = lightSpaceMatrices[layer] * vec4(fragPosition, 1.0);
+        vec2 projCoords = fragPosLightSpace.xy / fragPosLightSpace.w * 0.5 + 0.5;
+        if (all(greaterThanEqual(projCoords, vec2(0.0))) && all(lessThanEqual(projCoords, vec2(1.0))))
+            break;
+        layer++;
+    }
+
     return simpleShadowSampleCSMLayer(lightDir, layer, fragPosition);
 }
 //---------------------------------------------------------
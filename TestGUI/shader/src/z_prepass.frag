@@ -5,6 +5,7 @@ in vec3 normalVector;
 
 uniform sampler2D ubauTexture;
 uniform float ditherAlpha;
+uniform float lodFadeAlpha = 1.0;
 
 
 float ditherTransparency(float transparency)   // https://docs.unity3d.com/Packages/com.unity.shadergraph@6.9/manual/Dither-Node.html
@@ -37,6 +38,14 @@ void main()
 	if (ditherTransparency(ditherAlpha * 2.0) < 0.5)
         discard;
 
+	if (lodFadeAlpha < 1.0)
+	{
+		// LOD crossfade: the LOD that's fading in keeps the pixels under the threshold, and the one fading out (negative) keeps the rest
+		float ditherThreshold = -ditherTransparency(0.0);
+		if ((lodFadeAlpha >= 0.0) ? (ditherThreshold >= lodFadeAlpha) : (ditherThreshold < -lodFadeAlpha))
+			discard;
+	}
+
 	float textureAlpha = texture(ubauTexture, texCoord).a;
 	if (textureAlpha < 0.5)
 		discard;
@@ -7,6 +7,8 @@
 #include "../render_engine/render_manager/RenderManager.h"
 #include "../render_engine/material/Texture.h"
 #include "../render_engine/camera/Camera.h"
+#include "../render_engine/model/Model.h"
+#include "../render_engine/model/animation/Animator.h"
 
 #include "../audio_engine/AudioEngine.h"
 
@@ -319,6 +321,7 @@ void MainLoop::run()
 		//
 		float currentFrame = (float)glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
+		unscaledDeltaTime = deltaTime;		// For perf stuff (auto LOD bias)
 #ifdef _DEVELOP
 		deltaTime *= timeScale;
 #endif
@@ -358,6 +361,9 @@ void MainLoop::run()
 		//
 		// Do all pre-render updates
 		//
+		Animator::INTERNALresetLODStats();
+		Model::INTERNALresetLODStats();
+		Model::INTERNALupdateAutoLODBias(unscaledDeltaTime);
 		for (size_t i = 0; i < objects.size(); i++)
 		{
 			objects[i]->preRenderUpdate();
@@ -377,10 +383,13 @@ void MainLoop::run()
 
 		//
 		// Delete all objects that were marked for deletion
+		// NOTE: a stale handle means it already got deleted (marked twice, or deleted some other way in the meantime)
 		//
-		for (int i = objectsToDelete.size() - 1; i >= 0; i--)
+		for (int i = (int)objectsToDelete.size() - 1; i >= 0; i--)
 		{
-			delete objectsToDelete[i];
+			BaseObject** obj = objects.get(objectsToDelete[i]);
+			if (obj != nullptr)
+				delete *obj;
 		}
 		objectsToDelete.clear();
 
@@ -409,11 +418,8 @@ void MainLoop::cleanup()
 
 void MainLoop::deleteObject(BaseObject* obj)
 {
-	// Don't add unless not in the deletion list
-	if (std::find(objectsToDelete.begin(), objectsToDelete.end(), obj) != objectsToDelete.end())
-		return;
-
-	objectsToDelete.push_back(obj);
+	// NOTE: no need to check if it's already in the list. The handle goes stale after the first delete, so the rest get skipped
+	objectsToDelete.push_back(obj->getHandle());
 }
 
 
@@ -757,14 +763,6 @@ void physicsUpdate()
 		return;
 	
 	const physx::PxRenderBuffer& rb = MainLoop::getInstance().physicsScene->getRenderBuffer();
-	const physx::PxU32 numLines = rb.getNbLines();
-	std::vector<physx::PxDebugLine>* lineList = new std::vector<physx::PxDebugLine>();
-
-	for (physx::PxU32 i = 0; i < numLines; i++)
-	{
-		const physx::PxDebugLine& line = rb.getLines()[i];
-		lineList->push_back(line);
-	}
-	MainLoop::getInstance().renderManager->physxVisSetDebugLineList(lineList);
+	MainLoop::getInstance().renderManager->physxVisSetDebugLineList(rb.getLines(), (size_t)rb.getNbLines());
 #endif
 }
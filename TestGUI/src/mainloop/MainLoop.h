@@ -4,6 +4,7 @@
 #include <PxPhysicsAPI.h>
 
 #include "../objects/BaseObject.h"
+#include "../utils/SlotMap.h"
 #include "../render_engine/camera/Camera.h"
 
 class RenderManager;
@@ -22,10 +23,11 @@ public:
 
 	GLFWwindow* window = nullptr;
 	Camera camera;
-	std::vector<BaseObject*> objects;
-	std::vector<LightComponent*> lightObjects;
-	std::vector<PhysicsComponent*> physicsObjects;
-	std::vector<RenderComponent*> renderObjects;
+	// NOTE: these get iterated like vectors (size() and [i]), but deleting reorders them, so hold onto handles (BaseObject::getHandle()) instead of indices
+	SlotMap<BaseObject*> objects;
+	SlotMap<LightComponent*> lightObjects;
+	SlotMap<PhysicsComponent*> physicsObjects;
+	SlotMap<RenderComponent*> renderObjects;
 
 	RenderManager* renderManager = nullptr;
 
@@ -37,6 +39,7 @@ public:
 	physx::PxMaterial* defaultPhysicsMaterial = nullptr;
 
 	float deltaTime = 0.0f;				// To only be used on the rendering thread
+	float unscaledDeltaTime = 0.0f;		// Same as deltaTime, but w/o timeScale (or the clamp). For perf stuff and anything that should keep going while paused
 	float physicsDeltaTime = 0.0f;			// To only be used on the physics thread
 	float physicsCalcTimeAnchor = 0.0f;
 
@@ -53,7 +56,7 @@ public:
 	//bool simulatePhysics = false;		@Simplify: this was making things too complicated
 
 private:
-	std::vector<BaseObject*> objectsToDelete;
+	std::vector<SlotMapHandle> objectsToDelete;
 
 	// Fullscreen/windowed cache
 	bool isFullscreen = false;
@@ -10,7 +10,11 @@
 #include "../utils/PhysicsUtils.h"
 #include "../render_engine/camera/Camera.h"
 #include "../render_engine/render_manager/RenderManager.h"
+#include "../render_engine/render_manager/OcclusionCuller.h"
+#include "../render_engine/render_manager/ScenePicker.h"
+#include "../render_engine/render_manager/SkinningPrepass.h"
 #include "../render_engine/model/Model.h"
+#include "../render_engine/terrain/TerrainRenderer.h"
 #include "../render_engine/model/animation/Animator.h"
 #include "../render_engine/resources/Resources.h"
 #include "../render_engine/material/Shader.h"
@@ -90,19 +94,12 @@ BaseObject::BaseObject()
 	physicsTransformState.updateTransform(getTransform());
 	physicsTransformState.updateTransform(getTransform());
 
-	MainLoop::getInstance().objects.push_back(this);
+	objectHandle = MainLoop::getInstance().objects.add(this);
 }
 
 BaseObject::~BaseObject()
 {
-	MainLoop::getInstance().objects.erase(
-		std::remove(
-			MainLoop::getInstance().objects.begin(),
-			MainLoop::getInstance().objects.end(),
-			this
-		),
-		MainLoop::getInstance().objects.end()
-	);
+	MainLoop::getInstance().objects.remove(objectHandle);
 }
 
 void BaseObject::loadPropertiesFromJson(nlohmann::json& object)
@@ -177,19 +174,12 @@ void BaseObject::INTERNALfetchInterpolatedPhysicsTransform()
 
 LightComponent::LightComponent(BaseObject* baseObject, bool castsShadows) : baseObject(baseObject), castsShadows(castsShadows)
 {
-	MainLoop::getInstance().lightObjects.push_back(this);
+	componentHandle = MainLoop::getInstance().lightObjects.add(this);
 }
 
 LightComponent::~LightComponent()
 {
-	MainLoop::getInstance().lightObjects.erase(
-		std::remove(
-			MainLoop::getInstance().lightObjects.begin(),
-			MainLoop::getInstance().lightObjects.end(),
-			this
-		),
-		MainLoop::getInstance().lightObjects.end()
-	);
+	MainLoop::getInstance().lightObjects.remove(componentHandle);
 }
 
 void LightComponent::loadPropertiesFromJson(nlohmann::json& object)
@@ -209,19 +199,12 @@ void LightComponent::renderPassShadowMap() {}
 PhysicsComponent::PhysicsComponent(BaseObject* baseObject) : baseObject(baseObject)
 {
 	// Populate the transformstate struct
-	MainLoop::getInstance().physicsObjects.push_back(this);
+	componentHandle = MainLoop::getInstance().physicsObjects.add(this);
 }
 
 PhysicsComponent::~PhysicsComponent()
 {
-	MainLoop::getInstance().physicsObjects.erase(
-		std::remove(
-			MainLoop::getInstance().physicsObjects.begin(),
-			MainLoop::getInstance().physicsObjects.end(),
-			this
-		),
-		MainLoop::getInstance().physicsObjects.end()
-	);
+	MainLoop::getInstance().physicsObjects.remove(componentHandle);
 }
 
 physx::PxRigidActor* PhysicsComponent::getActor()
@@ -236,19 +219,16 @@ void PhysicsComponent::INTERNALonTrigger(const physx::PxTriggerPair& pair)
 
 RenderComponent::RenderComponent(BaseObject* baseObject) : baseObject(baseObject)
 {
-	MainLoop::getInstance().renderObjects.push_back(this);
+	componentHandle = MainLoop::getInstance().renderObjects.add(this);
 }
 
 RenderComponent::~RenderComponent()
 {
-	MainLoop::getInstance().renderObjects.erase(
-		std::remove(
-			MainLoop::getInstance().renderObjects.begin(),
-			MainLoop::getInstance().renderObjects.end(),
-			this
-		),
-		MainLoop::getInstance().renderObjects.end()
-	);
+	MainLoop::getInstance().renderObjects.remove(componentHandle);
+
+	// Get the shadow erased from the cached cascades and atlas tiles
+	if (hasLastShadowCasterBounds)
+		MainLoop::getInstance().renderManager->INTERNALaddChangedShadowCasterBounds({ (lastShadowCasterMinPoint + lastShadowCasterMaxPoint) / 2.0f, (lastShadowCasterMaxPoint - lastShadowCasterMinPoint) / 2.0f });
 
 	for (size_t i = 0; i < textRenderers.size(); i++)
 	{
@@ -259,21 +239,25 @@ RenderComponent::~RenderComponent()
 void RenderComponent::addModelToRender(const ModelWithMetadata& modelWithMetadata)
 {
 	modelsWithMetadata.push_back(modelWithMetadata);
+	lodStates.push_back({});
 }
 
 void RenderComponent::insertModelToRender(size_t index, const ModelWithMetadata& modelWithMetadata)
 {
 	modelsWithMetadata.insert(modelsWithMetadata.begin() + index, modelWithMetadata);
+	lodStates.insert(lodStates.begin() + index, {});
 }
 
 void RenderComponent::changeModelToRender(size_t index, const ModelWithMetadata& modelWithMetadata)
 {
 	modelsWithMetadata[index] = modelWithMetadata;
+	lodStates[index] = {};
 }
 
 void RenderComponent::removeModelToRender(size_t index)
 {
 	modelsWithMetadata.erase(modelsWithMetadata.begin() + index);
+	lodStates.erase(lodStates.begin() + index);
 }
 
 ModelWithMetadata RenderComponent::getModelFromIndex(size_t index)
@@ -284,6 +268,7 @@ ModelWithMetadata RenderComponent::getModelFromIndex(size_t index)
 void RenderComponent::clearAllModels()
 {
 	modelsWithMetadata.clear();
+	lodStates.clear();
 }
 
 void RenderComponent::addTextToRender(TextRenderer* textRenderer)
@@ -298,7 +283,155 @@ void RenderComponent::removeTextRenderer(TextRenderer* textRenderer)
 	MainLoop::getInstance().renderManager->removeTextRenderer(textRenderer);
 }
 
-void RenderComponent::render(const ViewFrustum* viewFrustum, Shader* zPassShader)								// @Copypasta
+void RenderComponent::setTerrainToRender(TerrainRenderer* terrainRenderer)
+{
+	RenderComponent::terrainRenderer = terrainRenderer;
+}
+
+void RenderComponent::submitOccluders(const ViewFrustum* viewFrustum, OcclusionCuller* occlusionCuller)
+{
+	for (size_t i = 0; i < modelsWithMetadata.size(); i++)
+	{
+		const ModelWithMetadata& mwmd = modelsWithMetadata[i];
+		Model* occluderModel = mwmd.occluderModel;
+		if (occluderModel == nullptr)
+			continue;
+
+		const glm::mat4 modelMatrix = baseObject->getTransform() * *mwmd.localTransform;
+		for (auto& mesh : occluderModel->getRenderMeshes())
+		{
+			if (!mesh.hasCPUCopies() ||		// NOTE: the occluder model needs to get registered w/ CPUMeshDataNeed::RENDER_MESHES
+				!viewFrustum->checkIfInViewFrustum(mesh.bounds, modelMatrix))
+				continue;
+
+			const std::vector<glm::vec3>& positions = mesh.getCPUPositions();
+			const std::vector<uint32_t>& indices = mesh.getCPUIndices();
+			occlusionCuller->addOccluder(positions.data(), sizeof(glm::vec3), positions.size(), indices.data(), indices.size(), modelMatrix);
+		}
+	}
+
+	if (terrainRenderer != nullptr)
+		terrainRenderer->submitOccluder(baseObject->getTransform(), viewFrustum, occlusionCuller);
+}
+
+void RenderComponent::submitSkinning(SkinningPrepass* skinningPrepass)
+{
+	for (size_t i = 0; i < modelsWithMetadata.size(); i++)
+	{
+		const ModelWithMetadata& mwmd = modelsWithMetadata[i];
+		if (mwmd.modelAnimator == nullptr)
+			continue;
+
+		// NOTE: the LOD state is from last frame, so anything that changes LODs or comes
+		// into view this frame just gets skinned in the vertex shader like normal
+		const ModelLODState& lodState = lodStates[i];
+		if (!lodState.wasInView && !mwmd.renderModelInShadow)
+			continue;
+
+		std::vector<glm::mat4>* boneTransforms = mwmd.modelAnimator->getFinalBoneMatrices();
+		std::vector<size_t> levels = { lodState.currentLevel };
+		if (lodState.crossfadeTimer > 0.0f && lodState.previousLevel != lodState.currentLevel)
+			levels.push_back(lodState.previousLevel);
+
+		for (size_t level : levels)
+		{
+			size_t meshLODIndex;
+			Model* levelModel = getLODLevelModel(mwmd, level, meshLODIndex);
+			for (auto& mesh : levelModel->getRenderMeshes())
+				skinningPrepass->addMesh(&mesh, boneTransforms);		// NOTE: generated mesh LODs share the vertex buffer, so one skinning covers all of them
+		}
+	}
+}
+
+bool RenderComponent::getShadowCasterBounds(glm::vec3& out_minPoint, glm::vec3& out_maxPoint)
+{
+	out_minPoint = glm::vec3(std::numeric_limits<float>::max());
+	out_maxPoint = glm::vec3(std::numeric_limits<float>::lowest());
+	bool hasShadowCaster = false;
+	for (size_t i = 0; i < modelsWithMetadata.size(); i++)
+	{
+		const ModelWithMetadata& mwmd = modelsWithMetadata[i];
+		if (!mwmd.renderModelInShadow)
+			continue;
+
+		const RenderAABB bounds = mwmd.model->getWorldBounds(baseObject->getTransform() * *mwmd.localTransform);
+		out_minPoint = glm::min(out_minPoint, bounds.center - bounds.extents);
+		out_maxPoint = glm::max(out_maxPoint, bounds.center + bounds.extents);
+		hasShadowCaster = true;
+	}
+	return hasShadowCaster;
+}
+
+void RenderComponent::submitShadowCasterChanges(std::vector<RenderAABB>& out_changedBounds)
+{
+	// NOTE: this only catches things moving (or models getting swapped out). Animations
+	// don't count, so the far cascades and atlas tiles just pick those up on their refresh interval
+	glm::vec3 minPoint, maxPoint;
+	const bool hasShadowCaster = getShadowCasterBounds(minPoint, maxPoint);
+	if (hasShadowCaster == hasLastShadowCasterBounds &&
+		(!hasShadowCaster || (minPoint == lastShadowCasterMinPoint && maxPoint == lastShadowCasterMaxPoint)))
+		return;
+
+	if (hasLastShadowCasterBounds)
+		out_changedBounds.push_back({ (lastShadowCasterMinPoint + lastShadowCasterMaxPoint) / 2.0f, (lastShadowCasterMaxPoint - lastShadowCasterMinPoint) / 2.0f });
+	if (hasShadowCaster)
+		out_changedBounds.push_back({ (minPoint + maxPoint) / 2.0f, (maxPoint - minPoint) / 2.0f });
+
+	lastShadowCasterMinPoint = minPoint;
+	lastShadowCasterMaxPoint = maxPoint;
+	hasLastShadowCasterBounds = hasShadowCaster;
+}
+
+bool RenderComponent::getPickingBounds(glm::vec3& out_minPoint, glm::vec3& out_maxPoint)
+{
+	out_minPoint = glm::vec3(std::numeric_limits<float>::max());
+	out_maxPoint = glm::vec3(std::numeric_limits<float>::lowest());
+	bool hasBounds = false;
+	for (size_t i = 0; i < modelsWithMetadata.size(); i++)
+	{
+		const ModelWithMetadata& mwmd = modelsWithMetadata[i];
+		const RenderAABB bounds = mwmd.model->getWorldBounds(baseObject->getTransform() * *mwmd.localTransform);
+		out_minPoint = glm::min(out_minPoint, bounds.center - bounds.extents);
+		out_maxPoint = glm::max(out_maxPoint, bounds.center + bounds.extents);
+		hasBounds = true;
+	}
+
+	if (terrainRenderer != nullptr)
+	{
+		glm::vec3 localMin, localMax;
+		terrainRenderer->getLocalBounds(localMin, localMax);
+		const RenderAABB bounds = PhysicsUtils::fitAABB({ (localMin + localMax) * 0.5f, (localMax - localMin) * 0.5f }, baseObject->getTransform());
+		out_minPoint = glm::min(out_minPoint, bounds.center - bounds.extents);
+		out_maxPoint = glm::max(out_maxPoint, bounds.center + bounds.extents);
+		hasBounds = true;
+	}
+	return hasBounds;
+}
+
+void RenderComponent::submitPickingMeshes(std::vector<ScenePickerMesh>& out_meshes)
+{
+	// NOTE: always the full detail model, and skinned meshes are in their bind pose (same as the bounds)
+	// Only meshes that kept their CPU copies around get used. If none did, then the picker just uses the AABB
+	for (size_t i = 0; i < modelsWithMetadata.size(); i++)
+	{
+		const ModelWithMetadata& mwmd = modelsWithMetadata[i];
+		const glm::mat4 modelMatrix = baseObject->getTransform() * *mwmd.localTransform;
+		for (auto& mesh : mwmd.model->getRenderMeshes())
+		{
+			if (!mesh.hasCPUCopies())
+				continue;
+
+			const std::vector<glm::vec3>& positions = mesh.getCPUPositions();
+			const std::vector<uint32_t>& indices = mesh.getCPUIndices();
+			out_meshes.push_back({ positions.data(), positions.size(), indices.data(), indices.size(), modelMatrix });
+		}
+	}
+
+	if (terrainRenderer != nullptr)
+		terrainRenderer->submitPickingMesh(baseObject->getTransform(), out_meshes);
+}
+
+void RenderComponent::render(const ViewFrustum* viewFrustum, Shader* zPassShader, OcclusionCuller* occlusionCuller)								// @Copypasta
 {
 #ifdef _DEVELOP
 	refreshResources();
@@ -307,19 +440,151 @@ void RenderComponent::render(const ViewFrustum* viewFrustum, Shader* zPassShader
 	for (size_t i = 0; i < modelsWithMetadata.size(); i++)
 	{
 		const ModelWithMetadata& mwmd = modelsWithMetadata[i];
+		const glm::mat4 modelMatrix = baseObject->getTransform() * *mwmd.localTransform;
 
 		// Short circuit out of loop if none of meshes are in view frustum.
 		// Also creates a reference to the meshes of which ones are in the view frustum.
 		std::vector<bool> whichMeshesInView;
-		if (!mwmd.model->getIfInViewFrustum(baseObject->getTransform() * *mwmd.localTransform, viewFrustum, whichMeshesInView))
+		const bool inViewFrustum = mwmd.model->getIfInViewFrustum(modelMatrix, viewFrustum, whichMeshesInView);
+		const float projectedScreenSize = inViewFrustum ? mwmd.model->getProjectedScreenSize(modelMatrix, MainLoop::getInstance().camera) : 0.0f;
+
+		// Let the animator know how visible it is for the animation LOD
+		if (mwmd.modelAnimator != nullptr)
+			mwmd.modelAnimator->INTERNALreportVisibility(inViewFrustum, projectedScreenSize, mwmd.renderModelInShadow);
+
+		updateLOD(i, projectedScreenSize, inViewFrustum);
+
+		if (!inViewFrustum)
+			continue;
+
+		// Occlusion culling
+		if (!cullMeshes(mwmd.model, modelMatrix, nullptr, occlusionCuller, whichMeshesInView))
 			continue;
 		
 		std::vector<glm::mat4>* boneTransforms = nullptr;
 		if (mwmd.modelAnimator != nullptr)
 			boneTransforms = mwmd.modelAnimator->getFinalBoneMatrices();
 
-		mwmd.model->render(baseObject->getTransform() * *mwmd.localTransform, zPassShader, &whichMeshesInView, boneTransforms, RenderStage::Z_PASS);
+		//
+		// Render the LOD. If it's in the middle of crossfading, then the previous
+		// LOD gets rendered too w/ the opposite dither pattern
+		//
+		const ModelLODState& lodState = lodStates[i];
+		float fadeInAlpha = 1.0f;
+		if (lodState.crossfadeTimer > 0.0f && Model::lodSettings.crossfadeTime > 0.0f)
+			fadeInAlpha = glm::clamp(1.0f - lodState.crossfadeTimer / Model::lodSettings.crossfadeTime, 0.0f, 1.0f);
+
+		Model::lodStats.numTrianglesFullDetail += mwmd.model->getTriangleCount(0, &whichMeshesInView);
+
+		struct LODDraw { size_t level; float lodFadeAlpha; };
+		std::vector<LODDraw> lodDraws;
+		if (fadeInAlpha > 0.0f)
+			lodDraws.push_back({ lodState.currentLevel, fadeInAlpha });
+		if (fadeInAlpha < 1.0f)
+		{
+			lodDraws.push_back({ lodState.previousLevel, (fadeInAlpha > 0.0f) ? -fadeInAlpha : 1.0f });
+			Model::lodStats.numCrossfading++;
+		}
+
+		for (const LODDraw& lodDraw : lodDraws)
+		{
+			size_t meshLODIndex;
+			Model* levelModel = getLODLevelModel(mwmd, lodDraw.level, meshLODIndex);
+
+			std::vector<bool> whichLevelMeshesInView;
+			std::vector<bool>* levelMeshesInView = &whichMeshesInView;
+			if (levelModel != mwmd.model)
+			{
+				if (!cullMeshes(levelModel, modelMatrix, viewFrustum, occlusionCuller, whichLevelMeshesInView))
+					continue;
+				levelMeshesInView = &whichLevelMeshesInView;
+			}
+
+			Model::lodStats.numTrianglesRendered += levelModel->getTriangleCount(meshLODIndex, levelMeshesInView);
+			levelModel->render(modelMatrix, zPassShader, levelMeshesInView, boneTransforms, RenderStage::Z_PASS, meshLODIndex, lodDraw.lodFadeAlpha);
+		}
 	}
+
+	if (terrainRenderer != nullptr)
+		terrainRenderer->render(baseObject->getTransform(), viewFrustum, zPassShader, occlusionCuller);
+}
+
+void RenderComponent::updateLOD(size_t index, float projectedScreenSize, bool inViewFrustum)
+{
+	const ModelWithMetadata& mwmd = modelsWithMetadata[index];
+	ModelLODState& lodState = lodStates[index];
+
+	if (!Model::lodSettings.enabled)
+	{
+		lodState = {};
+		lodState.wasInView = inViewFrustum;
+		return;
+	}
+
+	lodState.crossfadeTimer = std::max(0.0f, lodState.crossfadeTimer - MainLoop::getInstance().deltaTime);
+
+	if (inViewFrustum)
+	{
+		std::vector<float> levelScreenSizes;
+		if (mwmd.lodLevels.empty())
+			mwmd.model->getGeneratedLODScreenSizes(MainLoop::getInstance().camera.height, levelScreenSizes);
+		else
+		{
+			levelScreenSizes.push_back(std::numeric_limits<float>::max());
+			for (const ModelLODLevel& lodLevel : mwmd.lodLevels)
+				levelScreenSizes.push_back(lodLevel.screenSize);
+		}
+
+		// NOTE: a switch has to wait until the running crossfade finishes. Retargeting it midway would make the level that's fading out pop
+		const bool isCrossfading = (lodState.crossfadeTimer > 0.0f);
+		const size_t newLevel = ModelLOD::selectLevel(levelScreenSizes, projectedScreenSize * Model::lodSettings.lodBias, lodState.currentLevel, Model::lodSettings.hysteresis);
+		if (newLevel != lodState.currentLevel && !isCrossfading)
+		{
+			// NOTE: if it just came into view, then just snap to the new LOD. Nobody saw the old one anyways
+			lodState.previousLevel = lodState.currentLevel;
+			lodState.crossfadeTimer = lodState.wasInView ? Model::lodSettings.crossfadeTime : 0.0f;
+			lodState.currentLevel = newLevel;
+		}
+	}
+
+	lodState.wasInView = inViewFrustum;
+}
+
+Model* RenderComponent::getLODLevelModel(const ModelWithMetadata& modelWithMetadata, size_t level, size_t& out_meshLODIndex)
+{
+	if (modelWithMetadata.lodLevels.empty())
+	{
+		out_meshLODIndex = level;
+		return modelWithMetadata.model;
+	}
+
+	out_meshLODIndex = 0;
+	if (level == 0 || modelWithMetadata.lodLevels[level - 1].model == nullptr)
+		return modelWithMetadata.model;
+	return modelWithMetadata.lodLevels[level - 1].model;
+}
+
+bool RenderComponent::cullMeshes(Model* model, const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, OcclusionCuller* occlusionCuller, std::vector<bool>& out_whichMeshesInView)
+{
+	// NOTE: if viewFrustum is nullptr, then out_whichMeshesInView is assumed to already be filled in from the frustum culling
+	if (viewFrustum != nullptr && !model->getIfInViewFrustum(modelMatrix, viewFrustum, out_whichMeshesInView))
+		return false;
+
+	if (occlusionCuller == nullptr)
+		return true;
+
+	bool anyMeshesVisible = false;
+	std::vector<Mesh>& meshes = model->getRenderMeshes();
+	for (size_t j = 0; j < meshes.size(); j++)
+	{
+		if (!out_whichMeshesInView[j])
+			continue;
+
+		RenderAABB cookedBounds = PhysicsUtils::fitAABB(meshes[j].bounds, modelMatrix);
+		out_whichMeshesInView[j] = occlusionCuller->isVisible(cookedBounds.center - cookedBounds.extents, cookedBounds.center + cookedBounds.extents);
+		anyMeshesVisible |= out_whichMeshesInView[j];
+	}
+	return anyMeshesVisible;
 }
 
 void RenderComponent::renderShadow(Shader* shader)		// @Copypasta
@@ -335,8 +600,14 @@ void RenderComponent::renderShadow(Shader* shader)		// @Copypasta
 		if (mwmd.modelAnimator != nullptr)
 			boneTransforms = mwmd.modelAnimator->getFinalBoneMatrices();
 
-		mwmd.model->render(baseObject->getTransform() * *mwmd.localTransform, shader, nullptr, boneTransforms, RenderStage::OVERRIDE);
+		// NOTE: shadows just use the LOD that's fading in (no crossfade)
+		size_t meshLODIndex;
+		Model* levelModel = getLODLevelModel(mwmd, lodStates[i].currentLevel, meshLODIndex);
+		levelModel->render(baseObject->getTransform() * *mwmd.localTransform, shader, nullptr, boneTransforms, RenderStage::OVERRIDE, meshLODIndex);
 	}
+
+	if (terrainRenderer != nullptr)
+		terrainRenderer->renderShadow(baseObject->getTransform(), shader);
 }
 
 #ifdef _DEVELOP
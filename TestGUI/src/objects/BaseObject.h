@@ -6,6 +6,7 @@
 #include <vector>
 #include <PxPhysicsAPI.h>
 #include "../utils/json.hpp"
+#include "../utils/SlotMap.h"
 
 
 typedef unsigned int GLuint;
@@ -67,8 +68,11 @@ public:
 	void INTERNALsubmitPhysicsCalculation(glm::mat4 newTransform);
 	void INTERNALfetchInterpolatedPhysicsTransform();
 
+	inline SlotMapHandle getHandle() const { return objectHandle; }		// NOTE: stays good after other objects get deleted, unlike the index into MainLoop::objects
+
 private:
 	glm::mat4 transform;
+	SlotMapHandle objectHandle;
 
 	PhysicsTransformState physicsTransformState;		// INTERNAL for physics
 };
@@ -119,6 +123,9 @@ public:
 
 	virtual void loadPropertiesFromJson(nlohmann::json& object);
 	virtual nlohmann::json savePropertiesToJson();
+
+private:
+	SlotMapHandle componentHandle;
 };
 
 
@@ -143,6 +150,9 @@ public:
 
 protected:
 	physx::PxRigidActor* body = nullptr;
+
+private:
+	SlotMapHandle componentHandle;
 }; 
 
 
@@ -152,12 +162,20 @@ protected:
 //
 class Model;
 class Animator;
+struct ModelLODLevel
+{
+	Model* model = nullptr;			// NOTE: skinned LODs need to share the same skeleton as the full detail model
+	float screenSize = 0.0f;		// Switches to this level once the model is smaller than this on screen (see Model::getProjectedScreenSize())
+};
+
 struct ModelWithMetadata
 {
 	Model* model = nullptr;
 	bool renderModelInShadow = true;
 	Animator* modelAnimator = nullptr;
 	glm::mat4* localTransform = new glm::mat4(1.0f);
+	Model* occluderModel = nullptr;		// Gets rasterized into the CPU occlusion buffer (see OcclusionCuller). NOTE: this needs to be a simplified or hand-picked low poly mesh, never the full render model (unless it's already just a box or so)
+	std::vector<ModelLODLevel> lodLevels;	// Optional authored LODs (coarser than model, in order). If empty, the model's generated mesh LODs get used
 };
 
 enum class TextAlignment
@@ -180,6 +198,11 @@ struct TextRenderer
 
 class Shader;
 struct ViewFrustum;
+class OcclusionCuller;
+class TerrainRenderer;
+class SkinningPrepass;
+struct RenderAABB;
+struct ScenePickerMesh;
 class RenderComponent final
 {
 public:
@@ -200,7 +223,14 @@ public:
 	void addTextToRender(TextRenderer* textRenderer);
 	void removeTextRenderer(TextRenderer* textRenderer);
 
-	void render(const ViewFrustum* viewFrustum, Shader* zPassShader);
+	void setTerrainToRender(TerrainRenderer* terrainRenderer);		// NOTE: the object owns the terrain, not the render component. nullptr to remove
+
+	void submitOccluders(const ViewFrustum* viewFrustum, OcclusionCuller* occlusionCuller);
+	void submitSkinning(SkinningPrepass* skinningPrepass);
+	void submitShadowCasterChanges(std::vector<RenderAABB>& out_changedBounds);		// NOTE: for the CSM cascade caching and the point light shadow atlas. Both the old and the new bounds get submitted
+	bool getPickingBounds(glm::vec3& out_minPoint, glm::vec3& out_maxPoint);		// NOTE: world space. Returns false if there's nothing to pick
+	void submitPickingMeshes(std::vector<ScenePickerMesh>& out_meshes);				// NOTE: for the editor picking (see ScenePicker)
+	void render(const ViewFrustum* viewFrustum, Shader* zPassShader, OcclusionCuller* occlusionCuller = nullptr);
 	void renderShadow(Shader* shader);
 
 #ifdef _DEVELOP
@@ -209,8 +239,28 @@ public:
 #endif
 
 private:
+	SlotMapHandle componentHandle;
+
 	std::vector<ModelWithMetadata> modelsWithMetadata;
 	std::vector<TextRenderer*> textRenderers;
+	TerrainRenderer* terrainRenderer = nullptr;
+
+	struct ModelLODState
+	{
+		size_t currentLevel = 0;
+		size_t previousLevel = 0;
+		float crossfadeTimer = 0.0f;		// Counts down while the previous level is dithering out
+		bool wasInView = false;
+	};
+	std::vector<ModelLODState> lodStates;		// NOTE: one for each of modelsWithMetadata
+
+	bool getShadowCasterBounds(glm::vec3& out_minPoint, glm::vec3& out_maxPoint);
+	glm::vec3 lastShadowCasterMinPoint, lastShadowCasterMaxPoint;
+	bool hasLastShadowCasterBounds = false;
+
+	void updateLOD(size_t index, float projectedScreenSize, bool inViewFrustum);
+	Model* getLODLevelModel(const ModelWithMetadata& modelWithMetadata, size_t level, size_t& out_meshLODIndex);
+	bool cullMeshes(Model* model, const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, OcclusionCuller* occlusionCuller, std::vector<bool>& out_whichMeshesInView);
 
 #ifdef _DEVELOP
 	void refreshResources();
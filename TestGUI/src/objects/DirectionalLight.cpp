@@ -8,6 +8,7 @@
 #include "../render_engine/material/Texture.h"
 #include "../render_engine/resources/Resources.h"
 #include "../render_engine/render_manager/RenderManager.h"
+#include "../render_engine/render_manager/DebugDraw.h"
 #include "../render_engine/material/Shader.h"
 #include "../utils/GameState.h"
 
@@ -195,6 +196,9 @@ void DirectionalLightLight::createCSMBuffers()
 	glBindBufferBase(GL_UNIFORM_BUFFER, 0, matricesUBO);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+	// Nothing's been rendered in the new shadow map yet
+	cascadeScheduler.reset();
+
 	// Set flag
 	shadowMapsCreated = true;
 }
@@ -221,22 +225,34 @@ void DirectionalLightLight::renderPassShadowMap()
 
 	csmShader->use();
 
-	// Setup UBOs
-	const std::vector<glm::mat4> lightMatrices = getLightSpaceMatrices();
+	//
+	// Only the cascades that need it get re-rendered. The cached ones keep the
+	// matrix they were rendered with, so that's what goes into the UBO
+	//
+	getLightSpaceMatrices(freshLightMatrices);
+	const uint32_t cascadesToRender = cascadeScheduler.schedule(freshLightMatrices, facingDirection, MainLoop::getInstance().renderManager->INTERNALgetChangedShadowCasterBounds());
+	const std::vector<glm::mat4>& lightMatrices = cascadeScheduler.getCascadeMatrices();
 	glNamedBufferSubData(matricesUBO, 0, sizeof(glm::mat4x4) * lightMatrices.size(), &lightMatrices[0]);
 
+	if (cascadesToRender == 0)
+		return;
+
 	// Render depth of scene
 	glBindFramebuffer(GL_FRAMEBUFFER, lightFBO);
 	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMapTexture, 0);
 	glViewport(0, 0, depthMapResolution, depthMapResolution);
-	glClear(GL_DEPTH_BUFFER_BIT);
 	//glCullFace(GL_FRONT);  // peter panning
 
+	constexpr float clearDepth = 1.0f;
+	for (GLint i = 0; i < (GLint)lightMatrices.size(); i++)
+		if (cascadesToRender & (1u << i))
+			glClearTexSubImage(shadowMapTexture, 0, 0, 0, i, depthMapResolution, depthMapResolution, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+
 	// NOTE: enabling depth clamping causes the fragments that are too far behind
 	// the clip space to actually just get clamped. This forces things to stay inside
 	// the shadowmap when creating it, especially with the CSM
 	glEnable(GL_DEPTH_CLAMP);
-	MainLoop::getInstance().renderManager->renderSceneShadowPass(csmShader);
+	MainLoop::getInstance().renderManager->renderSceneShadowLayers(csmShader, shadowMapTexture, lightMatrices, true, cascadesToRender);
 	glDisable(GL_DEPTH_CLAMP);
 
 	//glCullFace(GL_BACK);
@@ -248,11 +264,12 @@ void DirectionalLightLight::refreshResources()
 	csmShader = (Shader*)Resources::getResource("shader;csmShadowPass");
 }
 
-std::vector<glm::vec4> DirectionalLightLight::getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view)
+std::array<glm::vec4, 8> DirectionalLightLight::getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view)
 {
 	const auto inverseMatrix = glm::inverse(proj * view);
 
-	std::vector<glm::vec4> frustumCorners;
+	std::array<glm::vec4, 8> frustumCorners;
+	size_t cornerIndex = 0;
 	for (int x = 0; x < 2; x++)
 	{
 		for (int y = 0; y < 2; y++)
@@ -266,7 +283,7 @@ std::vector<glm::vec4> DirectionalLightLight::getFrustumCornersWorldSpace(const
 						2.0f * (float)z - 1.0f,
 						1.0f
 					);
-				frustumCorners.push_back(corner / corner.w);
+				frustumCorners[cornerIndex++] = corner / corner.w;
 			}
 		}
 	}
@@ -286,7 +303,7 @@ struct DEBUG_frustumLightSpaceCalculations
 std::vector<DEBUG_frustumLightSpaceCalculations> heyho;
 #endif
 
-glm::mat4 DirectionalLightLight::getLightSpaceMatrix(const float nearPlane, const float farPlane)
+glm::mat4 DirectionalLightLight::getLightSpaceMatrix(const float nearPlane, const float farPlane, const glm::mat4& cameraView)
 {
 	if (MainLoop::getInstance().camera.width == 0.0f || MainLoop::getInstance().camera.height == 0.0f)
 		return glm::mat4(1.0f);
@@ -300,7 +317,7 @@ glm::mat4 DirectionalLightLight::getLightSpaceMatrix(const float nearPlane, cons
 		nearPlane,
 		farPlane
 	);
-	const auto corners = getFrustumCornersWorldSpace(proj, MainLoop::getInstance().camera.calculateViewMatrix());
+	const auto corners = getFrustumCornersWorldSpace(proj, cameraView);
 
 	glm::vec3 center(0.0f);
 	for (const auto& v : corners)
@@ -528,30 +545,30 @@ glm::mat4 DirectionalLightLight::getLightSpaceMatrix(const float nearPlane, cons
 	return lightProjection * lightView;
 }
 
-std::vector<glm::mat4> DirectionalLightLight::getLightSpaceMatrices()
+void DirectionalLightLight::getLightSpaceMatrices(std::vector<glm::mat4>& out_lightMatrices)
 {
 #ifdef _DEVELOP
 	if (InputManager::getInstance().pausePressed)
 		heyho.push_back(DEBUG_frustumLightSpaceCalculations());
 #endif
 
-	std::vector<glm::mat4> ret;
+	const glm::mat4 cameraView = MainLoop::getInstance().camera.calculateViewMatrix();
+	out_lightMatrices.resize(shadowCascadeLevels.size() + 1);
 	for (size_t i = 0; i < shadowCascadeLevels.size() + 1; ++i)
 	{
 		if (i == 0)
 		{
-			ret.push_back(getLightSpaceMatrix(MainLoop::getInstance().camera.zNear, shadowCascadeLevels[i] + planeOffset));
+			out_lightMatrices[i] = getLightSpaceMatrix(MainLoop::getInstance().camera.zNear, shadowCascadeLevels[i] + planeOffset, cameraView);
 		}
 		else if (i < shadowCascadeLevels.size())
 		{
-			ret.push_back(getLightSpaceMatrix(shadowCascadeLevels[i - 1] - planeOffset, shadowCascadeLevels[i] + planeOffset));
+			out_lightMatrices[i] = getLightSpaceMatrix(shadowCascadeLevels[i - 1] - planeOffset, shadowCascadeLevels[i] + planeOffset, cameraView);
 		}
 		else
 		{
-			ret.push_back(getLightSpaceMatrix(shadowCascadeLevels[i - 1] - planeOffset, shadowFarPlane));
+			out_lightMatrices[i] = getLightSpaceMatrix(shadowCascadeLevels[i - 1] - planeOffset, shadowFarPlane, cameraView);
 		}
 	}
-	return ret;
 }
 
 float shadowDisappearMultiplier = 2.14524f;		// @Tuned value
@@ -730,36 +747,7 @@ void DirectionalLight::imguiRender()
 		if (i > 24)		// Only render the first frustum
 			break;
 
-		//
-		// Convert to screen space
-		//
-		physx::PxU32 lineColor = 0xFFAA3300;
-
-		bool willBeOnScreen = true;
-		glm::vec3 pointsOnScreen[] = {
-			MainLoop::getInstance().camera.PositionToClipSpace(heyho[currentIndex].frustumCornersLightSpace[i]),
-			MainLoop::getInstance().camera.PositionToClipSpace(heyho[currentIndex].frustumCornersLightSpace[i - 1])
-		};
-		for (size_t ii = 0; ii < 2; ii++)
-		{
-			if (pointsOnScreen[ii].z < 0.0f)
-			{
-				// Short circuit bc it won't be on screen anymore
-				willBeOnScreen = false;
-				break;
-			}
-
-			pointsOnScreen[ii] /= pointsOnScreen[ii].z;
-			pointsOnScreen[ii].x = ImGui::GetWindowPos().x + pointsOnScreen[ii].x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointsOnScreen[ii].y = ImGui::GetWindowPos().y - pointsOnScreen[ii].y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-		}
-
-		if (!willBeOnScreen)
-			continue;
-
-		ImVec2 point1(pointsOnScreen[0].x, pointsOnScreen[0].y);
-		ImVec2 point2(pointsOnScreen[1].x, pointsOnScreen[1].y);
-		ImGui::GetBackgroundDrawList()->AddLine(point1, point2, lineColor, 1.0f);
+		DebugDraw::getInstance().addLine(heyho[currentIndex].frustumCornersLightSpace[i], heyho[currentIndex].frustumCornersLightSpace[i - 1], 0xFFAA3300, 0.0f, false);
 	}
 
 	for (size_t i = 1; i < heyho[currentIndex].frustumCornersViewSpace.size(); i += 2)
@@ -767,36 +755,7 @@ void DirectionalLight::imguiRender()
 		if (i > 24)		// Only render the first frustum
 			break;
 
-		//
-		// Convert to screen space
-		//
-		physx::PxU32 lineColor = 0xFFAACC00;
-
-		bool willBeOnScreen = true;
-		glm::vec3 pointsOnScreen[] = {
-			MainLoop::getInstance().camera.PositionToClipSpace(heyho[currentIndex].frustumCornersViewSpace[i]),
-			MainLoop::getInstance().camera.PositionToClipSpace(heyho[currentIndex].frustumCornersViewSpace[i - 1])
-		};
-		for (size_t ii = 0; ii < 2; ii++)
-		{
-			if (pointsOnScreen[ii].z < 0.0f)
-			{
-				// Short circuit bc it won't be on screen anymore
-				willBeOnScreen = false;
-				break;
-			}
-
-			pointsOnScreen[ii] /= pointsOnScreen[ii].z;
-			pointsOnScreen[ii].x = ImGui::GetWindowPos().x + pointsOnScreen[ii].x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointsOnScreen[ii].y = ImGui::GetWindowPos().y - pointsOnScreen[ii].y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-		}
-
-		if (!willBeOnScreen)
-			continue;
-
-		ImVec2 point1(pointsOnScreen[0].x, pointsOnScreen[0].y);
-		ImVec2 point2(pointsOnScreen[1].x, pointsOnScreen[1].y);
-		ImGui::GetBackgroundDrawList()->AddLine(point1, point2, lineColor, 1.0f);
+		DebugDraw::getInstance().addLine(heyho[currentIndex].frustumCornersViewSpace[i], heyho[currentIndex].frustumCornersViewSpace[i - 1], 0xFFAACC00, 0.0f, false);
 	}
 
 	for (size_t i = 1; i < heyho[currentIndex].frustumCornersJojoSpace.size(); i += 2)
@@ -804,36 +763,7 @@ void DirectionalLight::imguiRender()
 		if (i > 24)		// Only render the first frustum
 			break;
 
-		//
-		// Convert to screen space
-		//
-		physx::PxU32 lineColor = 0xFF22FF00;
-
-		bool willBeOnScreen = true;
-		glm::vec3 pointsOnScreen[] = {
-			MainLoop::getInstance().camera.PositionToClipSpace(heyho[currentIndex].frustumCornersJojoSpace[i]),
-			MainLoop::getInstance().camera.PositionToClipSpace(heyho[currentIndex].frustumCornersJojoSpace[i - 1])
-		};
-		for (size_t ii = 0; ii < 2; ii++)
-		{
-			if (pointsOnScreen[ii].z < 0.0f)
-			{
-				// Short circuit bc it won't be on screen anymore
-				willBeOnScreen = false;
-				break;
-			}
-
-			pointsOnScreen[ii] /= pointsOnScreen[ii].z;
-			pointsOnScreen[ii].x = ImGui::GetWindowPos().x + pointsOnScreen[ii].x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointsOnScreen[ii].y = ImGui::GetWindowPos().y - pointsOnScreen[ii].y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-		}
-
-		if (!willBeOnScreen)
-			continue;
-
-		ImVec2 point1(pointsOnScreen[0].x, pointsOnScreen[0].y);
-		ImVec2 point2(pointsOnScreen[1].x, pointsOnScreen[1].y);
-		ImGui::GetBackgroundDrawList()->AddLine(point1, point2, lineColor, 1.0f);
+		DebugDraw::getInstance().addLine(heyho[currentIndex].frustumCornersJojoSpace[i], heyho[currentIndex].frustumCornersJojoSpace[i - 1], 0xFF22FF00, 0.0f, false);
 	}
 
 	for (size_t i = 0; i < heyho[currentIndex].lightSpaceCenters.size(); i++)
@@ -2,8 +2,10 @@
 
 #include "BaseObject.h"
 #include "../render_engine/camera/Camera.h"
+#include "../render_engine/render_manager/CascadeScheduler.h"
 
 #include <vector>
+#include <array>
 class Shader;
 
 class DirectionalLightLight : public LightComponent
@@ -16,6 +18,7 @@ public:
 
 	std::vector<float_t> shadowCascadeLevels;
 	float_t shadowCascadeTexelSize;
+	inline uint32_t getStaleCascadeMask() const { return cascadeScheduler.getStaleCascadeMask(); }
 
 	// Light intensity based off angle
 	// @DEBUG: putting into public, but really should be in private bc imgui yo
@@ -33,9 +36,12 @@ private:
 	// If casting shadows
 	//
 	void renderPassShadowMap();				// NOTE: here, we'll be using cascaded shadow maps
-	std::vector<glm::vec4> getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view);
-	glm::mat4 getLightSpaceMatrix(const float nearPlane, const float farPlane);
-	std::vector<glm::mat4> getLightSpaceMatrices();
+	std::array<glm::vec4, 8> getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view);
+	glm::mat4 getLightSpaceMatrix(const float nearPlane, const float farPlane, const glm::mat4& cameraView);
+	void getLightSpaceMatrices(std::vector<glm::mat4>& out_lightMatrices);
+
+	CascadeScheduler cascadeScheduler;
+	std::vector<glm::mat4> freshLightMatrices;		// NOTE: reused every frame. What actually got rendered is in the cascadeScheduler
 
 	GLuint lightFBO, matricesUBO;
 	Shader* csmShader;
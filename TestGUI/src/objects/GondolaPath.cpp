@@ -76,6 +76,7 @@ GondolaPath::GondolaPath()
 	trackModels.clear();
 	for (auto& path : trackModelPaths)
 	{
+		Model::registerCPUMeshDataNeed(path, CPUMeshDataNeed::PHYSICS_MESHES);
 		trackModels.push_back((Model*)Resources::getResource(path));
 	}
 
@@ -123,6 +124,7 @@ GondolaPath::GondolaPath()
 
 	recalculateCachedGondolaBezierCurvePoints();
 
+	Model::registerCPUMeshDataNeed("model;gondola", CPUMeshDataNeed::PHYSICS_MESHES);
 	gondolaModel = (Model*)Resources::getResource("model;gondola");
 	gondolasUnderControl.clear();
 	recalculateGondolaTransformFromLinearPosition();
@@ -248,7 +250,7 @@ void GondolaPath::physicsUpdate()
 		if (gondola._stoppingPointWaitTimer > 0.0f)
 		{
 			if (gondola._stoppingPointWaitTimer < 1.0f)
-				gondola.animatorStateMachine->setVariable("isDoorOpen", false);
+				gondola.animatorStateMachine->setVariable(gondola.asmIsDoorOpen, false);
 
 			gondola._stoppingPointWaitTimer -= MainLoop::getInstance().physicsDeltaTime;
 			continue;
@@ -328,7 +330,7 @@ void GondolaPath::physicsUpdate()
 				gondola._nextStoppingPointLinearPosition = -1.0f;	// Flag this as needing recalculation
 				gondola._stoppingPointWaitTimer = WAIT_AT_STATION_TIME;		// Start wait cycle
 				gondola._movementSpeedDamper = 0.0f;
-				gondola.animatorStateMachine->setVariable("isDoorOpen", true);
+				gondola.animatorStateMachine->setVariable(gondola.asmIsDoorOpen, true);
 				continue;		// Short circuit
 			}
 
@@ -718,15 +720,16 @@ void GondolaPath::createGondolaUnderControl(float linearPosition, float movement
 	IndividualGondolaMetadata gmm;
 	gmm.animator = new Animator(&gondolaModel->getAnimations(), { "Bogie.Front", "Bogie.Back" });
 	gmm.animatorStateMachine = new AnimatorStateMachine("gondola", gmm.animator);
+	gmm.asmIsDoorOpen = gmm.animatorStateMachine->getVariableHandle<bool>("IsDoorOpen");
 	gmm.dummyObject = new DummyBaseObject();
 	gmm.headlessRenderComponent = new RenderComponent(gmm.dummyObject);
 	gmm.headlessRenderComponent->addModelToRender({ gondolaModel, true, gmm.animator });		// @FIXME: add in the correct gondola door animation behavior!!!
 	gmm.headlessPhysicsComponent = new TriangleMeshCollider(gmm.dummyObject, { { gondolaModel } }, RigidActorTypes::KINEMATIC);
 	gmm.currentLinearPosition = linearPosition;
 	gmm.movementSpeed = movementSpeed;
-	gondolasUnderControl.push_back(gmm);
 
-	gondolasUnderControl[gondolasUnderControl.size() - 1].animatorStateMachine->setVariable("isDoorOpen", true);
+	gmm.animatorStateMachine->setVariable(gmm.asmIsDoorOpen, true);
+	gondolasUnderControl.push_back(gmm);
 }
 
 void GondolaPath::recalculateGondolaTransformFromLinearPosition()
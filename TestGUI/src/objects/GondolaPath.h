@@ -86,6 +86,7 @@ private:
 	{
 		Animator* animator;
 		AnimatorStateMachine* animatorStateMachine;
+		ASMVariableHandle<bool> asmIsDoorOpen;
 		BaseObject* dummyObject;
 		RenderComponent* headlessRenderComponent;
 		PhysicsComponent* headlessPhysicsComponent;
@@ -508,6 +508,16 @@ void PlayerCharacter::refreshResources()
 		);
 
 		animatorStateMachine = AnimatorStateMachine("slime_girl", &animator);
+		asmHandles.blendWalkRun = animatorStateMachine.getVariableHandle<float>("blendWalkRun");
+		asmHandles.isMoving = animatorStateMachine.getVariableHandle<bool>("isMoving");
+		asmHandles.isGrounded = animatorStateMachine.getVariableHandle<bool>("isGrounded");
+		asmHandles.isLedgeGrab = animatorStateMachine.getVariableHandle<bool>("isLedgeGrab");
+		asmHandles.triggerJumping = animatorStateMachine.getVariableHandle<bool>("triggerJumping");
+		asmHandles.triggerMidairJumping = animatorStateMachine.getVariableHandle<bool>("triggerMidairJumping");
+		asmHandles.triggerTurnAround = animatorStateMachine.getVariableHandle<bool>("triggerTurnAround");
+		asmHandles.triggerFall = animatorStateMachine.getVariableHandle<bool>("triggerFall");
+		asmHandles.triggerDrawWeapon = animatorStateMachine.getVariableHandle<bool>("triggerDrawWeapon");
+		asmHandles.triggerSheathWeapon = animatorStateMachine.getVariableHandle<bool>("triggerSheathWeapon");
 
 		//((PBRMaterial*)materials["Sweater"])->setTilingAndOffset(glm::vec4(0.4, 0.4, 0, 0));
 		//((PBRMaterial*)materials["Vest"])->setTilingAndOffset(glm::vec4(0.6, 0.6, 0, 0));
@@ -767,7 +777,7 @@ void PlayerCharacter::processMovement()
 			// Trigger falling if velo.y <= 0.0f
 			if (prevIsGrounded && ((PlayerPhysics*)getPhysicsComponent())->velocity.y <= 0.0f)
 			{
-				animatorStateMachine.setVariable("triggerFall", true);
+				animatorStateMachine.setVariable(asmHandles.triggerFall, true);
 			}
 		}
 		prevIsGrounded = isGroundedChecked;
@@ -794,9 +804,9 @@ void PlayerCharacter::processMovement()
 			((PlayerPhysics*)getPhysicsComponent())->setIsSliding(false);
 
 			if (canJumpGrounded)
-				animatorStateMachine.setVariable("triggerJumping", true);
+				animatorStateMachine.setVariable(asmHandles.triggerJumping, true);
 			else if (human_canJumpAirbourne)
-				animatorStateMachine.setVariable("triggerMidairJumping", true);
+				animatorStateMachine.setVariable(asmHandles.triggerMidairJumping, true);
 
 			//
 			// @SPECIAL_SKILL: @HUMAN: Human midair Jump
@@ -819,9 +829,9 @@ void PlayerCharacter::processMovement()
 		{
 			weaponDrawn = !weaponDrawn;
 			if (weaponDrawn)
-				animatorStateMachine.setVariable("triggerDrawWeapon", true);
+				animatorStateMachine.setVariable(asmHandles.triggerDrawWeapon, true);
 			else
-				animatorStateMachine.setVariable("triggerSheathWeapon", true);
+				animatorStateMachine.setVariable(asmHandles.triggerSheathWeapon, true);
 		}
 
 		if (isMoving)
@@ -920,7 +930,7 @@ void PlayerCharacter::processMovement()
 			velocity.y = ps_ledgeGrabHumanData.jumpSpeed;
 			GameState::getInstance().inputStaminaEvent(StaminaEvent::JUMP);
 			playerState = PlayerState::NORMAL;
-			animatorStateMachine.setVariable("triggerJumping", true);
+			animatorStateMachine.setVariable(asmHandles.triggerJumping, true);
 		}
 
 		// @TODO: Hold the stick away from facingDirection to do a let go instead of a jump up.
@@ -1024,7 +1034,7 @@ physx::PxVec3 PlayerCharacter::processGroundedMovement(const glm::vec2& movement
 			{
 				facingDirection = movementVector;
 				currentRunSpeed = -currentRunSpeed; // NOTE: this makes more sense especially when you land on the ground and inherit a butt ton of velocity
-				animatorStateMachine.setVariable("triggerTurnAround", true);
+				animatorStateMachine.setVariable(asmHandles.triggerTurnAround, true);
 			}
 			// Immediate facing direction when moving slowly:
 			else if (!weaponDrawn && flatVelocityMagnitude <= immediateTurningRequiredSpeed)		// @NOTE: after some thinking, I really don't think that this should be allowed while the weapon is drawn, bc then turning would be very difficult.  -Timo
@@ -1617,10 +1627,10 @@ void PlayerCharacter::processAnimation()
 	physx::PxVec3 velo = ((PlayerPhysics*)getPhysicsComponent())->velocity;
 	velo.y = 0.0f;
 	float flatSpeed = velo.magnitude();
-	animatorStateMachine.setVariable("blendWalkRun", glm::clamp(REMAP(flatSpeed, 0.4f, groundRunSpeed, 0.0f, 1.0f), 0.0f, 1.0f));
-	animatorStateMachine.setVariable("isMoving", isMoving);
-	animatorStateMachine.setVariable("isGrounded", ((PlayerPhysics*)getPhysicsComponent())->getIsGrounded());
-	animatorStateMachine.setVariable("isLedgeGrab", playerState == PlayerState::LEDGE_GRAB_HUMAN);
+	animatorStateMachine.setVariable(asmHandles.blendWalkRun, glm::clamp(REMAP(flatSpeed, 0.4f, groundRunSpeed, 0.0f, 1.0f), 0.0f, 1.0f));
+	animatorStateMachine.setVariable(asmHandles.isMoving, isMoving);
+	animatorStateMachine.setVariable(asmHandles.isGrounded, ((PlayerPhysics*)getPhysicsComponent())->getIsGrounded());
+	animatorStateMachine.setVariable(asmHandles.isLedgeGrab, playerState == PlayerState::LEDGE_GRAB_HUMAN);
 	animatorStateMachine.updateStateMachine(MainLoop::getInstance().deltaTime);
 
 	//
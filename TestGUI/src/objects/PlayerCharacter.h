@@ -158,6 +158,19 @@ public:
 	glm::mat4 modelLocalTransform = glm::mat4(1.0f);
 	Animator animator;
 	AnimatorStateMachine animatorStateMachine;
+	struct ASMHandles
+	{
+		ASMVariableHandle<float> blendWalkRun;
+		ASMVariableHandle<bool> isMoving;
+		ASMVariableHandle<bool> isGrounded;
+		ASMVariableHandle<bool> isLedgeGrab;
+		ASMVariableHandle<bool> triggerJumping;
+		ASMVariableHandle<bool> triggerMidairJumping;
+		ASMVariableHandle<bool> triggerTurnAround;
+		ASMVariableHandle<bool> triggerFall;
+		ASMVariableHandle<bool> triggerDrawWeapon;
+		ASMVariableHandle<bool> triggerSheathWeapon;
+	} asmHandles;		// Resolved once when the ASM gets created
 
 	Model* bottleModel;
 	glm::mat4 bottleModelLocalTransform = glm::mat4(1.0f);
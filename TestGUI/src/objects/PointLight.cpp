@@ -78,7 +78,6 @@ PointLightLight::PointLightLight(BaseObject* bo, bool castsShadows) : LightCompo
 
 PointLightLight::~PointLightLight()
 {
-	destroyShadowBuffers();
 }
 
 void PointLightLight::refreshShadowBuffers()
@@ -86,70 +85,9 @@ void PointLightLight::refreshShadowBuffers()
 	constexpr float lightAttenuationThreshold = 0.025f;		// If the attenuation gets below here, then the light is done (also where the shadowmap ends)
 	farPlane = glm::sqrt(colorIntensity / lightAttenuationThreshold);
 
+	// NOTE: the shadow itself lives in the RenderManager's ShadowAtlas now, so there's nothing to create here
 	if (castsShadows)
-		createShadowBuffers();
-	else
-		destroyShadowBuffers();
-}
-
-constexpr unsigned int depthMapResolution = 512;		// NOTE: this is x6 since we're doing a whole cube!
-void PointLightLight::createShadowBuffers()
-{
-	if (shadowMapsCreated) return;
-
-	refreshResources();
-
-	glGenFramebuffers(1, &lightFBO);
-
-	glGenTextures(1, &shadowMapTexture);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMapTexture);
-	for (unsigned int i = 0; i < 6; i++)
-	{
-		glTexImage2D(
-			GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-			0,
-			GL_DEPTH_COMPONENT,
-			depthMapResolution,
-			depthMapResolution,
-			0,
-			GL_DEPTH_COMPONENT,
-			GL_FLOAT,
-			nullptr
-		);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-	// Framebuffer biz
-	glBindFramebuffer(GL_FRAMEBUFFER, lightFBO);
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMapTexture, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-
-	int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (status != GL_FRAMEBUFFER_COMPLETE)
-	{
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!";
-		throw 0;
-	}
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// Set flag
-	shadowMapsCreated = true;
-}
-
-void PointLightLight::destroyShadowBuffers()
-{
-	if (!shadowMapsCreated) return;
-
-	glDeleteFramebuffers(1, &lightFBO);
-	glDeleteTextures(1, &shadowMapTexture);
-
-	shadowMapsCreated = false;
+		refreshResources();
 }
 
 void PointLightLight::configureShaderAndMatrices()
@@ -173,25 +111,20 @@ void PointLightLight::configureShaderAndMatrices()
 }
 
 void PointLightLight::renderPassShadowMap()
+{
+	// NOTE: point lights get rendered by the ShadowAtlas, since it decides which lights get how much space (see renderPassShadowAtlas())
+}
+
+void PointLightLight::renderPassShadowAtlas(const std::vector<glm::ivec4>& faceViewports)
 {
 #ifdef _DEVELOP
 	refreshResources();
 #endif
 
+	// NOTE: the atlas FBO is already bound, and the tiles are already cleared
 	pointLightShadowShader->use();
-
-	// Render depth of scene
-	glBindFramebuffer(GL_FRAMEBUFFER, lightFBO);
-
-	glViewport(0, 0, depthMapResolution, depthMapResolution);
-	glClear(GL_DEPTH_BUFFER_BIT);
-	//glCullFace(GL_FRONT);  // peter panning
-
 	configureShaderAndMatrices();
-	MainLoop::getInstance().renderManager->renderSceneShadowPass(pointLightShadowShader);
-
-	//glCullFace(GL_BACK);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	MainLoop::getInstance().renderManager->renderSceneShadowViewports(pointLightShadowShader, shadowTransforms, faceViewports);
 }
 
 void PointLightLight::refreshResources()
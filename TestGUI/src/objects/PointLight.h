@@ -14,18 +14,14 @@ public:
 
 	void refreshShadowBuffers();
 
+	void renderPassShadowAtlas(const std::vector<glm::ivec4>& faceViewports);		// NOTE: the ShadowAtlas calls this w/ the 6 tiles this light got
+
 	float nearPlane = 1.0f, farPlane = 25.0f;
 
-	GLuint lightFBO;
 	Shader* pointLightShadowShader;
 private:
-	bool shadowMapsCreated = false;
-
 	std::vector<glm::mat4> shadowTransforms;
 
-	void createShadowBuffers();
-	void destroyShadowBuffers();
-
 	void configureShaderAndMatrices();
 	void renderPassShadowMap();
 
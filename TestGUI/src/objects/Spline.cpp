@@ -2,6 +2,7 @@
 
 #include "../mainloop/MainLoop.h"
 #include "../render_engine/render_manager/RenderManager.h"
+#include "../render_engine/render_manager/DebugDraw.h"
 #include "../utils/PhysicsUtils.h"
 
 #include <glm/gtc/type_ptr.hpp>
@@ -165,25 +166,10 @@ void Spline::imguiRender()
         return;
 
     physx::PxU32 lineColor = 0xFF3300FF;
-    std::vector<ImVec2> pointsToRender;
+    std::vector<glm::vec3> pointsToRender;
     for (size_t i = 0; i < m_calculated_spline_curve_cache.size(); i++)
-    {
-        //
-        // Convert to screen space
-        //
-        glm::vec3 pointOnScreen =
-            MainLoop::getInstance().camera.PositionToClipSpace(glm::vec3(getTransform() * glm::vec4(m_calculated_spline_curve_cache[i], 1.0f)));
-
-        if (pointOnScreen.z < 0.0f)
-            continue;   // Short circuit bc it won't be on screen anymore
-
-        pointOnScreen /= pointOnScreen.z;
-        pointOnScreen.x = ImGui::GetWindowPos().x + pointOnScreen.x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-        pointOnScreen.y = ImGui::GetWindowPos().y - pointOnScreen.y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-
-        pointsToRender.push_back({ pointOnScreen.x, pointOnScreen.y });
-    }
-    ImGui::GetBackgroundDrawList()->AddPolyline(&pointsToRender[0], pointsToRender.size(), lineColor, ImDrawFlags_None, 1.0f);
+        pointsToRender.push_back(glm::vec3(getTransform() * glm::vec4(m_calculated_spline_curve_cache[i], 1.0f)));
+    DebugDraw::getInstance().addPolyline(pointsToRender.data(), pointsToRender.size(), false, lineColor, 0.0f, false);
 
     // Draw all the spline control lines
     physx::PxU32 controlLinesColors[] = { 0xFF3DB80A, 0xFFC74B0D };
@@ -258,7 +258,9 @@ void VoxelGroup::refreshResources()
 			// Create cooked collision mesh
 			//
 			INTERNALrecreatePhysicsComponent();
-			renderComponent->addModelToRender({ voxel_model, true, nullptr });
+			ModelWithMetadata mwmd = { voxel_model, true, nullptr };
+			mwmd.occluderModel = voxel_model;		// NOTE: it's just the outside faces of the voxels, so it's simple enough to occlude with as-is
+			renderComponent->addModelToRender(mwmd);
 		}
 
 
@@ -470,7 +472,7 @@ void VoxelGroup::updateQuadMeshFromBitField()
 
 	if (quadMesh.size() > 0)
 	{
-		voxel_model = new Model(quadMesh);
+		voxel_model = new Model(quadMesh, CPUMeshDataNeed::RENDER_MESHES);		// NOTE: it's the collision mesh and the occluder too
 
 		std::vector<Mesh>& meshes = voxel_model->getRenderMeshes();
 		nlohmann::json j;
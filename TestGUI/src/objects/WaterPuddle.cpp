@@ -142,7 +142,7 @@ void WaterPuddle::preRenderUpdate()
 	//
 	// Process Animations
 	//
-	animatorStateMachine.setVariable("isFull", numWaterServings > 0);
+	animatorStateMachine.setVariable(asmIsFull, numWaterServings > 0);
 	animatorStateMachine.updateStateMachine(MainLoop::getInstance().deltaTime);
 
 	//
@@ -169,6 +169,7 @@ void WaterPuddle::refreshResources()
 	{
 		animator = Animator(&model->getAnimations());
 		animatorStateMachine = AnimatorStateMachine("water_puddle", &animator);
+		asmIsFull = animatorStateMachine.getVariableHandle<bool>("isFull");
 	}
 }
 
@@ -51,6 +51,7 @@ private:
 	glm::mat4 modelTransform;
 	Animator animator;
 	AnimatorStateMachine animatorStateMachine;
+	ASMVariableHandle<bool> asmIsFull;
 	std::map<std::string, Material*> materials;
 	TextRenderer waterServingsText;
 };
@@ -9,6 +9,7 @@
 #include "../render_engine/model/Model.h"
 #include "../render_engine/material/Material.h"
 #include "../render_engine/resources/Resources.h"
+#include "../render_engine/terrain/TerrainRenderer.h"
 #include "../utils/PhysicsUtils.h"
 
 #ifdef _DEVELOP
@@ -21,8 +22,6 @@ YosemiteTerrain::YosemiteTerrain(std::string modelResourceName) : modelResourceN
 {
 	name = "Yosemite Terrain";
 
-	INTERNALrecreatePhysicsComponent(modelResourceName);
-
 	renderComponent = new RenderComponent(this);
 	refreshResources();
 }
@@ -31,20 +30,77 @@ YosemiteTerrain::~YosemiteTerrain()
 {
 	delete renderComponent;
 	delete physicsComponent;
+	delete terrainRenderer;
 }
 
 void YosemiteTerrain::refreshResources()
 {
+	// NOTE: the heightfield gets built off of the CPU copies, and the placeholder cube is an occluder
+	Model::registerCPUMeshDataNeed(modelResourceName, (modelResourceName == "model;cube") ? CPUMeshDataNeed::RENDER_MESHES : CPUMeshDataNeed::PHYSICS_MESHES);
+
 	bool isNewModel;
 	model = (Model*)Resources::getResource(modelResourceName, model, &isNewModel);
 	if (isNewModel)
 	{
-		INTERNALrecreatePhysicsComponent(modelResourceName);
 		renderComponent->clearAllModels();
-		renderComponent->addModelToRender({ model, true, nullptr });
+		renderComponent->setTerrainToRender(nullptr);
+		delete terrainRenderer;
+		terrainRenderer = nullptr;
+
+		if (modelResourceName == "model;cube")
+		{
+			// Placeholder, so just render the model like normal
+			ModelWithMetadata mwmd = { model, true, nullptr };
+			mwmd.occluderModel = model;
+			renderComponent->addModelToRender(mwmd);
+		}
+		else
+			buildHeightfieldTerrain();
+
+		INTERNALrecreatePhysicsComponent(modelResourceName);
 	}
 }
 
+void YosemiteTerrain::buildHeightfieldTerrain()
+{
+	//
+	// Flatten all of the model's meshes into a heightfield
+	//
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	for (auto& mesh : model->getPhysicsMeshes())
+	{
+		const uint32_t baseIndex = (uint32_t)positions.size();
+		const std::vector<glm::vec3>& meshPositions = mesh.getCPUPositions();
+		const std::vector<uint32_t>& meshIndices = mesh.getCPUIndices();
+		positions.insert(positions.end(), meshPositions.begin(), meshPositions.end());
+		for (uint32_t index : meshIndices)
+			indices.push_back(index + baseIndex);
+	}
+	heightfield = Heightfield::createFromTriangles(positions, indices, heightfieldResolution);		// NOTE: the CPU copies have to stay. The model's cached, so the next YosemiteTerrain w/ it builds off of them too
+
+	// @NOTE: cliffs and overhangs still collide (see HeightfieldCollider), but the CDLOD terrain can't
+	// draw them, so they just get stretched over or disappear. Gotta know if a model's not a good fit.
+	if (!heightfield.leftoverIndices.empty())
+		std::cout << "WARNING::YOSEMITETERRAIN::" << modelResourceName << "::" << heightfield.leftoverIndices.size() / 3 << " of " << indices.size() / 3
+			<< " triangles are vertical or under an overhang, so the terrain can't draw them right (collision still has them)" << std::endl;
+
+	// The terrain gets one material, so take it off of the biggest mesh
+	Material* material = nullptr;
+	size_t mostIndices = 0;
+	for (auto& mesh : model->getRenderMeshes())
+	{
+		if (mesh.getNumIndices() > mostIndices)
+		{
+			mostIndices = mesh.getNumIndices();
+			material = mesh.getMaterial();
+		}
+	}
+
+	terrainRenderer = new TerrainRenderer(heightfield, material);
+	renderComponent->setTerrainToRender(terrainRenderer);
+}
+
 void YosemiteTerrain::loadPropertiesFromJson(nlohmann::json& object)		// @Override
 {
 	// NOTE: "Type" is taken care of not here, but at the very beginning when the object is getting created.
@@ -57,6 +113,10 @@ void YosemiteTerrain::loadPropertiesFromJson(nlohmann::json& object)		// @Overri
 	{
 		modelResourceName = object["modelResourceName"];
 	}
+	if (object.contains("heightfieldResolution"))
+	{
+		heightfieldResolution = object["heightfieldResolution"];
+	}
 
 	// TODO: make it so that you don't have to retrigger this every time you load
 	refreshResources();
@@ -70,6 +130,7 @@ nlohmann::json YosemiteTerrain::savePropertiesToJson()
 
 	// Explicit model resource name
 	j["modelResourceName"] = modelResourceName;
+	j["heightfieldResolution"] = heightfieldResolution;
 
 	return j;
 }
@@ -99,8 +160,8 @@ void YosemiteTerrain::INTERNALrecreatePhysicsComponent(std::string modelResource
 	}
 	else
 	{
-		Model* fetchedModel = (Model*)Resources::getResource(modelResourceName);
-		physicsComponent = new TriangleMeshCollider(this, { { fetchedModel } }, RigidActorTypes::STATIC); // RigidActorTypes::KINEMATIC);
+		// NOTE: refreshResources() needs to have made the heightfield already
+		physicsComponent = new HeightfieldCollider(this, heightfield, RigidActorTypes::STATIC);
 	}
 }
 
@@ -124,6 +185,17 @@ void YosemiteTerrain::imguiPropertyPanel()
 
 	ImGui::Separator();
 
+	if (terrainRenderer != nullptr)
+	{
+		ImGui::Text("Heightfield: %u x %u", heightfield.resolutionX, heightfield.resolutionZ);
+		ImGui::Text("Chunks: %i (%i tris), Shadow chunks: %i", (int)terrainRenderer->stats.numChunks, (int)terrainRenderer->stats.numTriangles, (int)terrainRenderer->stats.numShadowChunks);
+		ImGui::DragFloat("LOD Distance Multiplier", &terrainRenderer->lodDistanceMultiplier, 0.01f, 0.1f, 8.0f);
+		ImGui::DragFloat("Shadow LOD Distance Multiplier", &terrainRenderer->shadowLODDistanceMultiplier, 0.01f, 0.1f, 1.0f);
+	}
+	ImGui::InputScalar("Heightfield Resolution (needs reload)", ImGuiDataType_U32, &heightfieldResolution);
+
+	ImGui::Separator();
+
 	ImGui::DragFloat3("Velocity", &velocity[0], 0.01f);
 	ImGui::DragFloat3("Ang Velocity", &angularVelocity[0], 0.01f);
 }
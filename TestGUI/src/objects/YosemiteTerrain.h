@@ -3,10 +3,12 @@
 #include <PxPhysicsAPI.h>
 #include "BaseObject.h"
 #include "../render_engine/model/animation/Animator.h"
+#include "../render_engine/terrain/TerrainQuadtree.h"
 
 
 typedef unsigned int GLuint;
 class Material;
+class TerrainRenderer;
 
 class YosemiteTerrain : public BaseObject
 {
@@ -43,9 +45,17 @@ public:
 	// OLD YOSEMITETERRAINRENDER
 	//
 	std::string modelResourceName;
-	Model* model;
+	Model* model = nullptr;
 	std::map<std::string, Material*> materials;
 
+	//
+	// Heightfield terrain (converted from the model)
+	//
+	uint32_t heightfieldResolution = 1024;
+	Heightfield heightfield;
+	TerrainRenderer* terrainRenderer = nullptr;
+	void buildHeightfieldTerrain();
+
 	// TODO: This needs to stop (having a bad loading function) bc this function should be private, but it's not. Kuso.
 	void refreshResources();
 };
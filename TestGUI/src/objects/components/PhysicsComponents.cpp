@@ -5,6 +5,7 @@
 #include "../../utils/PhysicsUtils.h"
 #include "../../utils/GameState.h"
 #include "../../render_engine/model/Model.h"
+#include "../../render_engine/terrain/TerrainQuadtree.h"
 #include "../PlayerCharacter.h"
 
 //#ifdef _DEVELOP
@@ -78,8 +79,14 @@ void TriangleMeshCollider::routineCreateTriangleMeshGeometry(const glm::mat4& ne
 		const std::vector<Mesh>& modelMeshes = model.model->getPhysicsMeshes();
 		for (size_t i = 0; i < modelMeshes.size(); i++)
 		{
-			const std::vector<Vertex>& vertices = modelMeshes[i].getVertices();
-			const std::vector<uint32_t>& indices = modelMeshes[i].getIndices();
+			if (!modelMeshes[i].hasCPUCopies())
+			{
+				std::cout << "ERROR::TRIANGLEMESHCOLLIDER::Mesh has no CPU copies to cook with (register the model w/ Model::registerCPUMeshDataNeed() before loading it)" << std::endl;
+				continue;
+			}
+
+			const std::vector<glm::vec3>& vertices = modelMeshes[i].getCPUPositions();
+			const std::vector<uint32_t>& indices = modelMeshes[i].getCPUIndices();
 
 			nbVerts += (physx::PxU32)vertices.size();
 			nbIndices += (physx::PxU32)indices.size();
@@ -89,7 +96,7 @@ void TriangleMeshCollider::routineCreateTriangleMeshGeometry(const glm::mat4& ne
 			//
 			for (size_t j = 0; j < vertices.size(); j++)
 			{
-				const glm::vec3 vec = glm::vec3(model.localTransform * glm::vec4(vertices[j].position, 1.0f)) * xformScale;
+				const glm::vec3 vec = glm::vec3(model.localTransform * glm::vec4(vertices[j], 1.0f)) * xformScale;
 				verts.push_back(physx::PxVec3(vec.x, vec.y, vec.z));
 			}
 
@@ -154,6 +161,147 @@ void TriangleMeshCollider::routineCreateTriangleMeshGeometry(const glm::mat4& ne
 #endif
 }
 
+// -----------------------------------------------------------------------------------------------------------------------------------------------------------
+// HeightfieldCollider Class
+// -----------------------------------------------------------------------------------------------------------------------------------------------------------
+HeightfieldCollider::HeightfieldCollider(BaseObject* bo, const Heightfield& heightfield, RigidActorTypes rigidActorType, ShapeTypes shapeType) : PhysicsComponent(bo), shapeType(shapeType)
+{
+	localOffset = heightfield.boundsMin;
+	sampleSpacing = heightfield.getSampleSpacing();
+	heightScale = std::max((heightfield.boundsMax.y - heightfield.boundsMin.y) / 32767.0f, 0.0001f);		// NOTE: PhysX heightfield samples are int16's
+
+	//
+	// Convert to PhysX's format (rows go along x, columns go along z)
+	//
+	std::vector<physx::PxHeightFieldSample> samples((size_t)heightfield.resolutionX * heightfield.resolutionZ);
+	for (uint32_t x = 0; x < heightfield.resolutionX; x++)
+	for (uint32_t z = 0; z < heightfield.resolutionZ; z++)
+	{
+		physx::PxHeightFieldSample& sample = samples[(size_t)x * heightfield.resolutionZ + z];
+		sample.height = (physx::PxI16)std::clamp((int)std::round((heightfield.getHeight(x, z) - localOffset.y) / heightScale), 0, 32767);
+
+		const bool isHole = !heightfield.holes.empty() && heightfield.holes[(size_t)z * heightfield.resolutionX + x];
+		sample.materialIndex0 = isHole ? physx::PxHeightFieldMaterial::eHOLE : 0;
+		sample.materialIndex1 = isHole ? physx::PxHeightFieldMaterial::eHOLE : 0;
+	}
+
+	physx::PxHeightFieldDesc heightFieldDesc;
+	heightFieldDesc.format = physx::PxHeightFieldFormat::eS16_TM;
+	heightFieldDesc.nbRows = heightfield.resolutionX;
+	heightFieldDesc.nbColumns = heightfield.resolutionZ;
+	heightFieldDesc.samples.data = samples.data();
+	heightFieldDesc.samples.stride = sizeof(physx::PxHeightFieldSample);
+
+	heightField = MainLoop::getInstance().physicsCooking->createHeightField(heightFieldDesc, MainLoop::getInstance().physicsPhysics->getPhysicsInsertionCallback());
+	if (heightField == nullptr)
+		std::cout << "ERROR: HeightfieldCollider: creating the PxHeightField failed (" << heightfield.resolutionX << "x" << heightfield.resolutionZ << ")" << std::endl;
+
+	//
+	// Cook whatever the heightfield couldn't hold. NOTE: this is unscaled, the scale goes on the geometry
+	//
+	if (!heightfield.leftoverIndices.empty())
+	{
+		physx::PxTriangleMeshDesc meshDesc;
+		meshDesc.points.count = (physx::PxU32)heightfield.leftoverPositions.size();
+		meshDesc.points.stride = sizeof(glm::vec3);
+		meshDesc.points.data = heightfield.leftoverPositions.data();
+		meshDesc.triangles.count = (physx::PxU32)heightfield.leftoverIndices.size() / 3;
+		meshDesc.triangles.stride = 3 * sizeof(uint32_t);
+		meshDesc.triangles.data = heightfield.leftoverIndices.data();
+
+		physx::PxDefaultMemoryOutputStream writeBuffer;
+		if (MainLoop::getInstance().physicsCooking->cookTriangleMesh(meshDesc, writeBuffer))
+		{
+			physx::PxDefaultMemoryInputData readBuffer(writeBuffer.getData(), writeBuffer.getSize());
+			leftoverTriangleMesh = MainLoop::getInstance().physicsPhysics->createTriangleMesh(readBuffer);
+		}
+		if (leftoverTriangleMesh == nullptr)
+			std::cout << "ERROR: HeightfieldCollider: cooking the leftover triangles failed (" << meshDesc.triangles.count << " triangles)" << std::endl;
+	}
+
+	body = PhysicsUtils::createRigidActor(MainLoop::getInstance().physicsPhysics, PhysicsUtils::createTransform(baseObject->getTransform()), rigidActorType);
+	routineCreateHeightfieldShape(baseObject->getTransform());
+	MainLoop::getInstance().physicsScene->addActor(*body);
+}
+
+HeightfieldCollider::~HeightfieldCollider()
+{
+	MainLoop::getInstance().physicsScene->removeActor(*body);
+	body->release();
+	if (heightField != nullptr)
+		heightField->release();
+	if (leftoverTriangleMesh != nullptr)
+		leftoverTriangleMesh->release();
+}
+
+void HeightfieldCollider::physicsUpdate() { baseObject->physicsUpdate(); }
+
+void HeightfieldCollider::propagateNewTransform(const glm::mat4& newTransform)
+{
+#ifdef _DEVELOP
+	glm::vec3 newScale = PhysicsUtils::getScale(newTransform);
+	if (newScale != cachedScale)
+	{
+		// NOTE: unlike the triangle mesh, the heightfield doesn't need to be recreated. Just the shape w/ the new scales
+		routineCreateHeightfieldShape(newTransform);
+	}
+#endif
+
+	physx::PxTransform trans = PhysicsUtils::createTransform(newTransform);
+	body->setGlobalPose(trans);
+}
+
+physx::PxTransform HeightfieldCollider::getGlobalPose()
+{
+	return body->getGlobalPose();
+}
+
+void HeightfieldCollider::routineCreateHeightfieldShape(const glm::mat4& newTransform)
+{
+	if (heightField == nullptr)
+		return;
+
+	for (physx::PxShape** oldShape : { &shape, &leftoverShape })
+	{
+		if (*oldShape != nullptr)
+		{
+			body->detachShape(**oldShape);
+			*oldShape = nullptr;
+		}
+	}
+
+	auto setupShape = [&](physx::PxShape* newShape)
+	{
+		physx::PxFilterData filterData;
+		filterData.word0 = (physx::PxU32)PhysicsUtils::Word0Tags::UNTAGGED;
+		newShape->setQueryFilterData(filterData);
+
+		if (shapeType == ShapeTypes::TRIGGER)
+		{
+			newShape->setFlag(physx::PxShapeFlag::eSCENE_QUERY_SHAPE, false);
+			newShape->setFlag(physx::PxShapeFlag::eSIMULATION_SHAPE, false);
+			newShape->setFlag(physx::PxShapeFlag::eTRIGGER_SHAPE, true);
+		}
+	};
+
+	const glm::vec3 xformScale = PhysicsUtils::getScale(newTransform);
+	physx::PxHeightFieldGeometry heightFieldGeom(heightField, physx::PxMeshGeometryFlags(), heightScale * xformScale.y, sampleSpacing.x * xformScale.x, sampleSpacing.y * xformScale.z);
+	shape = physx::PxRigidActorExt::createExclusiveShape(*body, heightFieldGeom, *MainLoop::getInstance().defaultPhysicsMaterial);			// @NOTE: When the actor gets released, that's when the exclusiveshape gets released too
+	shape->setLocalPose(physx::PxTransform(PhysicsUtils::toPxVec3(localOffset * xformScale)));
+	setupShape(shape);
+
+	if (leftoverTriangleMesh != nullptr)
+	{
+		physx::PxTriangleMeshGeometry leftoverGeom(leftoverTriangleMesh, physx::PxMeshScale(PhysicsUtils::toPxVec3(xformScale)));
+		leftoverShape = physx::PxRigidActorExt::createExclusiveShape(*body, leftoverGeom, *MainLoop::getInstance().defaultPhysicsMaterial);
+		setupShape(leftoverShape);
+	}
+
+#ifdef _DEVELOP
+	cachedScale = xformScale;
+#endif
+}
+
 // -----------------------------------------------------------------------------------------------------------------------------------------------------------
 // BoxCollider Class
 // -----------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -5,6 +5,7 @@
 
 
 class Model;
+struct Heightfield;
 
 struct ModelWithTransform
 {
@@ -36,6 +37,39 @@ private:
 #endif
 };
 
+//
+// Static terrain collision straight off of a heightfield. Way cheaper to create
+// than cooking the terrain as a triangle mesh, and a lot less memory too.
+// The triangles that the heightfield couldn't hold (cliffs, overhangs) get cooked
+// into a small triangle mesh shape on the same actor.
+//
+class HeightfieldCollider : public PhysicsComponent
+{
+public:
+	HeightfieldCollider(BaseObject* bo, const Heightfield& heightfield, RigidActorTypes rigidActorType, ShapeTypes shapeType = ShapeTypes::COLLISION);
+	~HeightfieldCollider();
+
+	void physicsUpdate();
+	void propagateNewTransform(const glm::mat4& newTransform);
+	physx::PxTransform getGlobalPose();
+
+private:
+	void routineCreateHeightfieldShape(const glm::mat4& newTransform);
+
+	physx::PxHeightField* heightField = nullptr;
+	physx::PxShape* shape = nullptr;
+	physx::PxTriangleMesh* leftoverTriangleMesh = nullptr;
+	physx::PxShape* leftoverShape = nullptr;
+	glm::vec3 localOffset;				// boundsMin of the heightfield (PhysX heightfields start at the origin)
+	glm::vec2 sampleSpacing;
+	float heightScale;
+	ShapeTypes shapeType = ShapeTypes::COLLISION;
+
+#ifdef _DEVELOP
+	glm::vec3 cachedScale;
+#endif
+};
+
 class BoxCollider : public PhysicsComponent
 {
 public:
@@ -12,6 +12,14 @@
 
 Material::Material(Shader* myShader, float ditherAlpha, float fadeAlpha, bool isTransparent, bool renderBackThenFront) : myShader(myShader), ditherAlpha(ditherAlpha), fadeAlpha(fadeAlpha), isTransparent(isTransparent), renderBackThenFront(renderBackThenFront) {}
 
+void Material::applyTextureUniformsToShader(Shader* shader, nlohmann::json injection)
+{
+	Shader* originalShader = myShader;
+	myShader = shader;
+	applyTextureUniforms(injection);
+	myShader = originalShader;
+}
+
 
 //
 // PBR Material
@@ -18,6 +18,7 @@ public:
 	virtual void applyTextureUniforms(nlohmann::json injection = nullptr) = 0;
 	virtual Texture* getMainTexture() = 0;
 	Shader* getShader() { return myShader; }
+	void applyTextureUniformsToShader(Shader* shader, nlohmann::json injection = nullptr);		// NOTE: for renderers that use their own shader w/ the same uniforms (e.g. terrain w/ pbr.frag)
 
 	float ditherAlpha;
 	float fadeAlpha;
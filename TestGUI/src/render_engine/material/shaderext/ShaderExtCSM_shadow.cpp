@@ -9,6 +9,7 @@ unsigned int ShaderExtCSM_shadow::csmShadowMap;
 std::vector<float> ShaderExtCSM_shadow::cascadePlaneDistances;
 float ShaderExtCSM_shadow::cascadeShadowMapTexelSize;
 int ShaderExtCSM_shadow::cascadeCount;
+int ShaderExtCSM_shadow::cascadeStaleMask = 0;
 float ShaderExtCSM_shadow::nearPlane;
 float ShaderExtCSM_shadow::farPlane;
 
@@ -24,6 +25,7 @@ void ShaderExtCSM_shadow::setupExtension()
 		shader->setFloat("cascadePlaneDistances[" + std::to_string(i) + "]", cascadePlaneDistances[i]);
 	shader->setFloat("cascadeShadowMapTexelSize", cascadeShadowMapTexelSize);
 	shader->setInt("cascadeCount", cascadeCount);
+	shader->setInt("cascadeStaleMask", cascadeStaleMask);
 	shader->setFloat("nearPlane", nearPlane);
 	shader->setFloat("farPlane", farPlane);
 }
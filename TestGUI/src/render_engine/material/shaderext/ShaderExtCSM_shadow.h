@@ -15,6 +15,7 @@ public:
 	static std::vector<float> cascadePlaneDistances;
 	static float cascadeShadowMapTexelSize;
 	static int cascadeCount;
+	static int cascadeStaleMask;		// NOTE: bit i is on if cascade i is cached and might not cover its whole slice anymore (see CascadeScheduler)
 	static float nearPlane;
 	static float farPlane;
 };
@@ -15,5 +15,5 @@ ShaderExtSSAO::ShaderExtSSAO(Shader* shader) : ShaderExt(shader)
 void ShaderExtSSAO::setupExtension()
 {
 	shader->setSampler("ssaoTexture", ssaoTexture);
-	shader->setVec2("invFullResolution", { 1.0f / MainLoop::getInstance().camera.width, 1.0f / MainLoop::getInstance().camera.height });
+	shader->setVec2("invFullResolution", { 1.0f / MainLoop::getInstance().renderManager->getRenderWidth(), 1.0f / MainLoop::getInstance().renderManager->getRenderHeight() });		// NOTE: the ssao texture is at the internal resolution
 }
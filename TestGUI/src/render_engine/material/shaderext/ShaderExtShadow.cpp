@@ -5,8 +5,7 @@
 #include "../../render_manager/RenderManager.h"
 
 unsigned int ShaderExtShadow::spotLightShadows[MAX_SHADOWS];
-unsigned int ShaderExtShadow::pointLightShadows[MAX_SHADOWS];
-float ShaderExtShadow::pointLightShadowFarPlanes[MAX_SHADOWS];
+unsigned int ShaderExtShadow::shadowAtlas = 0;
 
 
 ShaderExtShadow::ShaderExtShadow(Shader* shader) : ShaderExt(shader)
@@ -22,12 +21,8 @@ void ShaderExtShadow::setupExtension()
 			shader->setSampler("spotLightShadowMaps[" + std::to_string(i) + "]", spotLightShadows[i]);
 			continue;
 		}
-
-		if (pointLightShadows[i] != 0)
-		{
-			shader->setSampler("pointLightShadowMaps[" + std::to_string(i) + "]", pointLightShadows[i]);
-			shader->setFloat("pointLightShadowFarPlanes[" + std::to_string(i) + "]", pointLightShadowFarPlanes[i]);
-			continue;
-		}
 	}
+
+	if (shadowAtlas != 0)
+		shader->setSampler("shadowAtlas", shadowAtlas);
 }
@@ -11,6 +11,5 @@ public:
 	static const int MAX_SHADOWS = 8;
 
 	static unsigned int spotLightShadows[MAX_SHADOWS];
-	static unsigned int pointLightShadows[MAX_SHADOWS];
-	static float pointLightShadowFarPlanes[MAX_SHADOWS];
+	static unsigned int shadowAtlas;		// NOTE: the point light shadows. Where each light is in it comes from the ShadowAtlasInformation UBO
 };
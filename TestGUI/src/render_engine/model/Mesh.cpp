@@ -2,6 +2,9 @@
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
+#include <iostream>
+#include <cstring>
 #include "../../mainloop/MainLoop.h"
 #include "../resources/Resources.h"
 #include "../render_manager/RenderManager.h"
@@ -9,26 +12,256 @@
 #include "../material/Shader.h"
 
 
-Mesh::Mesh(glm::vec3 centerOfGravity, std::vector<Vertex> vertices, std::vector<unsigned int> indices, const RenderAABB& bounds, const std::string& materialName)
+MeshMemoryStats Mesh::memoryStats = {};
+
+
+Mesh::Mesh(glm::vec3 centerOfGravity, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const RenderAABB& bounds, const std::string& materialName, bool isPhysicsOnly, const std::vector<MeshLOD>& lods, bool keepCPUCopies) :
+    Mesh(bake(centerOfGravity, vertices, indices, bounds, materialName, isPhysicsOnly, lods), keepCPUCopies)
 {
-    Mesh::centerOfGravity = centerOfGravity;
-    Mesh::vertices = vertices;
-    Mesh::indices = indices;
-    Mesh::bounds = bounds;
-    Mesh::materialName = materialName;
+}
+
+Mesh::Mesh(const MeshBakedData& bakedData, bool keepCPUCopies)
+{
+    Mesh::centerOfGravity = bakedData.centerOfGravity;
+    Mesh::bounds = bakedData.bounds;
+    Mesh::materialName = bakedData.materialName;
     Mesh::depthPriority = 0.0f;
     Mesh::material = (Material*)Resources::getResource("material;pbrDefaultMaterial");
+    Mesh::isPhysicsOnly = bakedData.isPhysicsOnly;
+    Mesh::isSkinned = bakedData.isSkinned;
+    Mesh::use16BitIndices = bakedData.use16BitIndices;
+    Mesh::numVertices = bakedData.numVertices;
+    Mesh::numIndices = bakedData.numIndices;
+    Mesh::lods = bakedData.lods;
+    if (Mesh::lods.empty())
+        Mesh::lods.push_back({ 0, (uint32_t)numIndices, 0.0f });
+
+    memoryStats.numMeshes++;
+    countedInStats = true;
 
-    setupMesh();
+    if (isPhysicsOnly)
+    {
+        // Physics meshes never get rendered, so just keep the positions around for cooking
+        cpuPositions.resize(numVertices);
+        cpuIndices.resize(numIndices);
+        memcpy(cpuPositions.data(), bakedData.vertexData.data(), numVertices * sizeof(glm::vec3));
+        memcpy(cpuIndices.data(), bakedData.indexData.data(), numIndices * sizeof(uint32_t));
+        cpuCopiesResident = true;
+
+        cpuBytesKept = cpuPositions.size() * sizeof(glm::vec3) + cpuIndices.size() * sizeof(uint32_t);
+        memoryStats.cpuBytesKept += cpuBytesKept;
+        return;
+    }
+
+    setupMesh(bakedData);
+    if (keepCPUCopies)
+        keepCPUCopiesFromBakedData(bakedData);
 }
 
 Mesh::~Mesh()
 {
-    // @TODO: create a destructor ya dungus!
+    releaseGPUResources();
+
+    memoryStats.cpuBytesKept -= cpuBytesKept;
+    memoryStats.cpuBytesReleased -= cpuBytesReleased;
+    if (countedInStats)
+        memoryStats.numMeshes--;
+}
+
+Mesh::Mesh(Mesh&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    releaseGPUResources();
+    memoryStats.cpuBytesKept -= cpuBytesKept;
+    memoryStats.cpuBytesReleased -= cpuBytesReleased;
+    if (countedInStats)
+        memoryStats.numMeshes--;
+
+    bounds = other.bounds;
+    VAO = other.VAO;
+    VBO = other.VBO;
+    EBO = other.EBO;
+    isPhysicsOnly = other.isPhysicsOnly;
+    isSkinned = other.isSkinned;
+    use16BitIndices = other.use16BitIndices;
+    numVertices = other.numVertices;
+    numIndices = other.numIndices;
+    lods = std::move(other.lods);
+    gpuBytes = other.gpuBytes;
+    gpuBytesUnquantized = other.gpuBytesUnquantized;
+    cpuBytesKept = other.cpuBytesKept;
+    cpuBytesReleased = other.cpuBytesReleased;
+    countedInStats = other.countedInStats;
+    cpuCopiesResident = other.cpuCopiesResident;
+    cpuPositions = std::move(other.cpuPositions);
+    cpuIndices = std::move(other.cpuIndices);
+    centerOfGravity = other.centerOfGravity;
+    depthPriority = other.depthPriority;
+    material = other.material;
+    materialName = std::move(other.materialName);
+    materialInjections = std::move(other.materialInjections);
+
+    // Leave the moved-from mesh empty so that its destructor doesn't touch the stats or the GL resources
+    other.VAO = other.VBO = other.EBO = 0;
+    other.gpuBytes = other.gpuBytesUnquantized = 0;
+    other.cpuBytesKept = other.cpuBytesReleased = 0;
+    other.countedInStats = false;
+    other.cpuCopiesResident = false;
+
+    return *this;
+}
+
+void Mesh::releaseGPUResources()
+{
+    if (VAO == 0)
+        return;
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    VAO = VBO = EBO = 0;
+
+    memoryStats.gpuBytes -= gpuBytes;
+    memoryStats.gpuBytesUnquantized -= gpuBytesUnquantized;
+    gpuBytes = gpuBytesUnquantized = 0;
+}
+
+namespace MeshQuantization
+{
+    void encodeOctahedralNormal(glm::vec3 normal, int16_t out[2])
+    {
+        normal /= (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z) + 1e-20f);
+        glm::vec2 encoded(normal.x, normal.y);
+        if (normal.z < 0.0f)
+        {
+            encoded = glm::vec2(
+                (1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f)
+            );
+        }
+
+        out[0] = (int16_t)std::round(glm::clamp(encoded.x, -1.0f, 1.0f) * 32767.0f);
+        out[1] = (int16_t)std::round(glm::clamp(encoded.y, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    void encodeHalfTexCoords(const glm::vec2& texCoords, uint16_t out[2])
+    {
+        const uint32_t packed = glm::packHalf2x16(texCoords);
+        out[0] = (uint16_t)(packed & 0xFFFF);
+        out[1] = (uint16_t)(packed >> 16);
+    }
+
+    void encodeBoneWeights(const Vertex& vertex, uint8_t outIds[MAX_BONE_INFLUENCE], uint8_t outWeights[MAX_BONE_INFLUENCE])
+    {
+        int total = 0;
+        int largestSlot = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            const bool used = (vertex.boneIds[i] >= 0 && vertex.boneWeights[i] > 0.0f);
+            outIds[i] = used ? (uint8_t)std::min(vertex.boneIds[i], 255) : 0;
+            outWeights[i] = used ? (uint8_t)std::round(glm::clamp(vertex.boneWeights[i], 0.0f, 1.0f) * 255.0f) : 0;
+            total += outWeights[i];
+            if (outWeights[i] > outWeights[largestSlot])
+                largestSlot = i;
+        }
+
+        // Make sure the quantized weights still add up to 1 (dump the rounding error into the largest weight)
+        if (total > 0)
+            outWeights[largestSlot] = (uint8_t)glm::clamp((int)outWeights[largestSlot] + (255 - total), 0, 255);
+    }
+}
+
+MeshBakedData Mesh::bake(glm::vec3 centerOfGravity, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const RenderAABB& bounds, const std::string& materialName, bool isPhysicsOnly, const std::vector<MeshLOD>& lods)
+{
+    MeshBakedData bakedData;
+    bakedData.centerOfGravity = centerOfGravity;
+    bakedData.bounds = bounds;
+    bakedData.materialName = materialName;
+    bakedData.isPhysicsOnly = isPhysicsOnly;
+    bakedData.isSkinned = false;
+    bakedData.use16BitIndices = false;
+    bakedData.numVertices = (uint32_t)vertices.size();
+    bakedData.numIndices = (uint32_t)indices.size();
+    bakedData.lods = lods;
+
+    if (isPhysicsOnly)
+    {
+        bakedData.vertexData.resize(vertices.size() * sizeof(glm::vec3));
+        for (size_t i = 0; i < vertices.size(); i++)
+            ((glm::vec3*)bakedData.vertexData.data())[i] = vertices[i].position;
+
+        bakedData.indexData.resize(indices.size() * sizeof(uint32_t));
+        memcpy(bakedData.indexData.data(), indices.data(), bakedData.indexData.size());
+        return bakedData;
+    }
+
+    //
+    // Figure out the layouts
+    //
+    for (const Vertex& vertex : vertices)
+    {
+        if (vertex.numWeights > 0)
+        {
+            bakedData.isSkinned = true;
+            break;
+        }
+    }
+    bakedData.use16BitIndices = (vertices.size() <= 0xFFFF);
+
+    //
+    // Quantize
+    //
+    const size_t vertexStride = bakedData.isSkinned ? sizeof(SkinnedVertexQuantized) : sizeof(StaticVertexQuantized);
+    bakedData.vertexData.resize(vertices.size() * vertexStride);
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vertex& vertex = vertices[i];
+        if (bakedData.isSkinned)
+        {
+            SkinnedVertexQuantized& quantized = ((SkinnedVertexQuantized*)bakedData.vertexData.data())[i];
+            quantized.position = vertex.position;
+            MeshQuantization::encodeOctahedralNormal(vertex.normal, quantized.normalOctahedral);
+            MeshQuantization::encodeHalfTexCoords(vertex.texCoords, quantized.texCoords);
+            MeshQuantization::encodeBoneWeights(vertex, quantized.boneIds, quantized.boneWeights);
+        }
+        else
+        {
+            StaticVertexQuantized& quantized = ((StaticVertexQuantized*)bakedData.vertexData.data())[i];
+            quantized.position = vertex.position;
+            MeshQuantization::encodeOctahedralNormal(vertex.normal, quantized.normalOctahedral);
+            MeshQuantization::encodeHalfTexCoords(vertex.texCoords, quantized.texCoords);
+        }
+    }
+
+    if (bakedData.use16BitIndices)
+    {
+        bakedData.indexData.resize(indices.size() * sizeof(uint16_t));
+        for (size_t i = 0; i < indices.size(); i++)
+            ((uint16_t*)bakedData.indexData.data())[i] = (uint16_t)indices[i];
+    }
+    else
+    {
+        bakedData.indexData.resize(indices.size() * sizeof(uint32_t));
+        memcpy(bakedData.indexData.data(), indices.data(), bakedData.indexData.size());
+    }
+
+    return bakedData;
 }
 
-void Mesh::setupMesh()
+void Mesh::setupMesh(const MeshBakedData& bakedData)
 {
+    const size_t vertexStride = isSkinned ? sizeof(SkinnedVertexQuantized) : sizeof(StaticVertexQuantized);
+
+    //
+    // Upload
+    //
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -36,31 +269,81 @@ void Mesh::setupMesh()
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, bakedData.vertexData.size(), bakedData.vertexData.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, bakedData.indexData.size(), bakedData.indexData.data(), GL_STATIC_DRAW);
 
     // vertex positions
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // vertex normals
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (GLsizei)vertexStride, (void*)0);
+    // vertex normals (octahedral)
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, (GLsizei)vertexStride, (void*)offsetof(StaticVertexQuantized, normalOctahedral));
     // vertex texture coords
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-    // bone ids
-    glEnableVertexAttribArray(3);
-    glVertexAttribIPointer(3, MAX_BONE_INFLUENCE, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIds));
-    // bone weights
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, MAX_BONE_INFLUENCE, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, boneWeights));
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, (GLsizei)vertexStride, (void*)offsetof(StaticVertexQuantized, texCoords));
+    if (isSkinned)
+    {
+        // bone ids
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, MAX_BONE_INFLUENCE, GL_UNSIGNED_BYTE, (GLsizei)vertexStride, (void*)offsetof(SkinnedVertexQuantized, boneIds));
+        // bone weights
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, MAX_BONE_INFLUENCE, GL_UNSIGNED_BYTE, GL_TRUE, (GLsizei)vertexStride, (void*)offsetof(SkinnedVertexQuantized, boneWeights));
+    }
 
     glBindVertexArray(0);
+
+    //
+    // Keep track of the memory
+    //
+    gpuBytes = bakedData.vertexData.size() + bakedData.indexData.size();
+    gpuBytesUnquantized = numVertices * sizeof(Vertex) + numIndices * sizeof(uint32_t);
+    memoryStats.gpuBytes += gpuBytes;
+    memoryStats.gpuBytesUnquantized += gpuBytesUnquantized;
+
+    cpuBytesReleased = gpuBytesUnquantized;		// NOTE: the CPU copies used to be the same as the unquantized size
+    memoryStats.cpuBytesReleased += cpuBytesReleased;
+}
+
+void Mesh::keepCPUCopiesFromBakedData(const MeshBakedData& bakedData)
+{
+    //
+    // Pull the positions and the LOD0 indices back out of the quantized data before it goes away
+    //
+    const size_t vertexStride = isSkinned ? sizeof(SkinnedVertexQuantized) : sizeof(StaticVertexQuantized);
+    cpuPositions.resize(numVertices);
+    for (size_t i = 0; i < numVertices; i++)
+        cpuPositions[i] = *(const glm::vec3*)(bakedData.vertexData.data() + i * vertexStride);		// NOTE: position is always at offset 0
+
+    const MeshLOD& lod0 = lods[0];
+    cpuIndices.resize(lod0.indexCount);
+    if (use16BitIndices)
+    {
+        const uint16_t* indices16 = (const uint16_t*)bakedData.indexData.data() + lod0.indexOffset;
+        for (size_t i = 0; i < cpuIndices.size(); i++)
+            cpuIndices[i] = indices16[i];
+    }
+    else
+        memcpy(cpuIndices.data(), (const uint32_t*)bakedData.indexData.data() + lod0.indexOffset, lod0.indexCount * sizeof(uint32_t));
+    cpuCopiesResident = true;
+
+    memoryStats.cpuBytesReleased -= cpuBytesReleased;
+    cpuBytesReleased = 0;
+    cpuBytesKept = cpuPositions.size() * sizeof(glm::vec3) + cpuIndices.size() * sizeof(uint32_t);
+    memoryStats.cpuBytesKept += cpuBytesKept;
+}
+
+void Mesh::reportMemoryStats()
+{
+    constexpr double toMB = 1.0 / (1024.0 * 1024.0);
+    std::cout << "MESH::MEMORY:: " << memoryStats.numMeshes << " meshes loaded" << std::endl;
+    std::cout << "MESH::MEMORY::   GPU: " << memoryStats.gpuBytes * toMB << "MB (" << memoryStats.gpuBytesUnquantized * toMB << "MB unquantized, saved " << (memoryStats.gpuBytesUnquantized - memoryStats.gpuBytes) * toMB << "MB)" << std::endl;
+    std::cout << "MESH::MEMORY::   CPU copies: " << memoryStats.cpuBytesKept * toMB << "MB kept, " << memoryStats.cpuBytesReleased * toMB << "MB released" << std::endl;
 }
 
-void Mesh::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage)
+void Mesh::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage, size_t lodIndex, float lodFadeAlpha)
 {
     bool needMainTexture = false;
 
@@ -75,12 +358,12 @@ void Mesh::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const st
 
         if (material->isTransparent)
         {
-            MainLoop::getInstance().renderManager->INTERNALaddMeshToTransparentRenderQueue(this, modelMatrix, boneTransforms);
+            MainLoop::getInstance().renderManager->INTERNALaddMeshToTransparentRenderQueue(this, modelMatrix, boneTransforms, lodIndex, lodFadeAlpha);
             return;  // Bail early; transparents aren't included in Z-pass
         }
         else
         {
-            MainLoop::getInstance().renderManager->INTERNALaddMeshToOpaqueRenderQueue(this, modelMatrix, boneTransforms);
+            MainLoop::getInstance().renderManager->INTERNALaddMeshToOpaqueRenderQueue(this, modelMatrix, boneTransforms, lodIndex, lodFadeAlpha);
         }
     }
     else if (renderStage == RenderStage::OPAQUE_RENDER_QUEUE || renderStage == RenderStage::TRANSPARENT_RENDER_QUEUE)
@@ -92,6 +375,7 @@ void Mesh::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const st
             else
                 material->applyTextureUniforms(materialInjections);
             shaderOverride = material->getShader();
+            shaderOverride->setFloat("lodFadeAlpha", lodFadeAlpha);
         }
     }
 
@@ -101,6 +385,7 @@ void Mesh::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const st
         if (renderStage == RenderStage::Z_PASS)
         {
             shaderOverride->setFloat("ditherAlpha", material->ditherAlpha);
+            shaderOverride->setFloat("lodFadeAlpha", lodFadeAlpha);
 
             glm::vec3 x, y, z;
             z = -glm::normalize(MainLoop::getInstance().camera.orientation);
@@ -124,23 +409,51 @@ void Mesh::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const st
     if (renderStage != RenderStage::OVERRIDE)           // @TODO: when abstracting the shaders, do this kinda logic in the shader instead!
         shaderOverride->setMat3("normalsModelMatrix", glm::mat3(glm::transpose(glm::inverse(modelMatrix))));
 
-    // Apply bone transformations
+    // Apply bone transformations. If the skinning prepass already skinned this mesh, then
+    // it just gets drawn as a static mesh out of the prepass's vertex buffer
+    GLuint drawVAO = VAO;
     if (boneTransforms != nullptr)
-        MainLoop::getInstance().renderManager->INTERNALupdateSkeletalBonesUBO(boneTransforms);
+    {
+        const GLuint skinnedVAO = MainLoop::getInstance().renderManager->INTERNALgetPrepassSkinnedVAO(this, boneTransforms, EBO);
+        if (skinnedVAO != 0)
+            drawVAO = skinnedVAO;
+        else
+            MainLoop::getInstance().renderManager->INTERNALupdateSkeletalBonesUBO(boneTransforms);
+    }
+
+    // Static meshes don't have the bone attributes, so give them zero weights (the shader treats that as no skinning)
+    if (!isSkinned || drawVAO != VAO)
+    {
+        glVertexAttribI4i(3, 0, 0, 0, 0);
+        glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
 
     // Draw the mesh
+    const MeshLOD& lod = lods[std::min(lodIndex, lods.size() - 1)];
+    const GLenum indexType = use16BitIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const void* indexOffset = (void*)(lod.indexOffset * (use16BitIndices ? sizeof(uint16_t) : sizeof(uint32_t)));
+    // Layered shadow maps only draw into the layers (cascades/cube faces) that the mesh reaches
+    ShadowLayerPass* shadowLayerPass = (renderStage == RenderStage::OVERRIDE) ? MainLoop::getInstance().renderManager->INTERNALgetActiveShadowLayerPass() : nullptr;
+    auto drawElements = [&]()
+    {
+        if (shadowLayerPass != nullptr)
+            shadowLayerPass->drawElements(shaderOverride, bounds, modelMatrix, GL_TRIANGLES, (GLsizei)lod.indexCount, indexType, indexOffset);
+        else
+            glDrawElements(GL_TRIANGLES, (GLsizei)lod.indexCount, indexType, indexOffset);
+    };
+
     if (material != nullptr && material->renderBackThenFront)
         glCullFace(GL_FRONT);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(drawVAO);
+    drawElements();
     glBindVertexArray(0);
 
     if (material != nullptr && material->renderBackThenFront)
     {
         material->applyTextureUniforms(materialInjections);
         glCullFace(GL_BACK);
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, (void*)0);
+        glBindVertexArray(drawVAO);
+        drawElements();
         glBindVertexArray(0);
     }
 }
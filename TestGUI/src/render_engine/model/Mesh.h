@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstdint>
 #include "../material/Material.h"
 
 #define MAX_BONE_INFLUENCE 4
@@ -22,6 +23,10 @@ struct RenderAABB
 };
 
 
+//
+// NOTE: this is the import format. It gets quantized into one of the
+// vertex layouts below when the mesh gets uploaded to the GPU.
+//
 struct Vertex
 {
 	glm::vec3 position;
@@ -32,6 +37,65 @@ struct Vertex
 	int numWeights = 0;
 };
 
+struct StaticVertexQuantized		// 20 bytes
+{
+	glm::vec3 position;
+	int16_t normalOctahedral[2];	// snorm16 (see shader/src/pbr.vert octahedralDecode())
+	uint16_t texCoords[2];			// Half floats
+};
+
+struct SkinnedVertexQuantized		// 28 bytes
+{
+	glm::vec3 position;
+	int16_t normalOctahedral[2];
+	uint16_t texCoords[2];
+	uint8_t boneIds[MAX_BONE_INFLUENCE];
+	uint8_t boneWeights[MAX_BONE_INFLUENCE];		// unorm8. Unused slots have 0 weight
+};
+
+
+//
+// All of the LODs of a mesh share the same vertex buffer. Each LOD
+// is just a range in the index buffer (see MeshOptimizer).
+//
+struct MeshLOD
+{
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	float error;		// Max distance (in model units) off of LOD0's surface
+};
+
+
+//
+// Everything that a mesh needs to get created, already quantized and ready
+// to go straight into the GL buffers. This is also what the model cache
+// stores (see ModelCache).
+//
+struct MeshBakedData
+{
+	glm::vec3 centerOfGravity;
+	RenderAABB bounds;
+	std::string materialName;
+	bool isPhysicsOnly;
+	bool isSkinned;
+	bool use16BitIndices;
+	uint32_t numVertices;
+	uint32_t numIndices;
+	std::vector<MeshLOD> lods;
+	std::vector<uint8_t> vertexData;		// NOTE: physics only meshes just store the positions (glm::vec3) in here
+	std::vector<uint8_t> indexData;			// NOTE: physics only meshes always use 32 bit indices
+};
+
+
+struct MeshMemoryStats
+{
+	size_t numMeshes;
+	size_t gpuBytes;
+	size_t gpuBytesUnquantized;		// What it would've been w/ the 68 byte Vertex and 32 bit indices
+	size_t cpuBytesKept;
+	size_t cpuBytesReleased;
+};
+
 
 enum class RenderStage
 {
@@ -46,34 +110,75 @@ enum class RenderStage
 class Mesh
 {
 public:
-	Mesh(glm::vec3 centerOfGravity, std::vector<Vertex> vertices, std::vector<unsigned int> indices, const RenderAABB& bounds, const std::string& materialName);
+	Mesh(glm::vec3 centerOfGravity, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const RenderAABB& bounds, const std::string& materialName, bool isPhysicsOnly = false, const std::vector<MeshLOD>& lods = {}, bool keepCPUCopies = false);		// NOTE: if lods is empty, then all of the indices are LOD0
+	Mesh(const MeshBakedData& bakedData, bool keepCPUCopies = false);
 	~Mesh();
 
-	void render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage);
+	static MeshBakedData bake(glm::vec3 centerOfGravity, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const RenderAABB& bounds, const std::string& materialName, bool isPhysicsOnly, const std::vector<MeshLOD>& lods);
+
+	// NOTE: GL resources are owned by the mesh, so no copying
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	Mesh(Mesh&& other) noexcept;
+	Mesh& operator=(Mesh&& other) noexcept;
+
+	void render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage, size_t lodIndex = 0, float lodFadeAlpha = 1.0f);		// NOTE: lodFadeAlpha < 0 draws the complementary dither pattern (for the LOD that's fading out)
+
+	inline const std::vector<MeshLOD>& getLODs() const { return lods; }
 
 	void pickFromMaterialList(std::map<std::string, Material*> materialMap);
 
 	inline std::string getMaterialName() { return materialName; }
+	inline Material* getMaterial() { return material; }
 	inline void setDepthPriority(float priority) { depthPriority = priority; }
 	inline float getDepthPriority() { return depthPriority; }
 
 	const glm::vec3& getCenterOfGravity() const { return centerOfGravity; }
-	const std::vector<Vertex>& getVertices() const { return vertices; }
-	const std::vector<uint32_t>& getIndices() const { return indices; }
 	inline void setMaterialInjections(const nlohmann::json j) { materialInjections = j; }
 
+	//
+	// CPU copies of the mesh only stick around if keepCPUCopies was set when the mesh got made (physics cooking, occluders, etc.)
+	// Physics only meshes always keep them. NOTE: there's no way to get them back after they're gone (no GPU readbacks)
+	//
+	inline bool hasCPUCopies() const { return cpuCopiesResident; }
+	const std::vector<glm::vec3>& getCPUPositions() const { return cpuPositions; }
+	const std::vector<uint32_t>& getCPUIndices() const { return cpuIndices; }		// NOTE: LOD0 only
+
+	inline bool getIsSkinned() const { return isSkinned; }
+	inline size_t getNumIndices() const { return numIndices; }
+	inline size_t getNumVertices() const { return numVertices; }
+	inline GLuint INTERNALgetVertexBuffer() const { return VBO; }		// NOTE: for the compute skinning prepass (see SkinningPrepass)
+
+	static MeshMemoryStats memoryStats;
+	static void reportMemoryStats();
+
 	RenderAABB bounds;
 
 private:
-	unsigned int VAO, VBO, EBO;
-	void setupMesh();
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	void setupMesh(const MeshBakedData& bakedData);
+	void keepCPUCopiesFromBakedData(const MeshBakedData& bakedData);
+	void releaseGPUResources();
+
+	bool isPhysicsOnly = false;
+	bool isSkinned = false;
+	bool use16BitIndices = false;
+	size_t numVertices = 0;
+	size_t numIndices = 0;
+	std::vector<MeshLOD> lods;
+	size_t gpuBytes = 0;
+	size_t gpuBytesUnquantized = 0;
+	size_t cpuBytesKept = 0;
+	size_t cpuBytesReleased = 0;
+	bool countedInStats = false;
+
+	bool cpuCopiesResident = false;
+	std::vector<glm::vec3>		cpuPositions;
+	std::vector<uint32_t>		cpuIndices;
 
 	glm::vec3					centerOfGravity;
-	std::vector<Vertex>			vertices;
-	std::vector<uint32_t>		indices;
 	float						depthPriority;
 	Material*					material;
 	std::string					materialName;
 	nlohmann::json				materialInjections;			// @Debug: Hard to know whether this will simply be a debug feature or not. But it'll be there for pbrmaterials.
 };
-
@@ -0,0 +1,656 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+
+
+namespace MeshOptimizer
+{
+	//
+	// Vertex cache
+	//
+	constexpr size_t forsythCacheSize = 32;
+
+	float forsythVertexScore(int cachePosition, uint32_t remainingValence)
+	{
+		if (remainingValence == 0)
+			return -1.0f;		// No triangles left that use this vertex
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = 0.75f;	// Was used in the last triangle, so it's a little bit penalized so that strips don't get favored too much
+			else
+				score = powf(1.0f - (float)(cachePosition - 3) / (float)(forsythCacheSize - 3), 1.5f);
+		}
+
+		score += 2.0f * powf((float)remainingValence, -0.5f);		// Boost vertices with only a few triangles left so that they get finished off
+		return score;
+	}
+
+	void optimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices)
+	{
+		const size_t numTriangles = indices.size() / 3;
+		if (numTriangles == 0)
+			return;
+
+		//
+		// Build vertex -> triangle adjacency
+		//
+		std::vector<uint32_t> remainingValence(numVertices, 0);
+		for (uint32_t index : indices)
+			remainingValence[index]++;
+
+		std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+		for (size_t i = 0; i < numVertices; i++)
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingValence[i];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+				adjacency[cursors[indices[i]]++] = (uint32_t)(i / 3);
+		}
+
+		std::vector<int> cachePositions(numVertices, -1);
+		std::vector<float> vertexScores(numVertices);
+		for (size_t i = 0; i < numVertices; i++)
+			vertexScores[i] = forsythVertexScore(-1, remainingValence[i]);
+
+		std::vector<bool> triangleEmitted(numTriangles, false);
+		auto triangleScore = [&](size_t triangle) {
+			return vertexScores[indices[triangle * 3 + 0]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+		};
+
+		size_t bestTriangle = 0;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < numTriangles; i++)
+		{
+			const float score = triangleScore(i);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestTriangle = i;
+			}
+		}
+
+		std::vector<uint32_t> cache, newCache;
+		cache.reserve(forsythCacheSize + 3);
+		newCache.reserve(forsythCacheSize + 3);
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		size_t scanCursor = 0;
+
+		while (result.size() < indices.size())
+		{
+			if (bestTriangle == (size_t)-1)
+			{
+				// Nothing in the cache has any triangles left, so just grab the next one that hasn't been emitted
+				while (triangleEmitted[scanCursor])
+					scanCursor++;
+				bestTriangle = scanCursor;
+			}
+
+			//
+			// Emit the triangle
+			//
+			const uint32_t triangleVerts[3] = { indices[bestTriangle * 3 + 0], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+			result.insert(result.end(), triangleVerts, triangleVerts + 3);
+			triangleEmitted[bestTriangle] = true;
+
+			for (uint32_t v : triangleVerts)
+			{
+				// Remove the triangle from the vertex's adjacency (swap w/ the last remaining one)
+				uint32_t* adjacencyStart = &adjacency[adjacencyOffsets[v]];
+				for (uint32_t j = 0; j < remainingValence[v]; j++)
+				{
+					if (adjacencyStart[j] == bestTriangle)
+					{
+						std::swap(adjacencyStart[j], adjacencyStart[remainingValence[v] - 1]);
+						remainingValence[v]--;
+						break;
+					}
+				}
+			}
+
+			//
+			// Update the cache (the emitted triangle's vertices go to the front)
+			//
+			newCache.clear();
+			newCache.insert(newCache.end(), triangleVerts, triangleVerts + 3);
+			for (uint32_t v : cache)
+				if (v != triangleVerts[0] && v != triangleVerts[1] && v != triangleVerts[2])
+					newCache.push_back(v);
+
+			for (size_t i = forsythCacheSize; i < newCache.size(); i++)
+			{
+				// Fell out of the cache
+				cachePositions[newCache[i]] = -1;
+				vertexScores[newCache[i]] = forsythVertexScore(-1, remainingValence[newCache[i]]);
+			}
+			if (newCache.size() > forsythCacheSize)
+				newCache.resize(forsythCacheSize);
+			cache.swap(newCache);
+
+			for (size_t i = 0; i < cache.size(); i++)
+			{
+				cachePositions[cache[i]] = (int)i;
+				vertexScores[cache[i]] = forsythVertexScore((int)i, remainingValence[cache[i]]);
+			}
+
+			//
+			// Find the next best triangle out of the ones touching the cache
+			//
+			bestTriangle = (size_t)-1;
+			bestScore = -1.0f;
+			for (uint32_t v : cache)
+			{
+				for (uint32_t j = 0; j < remainingValence[v]; j++)
+				{
+					const uint32_t triangle = adjacency[adjacencyOffsets[v] + j];
+					const float score = triangleScore(triangle);
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	float calculateACMR(const std::vector<uint32_t>& indices, size_t numVertices, size_t cacheSize)
+	{
+		const size_t numTriangles = indices.size() / 3;
+		if (numTriangles == 0)
+			return 0.0f;
+
+		// FIFO cache simulation. A vertex is in the cache if it got put in within the last cacheSize misses
+		std::vector<size_t> cacheTimestamps(numVertices, 0);
+		size_t timestamp = cacheSize + 1;
+		size_t numMisses = 0;
+		for (uint32_t index : indices)
+		{
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				numMisses++;
+			}
+		}
+
+		return (float)numMisses / (float)numTriangles;
+	}
+
+
+	//
+	// Overdraw
+	//
+	void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+	{
+		constexpr size_t cacheSize = 16;
+		const size_t numTriangles = indices.size() / 3;
+		if (numTriangles < 2)
+			return;
+
+		//
+		// Split into clusters where the cache is cold (all 3 verts miss). Moving those
+		// clusters around doesn't change the ACMR since the cache is getting refilled there anyways
+		//
+		std::vector<size_t> clusterStarts;
+		{
+			std::vector<size_t> cacheTimestamps(vertices.size(), 0);
+			size_t timestamp = cacheSize + 1;
+			for (size_t i = 0; i < numTriangles; i++)
+			{
+				int numMisses = 0;
+				for (size_t j = 0; j < 3; j++)
+				{
+					const uint32_t index = indices[i * 3 + j];
+					if (timestamp - cacheTimestamps[index] > cacheSize)
+					{
+						cacheTimestamps[index] = timestamp++;
+						numMisses++;
+					}
+				}
+
+				if (i == 0 || numMisses == 3)
+					clusterStarts.push_back(i);
+			}
+		}
+		if (clusterStarts.size() < 2)
+			return;
+
+		//
+		// Sort the clusters by how much they face outwards from the center of the mesh.
+		// The outer facing ones are more likely to be occluders of the other clusters, so they go first
+		//
+		std::vector<glm::vec3> clusterCentroids(clusterStarts.size(), glm::vec3(0.0f));
+		std::vector<glm::vec3> clusterNormals(clusterStarts.size(), glm::vec3(0.0f));
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (size_t c = 0; c < clusterStarts.size(); c++)
+		{
+			const size_t triangleEnd = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : numTriangles;
+			float clusterArea = 0.0f;
+			for (size_t i = clusterStarts[c]; i < triangleEnd; i++)
+			{
+				const glm::vec3& p0 = vertices[indices[i * 3 + 0]].position;
+				const glm::vec3& p1 = vertices[indices[i * 3 + 1]].position;
+				const glm::vec3& p2 = vertices[indices[i * 3 + 2]].position;
+				const glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+				const float area = glm::length(areaNormal);
+
+				clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+				clusterNormals[c] += areaNormal;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroids[c];
+			meshArea += clusterArea;
+			clusterCentroids[c] /= std::max(clusterArea, 1e-20f);
+		}
+		meshCentroid /= std::max(meshArea, 1e-20f);
+
+		std::vector<float> clusterSortKeys(clusterStarts.size());
+		for (size_t c = 0; c < clusterStarts.size(); c++)
+		{
+			const float normalLength = glm::length(clusterNormals[c]);
+			clusterSortKeys[c] = (normalLength > 0.0f) ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / normalLength) : 0.0f;
+		}
+
+		std::vector<size_t> clusterOrder(clusterStarts.size());
+		std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t a, size_t b) { return clusterSortKeys[a] > clusterSortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (size_t c : clusterOrder)
+		{
+			const size_t triangleEnd = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : numTriangles;
+			result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + triangleEnd * 3);
+		}
+		indices.swap(result);
+	}
+
+
+	//
+	// Vertex fetch
+	//
+	void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<std::vector<uint32_t>*> indexLists)
+	{
+		std::vector<uint32_t> remap(vertices.size(), (uint32_t)-1);
+		uint32_t nextVertex = 0;
+		for (std::vector<uint32_t>* indexList : indexLists)
+			for (uint32_t index : *indexList)
+				if (remap[index] == (uint32_t)-1)
+					remap[index] = nextVertex++;
+
+		// NOTE: vertices that aren't used by any of the index lists just get dropped
+		std::vector<Vertex> newVertices(nextVertex);
+		for (size_t i = 0; i < vertices.size(); i++)
+			if (remap[i] != (uint32_t)-1)
+				newVertices[remap[i]] = vertices[i];
+		vertices.swap(newVertices);
+
+		for (std::vector<uint32_t>* indexList : indexLists)
+			for (uint32_t& index : *indexList)
+				index = remap[index];
+	}
+
+
+	//
+	// Simplification
+	//
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double weight = 0;
+
+		void addPlane(const glm::dvec3& normal, double distance, double planeWeight)
+		{
+			a00 += planeWeight * normal.x * normal.x;
+			a01 += planeWeight * normal.x * normal.y;
+			a02 += planeWeight * normal.x * normal.z;
+			a11 += planeWeight * normal.y * normal.y;
+			a12 += planeWeight * normal.y * normal.z;
+			a22 += planeWeight * normal.z * normal.z;
+			b0 += planeWeight * normal.x * distance;
+			b1 += planeWeight * normal.y * distance;
+			b2 += planeWeight * normal.z * distance;
+			c += planeWeight * distance * distance;
+			weight += planeWeight;
+		}
+
+		Quadric operator+(const Quadric& other) const
+		{
+			Quadric q;
+			q.a00 = a00 + other.a00; q.a01 = a01 + other.a01; q.a02 = a02 + other.a02;
+			q.a11 = a11 + other.a11; q.a12 = a12 + other.a12; q.a22 = a22 + other.a22;
+			q.b0 = b0 + other.b0; q.b1 = b1 + other.b1; q.b2 = b2 + other.b2;
+			q.c = c + other.c;
+			q.weight = weight + other.weight;
+			return q;
+		}
+
+		// Returns the (area weighted) RMS distance of the point to all of the planes
+		float errorDistance(const glm::vec3& point) const
+		{
+			const double x = point.x, y = point.y, z = point.z;
+			const double error =
+				a00 * x * x + a11 * y * y + a22 * z * z +
+				2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2.0 * (b0 * x + b1 * y + b2 * z) +
+				c;
+			return (weight > 0.0) ? (float)std::sqrt(std::max(error, 0.0) / weight) : 0.0f;
+		}
+	};
+
+	struct CollapseCandidate
+	{
+		uint32_t from, to;
+		float error;
+	};
+
+	std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& out_error)
+	{
+		out_error = 0.0f;
+		std::vector<uint32_t> result = indices;
+		if (result.size() <= targetIndexCount)
+			return result;
+
+		const size_t numVertices = vertices.size();
+
+		//
+		// Lock the boundary vertices. NOTE: attribute seams (i.e. uv splits) show up as boundaries
+		// here too since the vertices on either side of the seam are different vertices
+		//
+		std::vector<bool> isLocked(numVertices, false);
+		{
+			std::vector<std::pair<uint32_t, uint32_t>> edges;
+			edges.reserve(result.size());
+			for (size_t i = 0; i < result.size(); i += 3)
+				for (size_t j = 0; j < 3; j++)
+				{
+					const uint32_t a = result[i + j], b = result[i + (j + 1) % 3];
+					edges.push_back({ std::min(a, b), std::max(a, b) });
+				}
+			std::sort(edges.begin(), edges.end());
+
+			for (size_t i = 0; i < edges.size();)
+			{
+				size_t j = i;
+				while (j < edges.size() && edges[j] == edges[i])
+					j++;
+				if (j - i == 1)
+					isLocked[edges[i].first] = isLocked[edges[i].second] = true;
+				i = j;
+			}
+		}
+
+		//
+		// Vertex quadrics (area weighted triangle planes)
+		//
+		std::vector<Quadric> quadrics(numVertices);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const glm::dvec3 p0 = vertices[result[i + 0]].position;
+			const glm::dvec3 p1 = vertices[result[i + 1]].position;
+			const glm::dvec3 p2 = vertices[result[i + 2]].position;
+			glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const double doubleArea = glm::length(normal);
+			if (doubleArea <= 0.0)
+				continue;
+			normal /= doubleArea;
+
+			const double distance = -glm::dot(normal, p0);
+			for (size_t j = 0; j < 3; j++)
+				quadrics[result[i + j]].addPlane(normal, distance, doubleArea * 0.5);
+		}
+
+		//
+		// Collapse edges in passes. Each pass, a vertex can only be touched by one collapse so that the checks stay valid
+		//
+		std::vector<uint32_t> remap(numVertices);
+		std::vector<bool> isTouched(numVertices);
+		std::vector<CollapseCandidate> candidates;
+		std::vector<std::pair<uint32_t, uint32_t>> edges;
+		std::vector<uint32_t> adjacencyOffsets(numVertices + 1);
+		std::vector<uint32_t> adjacency;
+
+		for (size_t pass = 0; pass < 100 && result.size() > targetIndexCount; pass++)
+		{
+			// Edges
+			edges.clear();
+			for (size_t i = 0; i < result.size(); i += 3)
+				for (size_t j = 0; j < 3; j++)
+				{
+					const uint32_t a = result[i + j], b = result[i + (j + 1) % 3];
+					edges.push_back({ std::min(a, b), std::max(a, b) });
+				}
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			// Pick the cheaper direction to collapse each edge in
+			candidates.clear();
+			for (auto& edge : edges)
+			{
+				const Quadric combined = quadrics[edge.first] + quadrics[edge.second];
+				CollapseCandidate candidate = { 0, 0, std::numeric_limits<float>::max() };
+				if (!isLocked[edge.first])
+					candidate = { edge.first, edge.second, combined.errorDistance(vertices[edge.second].position) };
+				if (!isLocked[edge.second])
+				{
+					const float error = combined.errorDistance(vertices[edge.first].position);
+					if (error < candidate.error)
+						candidate = { edge.second, edge.first, error };
+				}
+
+				if (candidate.error <= maxError)
+					candidates.push_back(candidate);
+			}
+			if (candidates.empty())
+				break;
+			std::sort(candidates.begin(), candidates.end(), [](const CollapseCandidate& a, const CollapseCandidate& b) { return a.error < b.error; });
+
+			// Vertex -> triangle adjacency
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (uint32_t index : result)
+				adjacencyOffsets[index + 1]++;
+			for (size_t i = 0; i < numVertices; i++)
+				adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < result.size(); i++)
+					adjacency[cursors[result[i]]++] = (uint32_t)(i / 3);
+			}
+
+			std::iota(remap.begin(), remap.end(), 0);
+			std::fill(isTouched.begin(), isTouched.end(), false);
+
+			size_t indexCountEstimate = result.size();
+			size_t numCollapses = 0;
+			for (const CollapseCandidate& candidate : candidates)
+			{
+				if (indexCountEstimate <= targetIndexCount)
+					break;
+				if (isTouched[candidate.from] || isTouched[candidate.to])
+					continue;
+
+				//
+				// Make sure none of the triangles that stick around get flipped
+				//
+				bool flips = false;
+				size_t numRemovedTriangles = 0;
+				for (uint32_t j = adjacencyOffsets[candidate.from]; j < adjacencyOffsets[candidate.from + 1] && !flips; j++)
+				{
+					const size_t triangle = adjacency[j];
+					glm::vec3 before[3], after[3];
+					bool containsTo = false;
+					for (size_t k = 0; k < 3; k++)
+					{
+						const uint32_t index = result[triangle * 3 + k];
+						containsTo |= (index == candidate.to);
+						before[k] = vertices[index].position;
+						after[k] = vertices[(index == candidate.from) ? candidate.to : index].position;
+					}
+
+					if (containsTo)
+					{
+						numRemovedTriangles++;
+						continue;
+					}
+
+					const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					flips = (glm::dot(normalBefore, normalAfter) <= 0.0f);
+				}
+				if (flips)
+					continue;
+
+				//
+				// Collapse
+				//
+				remap[candidate.from] = candidate.to;
+				quadrics[candidate.to] = quadrics[candidate.from] + quadrics[candidate.to];
+				out_error = std::max(out_error, candidate.error);
+				indexCountEstimate -= std::min(indexCountEstimate, numRemovedTriangles * 3);
+				numCollapses++;
+
+				for (uint32_t j = adjacencyOffsets[candidate.from]; j < adjacencyOffsets[candidate.from + 1]; j++)
+					for (size_t k = 0; k < 3; k++)
+						isTouched[result[adjacency[j] * 3 + k]] = true;
+				isTouched[candidate.to] = true;
+			}
+			if (numCollapses == 0)
+				break;
+
+			//
+			// Apply the collapses and remove the triangles that became degenerate
+			//
+			size_t writeIndex = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				const uint32_t a = remap[result[i + 0]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+				result[writeIndex++] = a;
+				result[writeIndex++] = b;
+				result[writeIndex++] = c;
+			}
+			result.resize(writeIndex);
+		}
+
+		return result;
+	}
+
+
+	//
+	// Whole pipeline
+	//
+	constexpr float maxOverdrawACMRIncrease = 1.05f;		// How much worse the overdraw reordering is allowed to make the ACMR (Sander et al. use about this much)
+
+	// Vertex cache + overdraw reordering, but each step only gets kept if the ACMR doesn't get (too much) worse.
+	// Returns false if the original order got kept
+	bool reorderTriangles(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float& out_acmrBefore, float& out_acmrAfter)
+	{
+		out_acmrBefore = calculateACMR(indices, vertices.size());
+
+		std::vector<uint32_t> reordered = indices;
+		optimizeVertexCache(reordered, vertices.size());
+		const float forsythACMR = calculateACMR(reordered, vertices.size());
+		if (forsythACMR > out_acmrBefore)
+		{
+			out_acmrAfter = out_acmrBefore;
+			return false;		// NOTE: this can happen w/ meshes that were already exported in a good order for a different cache size
+		}
+
+		std::vector<uint32_t> overdrawReordered = reordered;
+		optimizeOverdraw(overdrawReordered, vertices);
+		const float overdrawACMR = calculateACMR(overdrawReordered, vertices.size());
+		if (overdrawACMR <= forsythACMR * maxOverdrawACMRIncrease)
+		{
+			reordered.swap(overdrawReordered);
+			out_acmrAfter = overdrawACMR;
+		}
+		else
+			out_acmrAfter = forsythACMR;
+
+		indices.swap(reordered);
+		return true;
+	}
+
+	void buildLODChain(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const LODSettings& settings, std::vector<uint32_t>& out_indices, std::vector<MeshLOD>& out_lods, LODChainStats* out_stats)
+	{
+		out_indices.clear();
+		out_lods.clear();
+
+		std::vector<std::vector<uint32_t>> lodIndexLists;
+		std::vector<float> lodErrors;
+
+		lodIndexLists.push_back(indices);
+		lodErrors.push_back(0.0f);
+		{
+			float acmrBefore, acmrAfter;
+			const bool reordered = reorderTriangles(lodIndexLists[0], vertices, acmrBefore, acmrAfter);
+			if (out_stats != nullptr)
+				*out_stats = { acmrBefore, acmrAfter, !reordered };
+		}
+
+		//
+		// Simplified LODs (always simplified from the original so that the error is measured against it)
+		//
+		glm::vec3 minPoint(std::numeric_limits<float>::max());
+		glm::vec3 maxPoint(std::numeric_limits<float>::lowest());
+		for (const Vertex& vertex : vertices)
+		{
+			minPoint = glm::min(minPoint, vertex.position);
+			maxPoint = glm::max(maxPoint, vertex.position);
+		}
+		const float maxError = vertices.empty() ? 0.0f : settings.maxRelativeError * glm::length(maxPoint - minPoint) * 0.5f;
+
+		for (size_t i = 1; i < settings.maxLODs; i++)
+		{
+			const size_t previousIndexCount = lodIndexLists.back().size();
+			const size_t targetIndexCount = (size_t)(previousIndexCount / 3 * settings.targetReductionPerLOD) * 3;
+			if (targetIndexCount / 3 < settings.minTriangles)
+				break;
+
+			float error;
+			std::vector<uint32_t> lodIndices = simplify(vertices, indices, targetIndexCount, maxError, error);
+			if (lodIndices.empty() || lodIndices.size() > previousIndexCount * settings.minReductionPerLOD)
+				break;		// Hit the error limit (or everything's locked)
+
+			float acmrBefore, acmrAfter;
+			reorderTriangles(lodIndices, vertices, acmrBefore, acmrAfter);
+			lodIndexLists.push_back(std::move(lodIndices));
+			lodErrors.push_back(std::max(error, lodErrors.back()));
+		}
+
+		//
+		// Lay out the vertices in the order LOD0 uses them, then pack all of the LODs into one index buffer
+		//
+		std::vector<std::vector<uint32_t>*> indexListPtrs;
+		for (auto& lodIndices : lodIndexLists)
+			indexListPtrs.push_back(&lodIndices);
+		optimizeVertexFetch(vertices, indexListPtrs);
+
+		for (size_t i = 0; i < lodIndexLists.size(); i++)
+		{
+			MeshLOD lod;
+			lod.indexOffset = (uint32_t)out_indices.size();
+			lod.indexCount = (uint32_t)lodIndexLists[i].size();
+			lod.error = lodErrors[i];
+			out_lods.push_back(lod);
+			out_indices.insert(out_indices.end(), lodIndexLists[i].begin(), lodIndexLists[i].end());
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Mesh.h"
+
+
+//
+// Import-time mesh processing. Everything in here works off of the imported
+// Vertex/index lists before they get uploaded, so there's no GL in here.
+//
+// The vertices should already be welded (aiProcess_JoinIdenticalVertices)
+// before going through here.
+//
+namespace MeshOptimizer
+{
+	struct LODSettings
+	{
+		size_t maxLODs = 4;						// Including LOD0
+		float targetReductionPerLOD = 0.5f;		// Each LOD tries to have this much of the previous LOD's triangles
+		float minReductionPerLOD = 0.85f;		// Stop making LODs once the simplifier can't get under this much of the previous LOD
+		size_t minTriangles = 32;
+		float maxRelativeError = 0.05f;			// Relative to the mesh's bounding radius
+	};
+
+	// Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+	void optimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices);
+
+	// Splits up the (already cache optimized) triangles at cache-cold spots and sorts those clusters so that
+	// outward facing ones get drawn first (Sander et al. "Fast Triangle Reordering...")
+	void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+
+	// Reorders the vertices in the order that they're first used in the first index list. All the index lists get remapped
+	void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<std::vector<uint32_t>*> indexLists);
+
+	// Quadric error metric edge collapses. Vertices only get collapsed onto other existing vertices, so
+	// the vertex buffer is shared with the source. Vertices on boundaries and attribute seams are locked.
+	// out_error is the error in the mesh's units
+	std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& out_error);
+
+	float calculateACMR(const std::vector<uint32_t>& indices, size_t numVertices, size_t cacheSize = 16);	// Average cache miss ratio (verts transformed per triangle)
+
+	struct LODChainStats
+	{
+		float acmrBefore;				// LOD0 as it got imported
+		float acmrAfter;				// LOD0 after the reordering (the same as before if the reordering got thrown out)
+		bool keptImportedOrder;			// The vertex cache/overdraw reordering made the ACMR worse, so it didn't get used
+	};
+
+	// Runs the whole pipeline. out_indices holds all of the LODs one after another, which out_lods points into
+	void buildLODChain(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const LODSettings& settings, std::vector<uint32_t>& out_indices, std::vector<MeshLOD>& out_lods, LODChainStats* out_stats = nullptr);
+}
@@ -4,8 +4,11 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <iostream>
+#include <chrono>
 
 #include "animation/Animation.h"
+#include "MeshOptimizer.h"
+#include "ModelCache.h"
 #include "../../utils/PhysicsUtils.h"
 #include "../camera/Camera.h"
 #include "../../mainloop/MainLoop.h"
@@ -13,15 +16,66 @@
 #include "../material/Shader.h"
 
 
+ModelLODSettings Model::lodSettings;
+ModelLODStats Model::lodStats = {};
+float Model::autoLODBiasSmoothedFrameTimeMs = 0.0f;
+std::map<std::string, CPUMeshDataNeed> Model::cpuMeshDataNeeds;
+
+
+size_t ModelLOD::selectLevel(const std::vector<float>& levelScreenSizes, float screenSize, size_t currentLevel, float hysteresis)
+{
+	// Pick the coarsest level that the screen size is under. Levels coarser than the current one need
+	// the screen size to get under the threshold by the hysteresis amount before they can switch over.
+	// Going back to a finer level happens right at the threshold, so there's a gap of (hysteresis * threshold)
+	// that the screen size can wobble around in w/o switching back and forth
+	for (size_t i = levelScreenSizes.size() - 1; i > 0; i--)
+	{
+		const float threshold = (i > currentLevel) ? levelScreenSizes[i] * (1.0f - hysteresis) : levelScreenSizes[i];
+		if (screenSize <= threshold)
+			return i;
+	}
+	return 0;
+}
+
+
+void Model::INTERNALresetLODStats()
+{
+	lodStats = {};
+}
+
+
+void Model::INTERNALupdateAutoLODBias(float deltaTime)
+{
+	if (!lodSettings.autoLODBias)
+	{
+		autoLODBiasSmoothedFrameTimeMs = 0.0f;		// Start fresh the next time it gets turned on
+		return;
+	}
+	if (deltaTime <= 0.0f)
+		return;
+
+	if (autoLODBiasSmoothedFrameTimeMs <= 0.0f)
+		autoLODBiasSmoothedFrameTimeMs = lodSettings.targetFrameTimeMs;
+	autoLODBiasSmoothedFrameTimeMs = glm::mix(autoLODBiasSmoothedFrameTimeMs, deltaTime * 1000.0f, 0.1f);
+
+	// Only budge the bias when it's out of the [90%, 100%] of target range so that it doesn't oscillate
+	if (autoLODBiasSmoothedFrameTimeMs > lodSettings.targetFrameTimeMs)
+		lodSettings.lodBias *= 0.98f;
+	else if (autoLODBiasSmoothedFrameTimeMs < lodSettings.targetFrameTimeMs * 0.9f)
+		lodSettings.lodBias *= 1.01f;
+	lodSettings.lodBias = glm::clamp(lodSettings.lodBias, lodSettings.minLODBias, lodSettings.maxLODBias);
+}
+
+
 Model::Model() { }
 
-Model::Model(const char* path)
+Model::Model(const char* path, CPUMeshDataNeed cpuMeshDataNeed) : cpuMeshDataNeed(cpuMeshDataNeed)
 {
 	loadModel(path, {});
 }
 
 
-Model::Model(const char* path, std::vector<AnimationMetadata> animationMetadatas)
+Model::Model(const char* path, std::vector<AnimationMetadata> animationMetadatas, CPUMeshDataNeed cpuMeshDataNeed) : cpuMeshDataNeed(cpuMeshDataNeed)
 {
 	loadModel(path, animationMetadatas);
 }
@@ -35,10 +89,10 @@ Model::Model(const char* path, std::vector<AnimationMetadata> animationMetadatas
 //		|	   |
 //		1 ---- 2
 //
-Model::Model(const std::vector<Vertex>& quadMesh)
+Model::Model(const std::vector<Vertex>& quadMesh, CPUMeshDataNeed cpuMeshDataNeed) : cpuMeshDataNeed(cpuMeshDataNeed)
 {
 	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
+	std::vector<uint32_t> indices;
 
 	glm::vec3* minAABBPoint = nullptr;
 	glm::vec3* maxAABBPoint = nullptr;
@@ -130,7 +184,7 @@ Model::Model(const std::vector<Vertex>& quadMesh)
 	}
 
 	// Finally, create the mesh
-	renderMeshes.push_back(Mesh(glm::vec3(0.0f), vertices, indices, modelRenderAABB, "Material"));		// Default material name
+	renderMeshes.push_back(Mesh(glm::vec3(0.0f), vertices, indices, modelRenderAABB, "Material", false, {}, cpuMeshDataNeed != CPUMeshDataNeed::NONE));		// Default material name
 }
 
 bool Model::getIfInViewFrustum(const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, std::vector<bool>& out_whichMeshesInView)
@@ -150,15 +204,111 @@ bool Model::getIfInViewFrustum(const glm::mat4& modelMatrix, const ViewFrustum*
 }
 
 
-void Model::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<bool>* whichMeshesInView, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage)
+float Model::getProjectedScreenSize(const glm::mat4& modelMatrix, const Camera& camera)
+{
+	if (!modelBoundsCalculated)
+		calculateModelBounds();
+
+	RenderAABB cookedBounds = PhysicsUtils::fitAABB(modelBounds, modelMatrix);
+	const float radius = glm::length(cookedBounds.extents);
+	const float distance = glm::length(cookedBounds.center - camera.position);
+	if (distance <= radius)
+		return 1.0f;		// Camera is inside the bounds
+
+	return glm::min(1.0f, radius / (distance * tanf(glm::radians(camera.fov) * 0.5f)));
+}
+
+
+RenderAABB Model::getWorldBounds(const glm::mat4& modelMatrix)
+{
+	if (!modelBoundsCalculated)
+		calculateModelBounds();
+
+	return PhysicsUtils::fitAABB(modelBounds, modelMatrix);
+}
+
+
+void Model::calculateModelBounds()
+{
+	glm::vec3 minPoint(std::numeric_limits<float>::max());
+	glm::vec3 maxPoint(std::numeric_limits<float>::lowest());
+	for (size_t i = 0; i < renderMeshes.size(); i++)
+	{
+		minPoint = glm::min(minPoint, renderMeshes[i].bounds.center - renderMeshes[i].bounds.extents);
+		maxPoint = glm::max(maxPoint, renderMeshes[i].bounds.center + renderMeshes[i].bounds.extents);
+	}
+
+	if (renderMeshes.empty())
+		minPoint = maxPoint = glm::vec3(0.0f);
+
+	modelBounds.center = (minPoint + maxPoint) / 2.0f;
+	modelBounds.extents = maxPoint - modelBounds.center;
+	modelBoundsCalculated = true;
+}
+
+
+void Model::render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<bool>* whichMeshesInView, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage, size_t lodIndex, float lodFadeAlpha)
 {
 	for (size_t i = 0; i < renderMeshes.size(); i++)
 	{
 		if (whichMeshesInView == nullptr || (*whichMeshesInView)[i])
-			renderMeshes[i].render(modelMatrix, shaderOverride, boneTransforms, renderStage);
+			renderMeshes[i].render(modelMatrix, shaderOverride, boneTransforms, renderStage, lodIndex, lodFadeAlpha);
 	}
 }
 
+
+size_t Model::getNumGeneratedLODs()
+{
+	size_t numLODs = 1;
+	for (size_t i = 0; i < renderMeshes.size(); i++)
+		numLODs = std::max(numLODs, renderMeshes[i].getLODs().size());
+	return numLODs;
+}
+
+
+void Model::getGeneratedLODScreenSizes(float screenHeight, std::vector<float>& out_levelScreenSizes)
+{
+	if (!modelBoundsCalculated)
+		calculateModelBounds();
+
+	//
+	// A LOD w/ an error of e (in model units) is off by e * screenSize * screenHeight * 0.5 / modelRadius pixels,
+	// so solve for the screen size where that's maxPixelError. Use the worst mesh for each level
+	//
+	const float modelRadius = glm::length(modelBounds.extents);
+	const size_t numLODs = getNumGeneratedLODs();
+	out_levelScreenSizes.resize(numLODs);
+	for (size_t lodIndex = 0; lodIndex < numLODs; lodIndex++)
+	{
+		float maxError = 0.0f;
+		for (size_t i = 0; i < renderMeshes.size(); i++)
+		{
+			const std::vector<MeshLOD>& lods = renderMeshes[i].getLODs();
+			maxError = std::max(maxError, lods[std::min(lodIndex, lods.size() - 1)].error);
+		}
+
+		out_levelScreenSizes[lodIndex] =
+			(lodIndex == 0 || maxError <= 0.0f) ?
+			std::numeric_limits<float>::max() :
+			2.0f * lodSettings.maxPixelError * modelRadius / (maxError * screenHeight);
+	}
+}
+
+
+size_t Model::getTriangleCount(size_t lodIndex, const std::vector<bool>* whichMeshesInView)
+{
+	size_t numTriangles = 0;
+	for (size_t i = 0; i < renderMeshes.size(); i++)
+	{
+		if (whichMeshesInView != nullptr && !(*whichMeshesInView)[i])
+			continue;
+
+		const std::vector<MeshLOD>& lods = renderMeshes[i].getLODs();
+		numTriangles += lods[std::min(lodIndex, lods.size() - 1)].indexCount / 3;
+	}
+	return numTriangles;
+}
+
 #ifdef _DEVELOP
 std::vector<std::string> Model::getAnimationNameList()
 {
@@ -216,21 +366,66 @@ void Model::setDepthPriorityOfMeshesWithMaterial(const std::string& materialName
 }
 
 
+void Model::registerCPUMeshDataNeed(const std::string& resourceName, CPUMeshDataNeed need)
+{
+	// NOTE: RENDER_MESHES keeps everything that PHYSICS_MESHES would've, so just take whichever's bigger
+	CPUMeshDataNeed& registeredNeed = cpuMeshDataNeeds[resourceName];
+	registeredNeed = std::max(registeredNeed, need);
+}
+
+
+CPUMeshDataNeed Model::getCPUMeshDataNeed(const std::string& resourceName)
+{
+	auto it = cpuMeshDataNeeds.find(resourceName);
+	return (it != cpuMeshDataNeeds.end()) ? it->second : CPUMeshDataNeed::NONE;
+}
+
+
 void Model::loadModel(std::string path, std::vector<AnimationMetadata> animationMetadatas)
 {
 	std::cout << "MODEL::" << path << "::Import Started" << std::endl;
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	directory = path.substr(0, path.find_last_of('/'));
+
+	//
+	// Try the baked model cache first, and only go thru Assimp if it's not there (or if the source changed)
+	//
+	BakedModel bakedModel;
+	const uint64_t sourceHash = ModelCache::hashSource(path, animationMetadatas);
+	const std::string cachePath = ModelCache::getCachePath(path, sourceHash);
+	const bool loadedFromCache = (sourceHash != 0 && ModelCache::loadFromFile(cachePath, sourceHash, bakedModel));
+	if (!loadedFromCache)
+	{
+		if (!importModel(path, animationMetadatas, bakedModel))
+			return;
 
+		if (sourceHash != 0)
+			ModelCache::saveToFile(cachePath, sourceHash, bakedModel);
+	}
+
+	loadFromBakedModel(bakedModel);
+
+	const float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	std::cout << "MODEL::" << path << "::Import Fimished (" << (loadedFromCache ? "from cache" : "from source") << ", " << elapsedMs << "ms, " << getNumGeneratedLODs() << " LODs";
+	if (importNumTriangles > 0)
+		std::cout << ", ACMR " << importNumVertexTransformsBefore / importNumTriangles << " -> " << importNumVertexTransformsAfter / importNumTriangles;
+	std::cout << ")" << std::endl;
+}
+
+
+bool Model::importModel(const std::string& path, const std::vector<AnimationMetadata>& animationMetadatas, BakedModel& out_bakedModel)
+{
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_LimitBoneWeights);
+	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_LimitBoneWeights | aiProcess_JoinIdenticalVertices);		// NOTE: the vertex cache/overdraw/LOD stuff happens in processMesh()
 
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
 		std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-		return;
+		return false;
 	}
 
-	directory = path.substr(0, path.find_last_of('/'));
-	processNode(scene->mRootNode, scene);		// This starts the recursive process of loading in the model as vertices!
+	processNode(scene->mRootNode, scene, out_bakedModel);		// This starts the recursive process of loading in the model as vertices!
 
 	//
 	// Load in animations
@@ -238,45 +433,79 @@ void Model::loadModel(std::string path, std::vector<AnimationMetadata> animation
 	for (size_t i = 0; i < animationMetadatas.size(); i++)
 	{
 		Animation newAnimation(scene, this, animationMetadatas[i]);
-		animations.push_back(newAnimation);
+		out_bakedModel.animations.push_back({});
+		newAnimation.bake(out_bakedModel.animations.back());
 	}
 
-#ifdef _DEVELOP
-	// Load all the animation names
 	for (size_t i = 0; i < scene->mNumAnimations; i++)
 	{
-		animationNameList.push_back(scene->mAnimations[i]->mName.C_Str());
+		out_bakedModel.animationNameList.push_back(scene->mAnimations[i]->mName.C_Str());
 	}
+
+	//
+	// Bones (NOTE: processMesh() and the animations fill in the boneInfoMap as they go)
+	//
+	for (auto& [boneName, boneInfo] : boneInfoMap)
+		out_bakedModel.boneInfos.push_back({ boneName, boneInfo.id, boneInfo.offset });
+	out_bakedModel.boneCounter = boneCounter;
+
+	return true;
+}
+
+
+void Model::loadFromBakedModel(const BakedModel& bakedModel)
+{
+	renderMeshes.clear();
+	physicsMeshes.clear();
+	const bool keepRenderMeshCPUCopies =
+		(cpuMeshDataNeed == CPUMeshDataNeed::RENDER_MESHES) ||
+		(cpuMeshDataNeed == CPUMeshDataNeed::PHYSICS_MESHES && bakedModel.physicsMeshes.empty());		// NOTE: getPhysicsMeshes() falls back to the render meshes
+	for (const MeshBakedData& bakedMesh : bakedModel.renderMeshes)
+		renderMeshes.push_back(Mesh(bakedMesh, keepRenderMeshCPUCopies));
+	for (const MeshBakedData& bakedMesh : bakedModel.physicsMeshes)
+		physicsMeshes.push_back(Mesh(bakedMesh));
+
+	boneInfoMap.clear();
+	for (const BakedBoneInfo& boneInfo : bakedModel.boneInfos)
+		boneInfoMap[boneInfo.name] = { boneInfo.id, boneInfo.offset };
+	boneCounter = bakedModel.boneCounter;
+
+	animations.clear();
+	for (const BakedAnimation& bakedAnimation : bakedModel.animations)
+		animations.push_back(Animation(bakedAnimation));
+
+#ifdef _DEVELOP
+	animationNameList = bakedModel.animationNameList;
 #endif
 
-	std::cout << "MODEL::" << path << "::Import Fimished" << std::endl;
+	modelBoundsCalculated = false;
 }
 
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, BakedModel& out_bakedModel)
 {
 	// process all of the node's meshes (if any)
 	for (size_t i = 0; i < node->mNumMeshes; i++)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
 		if (mesh->mName == aiString("COLLISION_MESH"))
-			physicsMeshes.push_back(processMesh(mesh, scene));
+			out_bakedModel.physicsMeshes.push_back(processMesh(mesh, scene, true));		// NOTE: these never get rendered, so they don't get uploaded
 		else
-			renderMeshes.push_back(processMesh(mesh, scene));
+			out_bakedModel.renderMeshes.push_back(processMesh(mesh, scene, false));
 	}
 
 	// Recursive part: continue going down the children
 	for (size_t i = 0; i < node->mNumChildren; i++)
 	{
-		processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, out_bakedModel);
 	}
 }
 
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+MeshBakedData Model::processMesh(aiMesh* mesh, const aiScene* scene, bool isPhysicsOnly)
 {
 	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
+	std::vector<uint32_t> indices;
 
 	glm::vec3  centerOfGravity(0.0f);
 	glm::vec3* minAABBPoint = nullptr;
@@ -376,7 +605,21 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 		delete maxAABBPoint;
 	}
 
-	return Mesh(centerOfGravity, vertices, indices, modelRenderAABB, materialName);
+	if (isPhysicsOnly)
+		return Mesh::bake(centerOfGravity, vertices, indices, modelRenderAABB, materialName, true, {});
+
+	// Optimize and make the LODs
+	std::vector<uint32_t> lodIndices;
+	std::vector<MeshLOD> lods;
+	MeshOptimizer::LODChainStats lodChainStats;
+	MeshOptimizer::buildLODChain(vertices, indices, MeshOptimizer::LODSettings(), lodIndices, lods, &lodChainStats);
+
+	const size_t numTriangles = indices.size() / 3;
+	importNumTriangles += numTriangles;
+	importNumVertexTransformsBefore += lodChainStats.acmrBefore * numTriangles;
+	importNumVertexTransformsAfter += lodChainStats.acmrAfter * numTriangles;
+
+	return Mesh::bake(centerOfGravity, vertices, lodIndices, modelRenderAABB, materialName, false, lods);
 }
 
 
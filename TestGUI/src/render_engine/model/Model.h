@@ -12,19 +12,73 @@ struct aiNode;
 struct aiScene;
 struct aiMesh;
 struct ViewFrustum;
+struct BakedModel;
+class Camera;
 class Shader;
 typedef unsigned int GLuint;
 
+struct ModelLODSettings
+{
+	bool enabled = true;
+	float maxPixelError = 1.0f;			// How far off (in pixels) a generated LOD can be off of LOD0 before it can't be used
+	float hysteresis = 0.15f;			// Going to a coarser LOD needs the screen size to be this much (relative) under the threshold. Keeps LODs from popping back and forth
+	float crossfadeTime = 0.3f;			// Seconds. 0 turns off the dithered crossfade
+	float lodBias = 1.0f;				// Multiplies the screen size before picking a LOD (> 1 keeps more detail)
+	bool autoLODBias = false;			// Moves lodBias around to try and hit targetFrameTimeMs
+	float targetFrameTimeMs = 16.667f;
+	float minLODBias = 0.25f;
+	float maxLODBias = 2.0f;
+};
+
+struct ModelLODStats
+{
+	size_t numTrianglesFullDetail;		// What would've been drawn w/o LODs
+	size_t numTrianglesRendered;
+	size_t numCrossfading;
+};
+
+//
+// What a model needs to keep CPU copies of after uploading its meshes. Everything
+// else only lives on the GPU (see Mesh::hasCPUCopies())
+//
+enum class CPUMeshDataNeed
+{
+	NONE,
+	PHYSICS_MESHES,		// For collision cooking and such. If the model doesn't have any COLLISION_MESH meshes, then the render meshes get kept
+	RENDER_MESHES		// Occluders, picking, etc.
+};
+
+namespace ModelLOD
+{
+	// levelScreenSizes[i] is the screen size (see Model::getProjectedScreenSize()) that level i starts getting used under. Levels go fine -> coarse
+	size_t selectLevel(const std::vector<float>& levelScreenSizes, float screenSize, size_t currentLevel, float hysteresis);
+}
+
+
 class Model
 {
 public:
 	Model();						// NOTE: Creation of the default constructor is just to appease the compiler
-	Model(const char* path);
-	Model(const char* path, std::vector<AnimationMetadata> animationMetadatas);
-	Model(const std::vector<Vertex>& quadMesh);			// NOTE: this is for VoxelGroup class
+	Model(const char* path, CPUMeshDataNeed cpuMeshDataNeed = CPUMeshDataNeed::NONE);
+	Model(const char* path, std::vector<AnimationMetadata> animationMetadatas, CPUMeshDataNeed cpuMeshDataNeed = CPUMeshDataNeed::NONE);
+	Model(const std::vector<Vertex>& quadMesh, CPUMeshDataNeed cpuMeshDataNeed = CPUMeshDataNeed::NONE);			// NOTE: this is for VoxelGroup class
 	~Model() { }
 	bool getIfInViewFrustum(const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, std::vector<bool>& out_whichMeshesInView);
-	void render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<bool>* whichMeshesInView, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage);
+	float getProjectedScreenSize(const glm::mat4& modelMatrix, const Camera& camera);		// NOTE: returns how much of the screen's height the model's bounding sphere takes up [0-1]
+	RenderAABB getWorldBounds(const glm::mat4& modelMatrix);
+	void render(const glm::mat4& modelMatrix, Shader* shaderOverride, const std::vector<bool>* whichMeshesInView, const std::vector<glm::mat4>* boneTransforms, RenderStage renderStage, size_t lodIndex = 0, float lodFadeAlpha = 1.0f);
+
+	size_t getNumGeneratedLODs();
+	void getGeneratedLODScreenSizes(float screenHeight, std::vector<float>& out_levelScreenSizes);		// NOTE: converts the mesh LOD errors into screen sizes using lodSettings.maxPixelError
+	size_t getTriangleCount(size_t lodIndex, const std::vector<bool>* whichMeshesInView);
+
+	static ModelLODSettings lodSettings;
+	static ModelLODStats lodStats;
+	static void INTERNALresetLODStats();
+	static void INTERNALupdateAutoLODBias(float deltaTime);
+private:
+	static float autoLODBiasSmoothedFrameTimeMs;		// 0 until auto LOD bias gets turned on
+public:
 
 #ifdef _DEVELOP
 	std::vector<std::string> getAnimationNameList();
@@ -46,19 +100,39 @@ public:
 	std::vector<Mesh>& getRenderMeshes() { return renderMeshes; }
 	std::vector<Mesh>& getPhysicsMeshes() { return (physicsMeshes.size() == 0) ? renderMeshes : physicsMeshes; }
 
+	//
+	// NOTE: the CPU copies of the meshes get dropped after uploading unless the model's resource was registered
+	// as needing them before it got loaded (see Resources.cpp). Register in the object's ctor before the getResource() call
+	//
+	static void registerCPUMeshDataNeed(const std::string& resourceName, CPUMeshDataNeed need);
+	static CPUMeshDataNeed getCPUMeshDataNeed(const std::string& resourceName);
+
 private:
 	std::vector<Mesh> renderMeshes;
 	std::vector<Mesh> physicsMeshes;
 	std::string directory;
+	CPUMeshDataNeed cpuMeshDataNeed = CPUMeshDataNeed::NONE;
+	static std::map<std::string, CPUMeshDataNeed> cpuMeshDataNeeds;
 
 	std::vector<Animation> animations;
 
 	std::map<std::string, BoneInfo> boneInfoMap;
 	int boneCounter = 0;
 
+	// Summed up over the render meshes in processMesh(), so the ACMR goes out in the "Import Fimished" line. Stays 0 when it's loaded from the cache
+	size_t importNumTriangles = 0;
+	float importNumVertexTransformsBefore = 0.0f;
+	float importNumVertexTransformsAfter = 0.0f;
+
+	RenderAABB modelBounds;
+	bool modelBoundsCalculated = false;
+	void calculateModelBounds();
+
 	void loadModel(std::string path, std::vector<AnimationMetadata> animationMetadatas);
-	void processNode(aiNode* node, const aiScene* scene);
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+	bool importModel(const std::string& path, const std::vector<AnimationMetadata>& animationMetadatas, BakedModel& out_bakedModel);		// NOTE: Assimp only gets used in here
+	void loadFromBakedModel(const BakedModel& bakedModel);
+	void processNode(aiNode* node, const aiScene* scene, BakedModel& out_bakedModel);
+	MeshBakedData processMesh(aiMesh* mesh, const aiScene* scene, bool isPhysicsOnly);
 
 	void setVertexBoneDataToDefault(Vertex& vertex);
 	void addVertexBoneData(Vertex& vertex, int boneId, float boneWeight);
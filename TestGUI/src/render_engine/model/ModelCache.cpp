@@ -0,0 +1,546 @@
+#include "ModelCache.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <type_traits>
+#include "MeshOptimizer.h"
+
+
+namespace ModelCache
+{
+	constexpr uint32_t cacheMagic = 0x4C444D48;		// "HMDL"
+	constexpr uint32_t cacheFormatVersion = 1;		// NOTE: bump this whenever the layout below or the import/bake process changes
+	const std::string cacheDirectory = "res/_generated/model_cache/";
+
+	//
+	// Hashing (FNV-1a)
+	//
+	constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ULL;
+	constexpr uint64_t fnvPrime = 0x100000001b3ULL;
+
+	inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= fnvPrime;
+		}
+	}
+
+	template<typename T>
+	inline void hashValue(uint64_t& hash, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		hashBytes(hash, &value, sizeof(T));
+	}
+
+	uint64_t hashSource(const std::string& path, const std::vector<AnimationMetadata>& animationMetadatas)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return 0;
+
+		uint64_t hash = fnvOffsetBasis;
+		std::vector<char> chunk(1 << 16);
+		while (file)
+		{
+			file.read(chunk.data(), chunk.size());
+			hashBytes(hash, chunk.data(), (size_t)file.gcount());
+		}
+
+		// Everything else that changes what gets baked
+		hashValue(hash, cacheFormatVersion);
+		for (const AnimationMetadata& metadata : animationMetadatas)
+		{
+			hashBytes(hash, metadata.animationName.data(), metadata.animationName.size());
+			hashValue(hash, metadata.trackXZRootMotion);
+			hashValue(hash, metadata.timestampSpeed);
+		}
+
+		const MeshOptimizer::LODSettings lodSettings;
+		hashValue(hash, lodSettings.maxLODs);
+		hashValue(hash, lodSettings.targetReductionPerLOD);
+		hashValue(hash, lodSettings.minReductionPerLOD);
+		hashValue(hash, lodSettings.minTriangles);
+		hashValue(hash, lodSettings.maxRelativeError);
+
+		return (hash == 0) ? 1 : hash;
+	}
+
+	std::string getCachePath(const std::string& path, uint64_t sourceHash)
+	{
+		std::stringstream ss;
+		ss << cacheDirectory << std::filesystem::path(path).stem().string() << "_" << std::hex << std::setw(16) << std::setfill('0') << sourceHash << ".hmdl";
+		return ss.str();
+	}
+
+
+	//
+	// Writing
+	//
+	struct CacheWriter
+	{
+		std::ofstream& file;
+
+		template<typename T>
+		void write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			file.write((const char*)&value, sizeof(T));
+		}
+
+		template<typename T>
+		void writeVector(const std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			write((uint32_t)values.size());
+			file.write((const char*)values.data(), values.size() * sizeof(T));
+		}
+
+		void writeString(const std::string& value)
+		{
+			write((uint32_t)value.size());
+			file.write(value.data(), value.size());
+		}
+
+		void writeBoneInfos(const std::vector<BakedBoneInfo>& boneInfos)
+		{
+			write((uint32_t)boneInfos.size());
+			for (const BakedBoneInfo& boneInfo : boneInfos)
+			{
+				writeString(boneInfo.name);
+				write(boneInfo.id);
+				write(boneInfo.offset);
+			}
+		}
+	};
+
+	bool saveToFile(const std::string& cachePath, uint64_t sourceHash, const BakedModel& bakedModel)
+	{
+		std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path());
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::MODEL_CACHE::Couldn't open \"" << cachePath << "\" for writing" << std::endl;
+			return false;
+		}
+
+		CacheWriter writer = { file };
+		writer.write(cacheMagic);
+		writer.write(cacheFormatVersion);
+		writer.write(sourceHash);
+
+		//
+		// Material binding table (meshes just store an index into this)
+		//
+		std::vector<std::string> materialNames;
+		auto materialIndex = [&](const std::string& materialName) {
+			auto it = std::find(materialNames.begin(), materialNames.end(), materialName);
+			if (it != materialNames.end())
+				return (uint32_t)(it - materialNames.begin());
+			materialNames.push_back(materialName);
+			return (uint32_t)(materialNames.size() - 1);
+		};
+		for (const MeshBakedData& mesh : bakedModel.renderMeshes)
+			materialIndex(mesh.materialName);
+		for (const MeshBakedData& mesh : bakedModel.physicsMeshes)
+			materialIndex(mesh.materialName);
+
+		writer.write((uint32_t)materialNames.size());
+		for (const std::string& materialName : materialNames)
+			writer.writeString(materialName);
+
+		//
+		// Meshes
+		//
+		for (const std::vector<MeshBakedData>* meshes : { &bakedModel.renderMeshes, &bakedModel.physicsMeshes })
+		{
+			writer.write((uint32_t)meshes->size());
+			for (const MeshBakedData& mesh : *meshes)
+			{
+				writer.write(materialIndex(mesh.materialName));
+				writer.write(mesh.centerOfGravity);
+				writer.write(mesh.bounds);
+				writer.write((uint8_t)mesh.isPhysicsOnly);
+				writer.write((uint8_t)mesh.isSkinned);
+				writer.write((uint8_t)mesh.use16BitIndices);
+				writer.write(mesh.numVertices);
+				writer.write(mesh.numIndices);
+				writer.writeVector(mesh.lods);
+				writer.writeVector(mesh.vertexData);
+				writer.writeVector(mesh.indexData);
+			}
+		}
+
+		//
+		// Bones
+		//
+		writer.write(bakedModel.boneCounter);
+		writer.writeBoneInfos(bakedModel.boneInfos);
+
+		//
+		// Animations
+		//
+		writer.write((uint32_t)bakedModel.animationNameList.size());
+		for (const std::string& animationName : bakedModel.animationNameList)
+			writer.writeString(animationName);
+
+		writer.write((uint32_t)bakedModel.animations.size());
+		for (const BakedAnimation& animation : bakedModel.animations)
+		{
+			writer.writeString(animation.name);
+			writer.write(animation.duration);
+			writer.write(animation.ticksPerSecond);
+			writer.write(animation.globalRootInverseMatrix);
+
+			writer.write((uint32_t)animation.nodes.size());
+			for (const BakedNode& node : animation.nodes)
+			{
+				writer.writeString(node.name);
+				writer.write(node.transformation);
+				writer.write(node.parentIndex);
+				writer.write(node.childrenCount);
+			}
+
+			writer.write((uint32_t)animation.tracks.size());
+			for (const BakedBoneTrack& track : animation.tracks)
+			{
+				writer.writeString(track.name);
+				writer.write(track.id);
+				writer.writeVector(track.positions);
+				writer.writeVector(track.rotations);
+				writer.writeVector(track.scales);
+			}
+
+			writer.writeBoneInfos(animation.boneInfos);
+		}
+
+		if (!file)
+		{
+			std::cout << "ERROR::MODEL_CACHE::Failed writing \"" << cachePath << "\"" << std::endl;
+			file.close();
+			std::filesystem::remove(cachePath);
+			return false;
+		}
+		return true;
+	}
+
+
+	//
+	// Validation
+	//
+	bool validateMesh(const MeshBakedData& mesh, std::string& out_error)
+	{
+		const size_t vertexStride =
+			mesh.isPhysicsOnly ? sizeof(glm::vec3) :
+			mesh.isSkinned ? sizeof(SkinnedVertexQuantized) : sizeof(StaticVertexQuantized);
+		const size_t indexStride = mesh.use16BitIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+		if (mesh.isPhysicsOnly && mesh.use16BitIndices)
+		{
+			out_error = "physics mesh w/ 16 bit indices";
+			return false;
+		}
+		if (mesh.vertexData.size() != (size_t)mesh.numVertices * vertexStride ||
+			mesh.indexData.size() != (size_t)mesh.numIndices * indexStride)
+		{
+			out_error = "vertex/index data length doesn't match the count * stride";
+			return false;
+		}
+
+		for (const MeshLOD& lod : mesh.lods)
+		{
+			if ((uint64_t)lod.indexOffset + lod.indexCount > mesh.numIndices)
+			{
+				out_error = "LOD index range goes past the end of the index buffer";
+				return false;
+			}
+		}
+
+		uint32_t maxIndex = 0;
+		if (mesh.use16BitIndices)
+		{
+			const uint16_t* indices = (const uint16_t*)mesh.indexData.data();
+			for (size_t i = 0; i < mesh.numIndices; i++)
+				maxIndex = std::max(maxIndex, (uint32_t)indices[i]);
+		}
+		else
+		{
+			const uint32_t* indices = (const uint32_t*)mesh.indexData.data();
+			for (size_t i = 0; i < mesh.numIndices; i++)
+				maxIndex = std::max(maxIndex, indices[i]);
+		}
+		if (mesh.numIndices > 0 && maxIndex >= mesh.numVertices)
+		{
+			out_error = "index out of range of the vertices";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool validateNodes(const std::vector<BakedNode>& nodes, std::string& out_error)
+	{
+		// NOTE: the nodes are depth first, so every parent has to come before its children, and the
+		// children counts have to add up to exactly the nodes that point to them (see Animation::readBakedHierarchyData())
+		std::vector<int32_t> numChildrenFound(nodes.size(), 0);
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const BakedNode& node = nodes[i];
+			if (node.childrenCount < 0 || (size_t)node.childrenCount >= nodes.size())
+			{
+				out_error = "node children count out of range";
+				return false;
+			}
+
+			if (i == 0)
+			{
+				if (node.parentIndex != -1)
+				{
+					out_error = "root node has a parent";
+					return false;
+				}
+				continue;
+			}
+
+			if (node.parentIndex < 0 || (size_t)node.parentIndex >= i)
+			{
+				out_error = "node parent index out of range";
+				return false;
+			}
+			numChildrenFound[node.parentIndex]++;
+		}
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			if (numChildrenFound[i] != nodes[i].childrenCount)
+			{
+				out_error = "node children count doesn't match the hierarchy";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool validate(const BakedModel& bakedModel, std::string& out_error)
+	{
+		for (const std::vector<MeshBakedData>* meshes : { &bakedModel.renderMeshes, &bakedModel.physicsMeshes })
+			for (const MeshBakedData& mesh : *meshes)
+				if (!validateMesh(mesh, out_error))
+					return false;
+
+		for (const BakedAnimation& animation : bakedModel.animations)
+			if (!validateNodes(animation.nodes, out_error))
+				return false;
+
+		return true;
+	}
+
+
+	//
+	// Reading
+	//
+	struct CacheReader
+	{
+		std::ifstream& file;
+		size_t bytesRemaining;
+		bool ok = true;
+
+		bool readBytes(void* dest, size_t size)
+		{
+			if (!ok || size > bytesRemaining)
+			{
+				ok = false;
+				return false;
+			}
+
+			file.read((char*)dest, size);
+			bytesRemaining -= size;
+			ok = (bool)file;
+			return ok;
+		}
+
+		template<typename T>
+		bool read(T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			return readBytes(&value, sizeof(T));
+		}
+
+		// NOTE: this makes sure a corrupted count can't make a gigantic allocation. Every element takes up at least minElementSize bytes in the file
+		bool readCount(uint32_t& count, size_t minElementSize)
+		{
+			if (!read(count) || (size_t)count * minElementSize > bytesRemaining)
+			{
+				count = 0;
+				return ok = false;
+			}
+			return true;
+		}
+
+		template<typename T>
+		bool readVector(std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			uint32_t count;
+			if (!read(count) || (size_t)count * sizeof(T) > bytesRemaining)
+				return ok = false;
+
+			values.resize(count);
+			return readBytes(values.data(), count * sizeof(T));		// NOTE: this reads straight into the buffer that gets uploaded
+		}
+
+		bool readString(std::string& value)
+		{
+			uint32_t length;
+			if (!read(length) || length > bytesRemaining)
+				return ok = false;
+
+			value.resize(length);
+			return readBytes(value.data(), length);
+		}
+
+		bool readBoneInfos(std::vector<BakedBoneInfo>& boneInfos)
+		{
+			uint32_t count = 0;
+			if (!readCount(count, sizeof(uint32_t) + sizeof(int) + sizeof(glm::mat4)))
+				return false;
+
+			boneInfos.resize(count);
+			for (BakedBoneInfo& boneInfo : boneInfos)
+			{
+				readString(boneInfo.name);
+				read(boneInfo.id);
+				read(boneInfo.offset);
+			}
+			return ok;
+		}
+	};
+
+	bool loadFromFile(const std::string& cachePath, uint64_t sourceHash, BakedModel& out_bakedModel)
+	{
+		std::error_code ec;
+		const size_t fileSize = (size_t)std::filesystem::file_size(cachePath, ec);
+		if (ec)
+			return false;		// Not cached yet
+
+		std::ifstream file(cachePath, std::ios::binary);
+		if (!file)
+			return false;
+
+		CacheReader reader = { file, fileSize };
+		uint32_t magic, version;
+		uint64_t fileSourceHash;
+		if (!reader.read(magic) || !reader.read(version) || !reader.read(fileSourceHash) ||
+			magic != cacheMagic || version != cacheFormatVersion || fileSourceHash != sourceHash)
+			return false;		// Stale, so it'll just get reimported and overwritten
+
+		BakedModel bakedModel;
+
+		uint32_t numMaterials = 0;
+		reader.readCount(numMaterials, sizeof(uint32_t));
+		std::vector<std::string> materialNames(numMaterials);
+		for (std::string& materialName : materialNames)
+			reader.readString(materialName);
+
+		for (std::vector<MeshBakedData>* meshes : { &bakedModel.renderMeshes, &bakedModel.physicsMeshes })
+		{
+			uint32_t numMeshes = 0;
+			reader.readCount(numMeshes, sizeof(uint32_t) * 6);
+			meshes->resize(numMeshes);
+			for (MeshBakedData& mesh : *meshes)
+			{
+				uint32_t materialIndex;
+				uint8_t isPhysicsOnly, isSkinned, use16BitIndices;
+				reader.read(materialIndex);
+				reader.read(mesh.centerOfGravity);
+				reader.read(mesh.bounds);
+				reader.read(isPhysicsOnly);
+				reader.read(isSkinned);
+				reader.read(use16BitIndices);
+				reader.read(mesh.numVertices);
+				reader.read(mesh.numIndices);
+				reader.readVector(mesh.lods);
+				reader.readVector(mesh.vertexData);
+				reader.readVector(mesh.indexData);
+
+				if (!reader.ok || materialIndex >= materialNames.size())
+				{
+					reader.ok = false;
+					break;
+				}
+				mesh.materialName = materialNames[materialIndex];
+				mesh.isPhysicsOnly = isPhysicsOnly;
+				mesh.isSkinned = isSkinned;
+				mesh.use16BitIndices = use16BitIndices;
+			}
+		}
+
+		reader.read(bakedModel.boneCounter);
+		reader.readBoneInfos(bakedModel.boneInfos);
+
+		uint32_t numAnimationNames = 0;
+		reader.readCount(numAnimationNames, sizeof(uint32_t));
+		bakedModel.animationNameList.resize(numAnimationNames);
+		for (std::string& animationName : bakedModel.animationNameList)
+			reader.readString(animationName);
+
+		uint32_t numAnimations = 0;
+		reader.readCount(numAnimations, sizeof(uint32_t) * 4);
+		bakedModel.animations.resize(numAnimations);
+		for (BakedAnimation& animation : bakedModel.animations)
+		{
+			reader.readString(animation.name);
+			reader.read(animation.duration);
+			reader.read(animation.ticksPerSecond);
+			reader.read(animation.globalRootInverseMatrix);
+
+			uint32_t numNodes = 0;
+			reader.readCount(numNodes, sizeof(uint32_t) + sizeof(glm::mat4));
+			animation.nodes.resize(numNodes);
+			for (BakedNode& node : animation.nodes)
+			{
+				reader.readString(node.name);
+				reader.read(node.transformation);
+				reader.read(node.parentIndex);
+				reader.read(node.childrenCount);
+			}
+
+			uint32_t numTracks = 0;
+			reader.readCount(numTracks, sizeof(uint32_t) * 4);
+			animation.tracks.resize(numTracks);
+			for (BakedBoneTrack& track : animation.tracks)
+			{
+				reader.readString(track.name);
+				reader.read(track.id);
+				reader.readVector(track.positions);
+				reader.readVector(track.rotations);
+				reader.readVector(track.scales);
+			}
+
+			reader.readBoneInfos(animation.boneInfos);
+			if (!reader.ok)
+				break;
+		}
+
+		if (!reader.ok)
+		{
+			std::cout << "ERROR::MODEL_CACHE::\"" << cachePath << "\" is corrupted. Reimporting." << std::endl;
+			return false;
+		}
+
+		std::string validationError;
+		if (!validate(bakedModel, validationError))
+		{
+			std::cout << "ERROR::MODEL_CACHE::\"" << cachePath << "\" failed validation (" << validationError << "). Reimporting." << std::endl;
+			return false;
+		}
+
+		out_bakedModel = std::move(bakedModel);
+		return true;
+	}
+}
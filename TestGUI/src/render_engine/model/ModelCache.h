@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Mesh.h"
+#include "animation/Animation.h"
+
+
+//
+// Baked runtime model format. A model gets imported w/ Assimp the first time
+// (or whenever the source file changes), and then this gets written out to
+// res/_generated/model_cache/. Loading from the cache skips Assimp entirely.
+//
+struct BakedBoneInfo
+{
+	std::string name;
+	int id;
+	glm::mat4 offset;
+};
+
+struct BakedNode		// NOTE: these are stored depth first, so a node's parent always comes before it
+{
+	std::string name;
+	glm::mat4 transformation;
+	int32_t parentIndex;		// -1 for the root
+	int32_t childrenCount;
+};
+
+struct BakedBoneTrack
+{
+	std::string name;
+	int id;
+	std::vector<KeyPosition> positions;
+	std::vector<KeyRotation> rotations;
+	std::vector<KeyScale> scales;
+};
+
+struct BakedAnimation
+{
+	std::string name;
+	float duration;
+	int ticksPerSecond;
+	glm::mat4 globalRootInverseMatrix;
+	std::vector<BakedNode> nodes;
+	std::vector<BakedBoneTrack> tracks;
+	std::vector<BakedBoneInfo> boneInfos;
+};
+
+struct BakedModel
+{
+	std::vector<MeshBakedData> renderMeshes;
+	std::vector<MeshBakedData> physicsMeshes;
+	std::vector<BakedBoneInfo> boneInfos;
+	int boneCounter = 0;
+	std::vector<BakedAnimation> animations;
+	std::vector<std::string> animationNameList;
+};
+
+
+namespace ModelCache
+{
+	uint64_t hashSource(const std::string& path, const std::vector<AnimationMetadata>& animationMetadatas);		// NOTE: returns 0 if the source file couldn't be read
+	std::string getCachePath(const std::string& path, uint64_t sourceHash);
+
+	bool loadFromFile(const std::string& cachePath, uint64_t sourceHash, BakedModel& out_bakedModel);		// NOTE: returns false if the file's stale, corrupted or fails validate(). Then the model should just get reimported
+	bool validate(const BakedModel& bakedModel, std::string& out_error);		// Makes sure every size, range and index in there is in bounds before any of it gets uploaded or walked
+	bool saveToFile(const std::string& cachePath, uint64_t sourceHash, const BakedModel& bakedModel);
+}
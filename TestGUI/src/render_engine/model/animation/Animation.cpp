@@ -5,6 +5,7 @@
 #include <assimp/scene.h>
 #include <algorithm>
 #include "../Model.h"
+#include "../ModelCache.h"
 
 
 Animation::Animation(const aiScene* scene, Model* model, AnimationMetadata animationMetadata)
@@ -45,6 +46,42 @@ Animation::Animation(const aiScene* scene, Model* model, AnimationMetadata anima
 	readMissingBones(animation, *model, animationMetadata);
 }
 
+Animation::Animation(const BakedAnimation& bakedAnimation)
+{
+	name = bakedAnimation.name;
+	duration = bakedAnimation.duration;
+	ticksPerSecond = bakedAnimation.ticksPerSecond;
+	globalRootInverseMatrix = bakedAnimation.globalRootInverseMatrix;
+
+	if (!bakedAnimation.nodes.empty())
+		readBakedHierarchyData(rootNode, bakedAnimation, 0);
+
+	for (const BakedBoneTrack& track : bakedAnimation.tracks)
+		bones.insert(std::pair<std::string, Bone>(track.name, Bone(track.id, track.positions, track.rotations, track.scales)));
+
+	for (const BakedBoneInfo& boneInfo : bakedAnimation.boneInfos)
+		boneInfoMap[boneInfo.name] = { boneInfo.id, boneInfo.offset };
+}
+
+void Animation::bake(BakedAnimation& out_bakedAnimation)
+{
+	out_bakedAnimation.name = name;
+	out_bakedAnimation.duration = duration;
+	out_bakedAnimation.ticksPerSecond = ticksPerSecond;
+	out_bakedAnimation.globalRootInverseMatrix = globalRootInverseMatrix;
+
+	out_bakedAnimation.nodes.clear();
+	bakeHierarchyData(rootNode, -1, out_bakedAnimation);
+
+	out_bakedAnimation.tracks.clear();
+	for (auto& [boneName, bone] : bones)
+		out_bakedAnimation.tracks.push_back({ boneName, bone.getBoneId(), bone.getPositionKeys(), bone.getRotationKeys(), bone.getScaleKeys() });
+
+	out_bakedAnimation.boneInfos.clear();
+	for (auto& [boneName, boneInfo] : boneInfoMap)
+		out_bakedAnimation.boneInfos.push_back({ boneName, boneInfo.id, boneInfo.offset });
+}
+
 Bone* Animation::findBone(const std::string& name)
 {
 	if (bones.find(name) != bones.end())
@@ -139,3 +176,30 @@ void Animation::readHierarchyData(AssimpNodeData& dest, const aiNode* src)
 		dest.children.push_back(newData);
 	}
 }
+
+void Animation::bakeHierarchyData(const AssimpNodeData& src, int32_t parentIndex, BakedAnimation& out_bakedAnimation)
+{
+	const int32_t nodeIndex = (int32_t)out_bakedAnimation.nodes.size();
+	out_bakedAnimation.nodes.push_back({ src.name, src.transformation, parentIndex, (int32_t)src.children.size() });
+
+	for (const AssimpNodeData& child : src.children)
+		bakeHierarchyData(child, nodeIndex, out_bakedAnimation);
+}
+
+size_t Animation::readBakedHierarchyData(AssimpNodeData& dest, const BakedAnimation& bakedAnimation, size_t nodeIndex)
+{
+	const BakedNode& node = bakedAnimation.nodes[nodeIndex];
+	dest.name = node.name;
+	dest.transformation = node.transformation;
+	dest.childrenCount = node.childrenCount;
+
+	// Children come right after their parent (depth first), so just keep walking forward
+	size_t nextNodeIndex = nodeIndex + 1;
+	for (int32_t i = 0; i < node.childrenCount && nextNodeIndex < bakedAnimation.nodes.size(); i++)
+	{
+		AssimpNodeData newData;
+		nextNodeIndex = readBakedHierarchyData(newData, bakedAnimation, nextNodeIndex);
+		dest.children.push_back(newData);
+	}
+	return nextNodeIndex;
+}
@@ -3,6 +3,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <cstdint>
 #include "Bone.h"
 
 
@@ -10,6 +11,7 @@ struct aiScene;
 struct aiAnimation;
 struct aiNode;
 class Model;
+struct BakedAnimation;
 
 struct AnimatedRope;
 struct AssimpNodeData
@@ -48,6 +50,8 @@ class Animation
 public:
 	Animation() = default;
 	Animation(const aiScene* scene, Model* model, AnimationMetadata animationMetadata);
+	Animation(const BakedAnimation& bakedAnimation);
+	void bake(BakedAnimation& out_bakedAnimation);
 
 	Bone* findBone(const std::string& name);
 
@@ -61,6 +65,8 @@ public:
 private:
 	void readMissingBones(const aiAnimation* animation, Model& model, AnimationMetadata animationMetadata);
 	void readHierarchyData(AssimpNodeData& dest, const aiNode* src);
+	void bakeHierarchyData(const AssimpNodeData& src, int32_t parentIndex, BakedAnimation& out_bakedAnimation);
+	size_t readBakedHierarchyData(AssimpNodeData& dest, const BakedAnimation& bakedAnimation, size_t nodeIndex);
 
 	std::string name;
 	float duration;
@@ -1,6 +1,8 @@
 #include "Animator.h"
 
 #include <glm/gtx/quaternion.hpp>
+#include <chrono>
+#include <climits>
 #include "../../../mainloop/MainLoop.h"
 
 
@@ -8,6 +10,10 @@ Animator::Animator(std::vector<Animation>* animations, const std::vector<std::st
 {
 	playAnimation(0, 0.0f, true);
 
+	// Stagger the reduced-rate evaluations so that they don't all land on the same frame
+	static int lodStaggerIndex = 0;
+	lodFramesSinceEvaluation = (lodStaggerIndex++) % 4;
+
 	finalBoneMatrices.reserve(100);
 
 	for (unsigned int i = 0; i < 100; i++)
@@ -23,8 +29,10 @@ Animator::Animator(std::vector<Animation>* animations, const std::vector<std::st
 }
 
 
-//long long accumTime = 0;
-//size_t numCounts = 0;
+AnimationLODSettings Animator::lodSettings;
+AnimationLODStats Animator::lodStats = {};
+
+
 void Animator::updateAnimation(float deltaTime)
 {
 	deltaTime *= animationSpeed;
@@ -35,6 +43,169 @@ void Animator::updateAnimation(float deltaTime)
 		return;
 #endif
 
+	lodStats.numAnimatorsUpdated++;
+
+	//
+	// Pick the LOD off of what the renderer reported last frame
+	// NOTE: animators that never get reported (i.e. not rendered thru a RenderComponent, like the timeline viewer) stay at full rate
+	//
+	const AnimationUpdateRate prevUpdateRate = lodSelection.updateRate;
+	if (lodSettings.enabled && lodReportReceived)
+	{
+		lodFramesOffscreen = lodVisibleReport ? 0 : lodFramesOffscreen + 1;
+		lodSelection = AnimationLOD::selectLOD(lodSettings, lodVisibleReport, lodScreenSizeReport, lodFramesOffscreen, lodCastsShadowReport);
+	}
+	else
+		lodSelection = { AnimationUpdateRate::EVERY_FRAME, -1 };
+
+	lodReportReceived = false;
+	lodVisibleReport = false;
+	lodCastsShadowReport = false;
+	lodScreenSizeReport = 0.0f;
+
+	lodAccumulatedDeltaTime += deltaTime;
+	lodFramesSinceEvaluation++;
+
+	if (lodSelection.updateRate == AnimationUpdateRate::FROZEN)
+	{
+		lodStats.numFrozen++;
+		lodStats.numSkippedEvaluations++;
+		return;
+	}
+
+	//
+	// Wake up right away if coming out of being frozen, so that
+	// a stale pose doesn't get shown (or interpolated from)
+	//
+	const int updateRate = (int)lodSelection.updateRate;
+	const bool wakingUp = (prevUpdateRate == AnimationUpdateRate::FROZEN);
+	bool evaluate = wakingUp || lodFramesSinceEvaluation >= updateRate;
+	if (evaluate && !wakingUp && updateRate > 1 && lodStats.evaluationTimeMs > lodSettings.frameBudgetMs)
+	{
+		evaluate = false;
+		lodStats.numOverBudgetDeferrals++;
+	}
+
+	if (!evaluate)
+	{
+		// Interpolate in between the cached poses
+		lodStats.numSkippedEvaluations++;
+		if (!lodPoseTo.empty())
+			applyInterpolatedLODPose(glm::min(1.0f, (float)(lodFramesSinceEvaluation + 1) / (float)updateRate));
+		return;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	if (updateRate > 1 && !wakingUp && !lodPoseTo.empty())
+		decomposeLODPose(finalBoneMatrices, lodPoseFrom);		// Start from whatever was being shown
+
+	evaluateAnimation(lodAccumulatedDeltaTime);
+	lodAccumulatedDeltaTime = 0.0f;
+	lodFramesSinceEvaluation = 0;
+
+	if (updateRate > 1)
+	{
+		decomposeLODPose(finalBoneMatrices, lodPoseTo);
+		if (wakingUp || lodPoseFrom.size() != lodPoseTo.size())
+			lodPoseFrom = lodPoseTo;
+
+		applyInterpolatedLODPose(1.0f / (float)updateRate);
+	}
+	else
+	{
+		lodPoseFrom.clear();
+		lodPoseTo.clear();
+	}
+
+	lodStats.numEvaluations++;
+	lodStats.evaluationTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+
+void Animator::decomposeLODPose(const std::vector<glm::mat4>& boneMatrices, std::vector<LODBonePose>& out_pose)
+{
+	// NOTE: the bone matrices are just translate * rotate * scale, so there's no shear to worry about
+	out_pose.resize(boneMatrices.size());
+	for (size_t i = 0; i < boneMatrices.size(); i++)
+	{
+		const glm::mat4& m = boneMatrices[i];
+		LODBonePose& pose = out_pose[i];
+		pose.position = glm::vec3(m[3]);
+		pose.scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+
+		glm::mat3 rotationMatrix(
+			glm::vec3(m[0]) / glm::max(pose.scale.x, 1e-6f),
+			glm::vec3(m[1]) / glm::max(pose.scale.y, 1e-6f),
+			glm::vec3(m[2]) / glm::max(pose.scale.z, 1e-6f)
+		);
+		if (glm::determinant(rotationMatrix) < 0.0f)
+		{
+			// Mirrored. Put the flip into the scale so that the rest is a proper rotation
+			pose.scale.x = -pose.scale.x;
+			rotationMatrix[0] = -rotationMatrix[0];
+		}
+		pose.rotation = glm::normalize(glm::quat_cast(rotationMatrix));
+	}
+}
+
+void Animator::applyInterpolatedLODPose(float t)
+{
+	for (size_t i = 0; i < finalBoneMatrices.size() && i < lodPoseTo.size(); i++)
+	{
+		const LODBonePose& from = lodPoseFrom[i];
+		const LODBonePose& to = lodPoseTo[i];
+		finalBoneMatrices[i] = glm::scale(
+			glm::translate(glm::mat4(1.0f), glm::mix(from.position, to.position, t)) *
+				glm::toMat4(glm::slerp(from.rotation, to.rotation, t)),		// NOTE: glm's slerp takes the short way around
+			glm::mix(from.scale, to.scale, t)
+		);
+	}
+}
+
+
+void Animator::INTERNALreportVisibility(bool inViewFrustum, float projectedScreenSize, bool castsShadow)
+{
+	// NOTE: an animator can get reported multiple times in a frame, so just take the most visible one
+	lodReportReceived = true;
+	lodVisibleReport |= inViewFrustum;
+	lodCastsShadowReport |= castsShadow;
+	lodScreenSizeReport = glm::max(lodScreenSizeReport, projectedScreenSize);
+}
+
+
+void Animator::INTERNALresetLODStats()
+{
+	lodStats = {};
+}
+
+
+AnimationLODSelection AnimationLOD::selectLOD(const AnimationLODSettings& settings, bool visible, float projectedScreenSize, int framesOffscreen, bool castsShadow)
+{
+	if (!visible)
+	{
+		if (!castsShadow && framesOffscreen >= settings.offscreenFramesUntilFrozen)
+			return { AnimationUpdateRate::FROZEN, settings.reducedBoneDepth };
+		return { AnimationUpdateRate::EVERY_4TH_FRAME, settings.reducedBoneDepth };
+	}
+
+	AnimationLODSelection selection;
+	if (projectedScreenSize >= settings.everyFrameScreenSize)
+		selection.updateRate = AnimationUpdateRate::EVERY_FRAME;
+	else if (projectedScreenSize >= settings.every2ndFrameScreenSize)
+		selection.updateRate = AnimationUpdateRate::EVERY_2ND_FRAME;
+	else
+		selection.updateRate = AnimationUpdateRate::EVERY_4TH_FRAME;
+
+	selection.maxBoneDepth = (projectedScreenSize < settings.reducedBonesScreenSize) ? settings.reducedBoneDepth : -1;
+	return selection;
+}
+
+
+//long long accumTime = 0;
+//size_t numCounts = 0;
+void Animator::evaluateAnimation(float deltaTime)
+{
 	//auto start_time = std::chrono::high_resolution_clock::now();
 
 	//
@@ -152,7 +323,7 @@ void Animator::updateAnimation(float deltaTime)
 		float min = currentBTN[0].blendValue;
 		float max = currentBTN[1].blendValue;
 		cbti.mixValueBTCurrent =
-			glm::clamp((blendTreeVariables[currentBTN[0].blendVariableReference] - min) / (max - min), min, max);
+			glm::clamp((*currentBTN[0].INTERNALblendVariable - min) / (max - min), min, max);
 	}
 	else
 	{
@@ -176,7 +347,7 @@ void Animator::updateAnimation(float deltaTime)
 			float min = nextBTN[0].blendValue;
 			float max = nextBTN[1].blendValue;
 			cbti.mixValueBTNext =
-				glm::clamp((blendTreeVariables[nextBTN[0].blendVariableReference] - min) / (max - min), min, max);
+				glm::clamp((*nextBTN[0].INTERNALblendVariable - min) / (max - min), min, max);
 		}
 		else
 		{
@@ -191,6 +362,8 @@ void Animator::updateAnimation(float deltaTime)
 		cbti.mixValueCurrentNext = 0.0f;
 
 
+	cbti.boneDepthRemaining = (lodSelection.maxBoneDepth < 0) ? INT_MAX : lodSelection.maxBoneDepth;
+
 	calculateBoneTransform(cbti, globalRootInverseMatrix, glm::mat4(1.0f), boneInfoMap);
 
 	// @Optimize: Goal for skeletal animation is 0.01ms, however, right now it is taking 0.10ms in release mode, which is okay for now
@@ -248,6 +421,7 @@ void Animator::playBlendTree(std::vector<BlendTreeNode> blendTreeNodes, float mi
 
 		blendTreeAnims.push_back(&(*allAnimations)[blendTreeNodes[i].animationIndex]);
 
+		blendTreeNodes[i].INTERNALblendVariable = (i == 0) ? getBlendTreeVariableHandle(blendTreeNodes[i].blendVariableReference) : nullptr;
 		blendTreeNodes[i].INTERNALcurrentNodeTime = 0.0f;
 		blendTreeNodes[i].INTERNALnodeDuration = (*allAnimations)[blendTreeNodes[i].animationIndex].getDuration();
 	}
@@ -306,7 +480,17 @@ void Animator::calculateBoneTransform(CalculateBoneTransformInput input, const g
 	//
 	if (!input.btCurrent0->isCacheCreated)
 		createNodeTransformCache(input.btCurrent0, input.btCurrent0Anim, boneInfoMap);
-	if (input.btCurrent0->cacheBone)
+	AssimpNodeData* node = input.btCurrent0;
+	const bool hasHeldLocalTransform =
+		node->cacheBoneInfoExists &&
+		node->cacheBoneInfo_id < (int)lodHeldLocalTransformsValid.size() &&
+		lodHeldLocalTransformsValid[node->cacheBoneInfo_id];
+	if (input.btCurrent0->cacheBone && input.boneDepthRemaining <= 0 && hasHeldLocalTransform)
+	{
+		// Past the bone depth limit. Hold the last pose
+		nodeTransform = lodHeldLocalTransforms[node->cacheBoneInfo_id];
+	}
+	else if (input.btCurrent0->cacheBone)
 	{
 		// Calculate first blendtree
 		glm::vec3 position;
@@ -376,6 +560,17 @@ void Animator::calculateBoneTransform(CalculateBoneTransformInput input, const g
 
 		// Convert this all to matrix4x4
 		nodeTransform = glm::scale(glm::translate(glm::mat4(1.0f), position) * glm::toMat4(glm::normalize(rotation)), scale);
+
+		if (node->cacheBoneInfoExists)
+		{
+			if (node->cacheBoneInfo_id >= (int)lodHeldLocalTransforms.size())
+			{
+				lodHeldLocalTransforms.resize(node->cacheBoneInfo_id + 1);
+				lodHeldLocalTransformsValid.resize(node->cacheBoneInfo_id + 1, false);
+			}
+			lodHeldLocalTransforms[node->cacheBoneInfo_id] = nodeTransform;
+			lodHeldLocalTransformsValid[node->cacheBoneInfo_id] = true;
+		}
 	}
 
 	glm::mat4 globalTransformation = parentTransform * nodeTransform;
@@ -383,7 +578,6 @@ void Animator::calculateBoneTransform(CalculateBoneTransformInput input, const g
 	//
 	// Apply to the total transform!!!
 	//
-	AssimpNodeData* node = input.btCurrent0;
 	if (node->cacheBoneInfoExists)
 	{
 		// Populate bone matrices for shader
@@ -405,6 +599,7 @@ void Animator::calculateBoneTransform(CalculateBoneTransformInput input, const g
 	for (int i = 0; i < input.btCurrent0->childrenCount; i++)
 	{
 		CalculateBoneTransformInput nextInput = input;
+		nextInput.boneDepthRemaining = input.boneDepthRemaining - 1;
 		nextInput.btCurrent0 = &input.btCurrent0->children[i];
 		if (input.mixValueBTCurrent)
 			nextInput.btCurrent1 = &input.btCurrent1->children[i];
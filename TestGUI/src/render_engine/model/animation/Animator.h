@@ -17,11 +17,58 @@ struct BlendTreeNode
 	size_t animationIndex;
 	float blendValue;						// NOTE: undefined behavior if the mixValue's aren't sorted asc
 	std::string blendVariableReference;			// NOTE: only assign the first one, bc that's all that's used here
+	float* INTERNALblendVariable;				// Resolved from blendVariableReference in playBlendTree()
 	float INTERNALcurrentNodeTime;
 	float INTERNALnodeDuration;
 };
 
 
+//
+// Animation LOD. RenderComponent reports the visibility and projected screen size of
+// each animator during the z prepass, and then the next updateAnimation() uses that
+// to pick how often (and how many bones) to evaluate.
+//
+enum class AnimationUpdateRate
+{
+	FROZEN = 0,
+	EVERY_FRAME = 1,
+	EVERY_2ND_FRAME = 2,
+	EVERY_4TH_FRAME = 4
+};
+
+struct AnimationLODSettings
+{
+	bool enabled = true;
+	float everyFrameScreenSize = 0.2f;			// NOTE: these are fractions of the screen's height (see Model::getProjectedScreenSize())
+	float every2ndFrameScreenSize = 0.05f;
+	float reducedBonesScreenSize = 0.05f;
+	int reducedBoneDepth = 8;					// Bones deeper than this in the hierarchy don't get sampled (they hold whatever pose they had last)
+	int offscreenFramesUntilFrozen = 30;		// NOTE: animators that cast shadows never freeze, they drop to every 4th frame instead
+	float frameBudgetMs = 1.0f;					// Once this is used up, reduced-rate animators get pushed to the next frame
+};
+
+struct AnimationLODStats
+{
+	size_t numAnimatorsUpdated;
+	size_t numEvaluations;
+	size_t numSkippedEvaluations;
+	size_t numFrozen;
+	size_t numOverBudgetDeferrals;
+	float evaluationTimeMs;
+};
+
+struct AnimationLODSelection
+{
+	AnimationUpdateRate updateRate;
+	int maxBoneDepth;							// -1 is all bones
+};
+
+namespace AnimationLOD
+{
+	AnimationLODSelection selectLOD(const AnimationLODSettings& settings, bool visible, float projectedScreenSize, int framesOffscreen, bool castsShadow);
+}
+
+
 class Animator
 {
 public:
@@ -33,6 +80,7 @@ public:
 	void playBlendTree(std::vector<BlendTreeNode> blendTreeNodes, float mixTime = 0.0f, bool looping = true);		// NOTE: force=true
 
 	void setBlendTreeVariable(std::string variableName, float value);
+	inline float* getBlendTreeVariableHandle(const std::string& variableName) { return &blendTreeVariables[variableName]; }		// NOTE: std::map doesn't move its nodes around, so this pointer is good as long as the animator is alive
 
 	std::vector<glm::mat4>* getFinalBoneMatrices() { return &finalBoneMatrices; }
 
@@ -46,7 +94,42 @@ public:
 
 	float animationSpeed = 1.0f;
 
+	// Animation LOD
+	void INTERNALreportVisibility(bool inViewFrustum, float projectedScreenSize, bool castsShadow);
+	inline AnimationUpdateRate getLODUpdateRate() { return lodSelection.updateRate; }
+	static AnimationLODSettings lodSettings;
+	static AnimationLODStats lodStats;
+	static void INTERNALresetLODStats();
+
 private:
+	void evaluateAnimation(float deltaTime);
+
+	AnimationLODSelection lodSelection = { AnimationUpdateRate::EVERY_FRAME, -1 };
+	bool lodReportReceived = false;
+	bool lodVisibleReport = false;
+	bool lodCastsShadowReport = false;
+	float lodScreenSizeReport = 0.0f;
+	int lodFramesOffscreen = 0;
+	int lodFramesSinceEvaluation = 0;
+	float lodAccumulatedDeltaTime = 0.0f;
+
+	// Cached poses for interpolating in between evaluations. These are decomposed so
+	// that the rotations can get slerped (lerping the matrices shears/shrinks the bones)
+	struct LODBonePose
+	{
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+	std::vector<LODBonePose> lodPoseFrom, lodPoseTo;
+	static void decomposeLODPose(const std::vector<glm::mat4>& boneMatrices, std::vector<LODBonePose>& out_pose);
+	void applyInterpolatedLODPose(float t);
+
+	// The last evaluated local transforms, so bones past the bone depth limit keep their pose instead of snapping to rest
+	std::vector<glm::mat4> lodHeldLocalTransforms;
+	std::vector<bool> lodHeldLocalTransformsValid;
+
+
 	std::vector<glm::mat4> finalBoneMatrices;
 
 	bool currentUseBTN, nextUseBTN;
@@ -77,6 +160,8 @@ private:
 		float mixValueBTNext;
 
 		float mixValueCurrentNext;
+
+		int boneDepthRemaining;		// Bones at 0 or lower hold their last evaluated pose (see lodHeldLocalTransforms)
 	};
 
 	void calculateBoneTransform(CalculateBoneTransformInput input, const glm::mat4& globalRootInverseMatrix, const glm::mat4& parentTransform, std::map<std::string, BoneInfo>& boneInfoMap);
@@ -50,10 +50,18 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 	for (auto asmVar_j : animStateMachine["asm_variables"])
 	{
 		std::string varName = asmVar_j["var_name"];
-		variableNameIndexMap[varName] = variableNames.size();
+		size_t variableIndex = variableNames.size();
+		variableNameIndexMap[varName] = variableIndex;
 		variableNames.push_back(varName);
-		bool isTriggerVariable = (varName.rfind("trigger", 0) == 0);	// @NOTE: @HACK: @FIXME: if a variable name starts with the keyword "trigger", then mark the variable as a trigger variable (i.e. every frame where it's bool==true, turn it off after)
-		variableValues.push_back({ asmVar_j["value"], isTriggerVariable });
+
+		ASMVariableType variableType = ASMVariableType::FLOAT;
+		if (asmVar_j.contains("variable_type"))
+			variableType = (ASMVariableType)(int)asmVar_j["variable_type"];
+		variableTypes.push_back(variableType);
+		variableValues.push_back((float)asmVar_j["value"]);
+
+		if (varName.rfind("trigger", 0) == 0)		// @NOTE: @HACK: @FIXME: if a variable name starts with the keyword "trigger", then mark the variable as a trigger variable (i.e. every frame where it's bool==true, turn it off after)
+			triggerVariableIndices.push_back(variableIndex);
 	}
 
 	//
@@ -87,10 +95,12 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 		}
 
 		node.isBlendTreeAnimation = !std::string(asmNode_j["animation_name_2"]).empty();
+		node.blendTreeVariableHandle = nullptr;
 		if (node.isBlendTreeAnimation)
 		{
 			node.animationIndex2 = animNameToIndexMap[asmNode_j["animation_name_2"]];
 			node.blendTreeVariableIndex = variableNameIndexMap[asmNode_j["animation_blend_variable"]];
+			node.blendTreeVariableHandle = animatorPtr->getBlendTreeVariableHandle(variableNames[node.blendTreeVariableIndex]);
 			node.animationBlendBorder1 = asmNode_j["animation_blend_boundary_1"];
 			node.animationBlendBorder2 = asmNode_j["animation_blend_boundary_2"];
 		}
@@ -105,7 +115,15 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 
 	//
 	// String together all of the transitions
+	// @NOTE: the hsmm stores the condition groups on the node being transitioned *to*, however,
+	// the update loop wants them on the node being transitioned *from*, so gather them up in
+	// nested form first and then flatten it all into the tables at the end.
 	//
+	struct TempConditionGroup { std::vector<AnimationStateMachine_TransitionCondition> conditions; };
+	struct TempTransition { size_t toNodeIndex; std::vector<size_t> conditionGroupIndices; };
+	std::vector<TempConditionGroup> tempConditionGroups;
+	std::vector<std::vector<TempTransition>> tempTransitionsPerNode(nodeList.size());
+
 	size_t nodeIndex = 0;
 	for (auto asmNode_j : animStateMachine["asm_nodes"])
 	{
@@ -125,7 +143,7 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 					itr++;
 			}
 
-			AnimationStateMachine_TransitionConditionGroup transitionConditionGroup;
+			TempConditionGroup transitionConditionGroup;
 
 			// Bundle together all the transition conditions for the transition condition group
 			for (auto asmTranCondition_j : asmTranConditionGroup_j)
@@ -158,20 +176,39 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 					// Add a regular transition condition to this group
 					AnimationStateMachine_TransitionCondition transitionCondition;
 					transitionCondition.variableIndex = variableNameIndexMap[asmTranCondition_j["var_name"]];
-					transitionCondition.comparisonOperator = (AnimationStateMachine_TransitionCondition::ASMComparisonOperator)(int)asmTranCondition_j["comparison_operator"];
 					transitionCondition.compareToValue = asmTranCondition_j["compare_to_value"];
-					transitionConditionGroup.transitionConditions.push_back(transitionCondition);
+
+					// Compile the operator into which orderings (lesser/equal/greater) are accepted
+					switch ((AnimationStateMachine_TransitionCondition::ASMComparisonOperator)(int)asmTranCondition_j["comparison_operator"])
+					{
+					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::EQUAL:	transitionCondition.acceptedOrderingMask = 0b010; break;
+					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::NEQUAL:	transitionCondition.acceptedOrderingMask = 0b101; break;
+					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::LESSER:	transitionCondition.acceptedOrderingMask = 0b100; break;
+					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::GREATER:	transitionCondition.acceptedOrderingMask = 0b001; break;
+					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::LEQUAL:	transitionCondition.acceptedOrderingMask = 0b110; break;
+					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::GEQUAL:	transitionCondition.acceptedOrderingMask = 0b011; break;
+
+					default:
+						transitionCondition.acceptedOrderingMask = 0b000;		// Never passes
+						std::cout << "ERROR: The comparison operator doesn't exist" << std::endl;
+						break;
+					}
+
+					transitionConditionGroup.conditions.push_back(transitionCondition);
 				}
 			}
 
+			size_t conditionGroupIndex = tempConditionGroups.size();
+			tempConditionGroups.push_back(transitionConditionGroup);
+
 			// Search thru all the relevant node names and add this transition
 			for (auto relevantNodeName : relevantNodes)
 			{
-				auto& node = nodeList[nodeNameToIndexMap[relevantNodeName]];
-				
+				auto& transitions = tempTransitionsPerNode[nodeNameToIndexMap[relevantNodeName]];
+
 				// See if there are any transitions with this current node index yet.
-				AnimationStateMachine_Transition* transitionPtr = nullptr;
-				for (auto transition : node.transitions)
+				TempTransition* transitionPtr = nullptr;
+				for (auto& transition : transitions)
 				{
 					if (transition.toNodeIndex == nodeIndex)
 					{
@@ -182,18 +219,43 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 
 				if (transitionPtr == nullptr)
 				{
-					node.transitions.push_back({ nodeIndex });
-					transitionPtr = &node.transitions[node.transitions.size() - 1];
+					transitions.push_back({ nodeIndex });
+					transitionPtr = &transitions[transitions.size() - 1];
 				}
 
 				// Tack on this transition condition group!
-				transitionPtr->transitionConditionGroups.push_back(transitionConditionGroup);
+				transitionPtr->conditionGroupIndices.push_back(conditionGroupIndex);
 			}
 		}
 
 		nodeIndex++;
 	}
 
+	//
+	// Flatten into the tables
+	//
+	for (size_t i = 0; i < nodeList.size(); i++)
+	{
+		nodeList[i].transitionsStart = transitionList.size();
+		nodeList[i].transitionsCount = tempTransitionsPerNode[i].size();
+
+		for (auto& tempTransition : tempTransitionsPerNode[i])
+		{
+			AnimationStateMachine_Transition transition;
+			transition.toNodeIndex = tempTransition.toNodeIndex;
+			transition.conditionGroupsStart = transitionConditionGroupList.size();
+			transition.conditionGroupsCount = tempTransition.conditionGroupIndices.size();
+			transitionList.push_back(transition);
+
+			for (size_t conditionGroupIndex : tempTransition.conditionGroupIndices)
+			{
+				const auto& conditions = tempConditionGroups[conditionGroupIndex].conditions;
+				transitionConditionGroupList.push_back({ transitionConditionList.size(), conditions.size() });
+				transitionConditionList.insert(transitionConditionList.end(), conditions.begin(), conditions.end());
+			}
+		}
+	}
+
 	// Kick off the animation state machine
 	moveToStateMachineNode(currentASMNode);
 }
@@ -201,63 +263,39 @@ AnimatorStateMachine::AnimatorStateMachine(const std::string& asmFName, Animator
 
 void AnimatorStateMachine::updateStateMachine(float deltaTime)
 {
+	const AnimationStateMachine_Node& currentNode = nodeList[currentASMNode];
+
 	//
 	// Watch for any transition conditions
 	//
-	if (!nodeList[currentASMNode].doNotTransitionUntilAnimationFinished ||
-		animatorPtr->isAnimationFinished(nodeList[currentASMNode].animationIndex, deltaTime))
+	if (!currentNode.doNotTransitionUntilAnimationFinished ||
+		animatorPtr->isAnimationFinished(currentNode.animationIndex, deltaTime))
 	{
-		for (size_t i = 0; i < nodeList[currentASMNode].transitions.size(); i++)
+		const size_t transitionsEnd = currentNode.transitionsStart + currentNode.transitionsCount;
+		for (size_t i = currentNode.transitionsStart; i < transitionsEnd; i++)
 		{
-			const AnimationStateMachine_Transition& transition = nodeList[currentASMNode].transitions[i];
+			const AnimationStateMachine_Transition& transition = transitionList[i];
 			bool transitionPasses = false;
 
-			for (size_t j = 0; j < transition.transitionConditionGroups.size(); j++)
+			const size_t groupsEnd = transition.conditionGroupsStart + transition.conditionGroupsCount;
+			for (size_t j = transition.conditionGroupsStart; j < groupsEnd && !transitionPasses; j++)
 			{
-				const AnimationStateMachine_TransitionConditionGroup& transitionConditionGroup = transition.transitionConditionGroups[j];
+				const AnimationStateMachine_TransitionConditionGroup& transitionConditionGroup = transitionConditionGroupList[j];
 				bool transitionConditionGroupPasses = true;
 
-				for (size_t k = 0; k < transitionConditionGroup.transitionConditions.size(); k++)
+				const size_t conditionsEnd = transitionConditionGroup.conditionsStart + transitionConditionGroup.conditionsCount;
+				for (size_t k = transitionConditionGroup.conditionsStart; k < conditionsEnd; k++)
 				{
-					const AnimationStateMachine_TransitionCondition& transitionCondition = transitionConditionGroup.transitionConditions[k];
-					switch (transitionCondition.comparisonOperator)
-					{
-					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::EQUAL:
-						transitionConditionGroupPasses &= (variableValues[transitionCondition.variableIndex].value == transitionCondition.compareToValue);
-						break;
-
-					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::NEQUAL:
-						transitionConditionGroupPasses &= (variableValues[transitionCondition.variableIndex].value != transitionCondition.compareToValue);
-						break;
-
-					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::LESSER:
-						transitionConditionGroupPasses &= (variableValues[transitionCondition.variableIndex].value < transitionCondition.compareToValue);
-						break;
-
-					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::GREATER:
-						transitionConditionGroupPasses &= (variableValues[transitionCondition.variableIndex].value > transitionCondition.compareToValue);
-						break;
-
-					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::LEQUAL:
-						transitionConditionGroupPasses &= (variableValues[transitionCondition.variableIndex].value <= transitionCondition.compareToValue);
-						break;
-
-					case AnimationStateMachine_TransitionCondition::ASMComparisonOperator::GEQUAL:
-						transitionConditionGroupPasses &= (variableValues[transitionCondition.variableIndex].value >= transitionCondition.compareToValue);
-						break;
-					
-					default:
-						transitionConditionGroupPasses &= false;
-						std::cout << "ERROR: The comparison operator doesn't exist" << std::endl;
-						break;
-					}
+					const AnimationStateMachine_TransitionCondition& transitionCondition = transitionConditionList[k];
+					const float value = variableValues[transitionCondition.variableIndex];
+					const uint8_t ordering =
+						((uint8_t)(value < transitionCondition.compareToValue) << 2) |
+						((uint8_t)(value == transitionCondition.compareToValue) << 1) |
+						(uint8_t)(value > transitionCondition.compareToValue);
+					transitionConditionGroupPasses &= ((ordering & transitionCondition.acceptedOrderingMask) != 0);
 				}
 
-				if (transitionConditionGroupPasses)
-				{
- 					transitionPasses = true;
-					break;
-				}
+				transitionPasses = transitionConditionGroupPasses;
 			}
 
 			if (transitionPasses)
@@ -274,28 +312,47 @@ void AnimatorStateMachine::updateStateMachine(float deltaTime)
 		// Reset all trigger variables
 		// @NOTE: only do the reset when variables are considered
 		//
-		for (auto& variable : variableValues)
-		{
-			if (variable.isTriggerVariable)
-				variable.value = false;
-		}
+		for (size_t triggerIndex : triggerVariableIndices)
+			variableValues[triggerIndex] = 0.0f;
 	}
 
 	//
 	// Update the internal animator
 	//
-	if (nodeList[currentASMNode].isBlendTreeAnimation)
-	{
-		size_t variableIndex = nodeList[currentASMNode].blendTreeVariableIndex;
-		animatorPtr->setBlendTreeVariable(variableNames[variableIndex], variableValues[variableIndex].value);
-	}
+	const AnimationStateMachine_Node& node = nodeList[currentASMNode];
+	if (node.isBlendTreeAnimation)
+		*node.blendTreeVariableHandle = variableValues[node.blendTreeVariableIndex];
 	animatorPtr->updateAnimation(deltaTime);
 }
 
 
 void AnimatorStateMachine::setVariable(const std::string& varName, float value)
 {
-	variableValues[variableNameIndexMap[varName]].value = value;		// Hopefully this doesn't crash...
+	auto it = variableNameIndexMap.find(varName);
+	if (it == variableNameIndexMap.end())
+	{
+		std::cout << "ASM: ERROR: Variable \"" << varName << "\" doesn't exist" << std::endl;
+		return;
+	}
+	variableValues[it->second] = value;
+}
+
+
+size_t AnimatorStateMachine::findVariableIndex(const std::string& varName, ASMVariableType expectedType)
+{
+	auto it = variableNameIndexMap.find(varName);
+	if (it == variableNameIndexMap.end())
+	{
+		std::cout << "ASM: ERROR: Variable \"" << varName << "\" doesn't exist (handle will be invalid)" << std::endl;
+		return (size_t)-1;
+	}
+
+#ifdef _DEVELOP
+	if (variableTypes[it->second] != expectedType)
+		std::cout << "ASM: WARNING: Variable \"" << varName << "\" was resolved as a different type than it was declared as" << std::endl;
+#endif
+
+	return it->second;
 }
 
 
@@ -3,10 +3,17 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <cstdint>
+#include <type_traits>
 
 class Animator;
 
 
+//
+// @NOTE: the ASM gets compiled at load time into flat tables. Each level (nodes -> transitions -> groups -> conditions)
+// just stores a start index and a count into the next table down, so updating is just array walking (no string
+// lookups, no nested vectors).
+//
 struct AnimationStateMachine_TransitionCondition
 {
 	size_t variableIndex;
@@ -19,16 +26,19 @@ struct AnimationStateMachine_TransitionCondition
 		GREATER,
 		LEQUAL,
 		GEQUAL
-	} comparisonOperator;
+	};
+	uint8_t acceptedOrderingMask;		// Compiled from the ASMComparisonOperator. Bits are { 0b100: LESSER, 0b010: EQUAL, 0b001: GREATER }
 };
 struct AnimationStateMachine_TransitionConditionGroup
 {
-	std::vector<AnimationStateMachine_TransitionCondition> transitionConditions;
+	size_t conditionsStart;
+	size_t conditionsCount;
 };
 struct AnimationStateMachine_Transition		// NOTE: the specialCaseCurrentASMNodeName isn't included here bc the transition list is connected to all of the nodes in such a way that it's not needed  -Timo
 {
 	size_t toNodeIndex;
-	std::vector<AnimationStateMachine_TransitionConditionGroup> transitionConditionGroups;
+	size_t conditionGroupsStart;
+	size_t conditionGroupsCount;
 };
 
 
@@ -42,6 +52,7 @@ struct AnimationStateMachine_Node		// The node index will be what index it's sto
 	bool isBlendTreeAnimation;
 	size_t animationIndex2;
 	size_t blendTreeVariableIndex;
+	float* blendTreeVariableHandle;		// Points into the animator's blend tree variable, so that it can get set w/o a string lookup
 	float animationBlendBorder1;
 	float animationBlendBorder2;
 
@@ -49,21 +60,35 @@ struct AnimationStateMachine_Node		// The node index will be what index it's sto
 	bool doNotTransitionUntilAnimationFinished;
 	float transitionTime;		// It's here for now... it may be necessary to move this to the _Transition struct depending on how the data should get structured.
 
-	std::vector<AnimationStateMachine_Transition> transitions;
+	size_t transitionsStart;
+	size_t transitionsCount;
 };
 
-struct AnimationStateMachine_Variable
+
+enum class ASMVariableType
+{
+	BOOL,
+	INT,
+	FLOAT
+};
+
+//
+// Resolve one of these once (after loading in the ASM) and then use
+// it to set the variable every frame without any string hashing.
+//
+template<typename T>
+struct ASMVariableHandle
 {
-	float value;
-	bool isTriggerVariable;		// @NOTE: this is set to true if variable name starts with the name "trigger"
+	size_t variableIndex = (size_t)-1;
+	inline bool isValid() const { return variableIndex != (size_t)-1; }
 };
 
 
 /**
  * @brief I guess this is what you call a Decorator Class
- * 
+ *
  * It decorates the Animator class and allows you to load in a .hsmm file that contains Animator State Machine information.
- * 
+ *
  */
 class AnimatorStateMachine
 {
@@ -72,19 +97,54 @@ public:
 	AnimatorStateMachine(const std::string& asmFName, Animator* animator);
 	void updateStateMachine(float deltaTime);
 
+	template<typename T>
+	ASMVariableHandle<T> getVariableHandle(const std::string& varName);
+
+	inline void setVariable(ASMVariableHandle<bool> handle, bool value) { setVariableByIndex(handle.variableIndex, (float)value); }
+	inline void setVariable(ASMVariableHandle<int> handle, int value) { setVariableByIndex(handle.variableIndex, (float)value); }
+	inline void setVariable(ASMVariableHandle<float> handle, float value) { setVariableByIndex(handle.variableIndex, value); }
+
+	// @NOTE: these do a string lookup every call. Prefer the handle versions for anything that gets called every frame.
 	inline void setVariable(const std::string& varName, bool value) { setVariable(varName, (float)value); }
 	inline void setVariable(const std::string& varName, int value) { setVariable(varName, (float)value); }
 	void setVariable(const std::string& varName, float value);
 
 private:
 	void moveToStateMachineNode(size_t nodeIndex);
+	size_t findVariableIndex(const std::string& varName, ASMVariableType expectedType);
+
+	inline void setVariableByIndex(size_t variableIndex, float value)
+	{
+		if (variableIndex < variableValues.size())
+			variableValues[variableIndex] = value;
+	}
 
 	Animator* animatorPtr;
 
-	std::map<std::string, size_t> variableNameIndexMap;		// Populates in the constructor!
-	std::vector<std::string> variableNames;						// Hopefully this is fast eh!
-	std::vector<AnimationStateMachine_Variable> variableValues;						// Hopefully this is fast eh!
+	std::map<std::string, size_t> variableNameIndexMap;		// Only used for resolving handles (and the string setVariable())
+	std::vector<std::string> variableNames;
+	std::vector<ASMVariableType> variableTypes;
+	std::vector<float> variableValues;						// The variable slots
+	std::vector<size_t> triggerVariableIndices;				// @NOTE: these are variables whose names start with the name "trigger"
 
 	size_t currentASMNode;
 	std::vector<AnimationStateMachine_Node> nodeList;
+	std::vector<AnimationStateMachine_Transition> transitionList;
+	std::vector<AnimationStateMachine_TransitionConditionGroup> transitionConditionGroupList;
+	std::vector<AnimationStateMachine_TransitionCondition> transitionConditionList;
 };
+
+
+template<typename T>
+inline ASMVariableHandle<T> AnimatorStateMachine::getVariableHandle(const std::string& varName)
+{
+	ASMVariableType expectedType = ASMVariableType::FLOAT;
+	if constexpr (std::is_same_v<T, bool>)
+		expectedType = ASMVariableType::BOOL;
+	else if constexpr (std::is_same_v<T, int>)
+		expectedType = ASMVariableType::INT;
+
+	ASMVariableHandle<T> handle;
+	handle.variableIndex = findVariableIndex(varName, expectedType);
+	return handle;
+}
@@ -42,6 +42,15 @@ Bone::Bone(int id, const aiNodeAnim* channel) : id(id)
 }
 
 
+Bone::Bone(int id, const std::vector<KeyPosition>& positions, const std::vector<KeyRotation>& rotations, const std::vector<KeyScale>& scales) :
+	positions(positions), rotations(rotations), scales(scales), id(id)
+{
+	numPositions = (unsigned int)positions.size();
+	numRotations = (unsigned int)rotations.size();
+	numScales = (unsigned int)scales.size();
+}
+
+
 void Bone::update(float animationTime, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale)
 {
 	translation =	interpolatePosition(animationTime);
@@ -39,10 +39,14 @@ private:
 public:
 	Bone() : id(-1) {}
 	Bone(int id, const aiNodeAnim* channel);
+	Bone(int id, const std::vector<KeyPosition>& positions, const std::vector<KeyRotation>& rotations, const std::vector<KeyScale>& scales);		// NOTE: for loading from the model cache
 	
 	void update(float animationTime, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale);
 
 	int getBoneId() { return id; }
+	const std::vector<KeyPosition>& getPositionKeys() const { return positions; }
+	const std::vector<KeyRotation>& getRotationKeys() const { return rotations; }
+	const std::vector<KeyScale>& getScaleKeys() const { return scales; }
 
 	int getPositionIndex(float animationTime);
 	int getRotationIndex(float animationTime);
@@ -0,0 +1,129 @@
+#include "CascadeScheduler.h"
+
+#include <algorithm>
+#include "../model/Mesh.h"
+
+
+CascadeSchedulerSettings CascadeScheduler::settings;
+CascadeSchedulerStats CascadeScheduler::stats;
+
+void CascadeScheduler::INTERNALresetStats()
+{
+	stats = {};
+}
+
+void CascadeScheduler::reset()
+{
+	cascadeMatrices.clear();
+	framesSinceRender.clear();
+	staleCascadeMask = 0;
+	isValid = false;
+}
+
+uint32_t CascadeScheduler::schedule(const std::vector<glm::mat4>& freshMatrices, const glm::vec3& lightDirection, const std::vector<RenderAABB>& changedCasterBounds)
+{
+	const uint32_t numCascades = (uint32_t)freshMatrices.size();
+	const uint32_t allCascadesMask = (numCascades >= 32) ? ~0u : ((1u << numCascades) - 1);
+
+	//
+	// Everything gets re-rendered if there's nothing to reuse, or if the light turned
+	//
+	const float lightDirectionChangeCos = glm::cos(glm::radians(settings.maxLightDirectionChangeDegrees));
+	const bool lightDirectionChanged = glm::dot(glm::normalize(lightDirection), renderedLightDirection) < lightDirectionChangeCos;
+	if (!settings.enabled || !isValid || cascadeMatrices.size() != freshMatrices.size() || lightDirectionChanged)
+	{
+		cascadeMatrices = freshMatrices;
+		framesSinceRender.assign(numCascades, 0);
+		renderedLightDirection = glm::normalize(lightDirection);
+		staleCascadeMask = 0;
+		isValid = true;
+
+		stats.numCascadesRendered += numCascades;
+		return allCascadesMask;
+	}
+
+	uint32_t renderMask = 0;
+	std::vector<uint32_t> staggerCandidates;
+	for (uint32_t i = 0; i < numCascades; i++)
+	{
+		framesSinceRender[i]++;
+
+		if (i < settings.numCascadesEveryFrame)
+		{
+			renderMask |= (1u << i);
+			continue;
+		}
+
+		// NOTE: the caster's old spot counts too, since its old shadow has to get erased. The
+		// changed bounds have both (see RenderComponent::submitShadowCasterChanges())
+		bool casterChanged = false;
+		for (const RenderAABB& bounds : changedCasterBounds)
+		{
+			if (isAABBInCascade(bounds, cascadeMatrices[i]) || isAABBInCascade(bounds, freshMatrices[i]))
+			{
+				casterChanged = true;
+				break;
+			}
+		}
+		if (casterChanged)
+		{
+			renderMask |= (1u << i);
+			stats.numCasterInvalidations++;
+			continue;
+		}
+
+		// NOTE: w/ STABLE_FIT_CSM_SHADOWS the matrix only changes when the texel snapped origin moves
+		const bool fitChanged = (cascadeMatrices[i] != freshMatrices[i]);
+		const uint32_t interval = fitChanged ? settings.farCascadeUpdateInterval : settings.farCascadeRefreshInterval;
+		if (framesSinceRender[i] >= interval)
+			staggerCandidates.push_back(i);
+	}
+
+	// Stalest ones first, so the far cascades take turns
+	std::stable_sort(staggerCandidates.begin(), staggerCandidates.end(), [&](uint32_t a, uint32_t b) { return framesSinceRender[a] > framesSinceRender[b]; });
+	for (size_t i = 0; i < staggerCandidates.size() && i < settings.maxStaggeredCascadesPerFrame; i++)
+		renderMask |= (1u << staggerCandidates[i]);
+
+	//
+	// Take the new fit for the ones that get rendered. The rest keep what they got rendered with
+	//
+	staleCascadeMask = 0;
+	for (uint32_t i = 0; i < numCascades; i++)
+	{
+		if (renderMask & (1u << i))
+		{
+			cascadeMatrices[i] = freshMatrices[i];
+			framesSinceRender[i] = 0;
+			stats.numCascadesRendered++;
+			continue;
+		}
+
+		stats.numCascadesCached++;
+		if (cascadeMatrices[i] != freshMatrices[i])
+		{
+			staleCascadeMask |= (1u << i);
+			stats.numCascadesStale++;
+		}
+	}
+
+	return renderMask;
+}
+
+bool CascadeScheduler::isAABBInCascade(const RenderAABB& worldBounds, const glm::mat4& cascadeMatrix)
+{
+	// NOTE: same clip test as ShadowLayerPass::getLayerMask(), and the near plane doesn't cull (depth clamping)
+	uint32_t outsideAll = 0x1F;
+	for (int i = 0; i < 8; i++)
+	{
+		const glm::vec3 sign((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+		const glm::vec4 clip = cascadeMatrix * glm::vec4(worldBounds.center + worldBounds.extents * sign, 1.0f);
+		uint32_t outside = 0;
+		if (clip.x < -clip.w) outside |= 0x01;
+		if (clip.x >  clip.w) outside |= 0x02;
+		if (clip.y < -clip.w) outside |= 0x04;
+		if (clip.y >  clip.w) outside |= 0x08;
+		if (clip.z >  clip.w) outside |= 0x10;
+		outsideAll &= outside;
+	}
+	return outsideAll == 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct RenderAABB;
+
+
+struct CascadeSchedulerSettings
+{
+	bool enabled = true;
+	uint32_t numCascadesEveryFrame = 2;			// The near cascades. These always get re-rendered
+	uint32_t farCascadeUpdateInterval = 4;		// Frames. A far cascade that the camera moved away from gets re-rendered at most this often
+	uint32_t farCascadeRefreshInterval = 32;	// Frames. Even if nothing moved, a far cascade gets re-rendered this often (picks up animated casters)
+	uint32_t maxStaggeredCascadesPerFrame = 1;	// How many far cascades can get re-rendered on the interval in one frame. Caster/light changes don't count toward this
+	float maxLightDirectionChangeDegrees = 0.1f;
+};
+
+struct CascadeSchedulerStats
+{
+	size_t numCascadesRendered;
+	size_t numCascadesCached;
+	size_t numCascadesStale;			// Cached and the camera's moved since, so the shader has to check if it's still covered
+	size_t numCasterInvalidations;		// Cached cascades that had to re-render bc a shadow caster moved in them
+};
+
+
+//
+// Decides which CSM cascades need to get re-rendered this frame. The near cascades
+// update every frame. The far ones barely change frame to frame, so they keep their
+// shadow map (and the light matrix it got rendered with) until:
+//		- the light direction changes,
+//		- a shadow caster moves inside of it,
+//		- or it's its turn on the stagger (when its fit has changed, or every so often anyways)
+//
+// A cached cascade whose fit isn't the same as this frame's is "stale". Its shadow is
+// still correct, it just might not cover all of its slice of the view frustum anymore,
+// so the shader checks those and falls back to the next cascade (see getStaleCascadeMask())
+//
+// NOTE: there's no GL in here. The light does the rendering w/ the mask from schedule()
+//
+class CascadeScheduler
+{
+public:
+	void reset();		// NOTE: call whenever the shadow map gets recreated
+	uint32_t schedule(const std::vector<glm::mat4>& freshMatrices, const glm::vec3& lightDirection, const std::vector<RenderAABB>& changedCasterBounds);		// Returns the cascades to render as a bitmask
+
+	inline const std::vector<glm::mat4>& getCascadeMatrices() const { return cascadeMatrices; }
+	inline uint32_t getStaleCascadeMask() const { return staleCascadeMask; }
+
+	static CascadeSchedulerSettings settings;
+	static CascadeSchedulerStats stats;
+	static void INTERNALresetStats();
+
+private:
+	static bool isAABBInCascade(const RenderAABB& worldBounds, const glm::mat4& cascadeMatrix);
+
+	std::vector<glm::mat4> cascadeMatrices;		// What the cached shadow maps were rendered with
+	std::vector<uint32_t> framesSinceRender;
+	glm::vec3 renderedLightDirection = glm::vec3(0.0f);
+	uint32_t staleCascadeMask = 0;
+	bool isValid = false;
+};
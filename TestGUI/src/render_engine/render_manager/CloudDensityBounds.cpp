@@ -0,0 +1,45 @@
+#include "CloudDensityBounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void CloudDensityBounds::generate(const uint8_t* noiseRGBA, uint32_t noiseSize, uint32_t cellSize, std::vector<uint8_t>& out_bounds)
+{
+	const uint32_t boundsSize = noiseSize / cellSize;
+	out_bounds.assign((size_t)boundsSize * boundsSize * boundsSize, 0);
+
+	// Weight every texel once up front, since each one gets looked at by a few cells
+	std::vector<float> weightedDensities((size_t)noiseSize * noiseSize * noiseSize);
+	for (size_t i = 0; i < weightedDensities.size(); i++)
+		weightedDensities[i] = getWeightedDensity(&noiseRGBA[i * 4]);
+
+	auto wrap = [noiseSize](int64_t coord) { return (uint32_t)(((coord % noiseSize) + noiseSize) % noiseSize); };
+
+	for (uint32_t cz = 0; cz < boundsSize; cz++)
+	for (uint32_t cy = 0; cy < boundsSize; cy++)
+	for (uint32_t cx = 0; cx < boundsSize; cx++)
+	{
+		// NOTE: the noise gets sampled w/ GL_LINEAR, so a point inside of the cell can
+		// pull from 1 texel past either side of it. GL_REPEAT makes those wrap around.
+		float maxDensity = 0.0f;
+		for (int64_t z = (int64_t)(cz * cellSize) - 1; z <= (int64_t)((cz + 1) * cellSize); z++)
+		for (int64_t y = (int64_t)(cy * cellSize) - 1; y <= (int64_t)((cy + 1) * cellSize); y++)
+		for (int64_t x = (int64_t)(cx * cellSize) - 1; x <= (int64_t)((cx + 1) * cellSize); x++)
+		{
+			const size_t index = ((size_t)wrap(z) * noiseSize + wrap(y)) * noiseSize + wrap(x);
+			maxDensity = std::max(maxDensity, weightedDensities[index]);
+		}
+
+		out_bounds[((size_t)cz * boundsSize + cy) * boundsSize + cx] = (uint8_t)std::min(255.0f, std::ceil(maxDensity * 255.0f));
+	}
+}
+
+float CloudDensityBounds::getWeightedDensity(const uint8_t* texel)
+{
+	return
+		(0.5333333f * texel[0]
+		+ 0.2666667f * texel[1]
+		+ 0.1333333f * texel[2]
+		+ 0.0666667f * texel[3]) / 255.0f;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+
+//
+// Makes a low res volume that holds the max density the base cloud noise (cloudNoise1)
+// can give anywhere inside of each cell. The cloud raymarcher checks it before sampling
+// the noise, and if even the max can't pass densityRequirement it jumps to the end of
+// the cell instead of stepping thru it.
+//
+// The max is of the weighted RGBA sum that sampleDensityAtPoint() in
+// cloud_effect_screenspace.frag uses, before the detail noise, density offset,
+// multiplier and height falloff. Those all get applied to the bound in the shader,
+// so the volume doesn't need to be regenerated when the cloud settings change.
+//
+// NOTE: there's no GL in here, so it can be checked against the noise data headless.
+//
+class CloudDensityBounds
+{
+public:
+	// noiseRGBA is noiseSize^3 RGBA8 texels, x fastest then y then z (what glGetTextureImage() gives).
+	// out_bounds is (noiseSize / cellSize)^3 R8 texels, w/ the max rounded up so it stays a bound.
+	static void generate(const uint8_t* noiseRGBA, uint32_t noiseSize, uint32_t cellSize, std::vector<uint8_t>& out_bounds);
+
+	static float getWeightedDensity(const uint8_t* texel);		// 0-1. Same weights as the shader
+};
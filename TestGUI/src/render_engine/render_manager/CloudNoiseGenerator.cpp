@@ -0,0 +1,297 @@
+#include "CloudNoiseGenerator.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+#include <type_traits>
+
+
+namespace CloudNoiseGenerator
+{
+	constexpr uint32_t cacheMagic = 0x4E444C43;		// "CLDN"
+	constexpr uint32_t cacheFormatVersion = 1;		// NOTE: bump this whenever the layout below or the noise itself changes
+	const std::string cacheDirectory = "res/_generated/cloud_noise/";
+
+	// The octaves' weights when they get added together into a channel (same as the old cloud_noise_fractal.frag)
+	constexpr float octaveWeights[CloudNoiseVolumeParams::NUM_OCTAVES] = { 0.5333333f, 0.2666667f, 0.1333333f };
+
+	//
+	// Hashing (FNV-1a)		@Copypasta: ModelCache
+	//
+	constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ULL;
+	constexpr uint64_t fnvPrime = 0x100000001b3ULL;
+
+	inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= fnvPrime;
+		}
+	}
+
+	template<typename T>
+	inline void hashValue(uint64_t& hash, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		hashBytes(hash, &value, sizeof(T));
+	}
+
+	uint64_t hashParams(const CloudNoiseVolumeParams& params)
+	{
+		uint64_t hash = fnvOffsetBasis;
+		hashValue(hash, cacheFormatVersion);
+		hashValue(hash, params.size);
+		hashValue(hash, params.numChannels);
+		for (uint32_t channel = 0; channel < params.numChannels; channel++)
+			for (uint32_t octave = 0; octave < CloudNoiseVolumeParams::NUM_OCTAVES; octave++)
+				hashValue(hash, params.octaveGridSizes[channel][octave]);
+		hashValue(hash, params.seed);
+		return (hash == 0) ? 1 : hash;
+	}
+
+	std::string getCachePath(const std::string& name, uint64_t paramsHash)
+	{
+		std::stringstream ss;
+		ss << cacheDirectory << name << "_" << std::hex << std::setw(16) << std::setfill('0') << paramsHash << ".cldn";
+		return ss.str();
+	}
+
+
+	//
+	// Feature points
+	//
+	// NOTE: splitmix64 instead of std::mt19937 + std::uniform_real_distribution, since
+	// the distributions aren't guaranteed to give the same numbers on every standard library
+	inline uint64_t splitmix64(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	inline float randomFloat01(uint64_t& state)
+	{
+		return (float)(splitmix64(state) >> 40) * (1.0f / 16777216.0f);		// Top 24 bits, so it's exact as a float
+	}
+
+	struct OctaveGrid
+	{
+		uint32_t gridSize;
+		std::vector<float> pointsX, pointsY, pointsZ;		// Offset inside of each cell (0-1). Indexed (z * gridSize + y) * gridSize + x
+		std::vector<float> texelPositions;					// Texel centers in cells
+		std::vector<uint32_t> firstTexelInCell;				// gridSize + 1 of these, so [firstTexelInCell[c], firstTexelInCell[c + 1]) are the texels in cell c
+	};
+
+	void buildOctaveGrid(const CloudNoiseVolumeParams& params, uint32_t channel, uint32_t octave, OctaveGrid& out_grid)
+	{
+		const uint32_t gridSize = std::max(1u, params.octaveGridSizes[channel][octave]);
+		const size_t numCells = (size_t)gridSize * gridSize * gridSize;
+
+		out_grid.gridSize = gridSize;
+		out_grid.pointsX.resize(numCells);
+		out_grid.pointsY.resize(numCells);
+		out_grid.pointsZ.resize(numCells);
+
+		uint64_t state = ((uint64_t)params.seed << 32) ^ ((uint64_t)channel << 8) ^ (uint64_t)octave;
+		for (size_t i = 0; i < numCells; i++)
+		{
+			out_grid.pointsX[i] = randomFloat01(state);
+			out_grid.pointsY[i] = randomFloat01(state);
+			out_grid.pointsZ[i] = randomFloat01(state);
+		}
+
+		out_grid.texelPositions.resize(params.size);
+		for (uint32_t t = 0; t < params.size; t++)
+			out_grid.texelPositions[t] = ((float)t + 0.5f) / (float)params.size * (float)gridSize;
+
+		out_grid.firstTexelInCell.assign(gridSize + 1, params.size);
+		for (uint32_t t = params.size; t > 0; t--)
+		{
+			const uint32_t cell = std::min((uint32_t)out_grid.texelPositions[t - 1], gridSize - 1);
+			out_grid.firstTexelInCell[cell] = t - 1;
+		}
+		for (uint32_t c = gridSize; c > 0; c--)		// Empty cells (more cells than texels) start where the next one does
+			out_grid.firstTexelInCell[c - 1] = std::min(out_grid.firstTexelInCell[c - 1], out_grid.firstTexelInCell[c]);
+	}
+
+	inline int32_t wrapCell(int32_t cell, int32_t gridSize)
+	{
+		return ((cell % gridSize) + gridSize) % gridSize;
+	}
+
+	//
+	// One row of texels (along x) of one octave. scratch needs to be size long
+	//
+	void worleyRow(const OctaveGrid& grid, uint32_t size, uint32_t y, uint32_t z, std::vector<float>& scratch, uint8_t* out_octaveRow)
+	{
+		const int32_t gridSize = (int32_t)grid.gridSize;
+		const float positionY = ((float)y + 0.5f) / (float)size * (float)gridSize;
+		const float positionZ = ((float)z + 0.5f) / (float)size * (float)gridSize;
+		const int32_t cellY = std::min((int32_t)positionY, gridSize - 1);
+		const int32_t cellZ = std::min((int32_t)positionZ, gridSize - 1);
+
+		// NOTE: anything past 0.8 of a cell comes out as 0, so 1.0 is plenty far
+		float* minDistanceSqr = scratch.data();
+		std::fill(scratch.begin(), scratch.begin() + size, 1.0f);
+		const float* texelPositions = grid.texelPositions.data();
+
+		for (int32_t unwrappedZ = cellZ - 1; unwrappedZ <= cellZ + 1; unwrappedZ++)
+		for (int32_t unwrappedY = cellY - 1; unwrappedY <= cellY + 1; unwrappedY++)
+		{
+			const size_t cellRowIndex = ((size_t)wrapCell(unwrappedZ, gridSize) * gridSize + wrapCell(unwrappedY, gridSize)) * gridSize;
+
+			// The cells just outside of the row on each end are the wrapped around ones
+			for (int32_t unwrappedX = -1; unwrappedX <= gridSize; unwrappedX++)
+			{
+				const size_t cellIndex = cellRowIndex + wrapCell(unwrappedX, gridSize);
+				const float deltaY = positionY - ((float)unwrappedY + grid.pointsY[cellIndex]);
+				const float deltaZ = positionZ - ((float)unwrappedZ + grid.pointsZ[cellIndex]);
+				const float deltaYZSqr = deltaY * deltaY + deltaZ * deltaZ;
+				if (deltaYZSqr >= 1.0f)
+					continue;
+
+				// Only the texels in the cells right next to this point can have it as their closest
+				const float pointX = (float)unwrappedX + grid.pointsX[cellIndex];
+				const uint32_t firstTexel = grid.firstTexelInCell[std::clamp(unwrappedX - 1, 0, gridSize)];
+				const uint32_t lastTexel = grid.firstTexelInCell[std::clamp(unwrappedX + 2, 0, gridSize)];
+
+				// @NOTE: no branches and everything's contiguous in here, so this loop is what the compiler vectorizes
+				for (uint32_t t = firstTexel; t < lastTexel; t++)
+				{
+					const float deltaX = texelPositions[t] - pointX;
+					minDistanceSqr[t] = std::min(minDistanceSqr[t], deltaX * deltaX + deltaYZSqr);
+				}
+			}
+		}
+
+		for (uint32_t t = 0; t < size; t++)
+		{
+			const float value = 1.0f - std::clamp(std::sqrt(minDistanceSqr[t]) * 1.25f, 0.0f, 1.0f);
+			out_octaveRow[t] = (uint8_t)std::lround(value * 255.0f);		// NOTE: the octaves were 8 bit textures before, so they still get rounded like they were
+		}
+	}
+
+	void generate(const CloudNoiseVolumeParams& params, std::vector<uint8_t>& out_texels, uint32_t numWorkerThreads)
+	{
+		const uint32_t size = params.size;
+		const uint32_t numChannels = std::min(params.numChannels, CloudNoiseVolumeParams::MAX_CHANNELS);
+		out_texels.assign((size_t)size * size * size * numChannels, 0);
+		if (size == 0 || numChannels == 0)
+			return;
+
+		std::vector<OctaveGrid> grids(numChannels * CloudNoiseVolumeParams::NUM_OCTAVES);
+		for (uint32_t channel = 0; channel < numChannels; channel++)
+			for (uint32_t octave = 0; octave < CloudNoiseVolumeParams::NUM_OCTAVES; octave++)
+				buildOctaveGrid(params, channel, octave, grids[channel * CloudNoiseVolumeParams::NUM_OCTAVES + octave]);
+
+		// Each worker takes every n'th z slice. The slices don't depend on each other, so the output's the same no matter how many workers there are
+		if (numWorkerThreads == 0)
+			numWorkerThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 16u);
+		numWorkerThreads = std::min(numWorkerThreads, size);
+
+		auto work = [&](uint32_t workerIndex)
+		{
+			std::vector<float> scratch(size);
+			std::vector<uint8_t> octaveRows(CloudNoiseVolumeParams::NUM_OCTAVES * size);
+
+			for (uint32_t z = workerIndex; z < size; z += numWorkerThreads)
+			for (uint32_t y = 0; y < size; y++)
+			for (uint32_t channel = 0; channel < numChannels; channel++)
+			{
+				for (uint32_t octave = 0; octave < CloudNoiseVolumeParams::NUM_OCTAVES; octave++)
+					worleyRow(grids[channel * CloudNoiseVolumeParams::NUM_OCTAVES + octave], size, y, z, scratch, &octaveRows[octave * size]);
+
+				uint8_t* outRow = &out_texels[(((size_t)z * size + y) * size) * numChannels];
+				for (uint32_t x = 0; x < size; x++)
+				{
+					float value = 0.0f;
+					for (uint32_t octave = 0; octave < CloudNoiseVolumeParams::NUM_OCTAVES; octave++)
+						value += octaveWeights[octave] * ((float)octaveRows[octave * size + x] / 255.0f);
+					outRow[x * numChannels + channel] = (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (uint32_t i = 1; i < numWorkerThreads; i++)
+			workers.push_back(std::thread(work, i));
+		work(0);
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+
+	//
+	// Cache file (one binary volume per set of params)
+	//
+	struct CacheHeader
+	{
+		uint32_t magic;
+		uint32_t formatVersion;
+		uint64_t paramsHash;
+		uint32_t size;
+		uint32_t numChannels;
+		uint64_t numBytes;
+	};
+
+	bool loadFromFile(const std::string& cachePath, uint64_t paramsHash, const CloudNoiseVolumeParams& params, std::vector<uint8_t>& out_texels)
+	{
+		std::ifstream file(cachePath, std::ios::binary);
+		if (!file)
+			return false;
+
+		CacheHeader header;
+		file.read((char*)&header, sizeof(header));
+		const uint64_t expectedNumBytes = (uint64_t)params.size * params.size * params.size * params.numChannels;
+		if (!file ||
+			header.magic != cacheMagic ||
+			header.formatVersion != cacheFormatVersion ||
+			header.paramsHash != paramsHash ||
+			header.size != params.size ||
+			header.numChannels != params.numChannels ||
+			header.numBytes != expectedNumBytes)
+		{
+			std::cout << "ERROR::CLOUD_NOISE_CACHE::\"" << cachePath << "\" doesn't match the noise params" << std::endl;
+			return false;
+		}
+
+		out_texels.resize((size_t)header.numBytes);
+		file.read((char*)out_texels.data(), out_texels.size());
+		if ((uint64_t)file.gcount() != header.numBytes)
+		{
+			std::cout << "ERROR::CLOUD_NOISE_CACHE::\"" << cachePath << "\" is cut short" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool saveToFile(const std::string& cachePath, uint64_t paramsHash, const CloudNoiseVolumeParams& params, const std::vector<uint8_t>& texels)
+	{
+		std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path());
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::CLOUD_NOISE_CACHE::Couldn't open \"" << cachePath << "\" for writing" << std::endl;
+			return false;
+		}
+
+		CacheHeader header = {};
+		header.magic = cacheMagic;
+		header.formatVersion = cacheFormatVersion;
+		header.paramsHash = paramsHash;
+		header.size = params.size;
+		header.numChannels = params.numChannels;
+		header.numBytes = texels.size();
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)texels.data(), texels.size());
+		return (bool)file;
+	}
+}
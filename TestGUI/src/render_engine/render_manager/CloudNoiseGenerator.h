@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+//
+// Tileable 3D worley noise for the clouds, made on the CPU. Every channel is 3 octaves
+// of worley noise (weighted and added together, same as the old cloud_noise_fractal.frag),
+// and each octave gets one feature point per grid cell. The points come from hashing
+// the seed and the cell, so there's no limit on how many there are (the old GPU
+// generator only had room for 1024 of them in a UBO) and the output is the same
+// every time for the same params.
+//
+// The closest point search only looks at the neighboring cells. Anything farther than
+// 0.8 of a cell gets clamped to 0 anyways, so it comes out the same as checking every point
+// (TestGUI/tests/CloudNoiseGeneratorTests.cpp checks it against a brute force search).
+//
+// NOTE: the feature points aren't the ones the old GPU generator picked, so the noise
+// looks the same but isn't byte for byte what was in the old PNGs.
+//
+struct CloudNoiseVolumeParams
+{
+	static constexpr uint32_t MAX_CHANNELS = 4;
+	static constexpr uint32_t NUM_OCTAVES = 3;
+
+	uint32_t size = 0;						// The volume is size^3
+	uint32_t numChannels = 0;
+	uint32_t octaveGridSizes[MAX_CHANNELS][NUM_OCTAVES] = {};
+	uint32_t seed = 0;
+};
+
+
+namespace CloudNoiseGenerator
+{
+	// out_texels is size^3 * numChannels bytes, interleaved, x fastest then y then z
+	// (what glTextureSubImage3D() wants). NOTE: numWorkerThreads of 0 picks from the core count
+	void generate(const CloudNoiseVolumeParams& params, std::vector<uint8_t>& out_texels, uint32_t numWorkerThreads = 0);
+
+	uint64_t hashParams(const CloudNoiseVolumeParams& params);
+	std::string getCachePath(const std::string& name, uint64_t paramsHash);
+
+	bool loadFromFile(const std::string& cachePath, uint64_t paramsHash, const CloudNoiseVolumeParams& params, std::vector<uint8_t>& out_texels);
+	bool saveToFile(const std::string& cachePath, uint64_t paramsHash, const CloudNoiseVolumeParams& params, const std::vector<uint8_t>& texels);
+}
@@ -0,0 +1,350 @@
+#include "DebugDraw.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <iostream>
+#include "../material/Shader.h"
+#include "../resources/Resources.h"
+
+
+DebugDraw& DebugDraw::getInstance()
+{
+	static DebugDraw instance;
+	return instance;
+}
+
+void DebugDraw::initialize()
+{
+	renderThreadId = std::this_thread::get_id();
+	createBuffer();
+}
+
+void DebugDraw::cleanup()
+{
+	destroyBuffer();
+
+	{
+		std::lock_guard<std::mutex> lock(retainedMutex);
+		retainedPrimitives.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(stagingMutex);
+	stagingLineVertices.clear();
+	stagingTriangleVertices.clear();
+}
+
+void DebugDraw::createBuffer()
+{
+	const size_t regionSize = (size_t)lineVertexCapacity + (size_t)triangleVertexCapacity;
+	const GLsizeiptr bufferSize = (GLsizeiptr)(regionSize * NUM_REGIONS * sizeof(Vertex));
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glCreateBuffers(1, &vertexBuffer);
+	glNamedBufferStorage(vertexBuffer, bufferSize, nullptr, flags);
+	mappedVertices = (Vertex*)glMapNamedBufferRange(vertexBuffer, 0, bufferSize, flags);
+	if (mappedVertices == nullptr)
+		std::cout << "ERROR::DEBUGDRAW::BUFFER::FAILED_TO_MAP" << std::endl;
+
+	for (uint32_t i = 0; i < NUM_REGIONS; i++)
+	{
+		Region& region = regions[i];
+		region.lineVertices = mappedVertices + i * regionSize;
+		region.triangleVertices = region.lineVertices + lineVertexCapacity;
+		region.numLineVertices = 0;
+		region.numTriangleVertices = 0;
+		region.fence = nullptr;
+	}
+	currentRegionIndex = 0;
+	currentRegion.store(&regions[0], std::memory_order_release);
+
+	glCreateVertexArrays(1, &vertexArray);
+	glVertexArrayVertexBuffer(vertexArray, 0, vertexBuffer, 0, sizeof(Vertex));
+
+	glEnableVertexArrayAttrib(vertexArray, 0);
+	glVertexArrayAttribFormat(vertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+	glVertexArrayAttribBinding(vertexArray, 0, 0);
+
+	glEnableVertexArrayAttrib(vertexArray, 1);
+	glVertexArrayAttribFormat(vertexArray, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color));		// NOTE: ImU32 is RGBA in memory, so this just works
+	glVertexArrayAttribBinding(vertexArray, 1, 0);
+
+	glEnableVertexArrayAttrib(vertexArray, 2);
+	glVertexArrayAttribIFormat(vertexArray, 2, 1, GL_UNSIGNED_INT, offsetof(Vertex, depthTest));
+	glVertexArrayAttribBinding(vertexArray, 2, 0);
+}
+
+void DebugDraw::destroyBuffer()
+{
+	currentRegion.store(nullptr, std::memory_order_release);
+
+	for (uint32_t i = 0; i < NUM_REGIONS; i++)
+	{
+		if (regions[i].fence != nullptr)
+			glDeleteSync(regions[i].fence);
+		regions[i].fence = nullptr;
+	}
+
+	// NOTE: GL holds onto the buffer until any draws still using it are done, so no need to wait on the fences
+	if (vertexBuffer != 0)
+	{
+		glUnmapNamedBuffer(vertexBuffer);
+		glDeleteBuffers(1, &vertexBuffer);
+	}
+	if (vertexArray != 0)
+		glDeleteVertexArrays(1, &vertexArray);
+	vertexBuffer = 0;
+	vertexArray = 0;
+	mappedVertices = nullptr;
+}
+
+void DebugDraw::emit(const Vertex* vertices, uint32_t numVertices, bool isTriangle)
+{
+	if (std::this_thread::get_id() == renderThreadId)
+	{
+		emitToRegion(vertices, numVertices, isTriangle);
+		return;
+	}
+
+	// Not on the render thread, so beginFrame() could be growing the buffer right now. Wait for render() to copy it in
+	std::lock_guard<std::mutex> lock(stagingMutex);
+	std::vector<Vertex>& staging = isTriangle ? stagingTriangleVertices : stagingLineVertices;
+	staging.insert(staging.end(), vertices, vertices + numVertices);
+}
+
+void DebugDraw::emitToRegion(const Vertex* vertices, uint32_t numVertices, bool isTriangle)
+{
+	Region* region = currentRegion.load(std::memory_order_acquire);
+	if (region == nullptr)
+		return;
+
+	//
+	// Reserve the space in the region.
+	// NOTE: the count keeps going past the capacity on purpose, so beginFrame() knows how much it needs to grow.
+	// Lines are always 2 and triangles 3 (and the capacities are multiples of those), so a
+	// primitive can never end up half inside the region.
+	//
+	std::atomic<uint32_t>& count = isTriangle ? region->numTriangleVertices : region->numLineVertices;
+	const uint32_t capacity = isTriangle ? triangleVertexCapacity : lineVertexCapacity;
+	const uint32_t first = count.fetch_add(numVertices, std::memory_order_relaxed);
+	if (first + numVertices > capacity)
+	{
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Vertex* dest = (isTriangle ? region->triangleVertices : region->lineVertices) + first;
+	memcpy(dest, vertices, sizeof(Vertex) * numVertices);
+}
+
+void DebugDraw::flushStaging()
+{
+	// NOTE: a primitive at a time, so the drop count and the growth work the same as adding from the render thread.
+	// The vectors keep their capacity, so after the first couple frames there's no allocating here either
+	std::lock_guard<std::mutex> lock(stagingMutex);
+	for (size_t i = 0; i + 1 < stagingLineVertices.size(); i += 2)
+		emitToRegion(&stagingLineVertices[i], 2, false);
+	for (size_t i = 0; i + 2 < stagingTriangleVertices.size(); i += 3)
+		emitToRegion(&stagingTriangleVertices[i], 3, true);
+	stagingLineVertices.clear();
+	stagingTriangleVertices.clear();
+}
+
+void DebugDraw::addLine(const glm::vec3& point1, const glm::vec3& point2, uint32_t color, float duration, bool depthTest)
+{
+	const Vertex vertices[] = {
+		{ point1, color, (uint32_t)depthTest },
+		{ point2, color, (uint32_t)depthTest },
+	};
+	emit(vertices, 2, false);
+
+	if (duration > 0.0f)
+	{
+		RetainedPrimitive retained = {};
+		memcpy(retained.vertices, vertices, sizeof(vertices));
+		retained.isTriangle = false;
+		retained.timeLeft = duration;
+
+		std::lock_guard<std::mutex> lock(retainedMutex);
+		retainedPrimitives.push_back(retained);
+	}
+}
+
+void DebugDraw::addTriangle(const glm::vec3& point1, const glm::vec3& point2, const glm::vec3& point3, uint32_t color, float duration, bool depthTest)
+{
+	const Vertex vertices[] = {
+		{ point1, color, (uint32_t)depthTest },
+		{ point2, color, (uint32_t)depthTest },
+		{ point3, color, (uint32_t)depthTest },
+	};
+	emit(vertices, 3, true);
+
+	if (duration > 0.0f)
+	{
+		RetainedPrimitive retained = {};
+		memcpy(retained.vertices, vertices, sizeof(vertices));
+		retained.isTriangle = true;
+		retained.timeLeft = duration;
+
+		std::lock_guard<std::mutex> lock(retainedMutex);
+		retainedPrimitives.push_back(retained);
+	}
+}
+
+void DebugDraw::addAABB(const glm::vec3& minPoint, const glm::vec3& maxPoint, uint32_t color, float duration, bool depthTest)
+{
+	const glm::vec3 center = (minPoint + maxPoint) * 0.5f;
+	addBox(glm::translate(glm::mat4(1.0f), center), maxPoint - center, color, duration, depthTest);
+}
+
+void DebugDraw::addBox(const glm::mat4& modelMatrix, const glm::vec3& halfExtents, uint32_t color, float duration, bool depthTest)
+{
+	glm::vec3 corners[8];
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const glm::vec3 sign(
+			(i & 1) ? 1.0f : -1.0f,
+			(i & 2) ? 1.0f : -1.0f,
+			(i & 4) ? 1.0f : -1.0f
+		);
+		corners[i] = glm::vec3(modelMatrix * glm::vec4(sign * halfExtents, 1.0f));
+	}
+
+	// The 12 edges (each corner connects to the ones that are off by a single bit)
+	const uint32_t edges[12][2] = {
+		{0, 1}, {2, 3}, {4, 5}, {6, 7},
+		{0, 2}, {1, 3}, {4, 6}, {5, 7},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7},
+	};
+	for (uint32_t i = 0; i < 12; i++)
+		addLine(corners[edges[i][0]], corners[edges[i][1]], color, duration, depthTest);
+}
+
+void DebugDraw::addPolyline(const glm::vec3* points, size_t numPoints, bool closed, uint32_t color, float duration, bool depthTest)
+{
+	if (numPoints < 2)
+		return;
+
+	for (size_t i = 0; i + 1 < numPoints; i++)
+		addLine(points[i], points[i + 1], color, duration, depthTest);
+	if (closed && numPoints > 2)
+		addLine(points[numPoints - 1], points[0], color, duration, depthTest);
+}
+
+void DebugDraw::beginFrame(float unscaledDeltaTime)
+{
+	if (vertexBuffer == 0)
+		return;
+
+	//
+	// Grow the buffer if stuff got dropped last frame
+	// NOTE: the counts on the last region are how much actually got asked for, even past the capacity
+	//
+	const size_t dropped = numDropped.exchange(0, std::memory_order_relaxed);
+	stats.numDropped = dropped;
+	if (dropped > 0)
+	{
+		const Region& previous = regions[currentRegionIndex];
+		const uint32_t neededLineVertices = previous.numLineVertices.load(std::memory_order_relaxed);
+		const uint32_t neededTriangleVertices = previous.numTriangleVertices.load(std::memory_order_relaxed);
+
+		// Double until it fits (and keep them multiples of 2 and 3)
+		while (lineVertexCapacity < neededLineVertices)
+			lineVertexCapacity *= 2;
+		while (triangleVertexCapacity < neededTriangleVertices)
+			triangleVertexCapacity *= 2;
+
+		destroyBuffer();
+		createBuffer();
+	}
+	else
+	{
+		//
+		// Move onto the next region. Have to wait on the GPU to be done w/ it from NUM_REGIONS frames ago before writing into it.
+		//
+		currentRegionIndex = (currentRegionIndex + 1) % NUM_REGIONS;
+		Region& region = regions[currentRegionIndex];
+		if (region.fence != nullptr)
+		{
+			glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);		// 1 sec timeout
+			glDeleteSync(region.fence);
+			region.fence = nullptr;
+		}
+		region.numLineVertices = 0;
+		region.numTriangleVertices = 0;
+		currentRegion.store(&region, std::memory_order_release);
+	}
+
+	//
+	// Put back in everything that still has time left
+	//
+	std::lock_guard<std::mutex> lock(retainedMutex);
+	for (size_t i = 0; i < retainedPrimitives.size();)
+	{
+		RetainedPrimitive& retained = retainedPrimitives[i];
+		retained.timeLeft -= unscaledDeltaTime;
+		if (retained.timeLeft <= 0.0f)
+		{
+			// Swap n pop
+			retainedPrimitives[i] = retainedPrimitives.back();
+			retainedPrimitives.pop_back();
+			continue;
+		}
+
+		emitToRegion(retained.vertices, retained.isTriangle ? 3 : 2, retained.isTriangle);
+		i++;
+	}
+	stats.numRetained = retainedPrimitives.size();
+}
+
+void DebugDraw::render(float screenWidth, float screenHeight, float zNear, float zFar)
+{
+	Region* region = currentRegion.load(std::memory_order_acquire);
+	if (region == nullptr)
+		return;
+
+	flushStaging();
+
+	const uint32_t numLineVertices = std::min(region->numLineVertices.load(std::memory_order_relaxed), lineVertexCapacity);
+	const uint32_t numTriangleVertices = std::min(region->numTriangleVertices.load(std::memory_order_relaxed), triangleVertexCapacity);
+	stats.numLines = numLineVertices / 2;
+	stats.numTriangles = numTriangleVertices / 3;
+	stats.lineCapacity = lineVertexCapacity / 2;
+	stats.triangleCapacity = triangleVertexCapacity / 3;
+
+	if (enabled && (numLineVertices > 0 || numTriangleVertices > 0))
+	{
+		if (debugDrawShader == nullptr)
+			debugDrawShader = (Shader*)Resources::getResource("shader;debugDraw");
+
+		//
+		// NOTE: the depth test happens in the shader against the z prepass, so the
+		// depth tested and the always-on-top stuff can go in the same draw.
+		//
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		debugDrawShader->use();
+		debugDrawShader->setVec2("invFullResolution", { 1.0f / screenWidth, 1.0f / screenHeight });
+		debugDrawShader->setFloat("zNear", zNear);
+		debugDrawShader->setFloat("zFar", zFar);
+
+		glBindVertexArray(vertexArray);
+		if (numTriangleVertices > 0)
+			glDrawArrays(GL_TRIANGLES, (GLint)(region->triangleVertices - mappedVertices), (GLsizei)numTriangleVertices);
+		if (numLineVertices > 0)
+			glDrawArrays(GL_LINES, (GLint)(region->lineVertices - mappedVertices), (GLsizei)numLineVertices);
+		glBindVertexArray(0);
+
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	// So that beginFrame() knows when the GPU is done w/ this region
+	if (region->fence != nullptr)
+		glDeleteSync(region->fence);
+	region->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
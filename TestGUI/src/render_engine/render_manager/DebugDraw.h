@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+
+typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
+class Shader;
+
+
+//
+// Debug lines and triangles for everything (physx visualization, bounds, colliders,
+// paths, etc.). Anything can add to it from any thread, and it all gets drawn at the
+// end of the frame w/ one draw for the lines and one for the triangles.
+//
+// The vertices go straight into a persistently mapped buffer that's split up into
+// one region per frame in flight (w/ a fence on each), so nothing gets allocated
+// or uploaded while adding. If a region fills up, the rest of the frame's
+// primitives get dropped and the buffer grows at the start of the next frame.
+//
+// NOTE: only the render thread writes into the mapped buffer, since beginFrame() can
+// swap it out for a bigger one. Adds from other threads go into a locked staging queue
+// on the CPU instead, and render() copies them in.
+//
+// NOTE: colors are ImU32 (IM_COL32()), so A is the high byte and R is the low byte.
+// duration is in seconds. 0 means only this frame. depthTest off draws it over everything.
+//
+class DebugDraw
+{
+public:
+	static DebugDraw& getInstance();
+
+	void initialize();		// NOTE: the GL context needs to be there. Whichever thread calls this is the render thread
+	void cleanup();
+
+	void addLine(const glm::vec3& point1, const glm::vec3& point2, uint32_t color, float duration = 0.0f, bool depthTest = true);
+	void addTriangle(const glm::vec3& point1, const glm::vec3& point2, const glm::vec3& point3, uint32_t color, float duration = 0.0f, bool depthTest = true);
+	void addAABB(const glm::vec3& minPoint, const glm::vec3& maxPoint, uint32_t color, float duration = 0.0f, bool depthTest = true);
+	void addBox(const glm::mat4& modelMatrix, const glm::vec3& halfExtents, uint32_t color, float duration = 0.0f, bool depthTest = true);
+	void addPolyline(const glm::vec3* points, size_t numPoints, bool closed, uint32_t color, float duration = 0.0f, bool depthTest = true);
+
+	// Render thread only
+	void beginFrame(float unscaledDeltaTime);		// Moves onto the next region and puts in everything that's still got duration left (NOTE: durations are real time, not scaled w/ timeScale)
+	void render(float screenWidth, float screenHeight, float zNear, float zFar);		// NOTE: uses the camera UBO and the z prepass (ShaderExtZBuffer)
+
+	bool enabled = true;
+
+	struct Stats
+	{
+		size_t numLines;
+		size_t numTriangles;
+		size_t numRetained;				// Still have duration left
+		size_t numDropped;				// Didn't fit this frame
+		size_t lineCapacity;
+		size_t triangleCapacity;
+	} stats = {};
+
+private:
+	DebugDraw() = default;
+
+	struct Vertex
+	{
+		glm::vec3 position;
+		uint32_t color;
+		uint32_t depthTest;
+	};
+
+	static constexpr uint32_t NUM_REGIONS = 3;		// Frames in flight
+	struct Region
+	{
+		Vertex* lineVertices;
+		Vertex* triangleVertices;
+		std::atomic<uint32_t> numLineVertices;
+		std::atomic<uint32_t> numTriangleVertices;
+		GLsync fence;
+	};
+	Region regions[NUM_REGIONS];
+	std::atomic<Region*> currentRegion = nullptr;
+	uint32_t currentRegionIndex = 0;
+	std::atomic<size_t> numDropped = 0;
+
+	// NOTE: in vertices, per region
+	uint32_t lineVertexCapacity = 2 * 16384;
+	uint32_t triangleVertexCapacity = 3 * 4096;
+
+	GLuint vertexBuffer = 0;
+	GLuint vertexArray = 0;
+	Vertex* mappedVertices = nullptr;
+	Shader* debugDrawShader = nullptr;
+
+	void createBuffer();
+	void destroyBuffer();
+	void emit(const Vertex* vertices, uint32_t numVertices, bool isTriangle);
+	void emitToRegion(const Vertex* vertices, uint32_t numVertices, bool isTriangle);		// Render thread only
+	void flushStaging();
+
+	std::thread::id renderThreadId;
+	std::mutex stagingMutex;
+	std::vector<Vertex> stagingLineVertices;
+	std::vector<Vertex> stagingTriangleVertices;
+
+	struct RetainedPrimitive
+	{
+		Vertex vertices[3];
+		bool isTriangle;
+		float timeLeft;
+	};
+	std::mutex retainedMutex;
+	std::vector<RetainedPrimitive> retainedPrimitives;
+};
@@ -0,0 +1,136 @@
+#include "DynamicResolution.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+
+//
+// DynamicResolutionController
+//
+void DynamicResolutionController::reset(float renderScale)
+{
+	DynamicResolutionController::renderScale = std::clamp(renderScale, settings.minRenderScale, settings.maxRenderScale);
+	smoothedFrameTimeMs = 0.0f;
+	hasSample = false;
+	framesOverTarget = 0;
+	framesUnderTarget = 0;
+	cooldownFramesLeft = 0;
+}
+
+bool DynamicResolutionController::update(float gpuFrameTimeMs)
+{
+	// Turned off means native resolution
+	if (!settings.enabled)
+	{
+		const bool changed = (renderScale != 1.0f);
+		renderScale = 1.0f;
+		hasSample = false;
+		return changed;
+	}
+
+	smoothedFrameTimeMs = hasSample ? smoothedFrameTimeMs + (gpuFrameTimeMs - smoothedFrameTimeMs) * settings.smoothing : gpuFrameTimeMs;
+	hasSample = true;
+
+	if (cooldownFramesLeft > 0)
+	{
+		cooldownFramesLeft--;
+		return false;
+	}
+
+	framesOverTarget = (smoothedFrameTimeMs > settings.targetFrameTimeMs * settings.decreaseThreshold) ? framesOverTarget + 1 : 0;
+	framesUnderTarget = (smoothedFrameTimeMs < settings.targetFrameTimeMs * settings.increaseThreshold) ? framesUnderTarget + 1 : 0;
+
+	float newRenderScale = renderScale;
+	if (framesOverTarget >= settings.framesBeforeChange)
+	{
+		const float idealScale = renderScale * std::sqrt(settings.targetFrameTimeMs / std::max(smoothedFrameTimeMs, 0.001f));
+		newRenderScale = std::min(snapScale(idealScale), renderScale - settings.scaleStep);
+	}
+	else if (framesUnderTarget >= settings.framesBeforeChange)
+		newRenderScale = renderScale + settings.scaleStep;
+	else
+	{
+		// Pull back into the bounds if the settings changed
+		newRenderScale = std::clamp(renderScale, settings.minRenderScale, settings.maxRenderScale);
+	}
+
+	newRenderScale = std::clamp(snapScale(newRenderScale), settings.minRenderScale, settings.maxRenderScale);
+	if (std::abs(newRenderScale - renderScale) < 0.001f)
+		return false;
+
+	// The smoothed time was w/ the old scale, so guess what it'll be now
+	smoothedFrameTimeMs *= (newRenderScale * newRenderScale) / (renderScale * renderScale);
+
+	renderScale = newRenderScale;
+	framesOverTarget = 0;
+	framesUnderTarget = 0;
+	cooldownFramesLeft = settings.cooldownFrames;
+	return true;
+}
+
+float DynamicResolutionController::snapScale(float scale) const
+{
+	if (settings.scaleStep <= 0.0f)
+		return scale;
+	return std::round(scale / settings.scaleStep) * settings.scaleStep;
+}
+
+
+//
+// GPUFrameTimer
+//
+GPUFrameTimer::~GPUFrameTimer()
+{
+	if (isCreated)
+		glDeleteQueries(NUM_FRAMES_IN_FLIGHT * 2, &queries[0][0]);
+}
+
+void GPUFrameTimer::begin()
+{
+	if (!isCreated)
+	{
+		glGenQueries(NUM_FRAMES_IN_FLIGHT * 2, &queries[0][0]);
+		isCreated = true;
+	}
+
+	// Ring's full and nothing's come back. Skip timing this frame instead of touching the pending ones
+	isTimingFrame = (numPending < NUM_FRAMES_IN_FLIGHT);
+	if (!isTimingFrame)
+		return;
+
+	glQueryCounter(queries[writeIndex][0], GL_TIMESTAMP);
+}
+
+void GPUFrameTimer::end()
+{
+	if (!isCreated || !isTimingFrame)
+		return;
+	isTimingFrame = false;
+
+	glQueryCounter(queries[writeIndex][1], GL_TIMESTAMP);
+	writeIndex = (writeIndex + 1) % NUM_FRAMES_IN_FLIGHT;
+	numPending++;
+}
+
+bool GPUFrameTimer::getLatestFrameTimeMs(float& out_frameTimeMs)
+{
+	bool gotResult = false;
+	while (numPending > 0)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(queries[readIndex][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 beginTime, endTime;
+		glGetQueryObjectui64v(queries[readIndex][0], GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(queries[readIndex][1], GL_QUERY_RESULT, &endTime);
+		out_frameTimeMs = (float)((double)(endTime - beginTime) / 1000000.0);
+		gotResult = true;
+
+		readIndex = (readIndex + 1) % NUM_FRAMES_IN_FLIGHT;
+		numPending--;
+	}
+	return gotResult;
+}
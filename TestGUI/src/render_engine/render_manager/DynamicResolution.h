@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+typedef unsigned int GLuint;
+
+
+struct DynamicResolutionSettings
+{
+	bool enabled = false;					// @NOTE: opt in. It's still pretty new, and the upscale softens things a bit
+	float targetFrameTimeMs = 16.6f;
+	float minRenderScale = 0.5f;
+	float maxRenderScale = 1.0f;
+	float scaleStep = 0.05f;				// Scales get snapped to this, so the buffers don't get recreated for tiny changes
+	float smoothing = 0.1f;					// How much of the newest frame time goes into the running average
+	float decreaseThreshold = 1.05f;		// The smoothed frame time has to be over target * this to scale down...
+	float increaseThreshold = 0.85f;		// ...and under target * this to scale up
+	uint32_t framesBeforeChange = 8;		// Has to stay over/under for this many frames in a row
+	uint32_t cooldownFrames = 30;			// Frames to wait after a change (the timer is a few frames behind, and the new buffers need a sec)
+};
+
+
+//
+// Picks the internal render scale from the GPU frame time. Going down jumps straight
+// to the scale that should hit the target (GPU cost goes w/ the pixel count, so the
+// scale squared). Going up only goes one step at a time so it doesn't overshoot and
+// bounce back down.
+//
+// NOTE: there's no GL in here, so it can be fed made up timings headless.
+//
+class DynamicResolutionController
+{
+public:
+	void reset(float renderScale = 1.0f);
+	bool update(float gpuFrameTimeMs);		// Returns true if the render scale changed
+
+	inline float getRenderScale() const { return renderScale; }
+	inline float getSmoothedFrameTimeMs() const { return smoothedFrameTimeMs; }
+
+	DynamicResolutionSettings settings;
+
+private:
+	float snapScale(float scale) const;
+
+	float renderScale = 1.0f;
+	float smoothedFrameTimeMs = 0.0f;
+	bool hasSample = false;
+	uint32_t framesOverTarget = 0;
+	uint32_t framesUnderTarget = 0;
+	uint32_t cooldownFramesLeft = 0;
+};
+
+
+//
+// GPU time between begin() and end() w/ timestamp queries. The results get read
+// a few frames later when they're ready, so this never stalls.
+//
+// NOTE: if all of the queries are still in flight, that frame just doesn't get timed.
+// Reusing a query that hasn't come back yet would either stall or throw away a result
+// that's almost done.
+//
+class GPUFrameTimer
+{
+public:
+	~GPUFrameTimer();
+
+	void begin();
+	void end();
+	bool getLatestFrameTimeMs(float& out_frameTimeMs);		// False if nothing new has finished
+
+private:
+	static constexpr uint32_t NUM_FRAMES_IN_FLIGHT = 4;
+
+	GLuint queries[NUM_FRAMES_IN_FLIGHT][2] = {};
+	uint32_t writeIndex = 0;
+	uint32_t readIndex = 0;
+	uint32_t numPending = 0;
+	bool isCreated = false;
+	bool isTimingFrame = false;			// False if begin() had to skip this frame
+};
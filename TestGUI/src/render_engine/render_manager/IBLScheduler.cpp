@@ -0,0 +1,83 @@
+#include "IBLScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+IBLSchedulerSettings IBLScheduler::settings;
+IBLSchedulerStats IBLScheduler::stats;
+
+void IBLScheduler::INTERNALresetStats()
+{
+	stats = {};
+}
+
+void IBLScheduler::reset(uint32_t numPrefilterMips)
+{
+	IBLScheduler::numPrefilterMips = numPrefilterMips;
+	jobNextFace = 0;
+	isJobRunning = false;
+	isValid = false;
+}
+
+IBLUpdate IBLScheduler::schedule(const IBLMixParams& freshParams)
+{
+	IBLUpdate update;
+
+	//
+	// Nothing to show yet (or the scheduling's off), so everything gets mixed right now
+	//
+	if (!settings.enabled || !isValid)
+	{
+		update.firstFace = 0;
+		update.numFaces = getNumFaces();
+		update.swapAfter = true;
+		update.params = freshParams;
+
+		frontParams = freshParams;
+		isJobRunning = false;
+		isValid = true;
+
+		stats.numFaceRenders += update.numFaces;
+		stats.numSwaps++;
+		return update;
+	}
+
+	if (!isJobRunning)
+	{
+		if (!hasChangedEnough(freshParams))
+			return update;
+
+		// NOTE: the params stay the same until the job's done, even if the sun keeps moving
+		jobParams = freshParams;
+		jobNextFace = 0;
+		isJobRunning = true;
+	}
+
+	update.firstFace = jobNextFace;
+	update.numFaces = std::min(std::max(settings.maxFaceRendersPerFrame, 1u), getNumFaces() - jobNextFace);
+	update.params = jobParams;
+	jobNextFace += update.numFaces;
+
+	if (jobNextFace >= getNumFaces())
+	{
+		update.swapAfter = true;
+		frontParams = jobParams;
+		isJobRunning = false;
+		stats.numSwaps++;
+	}
+
+	stats.numFaceRenders += update.numFaces;
+	return update;
+}
+
+bool IBLScheduler::hasChangedEnough(const IBLMixParams& freshParams) const
+{
+	if (freshParams.whichMap != frontParams.whichMap)
+		return true;
+	if (std::abs(freshParams.mapInterpolationAmt - frontParams.mapInterpolationAmt) >= settings.minInterpolationChange)
+		return true;
+
+	const float sunSpinChangeCos = glm::cos(glm::radians(settings.minSunSpinChangeDegrees));
+	return glm::dot(freshParams.flatSunOrientation, frontParams.flatSunOrientation) < sunSpinChangeCos;
+}
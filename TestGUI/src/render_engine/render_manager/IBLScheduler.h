@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+
+struct IBLSchedulerSettings
+{
+	bool enabled = true;
+	uint32_t maxFaceRendersPerFrame = 6;		// Irradiance faces and prefilter faces (any mip) all count as one
+	float minInterpolationChange = 0.005f;		// mapInterpolationAmt has to move this much to start a re-mix...
+	float minSunSpinChangeDegrees = 0.25f;		// ...or the sun has to spin this much around the y axis
+};
+
+struct IBLSchedulerStats
+{
+	size_t numFaceRenders;
+	size_t numSwaps;
+};
+
+struct IBLMixParams
+{
+	size_t whichMap = 0;
+	float mapInterpolationAmt = 0.0f;
+	glm::vec3 flatSunOrientation = glm::vec3(1, 0, 0);
+};
+
+struct IBLUpdate
+{
+	uint32_t firstFace = 0, numFaces = 0;		// Render faces [firstFace, firstFace + numFaces) into the back buffer w/ params
+	bool swapAfter = false;						// The back buffer's done. Make it the front one after rendering
+	IBLMixParams params;
+};
+
+
+//
+// Decides when the interpolated irradiance/prefilter cubemaps need to get re-mixed from
+// the prebaked ones. The sun barely moves frame to frame, so the mix only gets redone
+// once the params have changed enough, and then it gets spread across a few frames.
+//
+// The faces go into a back buffer w/ the params from when the re-mix started, and
+// the back buffer only gets swapped in once every face is done. That way the shaders
+// never see half of the faces from one mix and half from another.
+//
+// Face order is the 6 irradiance faces, then 6 prefilter faces for each mip (mip 0 first)
+//
+// NOTE: there's no GL in here. RenderManager does the rendering w/ what schedule() returns
+//
+class IBLScheduler
+{
+public:
+	static constexpr uint32_t NUM_IRRADIANCE_FACES = 6;
+
+	void reset(uint32_t numPrefilterMips);		// NOTE: call whenever the cubemaps get recreated
+	IBLUpdate schedule(const IBLMixParams& freshParams);
+
+	inline uint32_t getNumFaces() const { return NUM_IRRADIANCE_FACES + 6 * numPrefilterMips; }
+	inline bool isUpdating() const { return isJobRunning; }
+	inline const IBLMixParams& getFrontParams() const { return frontParams; }
+
+	static IBLSchedulerSettings settings;
+	static IBLSchedulerStats stats;
+	static void INTERNALresetStats();
+
+private:
+	bool hasChangedEnough(const IBLMixParams& freshParams) const;
+
+	uint32_t numPrefilterMips = 0;
+	IBLMixParams frontParams;		// What the front buffer got mixed with
+	IBLMixParams jobParams;
+	uint32_t jobNextFace = 0;
+	bool isJobRunning = false;
+	bool isValid = false;
+};
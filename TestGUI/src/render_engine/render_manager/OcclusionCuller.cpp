@@ -0,0 +1,357 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cfloat>
+
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height, uint32_t numWorkerThreads) : stats(), width(width), height(height), numWorkerThreads(numWorkerThreads), projectionView(1.0f), isRasterized(false)
+{
+	if (OcclusionCuller::numWorkerThreads == 0)
+		OcclusionCuller::numWorkerThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+
+	//
+	// Create the hierarchical-z mip chain
+	//
+	uint32_t mipWidth = width;
+	uint32_t mipHeight = height;
+	while (true)
+	{
+		hiZMipWidths.push_back(mipWidth);
+		hiZMipHeights.push_back(mipHeight);
+		hiZMips.push_back(std::vector<float>((size_t)mipWidth * mipHeight, 1.0f));
+
+		if (mipWidth == 1 && mipHeight == 1)
+			break;
+
+		mipWidth = std::max(1u, (mipWidth + 1) / 2);
+		mipHeight = std::max(1u, (mipHeight + 1) / 2);
+	}
+
+	for (uint32_t i = 1; i < OcclusionCuller::numWorkerThreads; i++)
+		workers.push_back(std::thread(&OcclusionCuller::workerLoop, this, i));
+}
+
+
+OcclusionCuller::~OcclusionCuller()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		shuttingDown = true;
+	}
+	jobStartCV.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+
+void OcclusionCuller::beginFrame(const glm::mat4& projectionView)
+{
+	OcclusionCuller::projectionView = projectionView;
+	occluders.clear();
+	stats = {};
+	isRasterized = false;
+}
+
+
+void OcclusionCuller::addOccluder(const void* vertexData, size_t vertexStride, size_t vertexCount, const uint32_t* indices, size_t indexCount, const glm::mat4& modelMatrix)
+{
+	OccluderSubmission occluder;
+	occluder.vertexData = (const uint8_t*)vertexData;
+	occluder.vertexStride = vertexStride;
+	occluder.vertexCount = vertexCount;
+	occluder.indices = indices;
+	occluder.indexCount = indexCount;
+	occluder.modelMatrix = projectionView * modelMatrix;		// NOTE: baked into the mvp here
+	occluder.screenVerticesStart = occluders.empty() ? 0 : occluders.back().screenVerticesStart + occluders.back().vertexCount;
+	occluders.push_back(occluder);
+
+	stats.numOccluders++;
+	stats.numOccluderTriangles += indexCount / 3;
+}
+
+
+void OcclusionCuller::rasterizeOccluders()
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::fill(hiZMips[0].begin(), hiZMips[0].end(), 1.0f);
+	screenVertices.resize(occluders.empty() ? 0 : occluders.back().screenVerticesStart + occluders.back().vertexCount);
+
+	//
+	// Transform all the occluder vertices, then rasterize them in bands
+	// NOTE: each worker gets its own band of rows, so no two threads ever write to the same pixel
+	//
+	runJob(Job::TRANSFORM);
+	runJob(Job::RASTERIZE);
+
+	for (size_t i = 0; i < occluders.size(); i++)
+	{
+		const OccluderSubmission& occluder = occluders[i];
+		for (size_t j = 0; j + 2 < occluder.indexCount; j += 3)
+		{
+			if (screenVertices[occluder.screenVerticesStart + occluder.indices[j]].w != 0.0f &&
+				screenVertices[occluder.screenVerticesStart + occluder.indices[j + 1]].w != 0.0f &&
+				screenVertices[occluder.screenVerticesStart + occluder.indices[j + 2]].w != 0.0f)
+				stats.numRasterizedTriangles++;
+		}
+	}
+
+	buildHiZ();
+	isRasterized = true;
+
+	stats.rasterizeTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+
+void OcclusionCuller::workerLoop(uint32_t workerIndex)
+{
+	uint64_t lastGeneration = 0;
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobStartCV.wait(lock, [&] { return shuttingDown || jobGeneration != lastGeneration; });
+			if (shuttingDown)
+				return;
+			lastGeneration = jobGeneration;
+			job = currentJob;
+		}
+
+		doJob(job, workerIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			numWorkersRunning--;
+		}
+		jobDoneCV.notify_one();
+	}
+}
+
+
+void OcclusionCuller::runJob(Job job)
+{
+	if (workers.empty())
+	{
+		doJob(job, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		currentJob = job;
+		jobGeneration++;
+		numWorkersRunning = (uint32_t)workers.size();
+	}
+	jobStartCV.notify_all();
+
+	doJob(job, 0);
+
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobDoneCV.wait(lock, [&] { return numWorkersRunning == 0; });
+}
+
+
+void OcclusionCuller::doJob(Job job, uint32_t workerIndex)
+{
+	if (job == Job::TRANSFORM)
+		transformOccluders(workerIndex);
+	else if (job == Job::RASTERIZE)
+		rasterizeBand(height * workerIndex / numWorkerThreads, height * (workerIndex + 1) / numWorkerThreads);
+}
+
+
+bool OcclusionCuller::isVisible(const glm::vec3& worldAABBMin, const glm::vec3& worldAABBMax)
+{
+	stats.numTested++;
+	if (!isRasterized)
+		return true;
+
+	//
+	// Find the screen space rect and the nearest depth of the AABB
+	//
+	glm::vec2 rectMin(FLT_MAX), rectMax(-FLT_MAX);
+	float nearestDepth = FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		const glm::vec3 corner(
+			(i & 1) ? worldAABBMax.x : worldAABBMin.x,
+			(i & 2) ? worldAABBMax.y : worldAABBMin.y,
+			(i & 4) ? worldAABBMax.z : worldAABBMin.z
+		);
+		const glm::vec4 clip = projectionView * glm::vec4(corner, 1.0f);
+		if (clip.w <= 0.0f || clip.z < -clip.w)
+			return true;		// Crosses the near plane, so just assume it's visible
+
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		const glm::vec2 screen((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height);
+		rectMin = glm::min(rectMin, screen);
+		rectMax = glm::max(rectMax, screen);
+		nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+
+	if (rectMax.x < 0.0f || rectMax.y < 0.0f || rectMin.x >= (float)width || rectMin.y >= (float)height)
+		return true;		// Offscreen. Leave this up to the frustum culling
+
+	const int x0 = std::clamp((int)std::floor(rectMin.x), 0, (int)width - 1);
+	const int y0 = std::clamp((int)std::floor(rectMin.y), 0, (int)height - 1);
+	const int x1 = std::clamp((int)std::floor(rectMax.x), 0, (int)width - 1);
+	const int y1 = std::clamp((int)std::floor(rectMax.y), 0, (int)height - 1);
+
+	//
+	// Pick the mip where the rect is only a couple texels wide, and then check
+	// if any of the texels have an occluder that's farther than the AABB
+	//
+	const int rectSize = std::max(x1 - x0, y1 - y0) + 1;
+	int mipLevel = 0;
+	while ((rectSize >> mipLevel) > 2 && mipLevel + 1 < (int)hiZMips.size())
+		mipLevel++;
+
+	const std::vector<float>& mip = hiZMips[mipLevel];
+	const uint32_t mipWidth = hiZMipWidths[mipLevel];
+	for (int y = (y0 >> mipLevel); y <= (y1 >> mipLevel); y++)
+	for (int x = (x0 >> mipLevel); x <= (x1 >> mipLevel); x++)
+	{
+		if (mip[(size_t)y * mipWidth + x] >= nearestDepth)
+			return true;
+	}
+
+	stats.numCulled++;
+	return false;
+}
+
+
+void OcclusionCuller::transformOccluders(size_t threadIndex)
+{
+	for (size_t i = threadIndex; i < occluders.size(); i += std::max(1u, numWorkerThreads))
+	{
+		const OccluderSubmission& occluder = occluders[i];
+		for (size_t j = 0; j < occluder.vertexCount; j++)
+		{
+			const glm::vec3& position = *(const glm::vec3*)(occluder.vertexData + j * occluder.vertexStride);
+			const glm::vec4 clip = occluder.modelMatrix * glm::vec4(position, 1.0f);
+
+			glm::vec4& screenVertex = screenVertices[occluder.screenVerticesStart + j];
+			if (clip.w <= 0.0f || clip.z < -clip.w)
+			{
+				screenVertex = glm::vec4(0.0f);		// In front of the near plane. Any triangle that uses this vertex gets thrown out (which is conservative)
+				continue;
+			}
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			screenVertex = glm::vec4(
+				(ndc.x * 0.5f + 0.5f) * width,
+				(ndc.y * 0.5f + 0.5f) * height,
+				std::clamp(ndc.z * 0.5f + 0.5f, 0.0f, 1.0f),
+				1.0f
+			);
+		}
+	}
+}
+
+
+void OcclusionCuller::rasterizeBand(uint32_t yStart, uint32_t yEnd)
+{
+	for (size_t i = 0; i < occluders.size(); i++)
+	{
+		const OccluderSubmission& occluder = occluders[i];
+		const glm::vec4* vertices = &screenVertices[occluder.screenVerticesStart];
+		for (size_t j = 0; j + 2 < occluder.indexCount; j += 3)
+		{
+			const glm::vec4& v0 = vertices[occluder.indices[j]];
+			const glm::vec4& v1 = vertices[occluder.indices[j + 1]];
+			const glm::vec4& v2 = vertices[occluder.indices[j + 2]];
+			if (v0.w == 0.0f || v1.w == 0.0f || v2.w == 0.0f)
+				continue;
+
+			// Quick reject if it's not in this band
+			const float minY = std::min(v0.y, std::min(v1.y, v2.y));
+			const float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+			if (maxY < (float)yStart || minY >= (float)yEnd)
+				continue;
+
+			rasterizeTriangle(v0, v1, v2, yStart, yEnd);
+		}
+	}
+}
+
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1In, const glm::vec4& v2In, uint32_t yStart, uint32_t yEnd)
+{
+	// NOTE: both windings get rasterized (terrain and such can get seen from below)
+	float area = (v1In.x - v0.x) * (v2In.y - v0.y) - (v2In.x - v0.x) * (v1In.y - v0.y);
+	const bool flip = (area < 0.0f);
+	const glm::vec4& v1 = flip ? v2In : v1In;
+	const glm::vec4& v2 = flip ? v1In : v2In;
+	area = std::abs(area);
+	if (area < 1e-8f)
+		return;
+
+	const int minX = std::max(0, (int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+	const int maxX = std::min((int)width - 1, (int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))));
+	const int minY = std::max((int)yStart, (int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+	const int maxY = std::min((int)yEnd - 1, (int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	//
+	// Edge functions (e0 is the edge across from v0, etc.), which are positive inside the triangle.
+	// These double as the barycentric weights after dividing by the area.
+	//
+	const float a0 = v1.y - v2.y, b0 = v2.x - v1.x;
+	const float a1 = v2.y - v0.y, b1 = v0.x - v2.x;
+	const float a2 = v0.y - v1.y, b2 = v1.x - v0.x;
+	const float invArea = 1.0f / area;
+	const float z0 = v0.z * invArea, z1 = v1.z * invArea, z2 = v2.z * invArea;
+
+	std::vector<float>& depthBuffer = hiZMips[0];
+	for (int y = minY; y <= maxY; y++)
+	{
+		const float py = (float)y + 0.5f;
+		const float px = (float)minX + 0.5f;
+		const float rowE0 = a0 * (px - v1.x) + b0 * (py - v1.y);
+		const float rowE1 = a1 * (px - v2.x) + b1 * (py - v2.y);
+		const float rowE2 = a2 * (px - v0.x) + b2 * (py - v0.y);
+
+		// @NOTE: this loop is written branchless so that it gets auto-vectorized
+		float* row = &depthBuffer[(size_t)y * width];
+		const int count = maxX - minX + 1;
+		for (int i = 0; i < count; i++)
+		{
+			const float e0 = rowE0 + a0 * i;
+			const float e1 = rowE1 + a1 * i;
+			const float e2 = rowE2 + a2 * i;
+			const float depth = e0 * z0 + e1 * z1 + e2 * z2;
+			const bool inside = (e0 > 0.0f) & (e1 > 0.0f) & (e2 > 0.0f);
+			row[minX + i] = (inside && depth < row[minX + i]) ? depth : row[minX + i];
+		}
+	}
+}
+
+
+void OcclusionCuller::buildHiZ()
+{
+	for (size_t level = 1; level < hiZMips.size(); level++)
+	{
+		const std::vector<float>& prevMip = hiZMips[level - 1];
+		const uint32_t prevWidth = hiZMipWidths[level - 1];
+		const uint32_t prevHeight = hiZMipHeights[level - 1];
+
+		std::vector<float>& mip = hiZMips[level];
+		const uint32_t mipWidth = hiZMipWidths[level];
+		const uint32_t mipHeight = hiZMipHeights[level];
+		for (uint32_t y = 0; y < mipHeight; y++)
+		for (uint32_t x = 0; x < mipWidth; x++)
+		{
+			const uint32_t px0 = std::min(x * 2, prevWidth - 1), px1 = std::min(x * 2 + 1, prevWidth - 1);
+			const uint32_t py0 = std::min(y * 2, prevHeight - 1), py1 = std::min(y * 2 + 1, prevHeight - 1);
+			mip[(size_t)y * mipWidth + x] = std::max(
+				std::max(prevMip[(size_t)py0 * prevWidth + px0], prevMip[(size_t)py0 * prevWidth + px1]),
+				std::max(prevMip[(size_t)py1 * prevWidth + px0], prevMip[(size_t)py1 * prevWidth + px1])
+			);
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+//
+// CPU occlusion culling. Occluders get rasterized into a low-res depth buffer
+// (split up into horizontal bands, one per worker thread), a hierarchical-z
+// gets built off of it, and then world space AABBs get tested against the HiZ.
+//
+// The worker threads get created once and then sleep until there's a job for them
+// (the calling thread takes the first share of every job too).
+//
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(uint32_t width = 256, uint32_t height = 128, uint32_t numWorkerThreads = 0);		// NOTE: 0 worker threads means use the hardware concurrency (max 4)
+	~OcclusionCuller();
+
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	void beginFrame(const glm::mat4& projectionView);
+
+	// NOTE: the position needs to be the first thing in the vertex (i.e. a glm::vec3 at offset 0). The data needs to stay alive until rasterizeOccluders() is done
+	void addOccluder(const void* vertexData, size_t vertexStride, size_t vertexCount, const uint32_t* indices, size_t indexCount, const glm::mat4& modelMatrix);
+	void rasterizeOccluders();
+
+	bool isVisible(const glm::vec3& worldAABBMin, const glm::vec3& worldAABBMax);
+
+	inline uint32_t getWidth() const { return width; }
+	inline uint32_t getHeight() const { return height; }
+	inline const std::vector<float>& getDepthBuffer() const { return hiZMips[0]; }		// NOTE: depth is [0-1], where 1 is far
+
+	struct Stats
+	{
+		size_t numOccluders;
+		size_t numOccluderTriangles;
+		size_t numRasterizedTriangles;
+		size_t numTested;
+		size_t numCulled;
+		float rasterizeTimeMs;
+	} stats;
+
+private:
+	uint32_t width, height;
+	uint32_t numWorkerThreads;
+	glm::mat4 projectionView;
+	bool isRasterized;
+
+	struct OccluderSubmission
+	{
+		const uint8_t* vertexData;
+		size_t vertexStride;
+		size_t vertexCount;
+		const uint32_t* indices;
+		size_t indexCount;
+		glm::mat4 modelMatrix;
+		size_t screenVerticesStart;
+	};
+	std::vector<OccluderSubmission> occluders;
+	std::vector<glm::vec4> screenVertices;		// xy: pixel position, z: depth [0-1], w: 0 if the vertex is in front of the near plane (can't be rasterized)
+
+	std::vector<uint32_t> hiZMipWidths, hiZMipHeights;
+	std::vector<std::vector<float>> hiZMips;	// Mip 0 is the full depth buffer. Each texel after that is the farthest depth of the 2x2 texels below it
+
+	//
+	// Worker pool
+	//
+	enum class Job { NONE, TRANSFORM, RASTERIZE };
+	std::vector<std::thread> workers;		// NOTE: numWorkerThreads - 1 of these, since the calling thread does job 0
+	std::mutex jobMutex;
+	std::condition_variable jobStartCV, jobDoneCV;
+	Job currentJob = Job::NONE;
+	uint64_t jobGeneration = 0;
+	uint32_t numWorkersRunning = 0;
+	bool shuttingDown = false;
+
+	void workerLoop(uint32_t workerIndex);
+	void runJob(Job job);
+	void doJob(Job job, uint32_t workerIndex);
+
+	void transformOccluders(size_t threadIndex);
+	void rasterizeBand(uint32_t yStart, uint32_t yEnd);
+	void rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, uint32_t yStart, uint32_t yEnd);
+	void buildHiZ();
+};
@@ -0,0 +1,471 @@
+#include "RenderGraph.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+
+constexpr uint32_t framesUntilPhysicalTextureDeleted = 3;
+
+RenderGraph::~RenderGraph()
+{
+	for (size_t i = 0; i < pool.size(); i++)
+	{
+		glDeleteFramebuffers(1, &pool[i].fbo);
+		glDeleteTextures(1, &pool[i].texture);
+	}
+}
+
+void RenderGraph::reset()
+{
+	textures.clear();
+	passes.clear();
+	physicalSlots.clear();
+	physicalSlotToPool.clear();
+	compiled = false;
+}
+
+RenderGraph::TextureHandle RenderGraph::createTexture(const std::string& name, const RenderGraphTextureDesc& desc)
+{
+	TextureNode node;
+	node.name = name;
+	node.desc = desc;
+	textures.push_back(node);
+	return (TextureHandle)(textures.size() - 1);
+}
+
+RenderGraph::TextureHandle RenderGraph::importTexture(const std::string& name, GLuint texture, const RenderGraphTextureDesc& desc)
+{
+	TextureNode node;
+	node.name = name;
+	node.desc = desc;
+	node.isImported = true;
+	node.importedTexture = texture;
+	textures.push_back(node);
+	return (TextureHandle)(textures.size() - 1);
+}
+
+void RenderGraph::setImportedTexture(TextureHandle texture, GLuint glTexture)
+{
+	assert(texture < textures.size() && textures[texture].isImported);
+	textures[texture].importedTexture = glTexture;
+}
+
+size_t RenderGraph::addPass(const std::string& name, RenderGraphPassType type, const std::function<void(RenderGraph&)>& execute)
+{
+	PassNode node;
+	node.name = name;
+	node.type = type;
+	node.execute = execute;
+	passes.push_back(node);
+	return passes.size() - 1;
+}
+
+void RenderGraph::read(size_t pass, TextureHandle texture)
+{
+	assert(texture < textures.size());
+	passes[pass].reads.push_back(texture);
+}
+
+void RenderGraph::write(size_t pass, TextureHandle texture)
+{
+	assert(texture < textures.size());
+	passes[pass].writes.push_back(texture);
+}
+
+void RenderGraph::setHasSideEffects(size_t pass)
+{
+	passes[pass].hasSideEffects = true;
+}
+
+bool RenderGraph::compile()
+{
+	// Transient textures have to get written before they get read, since there's nothing in them at the start of the frame
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		if (textures[i].isImported)
+			continue;
+
+		bool written = false;
+		for (size_t j = 0; j < passes.size(); j++)
+		{
+			const PassNode& pass = passes[j];
+			if (!written && std::find(pass.reads.begin(), pass.reads.end(), (TextureHandle)i) != pass.reads.end())
+			{
+				std::cout << "ERROR::RENDERGRAPH::COMPILE:: pass \"" << pass.name << "\" reads transient texture \"" << textures[i].name << "\" before anything writes to it" << std::endl;
+				return false;
+			}
+			if (std::find(pass.writes.begin(), pass.writes.end(), (TextureHandle)i) != pass.writes.end())
+				written = true;
+		}
+	}
+
+	cullPasses();
+	computeLifetimes();
+	assignPhysicalTextures();
+	computeBarriers();
+
+	//
+	// Tally up stats
+	//
+	stats = {};
+	stats.numPasses = passes.size();
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		if (!passes[i].isAlive)
+			stats.numPassesCulled++;
+		else if (passes[i].barrierBits != 0)
+			stats.numBarriers++;
+	}
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		if (textures[i].isImported)
+			continue;
+		stats.numTransientTextures++;
+		stats.transientBytesWithoutAliasing += getTextureSizeInBytes(textures[i].desc);
+	}
+
+	stats.numPhysicalTextures = physicalSlots.size();
+	for (size_t i = 0; i < physicalSlots.size(); i++)
+		stats.transientBytesWithAliasing += getTextureSizeInBytes(physicalSlots[i]);
+
+#ifdef _DEVELOP
+	DEBUGlastFrameTextures.clear();
+	DEBUGlastFrameTextureHandles.clear();
+	for (size_t i = 0; i < textures.size(); i++)
+		if (!textures[i].isImported && textures[i].physicalIndex != ~0u)
+		{
+			DEBUGlastFrameTextures.push_back({ textures[i].name, 0 });
+			DEBUGlastFrameTextureHandles.push_back((TextureHandle)i);
+		}
+#endif
+
+	compiled = true;
+	return true;
+}
+
+void RenderGraph::cullPasses()
+{
+	//
+	// Go backwards from the passes that have to run (side effects, or write to
+	// something that lives outside of the graph). Whatever they read is needed,
+	// so whatever writes to that earlier is alive too, and so on.
+	//
+	std::vector<bool> isNeeded(textures.size(), false);
+	for (int i = (int)passes.size() - 1; i >= 0; i--)
+	{
+		PassNode& pass = passes[i];
+		pass.isAlive = pass.hasSideEffects;
+		for (TextureHandle texture : pass.writes)
+		{
+			if (textures[texture].isImported || isNeeded[texture])
+			{
+				pass.isAlive = true;
+				break;
+			}
+		}
+
+		if (!pass.isAlive)
+			continue;
+
+		for (TextureHandle texture : pass.reads)
+			isNeeded[texture] = true;
+	}
+}
+
+void RenderGraph::computeLifetimes()
+{
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		textures[i].firstPass = -1;
+		textures[i].lastPass = -1;
+		textures[i].physicalIndex = ~0u;
+	}
+
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		if (!passes[i].isAlive)
+			continue;
+
+		auto touch = [&](TextureHandle texture)
+		{
+			TextureNode& node = textures[texture];
+			if (node.firstPass < 0)
+				node.firstPass = (int)i;
+			node.lastPass = (int)i;
+		};
+		for (TextureHandle texture : passes[i].reads)
+			touch(texture);
+		for (TextureHandle texture : passes[i].writes)
+			touch(texture);
+	}
+}
+
+void RenderGraph::assignPhysicalTextures()
+{
+	//
+	// Greedy: in the order they start getting used, each transient texture takes
+	// the first physical texture w/ the same desc that's done being used
+	//
+	std::vector<TextureHandle> order;
+	for (size_t i = 0; i < textures.size(); i++)
+		if (!textures[i].isImported && textures[i].firstPass >= 0)		// NOTE: the ones only culled passes used don't get anything
+			order.push_back((TextureHandle)i);
+	std::stable_sort(order.begin(), order.end(), [&](TextureHandle a, TextureHandle b) { return textures[a].firstPass < textures[b].firstPass; });
+
+	physicalSlots.clear();
+	std::vector<int> slotBusyUntil;
+	for (TextureHandle texture : order)
+	{
+		TextureNode& node = textures[texture];
+
+		uint32_t slot = ~0u;
+		for (size_t i = 0; i < physicalSlots.size(); i++)
+		{
+			if (slotBusyUntil[i] < node.firstPass && isSameDesc(physicalSlots[i], node.desc))
+			{
+				slot = (uint32_t)i;
+				break;
+			}
+		}
+
+		if (slot == ~0u)
+		{
+			slot = (uint32_t)physicalSlots.size();
+			physicalSlots.push_back(node.desc);
+			slotBusyUntil.push_back(-1);
+		}
+
+		node.physicalIndex = slot;
+		slotBusyUntil[slot] = node.lastPass;
+	}
+}
+
+void RenderGraph::computeBarriers()
+{
+	//
+	// Image stores (compute) aren't coherent w/ anything that comes after them, so those
+	// need a glMemoryBarrier() w/ the bit for however the texture gets used next. Reads
+	// w/ image loads get one after any write too (framebuffer writes -> image loads).
+	// NOTE: the state is per physical texture, so aliased textures inherit what was in there.
+	//
+	struct ResourceState
+	{
+		bool isDirty = true;				// Imported textures could've been written to last frame
+		bool writtenByCompute = false;
+		GLbitfield issuedSinceWrite = 0;
+	};
+	std::vector<ResourceState> importedStates(textures.size());
+	std::vector<ResourceState> physicalStates(physicalSlots.size());
+	auto getState = [&](TextureHandle texture) -> ResourceState&
+	{
+		if (textures[texture].isImported)
+			return importedStates[texture];
+		return physicalStates[textures[texture].physicalIndex];
+	};
+	for (ResourceState& state : physicalStates)
+		state.isDirty = false;
+
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		PassNode& pass = passes[i];
+		pass.barrierBits = 0;
+		if (!pass.isAlive)
+			continue;
+
+		const bool isCompute = (pass.type == RenderGraphPassType::COMPUTE);
+		for (TextureHandle texture : pass.reads)
+		{
+			ResourceState& state = getState(texture);
+			GLbitfield needed = 0;
+			if (state.writtenByCompute)
+				needed |= GL_TEXTURE_FETCH_BARRIER_BIT;
+			if (isCompute && state.isDirty)
+				needed |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+			pass.barrierBits |= needed & ~state.issuedSinceWrite;
+		}
+		for (TextureHandle texture : pass.writes)
+		{
+			ResourceState& state = getState(texture);
+			if (state.writtenByCompute)
+				pass.barrierBits |= (isCompute ? GL_SHADER_IMAGE_ACCESS_BARRIER_BIT : GL_FRAMEBUFFER_BARRIER_BIT) & ~state.issuedSinceWrite;
+		}
+
+		// The barrier goes in before the pass, so it covers everything
+		for (ResourceState& state : importedStates)
+			state.issuedSinceWrite |= pass.barrierBits;
+		for (ResourceState& state : physicalStates)
+			state.issuedSinceWrite |= pass.barrierBits;
+
+		for (TextureHandle texture : pass.writes)
+		{
+			ResourceState& state = getState(texture);
+			state.isDirty = true;
+			state.writtenByCompute = isCompute;
+			state.issuedSinceWrite = 0;
+		}
+	}
+}
+
+void RenderGraph::acquirePhysicalTextures()
+{
+	for (size_t i = 0; i < pool.size(); i++)
+		pool[i].usedThisFrame = false;
+
+	physicalSlotToPool.assign(physicalSlots.size(), ~0u);
+	for (size_t i = 0; i < physicalSlots.size(); i++)
+	{
+		const RenderGraphTextureDesc& desc = physicalSlots[i];
+		for (size_t j = 0; j < pool.size(); j++)
+		{
+			if (!pool[j].usedThisFrame && isSameDesc(pool[j].desc, desc))
+			{
+				physicalSlotToPool[i] = (uint32_t)j;
+				break;
+			}
+		}
+
+		if (physicalSlotToPool[i] == ~0u)
+		{
+			PhysicalTexture physical;
+			physical.desc = desc;
+			glCreateTextures(GL_TEXTURE_2D, 1, &physical.texture);
+			glTextureStorage2D(physical.texture, (GLsizei)desc.levels, desc.internalFormat, (GLsizei)desc.width, (GLsizei)desc.height);
+			glTextureParameteri(physical.texture, GL_TEXTURE_MIN_FILTER, desc.minFilter == 0 ? GL_LINEAR : desc.minFilter);
+			glTextureParameteri(physical.texture, GL_TEXTURE_MAG_FILTER, desc.magFilter == 0 ? GL_LINEAR : desc.magFilter);
+			glTextureParameteri(physical.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(physical.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			glCreateFramebuffers(1, &physical.fbo);
+			glNamedFramebufferTexture(physical.fbo, GL_COLOR_ATTACHMENT0, physical.texture, 0);
+			if (glCheckNamedFramebufferStatus(physical.fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cout << "Framebuffer not complete! (Render Graph Physical Texture)" << std::endl;
+
+			pool.push_back(physical);
+			physicalSlotToPool[i] = (uint32_t)(pool.size() - 1);
+		}
+
+		PhysicalTexture& physical = pool[physicalSlotToPool[i]];
+		physical.usedThisFrame = true;
+		physical.framesUnused = 0;
+	}
+
+	//
+	// Get rid of the ones that haven't been used in a while (i.e. the old sizes after a resize)
+	// NOTE: this happens after the slots get mapped, so the indices have to get fixed up
+	//
+	std::vector<uint32_t> remap(pool.size(), ~0u);
+	std::vector<PhysicalTexture> keptPool;
+	for (size_t i = 0; i < pool.size(); i++)
+	{
+		if (!pool[i].usedThisFrame && ++pool[i].framesUnused > framesUntilPhysicalTextureDeleted)
+		{
+			glDeleteFramebuffers(1, &pool[i].fbo);
+			glDeleteTextures(1, &pool[i].texture);
+			continue;
+		}
+		remap[i] = (uint32_t)keptPool.size();
+		keptPool.push_back(pool[i]);
+	}
+	pool = keptPool;
+	for (size_t i = 0; i < physicalSlotToPool.size(); i++)
+		physicalSlotToPool[i] = remap[physicalSlotToPool[i]];
+}
+
+void RenderGraph::execute()
+{
+	if (!compiled && !compile())
+		return;
+
+	acquirePhysicalTextures();
+
+	for (size_t i = 0; i < passes.size(); i++)
+	{
+		PassNode& pass = passes[i];
+		if (!pass.isAlive)
+			continue;
+
+		if (pass.barrierBits != 0)
+			glMemoryBarrier(pass.barrierBits);
+		pass.execute(*this);
+	}
+
+#ifdef _DEVELOP
+	for (size_t i = 0; i < DEBUGlastFrameTextures.size(); i++)
+		DEBUGlastFrameTextures[i].second = getTexture(DEBUGlastFrameTextureHandles[i]);
+#endif
+}
+
+GLuint RenderGraph::getTexture(TextureHandle texture) const
+{
+	const TextureNode& node = textures[texture];
+	if (node.isImported)
+		return node.importedTexture;
+	if (node.physicalIndex == ~0u || node.physicalIndex >= physicalSlotToPool.size())
+		return 0;
+	return pool[physicalSlotToPool[node.physicalIndex]].texture;
+}
+
+void RenderGraph::bindRenderTarget(TextureHandle texture)
+{
+	const TextureNode& node = textures[texture];
+	if (node.isImported || node.physicalIndex == ~0u)
+	{
+		std::cout << "ERROR::RENDERGRAPH::BINDRENDERTARGET:: \"" << node.name << "\" isn't a transient texture w/ a physical texture" << std::endl;
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, pool[physicalSlotToPool[node.physicalIndex]].fbo);
+	glViewport(0, 0, (GLsizei)node.desc.width, (GLsizei)node.desc.height);
+}
+
+size_t RenderGraph::getTextureSizeInBytes(const RenderGraphTextureDesc& desc)
+{
+	size_t bytesPerPixel;
+	switch (desc.internalFormat)
+	{
+	case GL_R8:					bytesPerPixel = 1;	break;
+	case GL_R16F:				bytesPerPixel = 2;	break;
+	case GL_R32F:
+	case GL_RG16F:
+	case GL_RGBA8:
+	case GL_R11F_G11F_B10F:
+	case GL_DEPTH_COMPONENT24:
+	case GL_DEPTH_COMPONENT32F:	bytesPerPixel = 4;	break;
+	case GL_RG32F:
+	case GL_RGBA16F:			bytesPerPixel = 8;	break;
+	case GL_RGBA32F:			bytesPerPixel = 16;	break;
+	default:
+		std::cout << "WARNING::RENDERGRAPH:: unknown internal format " << desc.internalFormat << ", assuming 4 bytes per pixel" << std::endl;
+		bytesPerPixel = 4;
+		break;
+	}
+	size_t size = 0;
+	for (uint32_t i = 0; i < desc.levels; i++)
+		size += (size_t)std::max(1u, desc.width >> i) * (size_t)std::max(1u, desc.height >> i) * bytesPerPixel;
+	return size;
+}
+
+bool RenderGraph::isSameDesc(const RenderGraphTextureDesc& a, const RenderGraphTextureDesc& b)
+{
+	return a.width == b.width && a.height == b.height && a.internalFormat == b.internalFormat && a.minFilter == b.minFilter && a.magFilter == b.magFilter && a.levels == b.levels;
+}
+
+#ifdef _DEVELOP
+GLuint RenderGraph::DEBUGgetLastFrameTexture(const std::string& name) const
+{
+	for (size_t i = 0; i < DEBUGlastFrameTextures.size(); i++)
+		if (DEBUGlastFrameTextures[i].first == name)
+			return DEBUGlastFrameTextures[i].second;
+	return 0;
+}
+
+void RenderGraph::DEBUGgetLastFrameTextureNames(std::vector<std::string>& out_names) const
+{
+	out_names.clear();
+	for (size_t i = 0; i < DEBUGlastFrameTextures.size(); i++)
+		out_names.push_back(DEBUGlastFrameTextures[i].first);
+}
+#endif
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+typedef unsigned int GLuint;
+typedef unsigned int GLenum;
+typedef unsigned int GLbitfield;
+
+
+struct RenderGraphTextureDesc
+{
+	uint32_t width = 0, height = 0;
+	GLenum internalFormat = 0;
+	GLenum minFilter = 0, magFilter = 0;		// NOTE: 0 is GL_LINEAR
+	uint32_t levels = 1;
+};
+
+enum class RenderGraphPassType { GRAPHICS, COMPUTE };
+
+
+//
+// Passes declare what textures they read and write, and then compile() figures out:
+//		- which passes can get culled (nothing alive reads what they write),
+//		- how long each transient texture lives, so that ones w/ the same desc that
+//		  don't overlap can share the same physical texture,
+//		- and where glMemoryBarrier()'s need to go (anything reading after a compute pass wrote).
+// Then execute() runs the passes that are left in the order they got added.
+//
+// Transient textures only live for the frame, so don't expect anything to be in them
+// at the start of it. Imported textures are the persistent ones (history buffers, the
+// HDR buffer, etc.) and writing to one of them keeps the pass alive.
+//
+// NOTE: compile() doesn't touch GL, so the graph can be built and checked headless.
+// The physical textures get pooled across frames, and the ones that go unused for a
+// few frames (like after a resize) get deleted.
+//
+// The compiled graph sticks around until the next reset(), so calling execute() again
+// w/o redeclaring anything just reruns it. Only reset() when the passes or the texture
+// sizes change. Imported textures that get swapped out (ping-pongs) can be pointed at
+// the new texture w/ setImportedTexture() w/o a recompile.
+//
+class RenderGraph
+{
+public:
+	typedef uint32_t TextureHandle;
+	static constexpr TextureHandle INVALID_TEXTURE = ~0u;
+
+	~RenderGraph();
+
+	void reset();		// Starts declaring a new frame
+
+	TextureHandle createTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+	TextureHandle importTexture(const std::string& name, GLuint texture, const RenderGraphTextureDesc& desc);
+	void setImportedTexture(TextureHandle texture, GLuint glTexture);
+
+	size_t addPass(const std::string& name, RenderGraphPassType type, const std::function<void(RenderGraph&)>& execute);
+	void read(size_t pass, TextureHandle texture);
+	void write(size_t pass, TextureHandle texture);
+	void setHasSideEffects(size_t pass);		// For passes that render to stuff outside of the graph (i.e. the screen)
+
+	bool compile();
+	void execute();
+
+	// NOTE: these are for inside of the passes' execute functions
+	GLuint getTexture(TextureHandle texture) const;
+	void bindRenderTarget(TextureHandle texture);		// Binds the texture's FBO and sets the viewport to its size. Transient textures only
+
+	// Compiled results
+	bool isCompiled() const { return compiled; }
+	bool isPassCulled(size_t pass) const { return !passes[pass].isAlive; }
+	uint32_t getPhysicalTextureIndex(TextureHandle texture) const { return textures[texture].physicalIndex; }
+	GLbitfield getBarrierBits(size_t pass) const { return passes[pass].barrierBits; }
+
+	static size_t getTextureSizeInBytes(const RenderGraphTextureDesc& desc);
+
+	struct Stats
+	{
+		size_t numPasses;
+		size_t numPassesCulled;
+		size_t numTransientTextures;
+		size_t numPhysicalTextures;
+		size_t numBarriers;
+		size_t transientBytesWithoutAliasing;		// If every transient texture got its own allocation (like before the graph)
+		size_t transientBytesWithAliasing;
+	} stats = {};
+
+#ifdef _DEVELOP
+	GLuint DEBUGgetLastFrameTexture(const std::string& name) const;		// NOTE: 0 if it's not there. Might have been overwritten by an aliased texture
+	void DEBUGgetLastFrameTextureNames(std::vector<std::string>& out_names) const;
+#endif
+
+private:
+	struct TextureNode
+	{
+		std::string name;
+		RenderGraphTextureDesc desc;
+		bool isImported = false;
+		GLuint importedTexture = 0;
+
+		// Compiled
+		int firstPass = -1, lastPass = -1;
+		uint32_t physicalIndex = ~0u;
+	};
+
+	struct PassNode
+	{
+		std::string name;
+		RenderGraphPassType type;
+		std::function<void(RenderGraph&)> execute;
+		std::vector<TextureHandle> reads, writes;
+		bool hasSideEffects = false;
+
+		// Compiled
+		bool isAlive = false;
+		GLbitfield barrierBits = 0;
+	};
+
+	struct PhysicalTexture
+	{
+		RenderGraphTextureDesc desc;
+		GLuint texture = 0;
+		GLuint fbo = 0;
+		uint32_t framesUnused = 0;
+		bool usedThisFrame = false;
+	};
+
+	static bool isSameDesc(const RenderGraphTextureDesc& a, const RenderGraphTextureDesc& b);
+
+	void cullPasses();
+	void computeLifetimes();
+	void assignPhysicalTextures();
+	void computeBarriers();
+	void acquirePhysicalTextures();
+
+	std::vector<TextureNode> textures;
+	std::vector<PassNode> passes;
+	std::vector<RenderGraphTextureDesc> physicalSlots;		// What compile() came up with
+	std::vector<uint32_t> physicalSlotToPool;
+	std::vector<PhysicalTexture> pool;
+	bool compiled = false;
+
+#ifdef _DEVELOP
+	std::vector<std::pair<std::string, GLuint>> DEBUGlastFrameTextures;		// NOTE: the names get filled in when it compiles, and the textures every execute()
+	std::vector<TextureHandle> DEBUGlastFrameTextureHandles;
+#endif
+};
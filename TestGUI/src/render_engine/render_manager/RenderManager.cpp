@@ -1,17 +1,19 @@
 #include "RenderManager.h"
+#include "CloudDensityBounds.h"
+#include "DebugDraw.h"
 
 #include "../../mainloop/MainLoop.h"
 
 #include <string>
 #include <cmath>
 #include <random>
+#include <chrono>
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/scalar_multiplication.hpp>
 #include <glm/gtx/euler_angles.hpp>
 
 #include <filesystem>
-#include <stb/stb_image_write.h>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -35,6 +37,7 @@
 #include "../material/shaderext/ShaderExtZBuffer.h"
 #include "../material/Material.h"
 #include "../model/Model.h"
+#include "../terrain/TerrainRenderer.h"
 #include "../resources/Resources.h"
 #include "../../utils/FileLoading.h"
 #include "../../utils/PhysicsUtils.h"
@@ -295,13 +298,11 @@ RenderManager::RenderManager()
 	createFonts();
 	createHDRBuffer();
 	createLumenAdaptationTextures();
+	createVolumetricFroxelTextures();
 	createCloudNoise();
+	DebugDraw::getInstance().initialize();
 	//loadResources();
 
-#ifdef _DEVELOP
-	createPickingBuffer();
-#endif
-
 	//
 	// Create all the day/night cycle irradiance and prefilter maps
 	// @REFACTOR: place this inside the GlobalLight's constructor and something for the destructor
@@ -331,12 +332,10 @@ RenderManager::~RenderManager()
 	destroyFonts();
 	destroyHDRBuffer();
 	destroyLumenAdaptationTextures();
+	destroyVolumetricFroxelTextures();
 	destroyCloudNoise();
+	DebugDraw::getInstance().cleanup();
 	//unloadResources();
-
-#ifdef _DEVELOP
-	destroyPickingBuffer();
-#endif
 }
 
 
@@ -554,12 +553,30 @@ void RenderManager::createHDRSkybox(bool first, size_t index, const glm::vec3& s
 
 void RenderManager::recreateRenderBuffers()
 {
-	destroyHDRBuffer();
-	createHDRBuffer();
-#ifdef _DEVELOP
-	destroyPickingBuffer();
-	createPickingBuffer();
-#endif
+	//
+	// NOTE: only the stuff at the render resolution. This runs on every dynamic resolution step, so the
+	// cloud TAA history gets scaled into the new one instead of starting over
+	//
+	Texture* prevCloudEffectTAAHistoryTexture = cloudEffectTAAHistoryTexture;
+	GLuint prevCloudEffectTAAHistoryFBO = cloudEffectTAAHistoryFBO;
+	const int prevCloudEffectTextureWidth = cloudEffectTextureWidth;
+	const int prevCloudEffectTextureHeight = cloudEffectTextureHeight;
+	cloudEffectTAAHistoryTexture = nullptr;
+	cloudEffectTAAHistoryFBO = 0;
+
+	destroyRenderResolutionBuffers();
+	createRenderResolutionBuffers();
+
+	glBlitNamedFramebuffer(
+		prevCloudEffectTAAHistoryFBO,
+		cloudEffectTAAHistoryFBO,
+		0, 0, prevCloudEffectTextureWidth, prevCloudEffectTextureHeight,
+		0, 0, cloudEffectTextureWidth, cloudEffectTextureHeight,
+		GL_COLOR_BUFFER_BIT,
+		GL_LINEAR
+	);
+	delete prevCloudEffectTAAHistoryTexture;
+	glDeleteFramebuffers(1, &prevCloudEffectTAAHistoryFBO);
 }
 
 #ifdef _DEVELOP
@@ -567,13 +584,13 @@ std::vector<BaseObject*> RenderManager::getSelectedObjects()
 {
 	std::vector<BaseObject*> objs;
 
-	for (size_t i = 0; i < selectedObjectIndices.size(); i++)
+	for (size_t i = 0; i < selectedObjectHandles.size(); i++)
 	{
-		size_t selectedIndex = selectedObjectIndices[i];
-		if (selectedIndex >= MainLoop::getInstance().objects.size())
-			continue;
+		BaseObject** obj = MainLoop::getInstance().objects.get(selectedObjectHandles[i]);
+		if (obj == nullptr)
+			continue;		// Got deleted
 
-		objs.push_back(MainLoop::getInstance().objects[selectedIndex]);
+		objs.push_back(*obj);
 	}
 
 	return objs;
@@ -581,15 +598,20 @@ std::vector<BaseObject*> RenderManager::getSelectedObjects()
 
 bool RenderManager::isObjectSelected(size_t index)
 {
-	return (std::find(selectedObjectIndices.begin(), selectedObjectIndices.end(), index) != selectedObjectIndices.end());
+	if (index >= MainLoop::getInstance().objects.size())
+		return false;
+
+	const SlotMapHandle handle = MainLoop::getInstance().objects.getHandle(index);
+	return (std::find(selectedObjectHandles.begin(), selectedObjectHandles.end(), handle) != selectedObjectHandles.end());
 }
 
 bool RenderManager::isObjectSelected(const std::string& guid)
 {
 	// @NOTE: this is very inefficient, but it's only used in the voxelgroup class in the level editor, so yeah. It should be okay eh.
-	for (size_t i = 0; i < selectedObjectIndices.size(); i++)
+	for (size_t i = 0; i < selectedObjectHandles.size(); i++)
 	{
-		if (MainLoop::getInstance().objects[selectedObjectIndices[i]]->guid == guid)
+		BaseObject** obj = MainLoop::getInstance().objects.get(selectedObjectHandles[i]);
+		if (obj != nullptr && (*obj)->guid == guid)
 			return true;
 	}
 
@@ -598,22 +620,25 @@ bool RenderManager::isObjectSelected(const std::string& guid)
 
 void RenderManager::addSelectObject(size_t index)
 {
-	if (!isObjectSelected(index))
-		selectedObjectIndices.push_back(index);
+	if (index < MainLoop::getInstance().objects.size() && !isObjectSelected(index))
+		selectedObjectHandles.push_back(MainLoop::getInstance().objects.getHandle(index));
 }
 
 void RenderManager::deselectObject(size_t index)
 {
-	auto it = std::find(selectedObjectIndices.begin(), selectedObjectIndices.end(), index);
-	if (it != selectedObjectIndices.end())
+	if (index >= MainLoop::getInstance().objects.size())
+		return;
+
+	auto it = std::find(selectedObjectHandles.begin(), selectedObjectHandles.end(), MainLoop::getInstance().objects.getHandle(index));
+	if (it != selectedObjectHandles.end())
 	{
-		selectedObjectIndices.erase(it);
+		selectedObjectHandles.erase(it);
 	}
 }
 
 void RenderManager::deselectAllSelectedObject()
 {
-	selectedObjectIndices.clear();
+	selectedObjectHandles.clear();
 }
 
 void RenderManager::deleteAllSelectedObjects()
@@ -628,10 +653,9 @@ void RenderManager::deleteAllSelectedObjects()
 #endif
 
 #ifdef _DEVELOP
-void RenderManager::physxVisSetDebugLineList(std::vector<physx::PxDebugLine>* lineList)
+void RenderManager::physxVisSetDebugLineList(const physx::PxDebugLine* lines, size_t numLines)
 {
-	delete physxVisDebugLines;			// NOTE: this gets destroyed to prevent any memory leaks
-	physxVisDebugLines = lineList;
+	physxVisDebugLines.assign(lines, lines + numLines);		// NOTE: reuses the capacity from the last physics step, so this only allocates when there's more lines than ever before
 }
 #endif
 
@@ -660,6 +684,56 @@ void RenderManager::pushMessage(const std::string& text)
 
 void RenderManager::createHDRBuffer()
 {
+	createRenderResolutionBuffers();
+
+	//
+	// Create Skybox framebuffer
+	// NOTE: nothing in here depends on the render resolution, so dynamic resolution steps leave it (and the LUT cache and IBL scheduler) alone
+	//
+	skyboxLowResTexture = new Texture2D(skyboxLowResSize, skyboxLowResSize, 1, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	glCreateFramebuffers(1, &skyboxFBO);
+	glNamedFramebufferTexture(skyboxFBO, GL_COLOR_ATTACHMENT0, skyboxLowResTexture->getHandle(), 0);
+	if (glCheckNamedFramebufferStatus(skyboxFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete! (Skybox Framebuffer)" << std::endl;
+
+	skyboxLowResBlurTexture = new Texture2D(skyboxLowResSize, skyboxLowResSize, 1, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	glCreateFramebuffers(1, &skyboxBlurFBO);
+	glNamedFramebufferTexture(skyboxBlurFBO, GL_COLOR_ATTACHMENT0, skyboxLowResBlurTexture->getHandle(), 0);
+	if (glCheckNamedFramebufferStatus(skyboxBlurFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete! (Skybox blur Framebuffer)" << std::endl;
+
+	skyboxDepthSlicedLUT = new Texture3D(skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTSize, 1, GL_RGBA16F, GL_RGBA, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	atmosphericScatteringLUTCache.isValid = false;
+	ShaderExtCloud_effect::atmosphericScattering = skyboxDepthSlicedLUT->getHandle();
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		irradianceMapInterpolated[i] = new TextureCubemap(irradianceMapSize, irradianceMapSize, 1, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+		prefilterMapInterpolated[i] = new TextureCubemap(prefilterMapSize, prefilterMapSize, maxMipLevels, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	}
+	glCreateFramebuffers(1, &irradianceMapInterpolatedFBO);
+	glCreateFramebuffers(1, &prefilterMapInterpolatedFBO);
+
+	// NOTE: the scheduler mixes everything on the first frame, and then these get swapped in
+	iblFrontBuffer = 0;
+	iblScheduler.reset(maxMipLevels);
+	ShaderExtPBR_daynight_cycle::irradianceMap = irradianceMapInterpolated[iblFrontBuffer]->getHandle();
+	ShaderExtPBR_daynight_cycle::prefilterMap = prefilterMapInterpolated[iblFrontBuffer]->getHandle();
+
+	//
+	// Volumetric Lighting
+	//
+	//volumetricLightingStrength = 0.01f;		// @NOTE: I hate how subtle it is, but it just needs to be like this lol (According to Tiffoneus Bamboozler)  -Timo 01-20-2022
+	volumetricLightingStrength = 0.005f;		// @FIXME: @TODO: @NOTE: This is really bad looking and can cause gpu color issues if the brightness is too high (which 0.01f was too high apparently.. on some angles) SO YOU NEED TO REDO THE VOLUMETRIC LIGHT SYSTEM AND MAKE IT BETTER!!!!!
+	// @NOTE: the volumetric textures are transient textures in the render graph now (see render())
+}
+
+void RenderManager::createRenderResolutionBuffers()
+{
+	// NOTE: everything in here is at the internal resolution (see dynamicResolution)
+	renderWidth = (uint32_t)std::max(1.0f, std::floor(MainLoop::getInstance().camera.width * dynamicResolution.getRenderScale()));
+	renderHeight = (uint32_t)std::max(1.0f, std::floor(MainLoop::getInstance().camera.height * dynamicResolution.getRenderScale()));
+
 	//
 	// Create HDR framebuffer
 	//
@@ -670,70 +744,25 @@ void RenderManager::createHDRBuffer()
 	glTextureParameteri(hdrColorBuffer, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTextureParameteri(hdrColorBuffer, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTextureParameteri(hdrColorBuffer, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTextureStorage2D(hdrColorBuffer, 1, GL_RGBA16F, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
-	//glTextureSubImage2D(hdrColorBuffer, 0, 0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height, GL_RGBA, GL_FLOAT, NULL);
+	glTextureStorage2D(hdrColorBuffer, 1, GL_RGBA16F, (GLsizei)renderWidth, (GLsizei)renderHeight);
+	//glTextureSubImage2D(hdrColorBuffer, 0, 0, 0, (GLsizei)renderWidth, (GLsizei)renderHeight, GL_RGBA, GL_FLOAT, NULL);
 	// Create depth buffer (renderbuffer)
 	glGenRenderbuffers(1, &hdrDepthRBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, hdrDepthRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, (GLsizei)renderWidth, (GLsizei)renderHeight);
 	// Attach buffers
 	glNamedFramebufferTexture(hdrFBO, GL_COLOR_ATTACHMENT0, hdrColorBuffer, 0);
 	glNamedFramebufferRenderbuffer(hdrFBO, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, hdrDepthRBO);
 	if (glCheckNamedFramebufferStatus(hdrFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::cout << "Framebuffer not complete! (HDR Render Buffer)" << std::endl;
 
-	//
-	// Create HDR FXAA framebuffer
-	// @NOTE: there is no depth buffer for this. Since it's just for postprocessing.
-	//
-	glCreateFramebuffers(1, &hdrFXAAFBO);
-	// Create floating point color buffer
-	glCreateTextures(GL_TEXTURE_2D, 1, &hdrFXAAColorBuffer);
-	glTextureParameteri(hdrFXAAColorBuffer, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTextureParameteri(hdrFXAAColorBuffer, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTextureParameteri(hdrFXAAColorBuffer, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTextureParameteri(hdrFXAAColorBuffer, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTextureStorage2D(hdrFXAAColorBuffer, 1, GL_RGBA16F, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
-	// Attach buffers
-	glNamedFramebufferTexture(hdrFXAAFBO, GL_COLOR_ATTACHMENT0, hdrFXAAColorBuffer, 0);
-	if (glCheckNamedFramebufferStatus(hdrFXAAFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (HDR FXAA Render Buffer)" << std::endl;
-
-	//
-	// Create bloom pingpong buffers
-	//
-	glm::vec2 bufferDimensions(MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height);
-	bufferDimensions /= 2.0f;		// NOTE: Bloom should start at 1/4 the size.
-
-	glGenFramebuffers(bloomBufferCount, bloomFBOs);
-	glGenTextures(bloomBufferCount, bloomColorBuffers);
-	for (size_t i = 0; i < bloomBufferCount / 2; i++)
-	{
-		bufferDimensions /= 2.0f;
-		for (size_t j = 0; j < 2; j++)
-		{
-			glBindFramebuffer(GL_FRAMEBUFFER, bloomFBOs[i * 2 + j]);
-			glBindTexture(GL_TEXTURE_2D, bloomColorBuffers[i * 2 + j]);
-			glTexImage2D(		// @TODO: We don't need the alpha channel for this yo.
-				GL_TEXTURE_2D, 0, GL_RGBA16F, (GLsizei)bufferDimensions.x, (GLsizei)bufferDimensions.y, 0, GL_RGBA, GL_FLOAT, NULL
-			);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glFramebufferTexture2D(
-				GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloomColorBuffers[i * 2 + j], 0
-			);
-		}
-	}
-
 	//
 	// Create Z-Prepass framebuffer
 	//
 	zPrePassDepthTexture =
 		new Texture2D(
-			(GLsizei)MainLoop::getInstance().camera.width,
-			(GLsizei)MainLoop::getInstance().camera.height,
+			(GLsizei)renderWidth,
+			(GLsizei)renderHeight,
 			1,
 			GL_DEPTH_COMPONENT24,
 			GL_DEPTH_COMPONENT,
@@ -746,8 +775,8 @@ void RenderManager::createHDRBuffer()
 		);
 	//ssNormalTexture =			@DEPRECATE
 	//	new Texture2D(
-	//		(GLsizei)MainLoop::getInstance().camera.width,
-	//		(GLsizei)MainLoop::getInstance().camera.height,
+	//		(GLsizei)renderWidth,
+	//		(GLsizei)renderHeight,
 	//		1,
 	//		GL_RGB16F,
 	//		GL_RGB,
@@ -768,34 +797,12 @@ void RenderManager::createHDRBuffer()
 	ShaderExtZBuffer::depthTexture = zPrePassDepthTexture->getHandle();
 
 	//
-	// Create Skybox framebuffer
+	// Create Nighttime Skybox screenspace framebuffer
 	//
-	skyboxLowResTexture = new Texture2D(skyboxLowResSize, skyboxLowResSize, 1, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-	glCreateFramebuffers(1, &skyboxFBO);
-	glNamedFramebufferTexture(skyboxFBO, GL_COLOR_ATTACHMENT0, skyboxLowResTexture->getHandle(), 0);
-	if (glCheckNamedFramebufferStatus(skyboxFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (Skybox Framebuffer)" << std::endl;
-
-	skyboxLowResBlurTexture = new Texture2D(skyboxLowResSize, skyboxLowResSize, 1, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-	glCreateFramebuffers(1, &skyboxBlurFBO);
-	glNamedFramebufferTexture(skyboxBlurFBO, GL_COLOR_ATTACHMENT0, skyboxLowResBlurTexture->getHandle(), 0);
-	if (glCheckNamedFramebufferStatus(skyboxBlurFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (Skybox blur Framebuffer)" << std::endl;
-
-	skyboxDepthSlicedLUT = new Texture3D(skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTSize, 1, GL_RGBA16F, GL_RGBA, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-	glCreateFramebuffers(skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTFBOs);
-	for (size_t i = 0; i < skyboxDepthSlicedLUTSize; i++)
-	{
-		glNamedFramebufferTextureLayer(skyboxDepthSlicedLUTFBOs[i], GL_COLOR_ATTACHMENT0, skyboxDepthSlicedLUT->getHandle(), 0, i);
-		if (glCheckNamedFramebufferStatus(skyboxDepthSlicedLUTFBOs[i], GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-			std::cout << "Framebuffer not complete! (Skybox depth sliced Framebuffer (#" << i << "))" << std::endl;
-	}
-	ShaderExtCloud_effect::atmosphericScattering = skyboxDepthSlicedLUT->getHandle();
-
 	skyboxDetailsSS =
 		new Texture2D(
-			(GLsizei)MainLoop::getInstance().camera.width,//(GLsizei)ssaoFBOSize,
-			(GLsizei)MainLoop::getInstance().camera.height,//(GLsizei)ssaoFBOSize,
+			(GLsizei)renderWidth,//(GLsizei)ssaoFBOSize,
+			(GLsizei)renderHeight,//(GLsizei)ssaoFBOSize,
 			1,
 			GL_RGB16F,
 			GL_RGB,
@@ -811,115 +818,17 @@ void RenderManager::createHDRBuffer()
 	if (glCheckNamedFramebufferStatus(skyboxDetailsSSFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::cout << "Framebuffer not complete! (Nighttime Skybox Screenspace Framebuffer)" << std::endl;
 
-	irradianceMapInterpolated = new TextureCubemap(irradianceMapSize, irradianceMapSize, 1, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-	glCreateFramebuffers(1, &irradianceMapInterpolatedFBO);
-	prefilterMapInterpolated = new TextureCubemap(prefilterMapSize, prefilterMapSize, maxMipLevels, GL_RGB16F, GL_RGB, GL_FLOAT, nullptr, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-	glCreateFramebuffers(1, &prefilterMapInterpolatedFBO);
-
-	ShaderExtPBR_daynight_cycle::irradianceMap = irradianceMapInterpolated->getHandle();
-	ShaderExtPBR_daynight_cycle::prefilterMap = prefilterMapInterpolated->getHandle();
-
-
 	//
 	// Create SSAO framebuffer
 	//
-	ssaoRotationTexture = (Texture*)Resources::getResource("texture;ssaoRotation");
-	ssaoTexture =
-		new Texture2D(
-			(GLsizei)MainLoop::getInstance().camera.width,//(GLsizei)ssaoFBOSize,
-			(GLsizei)MainLoop::getInstance().camera.height,//(GLsizei)ssaoFBOSize,
-			1,
-			GL_R8,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			nullptr,
-			GL_LINEAR,
-			GL_LINEAR,
-			GL_CLAMP_TO_EDGE,
-			GL_CLAMP_TO_EDGE
-		);
-	ssaoBlurTexture =
-		new Texture2D(
-			(GLsizei)MainLoop::getInstance().camera.width,//(GLsizei)ssaoFBOSize,
-			(GLsizei)MainLoop::getInstance().camera.height,//(GLsizei)ssaoFBOSize,
-			1,
-			GL_R8,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			nullptr,
-			GL_LINEAR,
-			GL_LINEAR,
-			GL_CLAMP_TO_EDGE,
-			GL_CLAMP_TO_EDGE
-		);
-
-	ShaderExtSSAO::ssaoTexture = ssaoTexture->getHandle();
-	
-	glCreateFramebuffers(1, &ssaoFBO);
-	glNamedFramebufferTexture(ssaoFBO, GL_COLOR_ATTACHMENT0, ssaoTexture->getHandle(), 0);
-	if (glCheckNamedFramebufferStatus(ssaoFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (SSAO Framebuffer)" << std::endl;
-	
-	glCreateFramebuffers(1, &ssaoBlurFBO);
-	glNamedFramebufferTexture(ssaoBlurFBO, GL_COLOR_ATTACHMENT0, ssaoBlurTexture->getHandle(), 0);
-	if (glCheckNamedFramebufferStatus(ssaoBlurFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (SSAO Blur Framebuffer)" << std::endl;
-
-	//
-	// Create Volumetric Lighting framebuffer
-	//
-	//volumetricLightingStrength = 0.01f;		// @NOTE: I hate how subtle it is, but it just needs to be like this lol (According to Tiffoneus Bamboozler)  -Timo 01-20-2022
-	volumetricLightingStrength = 0.005f;		// @FIXME: @TODO: @NOTE: This is really bad looking and can cause gpu color issues if the brightness is too high (which 0.01f was too high apparently.. on some angles) SO YOU NEED TO REDO THE VOLUMETRIC LIGHT SYSTEM AND MAKE IT BETTER!!!!!
-
-	constexpr float volumetricTextureScale = 0.25f;  // 0.125f;
-	volumetricTextureWidth = MainLoop::getInstance().camera.width * volumetricTextureScale;
-	volumetricTextureHeight = MainLoop::getInstance().camera.height * volumetricTextureScale;
-
-	volumetricTexture =
-		new Texture2D(
-			(GLsizei)volumetricTextureWidth,
-			(GLsizei)volumetricTextureHeight,
-			1,
-			GL_R32F,
-			GL_RED,
-			GL_FLOAT,
-			nullptr,
-			GL_NEAREST,
-			GL_LINEAR,
-			GL_CLAMP_TO_EDGE,
-			GL_CLAMP_TO_EDGE
-		);
-	volumetricBlurTexture =
-		new Texture2D(
-			(GLsizei)volumetricTextureWidth,
-			(GLsizei)volumetricTextureHeight,
-			1,
-			GL_R32F,
-			GL_RED,
-			GL_FLOAT,
-			nullptr,
-			GL_NEAREST,
-			GL_LINEAR,
-			GL_CLAMP_TO_EDGE,
-			GL_CLAMP_TO_EDGE
-		);
-
-	glCreateFramebuffers(1, &volumetricFBO);
-	glNamedFramebufferTexture(volumetricFBO, GL_COLOR_ATTACHMENT0, volumetricTexture->getHandle(), 0);
-	if (glCheckNamedFramebufferStatus(volumetricFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (Volumetric Framebuffer)" << std::endl;
-
-	glCreateFramebuffers(1, &volumetricBlurFBO);
-	glNamedFramebufferTexture(volumetricBlurFBO, GL_COLOR_ATTACHMENT0, volumetricBlurTexture->getHandle(), 0);
-	if (glCheckNamedFramebufferStatus(volumetricBlurFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (Volumetric Blur Framebuffer)" << std::endl;
+	createSSAOBuffers();
 
 	//
 	// Create cloud raymarching buffer
 	//
 	constexpr float cloudEffectTextureScale = 1.0f;			// @NOTE: @CLOUDS: This can be used for settings/quality settings. Doing full-size rendering will be default, but half and quarter size should be an option too.
-	cloudEffectTextureWidth = MainLoop::getInstance().camera.width * cloudEffectTextureScale;
-	cloudEffectTextureHeight = MainLoop::getInstance().camera.height * cloudEffectTextureScale;
+	cloudEffectTextureWidth = renderWidth * cloudEffectTextureScale;
+	cloudEffectTextureHeight = renderHeight * cloudEffectTextureScale;
 
 	cloudEffectTexture =
 		new Texture2D(
@@ -1023,6 +932,24 @@ void RenderManager::createHDRBuffer()
 }
 
 void RenderManager::destroyHDRBuffer()
+{
+	destroyRenderResolutionBuffers();
+
+	delete skyboxLowResTexture;
+	glDeleteFramebuffers(1, &skyboxFBO);
+	delete skyboxLowResBlurTexture;
+	glDeleteFramebuffers(1, &skyboxBlurFBO);
+	delete skyboxDepthSlicedLUT;
+	for (size_t i = 0; i < 2; i++)
+	{
+		delete irradianceMapInterpolated[i];
+		delete prefilterMapInterpolated[i];
+	}
+	glDeleteFramebuffers(1, &irradianceMapInterpolatedFBO);
+	glDeleteFramebuffers(1, &prefilterMapInterpolatedFBO);
+}
+
+void RenderManager::destroyRenderResolutionBuffers()
 {
 	delete cloudEffectTexture;
 	delete cloudEffectDepthTexture;
@@ -1035,28 +962,10 @@ void RenderManager::destroyHDRBuffer()
 	delete cloudEffectTAAHistoryTexture;
 	glDeleteFramebuffers(1, &cloudEffectTAAHistoryFBO);
 
-	delete volumetricBlurTexture;
-	glDeleteFramebuffers(1, &volumetricBlurFBO);
-	delete volumetricTexture;
-	glDeleteFramebuffers(1, &volumetricFBO);
-
-	delete skyboxLowResTexture;
-	glDeleteFramebuffers(1, &skyboxFBO);
-	delete skyboxLowResBlurTexture;
-	glDeleteFramebuffers(1, &skyboxBlurFBO);
-	delete skyboxDepthSlicedLUT;
-	glDeleteFramebuffers(skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTFBOs);
 	delete skyboxDetailsSS;
 	glDeleteFramebuffers(1, &skyboxDetailsSSFBO);
-	delete irradianceMapInterpolated;
-	glDeleteFramebuffers(1, &irradianceMapInterpolatedFBO);
-	delete prefilterMapInterpolated;
-	glDeleteFramebuffers(1, &prefilterMapInterpolatedFBO);
 
-	delete ssaoBlurTexture;
-	glDeleteFramebuffers(1, &ssaoBlurFBO);
-	delete ssaoTexture;
-	glDeleteFramebuffers(1, &ssaoFBO);
+	destroySSAOBuffers();
 
 	delete zPrePassDepthTexture;
 	glDeleteFramebuffers(1, &zPrePassFBO);
@@ -1064,12 +973,63 @@ void RenderManager::destroyHDRBuffer()
 	glDeleteTextures(1, &hdrColorBuffer);
 	glDeleteRenderbuffers(1, &hdrDepthRBO);
 	glDeleteFramebuffers(1, &hdrFBO);
+}
+
+void RenderManager::createSSAOBuffers()
+{
+	ssaoWidth = std::max(1u, renderWidth / ssaoResolutionDivisor);
+	ssaoHeight = std::max(1u, renderHeight / ssaoResolutionDivisor);
+
+	// NOTE: 5 mips is plenty. The radius would have to be >256 pixels to get past that
+	ssaoNumMips = 1;
+	while (ssaoNumMips < 5 && (std::max(ssaoWidth, ssaoHeight) >> ssaoNumMips) > 0)
+		ssaoNumMips++;
+
+	ssaoRotationTexture = (Texture*)Resources::getResource("texture;ssaoRotation");
+	ssaoLinearDepthTexture = new Texture2D((GLsizei)ssaoWidth, (GLsizei)ssaoHeight, (GLsizei)ssaoNumMips, GL_R32F, GL_RED, GL_FLOAT, nullptr, GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	ssaoTexture = new Texture2D((GLsizei)ssaoWidth, (GLsizei)ssaoHeight, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	ssaoBlurTexture = new Texture2D((GLsizei)ssaoWidth, (GLsizei)ssaoHeight, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+	glCreateFramebuffers(1, &ssaoFBO);
+	glNamedFramebufferTexture(ssaoFBO, GL_COLOR_ATTACHMENT0, ssaoTexture->getHandle(), 0);
+	if (glCheckNamedFramebufferStatus(ssaoFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete! (SSAO Framebuffer)" << std::endl;
+
+	glCreateFramebuffers(1, &ssaoBlurFBO);
+	glNamedFramebufferTexture(ssaoBlurFBO, GL_COLOR_ATTACHMENT0, ssaoBlurTexture->getHandle(), 0);
+	if (glCheckNamedFramebufferStatus(ssaoBlurFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete! (SSAO Blur Framebuffer)" << std::endl;
+
+	if (ssaoResolutionDivisor == 1)
+	{
+		// Already at full res, so the pbr shader can just read it straight
+		ssaoFullResTexture = nullptr;
+		ssaoUpsampleFBO = 0;
+		ShaderExtSSAO::ssaoTexture = ssaoTexture->getHandle();
+		return;
+	}
 
-	glDeleteTextures(1, &hdrFXAAColorBuffer);
-	glDeleteFramebuffers(1, &hdrFXAAFBO);
+	ssaoFullResTexture = new Texture2D((GLsizei)renderWidth, (GLsizei)renderHeight, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	glCreateFramebuffers(1, &ssaoUpsampleFBO);
+	glNamedFramebufferTexture(ssaoUpsampleFBO, GL_COLOR_ATTACHMENT0, ssaoFullResTexture->getHandle(), 0);
+	if (glCheckNamedFramebufferStatus(ssaoUpsampleFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete! (SSAO Upsample Framebuffer)" << std::endl;
 
-	glDeleteTextures(bloomBufferCount, bloomColorBuffers);
-	glDeleteFramebuffers(bloomBufferCount, bloomFBOs);
+	ShaderExtSSAO::ssaoTexture = ssaoFullResTexture->getHandle();
+}
+
+void RenderManager::destroySSAOBuffers()
+{
+	delete ssaoLinearDepthTexture;
+	delete ssaoBlurTexture;
+	glDeleteFramebuffers(1, &ssaoBlurFBO);
+	delete ssaoTexture;
+	glDeleteFramebuffers(1, &ssaoFBO);
+	if (ssaoFullResTexture != nullptr)
+	{
+		delete ssaoFullResTexture;
+		glDeleteFramebuffers(1, &ssaoUpsampleFBO);
+	}
 }
 
 constexpr GLsizei luminanceTextureSize = 64;
@@ -1141,426 +1101,101 @@ void RenderManager::destroyLumenAdaptationTextures()
 	delete hdrLumAdaptationProcessed;
 }
 
+void RenderManager::createVolumetricFroxelTextures()
+{
+	// NOTE: the grid's a constant size (not the screen's), so no need to recreate on resize
+	for (size_t i = 0; i < 2; i++)
+		volumetricFroxelLit[i] = new Texture3D(volumetricFroxelGridWidth, volumetricFroxelGridHeight, volumetricFroxelGridDepth, 1, GL_R16F, GL_RED, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	volumetricFroxelIntegrated = new Texture3D(volumetricFroxelGridWidth, volumetricFroxelGridHeight, volumetricFroxelGridDepth, 1, GL_RGBA32F, GL_RGBA, GL_FLOAT, nullptr, GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	volumetricFroxelHistory.isValid = false;
+}
+
+void RenderManager::destroyVolumetricFroxelTextures()
+{
+	for (size_t i = 0; i < 2; i++)
+		delete volumetricFroxelLit[i];
+	delete volumetricFroxelIntegrated;
+}
+
 // @NOTE: https://www.guerrilla-games.com/media/News/Files/The-Real-time-Volumetric-Cloudscapes-of-Horizon-Zero-Dawn.pdf
-constexpr GLsizei cloudNoiseTex1Size = 128;
-constexpr GLsizei cloudNoiseTex2Size = 32;
-Texture* cloudNoise1Channels[4];
-Texture* cloudNoise2Channels[3];
 void RenderManager::createCloudNoise()
 {
-	constexpr const char* baseNoiseDirectory = "res/_generated/cloud_base_noise";
-	constexpr const char* detailNoiseDirectory = "res/_generated/cloud_detail_noise";
-
 	//
-	// PRECHECK: see if should load clouds from textures instead
+	// @Cloud noise 1:
+	//		R: worley	(Lowest frequency)
+	//		G: worley
+	//		B: worley
+	//		A: worley	(Highest frequency)
 	//
-	if (std::filesystem::is_directory(baseNoiseDirectory) &&
-		std::filesystem::is_directory(detailNoiseDirectory))
-	{
-		std::cout << "::CLOUD NOISE GENERATOR:: Cache detected. Loading noise texture from cache..." << std::endl;
-		try
-		{
-			// Compile all base noise files together
-			std::vector<ImageFile> baseNoiseFiles;
-			std::vector<ImageFile> detailNoiseFiles;
+	std::vector<uint8_t> baseNoiseTexels;
+	cloudNoise1 = createCloudNoiseVolume("cloud_base_noise", cloudNoiseInfo.baseNoiseParams, GL_RGBA8, GL_RGBA, baseNoiseTexels);
+	createCloudDensityBounds(baseNoiseTexels);
 
-			for (size_t i = 0; i < cloudNoiseTex1Size; i++)
-			{
-				std::string filename = "/layer" + std::to_string(i) + ".png";
-				if (!std::filesystem::exists(baseNoiseDirectory + filename))
-				{
-					std::cout << "File " << std::string(baseNoiseDirectory) << filename << " Does not exist." << std::endl;
-					throw new std::exception();
-				}
+	//
+	// Cloud noise 2:
+	//		R: worley	(Lowest frequency)
+	//		G: worley
+	//		B: worley	(Highest frequency)
+	//
+	std::vector<uint8_t> detailNoiseTexels;
+	cloudNoise2 = createCloudNoiseVolume("cloud_detail_noise", cloudNoiseInfo.detailNoiseParams, GL_RGB8, GL_RGB, detailNoiseTexels);
+}
 
-				baseNoiseFiles.push_back({ baseNoiseDirectory + filename, true, false, false });
-			}
+Texture* RenderManager::createCloudNoiseVolume(const std::string& name, const CloudNoiseVolumeParams& params, GLenum internalFormat, GLenum format, std::vector<uint8_t>& texels)
+{
+	const uint64_t paramsHash = CloudNoiseGenerator::hashParams(params);
+	const std::string cachePath = CloudNoiseGenerator::getCachePath(name, paramsHash);
 
-			for (size_t i = 0; i < cloudNoiseTex2Size; i++)
-			{
-				std::string filename = "/layer" + std::to_string(i) + ".png";
-				if (!std::filesystem::exists(detailNoiseDirectory + filename))
-				{
-					std::cout << "File " << std::string(detailNoiseDirectory) << filename << " Does not exist." << std::endl;
-					throw new std::exception();
-				}
+	if (CloudNoiseGenerator::loadFromFile(cachePath, paramsHash, params, texels))
+		std::cout << "::CLOUD NOISE GENERATOR:: Loaded " << name << " from cache" << std::endl;
+	else
+	{
+		std::cout << "::CLOUD NOISE GENERATOR:: Generating " << name << "..." << std::endl;
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		CloudNoiseGenerator::generate(params, texels);
+		const auto endTime = std::chrono::high_resolution_clock::now();
+		std::cout << "::CLOUD NOISE GENERATOR:: Finished " << name << " (" << std::chrono::duration<double, std::milli>(endTime - startTime).count() << "ms)" << std::endl;
 
-				detailNoiseFiles.push_back({ detailNoiseDirectory + filename, true, false, false });
-			}
+		CloudNoiseGenerator::saveToFile(cachePath, paramsHash, params, texels);
+	}
 
-			// Load up the textures (@CLOUDS: noise 1 has 4 channels RGBA, and noise2 has 3 channels RGB)
-			Texture::setLoadSync(true);
-			cloudNoise1 = new Texture3DFromFile(baseNoiseFiles, GL_RGBA, GL_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT, GL_REPEAT);
-			cloudNoise2 = new Texture3DFromFile(detailNoiseFiles, GL_RGB, GL_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT, GL_REPEAT);
-			Texture::setLoadSync(false);
+	// NOTE: the whole volume goes up in one glTextureSubImage3D() in here
+	return new Texture3D((GLsizei)params.size, (GLsizei)params.size, (GLsizei)params.size, 1, internalFormat, format, GL_UNSIGNED_BYTE, texels.data(), GL_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT, GL_REPEAT);
+}
 
-			std::cout << "::CLOUD NOISE GENERATOR:: Successfully loaded noise cache" << std::endl;
-			return;
-		}
-		catch (const std::exception& e)
-		{
-			std::cout << "::ERROR:: " << e.what() << std::endl;
-			std::cout << "::CLOUD NOISE GENERATOR:: Cache load failed. Falling back to auto-generate." << std::endl;
-		}
-	}
+void RenderManager::createCloudDensityBounds(const std::vector<uint8_t>& baseNoiseTexels)
+{
+	constexpr uint32_t cellSize = 8;
+
+	// NOTE: these are the same texels that got uploaded to cloudNoise1, whether they came from the cache or just got generated
+	const uint32_t noiseSize = cloudNoiseInfo.baseNoiseParams.size;
+	std::vector<uint8_t> bounds;
+	CloudDensityBounds::generate(baseNoiseTexels.data(), noiseSize, cellSize, bounds);
+
+	const GLsizei boundsSize = (GLsizei)(noiseSize / cellSize);
+	cloudDensityBounds = new Texture3D(boundsSize, boundsSize, boundsSize, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, bounds.data(), GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);
+
+	// Same test as the shader, w/ the default settings
+	size_t numEmptyCells = 0;
+	const float maxDensityOffset = std::max(cloudEffectInfo.densityOffsetInner, cloudEffectInfo.densityOffsetOuter);
+	for (uint8_t bound : bounds)
+		if (std::max(0.0f, bound / 255.0f + maxDensityOffset) * cloudEffectInfo.densityMultiplier <= cloudEffectInfo.densityRequirement)
+			numEmptyCells++;
+	std::cout << "::CLOUD NOISE GENERATOR:: Density bounds " << boundsSize << "^3 (" << numEmptyCells << "/" << bounds.size() << " cells skippable)" << std::endl;
+}
 
-	//
-	// GENERATE CLOUD NOISE (Fallback/first time... @NOTE: ship the game with the cloud cache fyi, or at least a file that contains the points)
-	//
-	std::cout << "::CLOUD NOISE GENERATOR:: Start" << std::endl;
-
-	//
-	// @Cloud noise 1:
-	//		R: perlin-worley
-	//		G: worley	(Same freq. as R)
-	//		B: worley	(Medium frequency)
-	//		A: worley	(Highest frequency)
-	//
-	cloudNoise1 =
-		new Texture3D(
-			cloudNoiseTex1Size,
-			cloudNoiseTex1Size,
-			cloudNoiseTex1Size,
-			1,
-			GL_RGBA8,
-			GL_RGBA,
-			GL_UNSIGNED_BYTE,
-			nullptr,
-			GL_LINEAR,
-			GL_LINEAR,
-			GL_REPEAT,
-			GL_REPEAT,
-			GL_REPEAT
-		);
-
-	// Create just a temporary UBO to store the worley noise points
-	GLuint cloudNoiseUBO;
-	glCreateBuffers(1, &cloudNoiseUBO);
-	glNamedBufferData(cloudNoiseUBO, sizeof(glm::vec4) * 1024, nullptr, GL_STATIC_DRAW);	 // @NOTE: the int:numPoints variable gets rounded up to 16 bytes in the buffer btw. No packing.
-	glBindBufferBase(GL_UNIFORM_BUFFER, 4, cloudNoiseUBO);
-
-	Texture* cloudNoise1FractalOctaves[] = {
-		new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT),
-		new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT),
-		new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT),
-	};
-
-	//Texture* cloudNoise1Channels[] = {
-	cloudNoise1Channels[0] = new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-	cloudNoise1Channels[1] = new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-	cloudNoise1Channels[2] = new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-	cloudNoise1Channels[3] = new Texture3D(cloudNoiseTex1Size, cloudNoiseTex1Size, cloudNoiseTex1Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-//};
-
-	const size_t channelGridSizes[] = {
-		3, 7, 11,
-		9, 20, 33,
-		12, 24, 40,
-		20, 35, 49
-	};		// @NOTE: amount^3 must not exceed 1024... bc I can't figure out how to get more than 1024 in a ubo even though the spec says I should have at least 64kb of vram????
-	std::vector<glm::vec3> worleyPoints[] = {
-		std::vector<glm::vec3>(), std::vector<glm::vec3>(), std::vector<glm::vec3>(),
-		std::vector<glm::vec3>(), std::vector<glm::vec3>(), std::vector<glm::vec3>(),
-		std::vector<glm::vec3>(), std::vector<glm::vec3>(), std::vector<glm::vec3>(),
-		std::vector<glm::vec3>(), std::vector<glm::vec3>(), std::vector<glm::vec3>()
-	};
-
-	std::cout << "::CLOUD NOISE GENERATOR:: Generating grid offsets" << std::endl;
-
-	std::random_device randomDevice;
-	std::mt19937 randomEngine(randomDevice());
-	std::uniform_real_distribution<> distribution(0.0, 1.0);
-
-	for (size_t i = 0; i < 12; i++)
-	{
-		size_t worleyPointCount = channelGridSizes[i] * channelGridSizes[i] * channelGridSizes[i];
-		for (size_t j = 0; j < glm::min((size_t)1024, worleyPointCount); j++)
-			worleyPoints[i].push_back(
-				glm::vec3(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine))
-			);
-	}
-
-	// Render out all the layers with the points!
-	// @TODO: I think what needs to happen is to generate a texture that contains all the points for a worley map and then use that texture to generate the actual worley map. This look up image can just be a GL_NEAREST filtered 8192x8192 texture I think. That should be big enough, and then delete it after it's not needed anymore.  -Timo
-	//		@RESPONSE: So I think that the current sitation where only 1024 points are inserted and then repeated works just fine actually. This allows for a smaller set of information needed to look thru.  -Timo
-	// @TODO: Also I am noting that there is noise stacking on page 33 of the pdf (https://www.guerrilla-games.com/media/News/Files/The-Real-time-Volumetric-Cloudscapes-of-Horizon-Zero-Dawn.pdf) FOR SURE!!!!!
-	std::cout << "::CLOUD NOISE GENERATOR:: Rendering base worley noise" << std::endl;
-	
-	GLuint noiseFBO;
-	glCreateFramebuffers(1, &noiseFBO);
-	glViewport(0, 0, cloudNoiseTex1Size, cloudNoiseTex1Size);
-
-	// Render noise textures onto 4 different 8 bit textures
-	for (size_t j = 0; j < 4; j++)
-	{
-		cloudNoiseGenerateShader->use();
-		cloudNoiseGenerateShader->setInt("includePerlin", (int)(j == 0));
-
-		// Render each octave (3 total) for one 8 bit noise texture
-		size_t numNoiseOctaves = 3;
-		for (size_t k = 0; k < numNoiseOctaves; k++)
-		{
-			cloudNoiseGenerateShader->setInt("gridSize", (int)channelGridSizes[j * numNoiseOctaves + k]);
-
-			assert(worleyPoints[j * numNoiseOctaves + k].size() <= 1024);
-			cloudNoiseInfo.worleyPoints.clear();
-			for (size_t worleypointcopy = 0; worleypointcopy < worleyPoints[j * numNoiseOctaves + k].size(); worleypointcopy++)
-				cloudNoiseInfo.worleyPoints.push_back(glm::vec4(worleyPoints[j * numNoiseOctaves + k][worleypointcopy], 0.0f));
-			glNamedBufferSubData(cloudNoiseUBO, 0, sizeof(glm::vec4) * cloudNoiseInfo.worleyPoints.size(), glm::value_ptr(cloudNoiseInfo.worleyPoints[0]));	 // @NOTE: the offset is sizeof(glm::vec4) bc the memory layout std140 rounds up the 4 bytes of the sizeof(int) up to 16 bytes (size of a vec4)
-
-			//
-			// Render each layer with the noise profile
-			//
-			for (size_t i = 0; i < cloudNoiseTex1Size; i++)
-			{
-				cloudNoiseGenerateShader->setFloat("currentRenderDepth", (float)i / (float)cloudNoiseTex1Size);
-
-				glNamedFramebufferTextureLayer(noiseFBO, GL_COLOR_ATTACHMENT0, cloudNoise1FractalOctaves[k]->getHandle(), 0, i);
-				auto status = glCheckNamedFramebufferStatus(noiseFBO, GL_FRAMEBUFFER);
-				if (status != GL_FRAMEBUFFER_COMPLETE)
-					std::cout << "Framebuffer not complete! (Worley Noise FBO) (Layer: " << i << ") (Channel: " << j << ") (Octave: " << k << ")" << std::endl;
-
-				glBindFramebuffer(GL_FRAMEBUFFER, noiseFBO);
-				glClear(GL_COLOR_BUFFER_BIT);
-				renderQuad();
-				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			}
-		}
-
-		//
-		// Combine octaves into a single noise channel
-		//
-		for (size_t i = 0; i < cloudNoiseTex1Size; i++)
-		{
-			cloudNoiseFractalShader->use();
-			cloudNoiseFractalShader->setFloat("currentRenderDepth", (float)i / (float)cloudNoiseTex1Size);
-			cloudNoiseFractalShader->setSampler("sample1", cloudNoise1FractalOctaves[0]->getHandle());
-			cloudNoiseFractalShader->setSampler("sample2", cloudNoise1FractalOctaves[1]->getHandle());
-			cloudNoiseFractalShader->setSampler("sample3", cloudNoise1FractalOctaves[2]->getHandle());
-			glNamedFramebufferTextureLayer(noiseFBO, GL_COLOR_ATTACHMENT0, cloudNoise1Channels[j]->getHandle(), 0, i);
-			auto status = glCheckNamedFramebufferStatus(noiseFBO, GL_FRAMEBUFFER);
-			if (status != GL_FRAMEBUFFER_COMPLETE)
-				std::cout << "Framebuffer not complete! (Worley Noise FBO) (Layer: " << i << ") (Channel: " << j << ")" << std::endl;
-
-			glBindFramebuffer(GL_FRAMEBUFFER, noiseFBO);
-			glClear(GL_COLOR_BUFFER_BIT);
-			renderQuad();
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		}
-	}
-
-	//
-	// Render all 4 of the noise textures onto a single RGBA texture
-	//
-	for (size_t i = 0; i < cloudNoiseTex1Size; i++)
-	{
-		cloudNoiseCombineShader->use();
-		cloudNoiseCombineShader->setFloat("currentRenderDepth", (float)i / (float)cloudNoiseTex1Size);
-		cloudNoiseCombineShader->setSampler("R", cloudNoise1Channels[0]->getHandle());
-		cloudNoiseCombineShader->setSampler("G", cloudNoise1Channels[1]->getHandle());
-		cloudNoiseCombineShader->setSampler("B", cloudNoise1Channels[2]->getHandle());
-		cloudNoiseCombineShader->setSampler("A", cloudNoise1Channels[3]->getHandle());
-
-		glNamedFramebufferTextureLayer(noiseFBO, GL_COLOR_ATTACHMENT0, cloudNoise1->getHandle(), 0, i);
-		auto status = glCheckNamedFramebufferStatus(noiseFBO, GL_FRAMEBUFFER);
-		if (status != GL_FRAMEBUFFER_COMPLETE)
-			std::cout << "Framebuffer not complete! (Worley Noise FBO) (Layer: " << i << ") (Channel: COMBINER)" << std::endl;
-
-		glBindFramebuffer(GL_FRAMEBUFFER, noiseFBO);
-		glClear(GL_COLOR_BUFFER_BIT);
-		renderQuad();
-
-		// Save the render result for later!		@COPYPASTA
-		static bool first = true;
-		if (first)
-		{
-			first = false;
-			std::filesystem::create_directories(baseNoiseDirectory);
-		}
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, noiseFBO);
-		glReadBuffer(GL_COLOR_ATTACHMENT0);
-		GLubyte* pixels = new GLubyte[4 * cloudNoiseTex1Size * cloudNoiseTex1Size];
-		glReadPixels(0, 0, cloudNoiseTex1Size, cloudNoiseTex1Size, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-		glReadBuffer(GL_NONE);
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-		stbi_flip_vertically_on_write(true);
-		stbi_write_png((baseNoiseDirectory + std::string("/layer") + std::to_string(i) + ".png").c_str(), cloudNoiseTex1Size, cloudNoiseTex1Size, 4, pixels, 4 * cloudNoiseTex1Size);
-		std::cout << "::CLOUD NOISE GENERATOR:: \tSaved render for base_noise layer " << i << std::endl;
-		delete[] pixels;
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-
-	//
-	// Cloud noise 2:
-	//		R: worley	(Lowest frequency)
-	//		G: worley
-	//		B: worley	(Highest frequency)
-	//
-	cloudNoise2 =
-		new Texture3D(
-			cloudNoiseTex2Size,
-			cloudNoiseTex2Size,
-			cloudNoiseTex2Size,
-			1,
-			GL_RGB8,
-			GL_RGB,
-			GL_UNSIGNED_BYTE,
-			nullptr,
-			GL_LINEAR,
-			GL_LINEAR,
-			GL_REPEAT,
-			GL_REPEAT,
-			GL_REPEAT
-		);
-
-	Texture* cloudNoise2FractalOctaves[] = {
-		new Texture3D(cloudNoiseTex2Size, cloudNoiseTex2Size, cloudNoiseTex2Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT),
-		new Texture3D(cloudNoiseTex2Size, cloudNoiseTex2Size, cloudNoiseTex2Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT),
-		new Texture3D(cloudNoiseTex2Size, cloudNoiseTex2Size, cloudNoiseTex2Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT),
-	};
-
-	//Texture* cloudNoise2Channels[] = {
-		cloudNoise2Channels[0] = new Texture3D(cloudNoiseTex2Size, cloudNoiseTex2Size, cloudNoiseTex2Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-		cloudNoise2Channels[1] = new Texture3D(cloudNoiseTex2Size, cloudNoiseTex2Size, cloudNoiseTex2Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-		cloudNoise2Channels[2] = new Texture3D(cloudNoiseTex2Size, cloudNoiseTex2Size, cloudNoiseTex2Size, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT, GL_REPEAT);   //,
-	//};
-
-	// @COPYPASTA: Reinsert/recalculate the randomized points for worley noise
-	std::cout << "::CLOUD NOISE GENERATOR:: Generating detail noise grid offsets" << std::endl;
-
-	for (size_t i = 0; i < 9; i++)
-	{
-		size_t worleyPointCount = channelGridSizes[i] * channelGridSizes[i] * channelGridSizes[i];
-		worleyPoints[i].clear();
-		for (size_t j = 0; j < glm::min((size_t)1024, worleyPointCount); j++)
-			worleyPoints[i].push_back(
-				glm::vec3(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine))
-			);
-	}
-
-	// Render it out!
-	glViewport(0, 0, cloudNoiseTex2Size, cloudNoiseTex2Size);
-	std::cout << "::CLOUD NOISE GENERATOR:: Rendering detail worley noise" << std::endl;
-
-	// Render noise textures onto 3 different 8 bit textures
-	for (size_t j = 0; j < 3; j++)
-	{
-		cloudNoiseGenerateShader->use();
-		cloudNoiseGenerateShader->setInt("includePerlin", false);
-
-		// Render each octave (3 total) for one 8 bit noise texture
-		size_t numNoiseOctaves = 3;
-		for (size_t k = 0; k < numNoiseOctaves; k++)
-		{
-			cloudNoiseGenerateShader->setInt("gridSize", (int)channelGridSizes[j * numNoiseOctaves + k]);
-
-			assert(worleyPoints[j * numNoiseOctaves + k].size() <= 1024);
-			cloudNoiseInfo.worleyPoints.clear();
-			for (size_t worleypointcopy = 0; worleypointcopy < worleyPoints[j * numNoiseOctaves + k].size(); worleypointcopy++)
-				cloudNoiseInfo.worleyPoints.push_back(glm::vec4(worleyPoints[j * numNoiseOctaves + k][worleypointcopy], 0.0f));
-			glNamedBufferSubData(cloudNoiseUBO, 0, sizeof(glm::vec4) * cloudNoiseInfo.worleyPoints.size(), glm::value_ptr(cloudNoiseInfo.worleyPoints[0]));	 // @NOTE: the offset is sizeof(glm::vec4) bc the memory layout std140 rounds up the 4 bytes of the sizeof(int) up to 16 bytes (size of a vec4)
-
-			//
-			// Render each layer with the noise profile
-			//
-			for (size_t i = 0; i < cloudNoiseTex2Size; i++)
-			{
-				cloudNoiseGenerateShader->setFloat("currentRenderDepth", (float)i / (float)cloudNoiseTex2Size);
-
-				glNamedFramebufferTextureLayer(noiseFBO, GL_COLOR_ATTACHMENT0, cloudNoise2FractalOctaves[k]->getHandle(), 0, i);
-				auto status = glCheckNamedFramebufferStatus(noiseFBO, GL_FRAMEBUFFER);
-				if (status != GL_FRAMEBUFFER_COMPLETE)
-					std::cout << "Framebuffer not complete! (Worley Noise FBO (pt2)) (Layer: " << i << ") (Channel: " << j << ") (Octave: " << k << ")" << std::endl;
-
-				glBindFramebuffer(GL_FRAMEBUFFER, noiseFBO);
-				glClear(GL_COLOR_BUFFER_BIT);
-				renderQuad();
-				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			}
-		}
-
-		//
-		// Combine octaves into a single noise channel
-		//
-		for (size_t i = 0; i < cloudNoiseTex2Size; i++)
-		{
-			cloudNoiseFractalShader->use();
-			cloudNoiseFractalShader->setFloat("currentRenderDepth", (float)i / (float)cloudNoiseTex2Size);
-			cloudNoiseFractalShader->setSampler("sample1", cloudNoise2FractalOctaves[0]->getHandle());
-			cloudNoiseFractalShader->setSampler("sample2", cloudNoise2FractalOctaves[1]->getHandle());
-			cloudNoiseFractalShader->setSampler("sample3", cloudNoise2FractalOctaves[2]->getHandle());
-			glNamedFramebufferTextureLayer(noiseFBO, GL_COLOR_ATTACHMENT0, cloudNoise2Channels[j]->getHandle(), 0, i);
-			auto status = glCheckNamedFramebufferStatus(noiseFBO, GL_FRAMEBUFFER);
-			if (status != GL_FRAMEBUFFER_COMPLETE)
-				std::cout << "Framebuffer not complete! (Worley Noise FBO (pt2)) (Layer: " << i << ") (Channel: " << j << ")" << std::endl;
-
-			glBindFramebuffer(GL_FRAMEBUFFER, noiseFBO);
-			glClear(GL_COLOR_BUFFER_BIT);
-			renderQuad();
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		}
-	}
-
-	//
-	// Render all 3 of the noise textures onto a single RGB texture
-	//
-	for (size_t i = 0; i < cloudNoiseTex2Size; i++)
-	{
-		cloudNoiseCombineShader->use();
-		cloudNoiseCombineShader->setFloat("currentRenderDepth", (float)i / (float)cloudNoiseTex2Size);
-		cloudNoiseCombineShader->setSampler("R", cloudNoise2Channels[0]->getHandle());
-		cloudNoiseCombineShader->setSampler("G", cloudNoise2Channels[1]->getHandle());
-		cloudNoiseCombineShader->setSampler("B", cloudNoise2Channels[2]->getHandle());
-
-		glNamedFramebufferTextureLayer(noiseFBO, GL_COLOR_ATTACHMENT0, cloudNoise2->getHandle(), 0, i);
-		auto status = glCheckNamedFramebufferStatus(noiseFBO, GL_FRAMEBUFFER);
-		if (status != GL_FRAMEBUFFER_COMPLETE)
-			std::cout << "Framebuffer not complete! (Worley Noise FBO (pt2)) (Layer: " << i << ") (Channel: COMBINER)" << std::endl;
-
-		glBindFramebuffer(GL_FRAMEBUFFER, noiseFBO);
-		glClear(GL_COLOR_BUFFER_BIT);
-		renderQuad();
-
-		// Save the render result for later!		@COPYPASTA
-		static bool first = true;
-		if (first)
-		{
-			first = false;
-			std::filesystem::create_directories(detailNoiseDirectory);
-		}
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, noiseFBO);
-		glReadBuffer(GL_COLOR_ATTACHMENT0);
-		GLubyte* pixels = new GLubyte[3 * cloudNoiseTex2Size * cloudNoiseTex2Size];
-		glReadPixels(0, 0, cloudNoiseTex2Size, cloudNoiseTex2Size, GL_RGB, GL_UNSIGNED_BYTE, pixels);
-		glReadBuffer(GL_NONE);
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-		stbi_flip_vertically_on_write(true);
-		stbi_write_png((detailNoiseDirectory + std::string("/layer") + std::to_string(i) + ".png").c_str(), cloudNoiseTex2Size, cloudNoiseTex2Size, 3, pixels, 3 * cloudNoiseTex2Size);
-		std::cout << "::CLOUD NOISE GENERATOR:: \tSaved render for detail_noise layer " << i << std::endl;
-		delete[] pixels;
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-
-	// Cleanup
-	glDeleteFramebuffers(1, &noiseFBO);
-	glDeleteBuffers(1, &cloudNoiseUBO);
-
-
-	std::cout << "::CLOUD NOISE GENERATOR:: Finished" << std::endl;
-}
-
-void RenderManager::destroyCloudNoise()
-{
-	delete cloudNoise1;
-	delete cloudNoise2;
-}
+void RenderManager::destroyCloudNoise()
+{
+	delete cloudNoise1;
+	delete cloudNoise2;
+	delete cloudDensityBounds;
+}
 
 void RenderManager::createShaderPrograms()
 {
 	skybox_program_id = (Shader*)Resources::getResource("shader;skybox");
 	skyboxDetailsShader = (Shader*)Resources::getResource("shader;skyboxDetails");
+	atmosphericScatteringLUTComputeShader = (Shader*)Resources::getResource("shader;atmosphericScatteringLUT");
 	debug_csm_program_id = (Shader*)Resources::getResource("shader;debugCSM");
 	debug_cloud_noise_program_id = (Shader*)Resources::getResource("shader;debugCloudNoise");
 	text_program_id = (Shader*)Resources::getResource("shader;text");
@@ -1570,21 +1205,26 @@ void RenderManager::createShaderPrograms()
 	environmentMapMixerShader = (Shader*)Resources::getResource("shader;environmentMapMixer");
 	hdrLuminanceProgramId = (Shader*)Resources::getResource("shader;luminance_postprocessing");
 	hdrLumAdaptationComputeProgramId = (Shader*)Resources::getResource("shader;computeLuminanceAdaptation");
+	hdrLumReductionComputeProgramId = (Shader*)Resources::getResource("shader;luminanceReduction");
 	bloom_postprocessing_program_id = (Shader*)Resources::getResource("shader;bloom_postprocessing");
 	postprocessing_program_id = (Shader*)Resources::getResource("shader;postprocessing");
 	fxaaPostProcessingShader = (Shader*)Resources::getResource("shader;fxaa_postprocessing");
+	bloomDownsampleComputeShader = (Shader*)Resources::getResource("shader;bloomDownsampleCompute");
+	bloomUpsampleComputeShader = (Shader*)Resources::getResource("shader;bloomUpsampleCompute");
 	pbrShaderProgramId = (Shader*)Resources::getResource("shader;pbr");
 	notificationUIProgramId = (Shader*)Resources::getResource("shader;notificationUI");
 	INTERNALzPassShader = (Shader*)Resources::getResource("shader;zPassShader");
 	ssaoProgramId = (Shader*)Resources::getResource("shader;ssao");
+	ssaoLinearDepthComputeShader = (Shader*)Resources::getResource("shader;ssaoLinearDepth");
+	ssaoUpsampleProgramId = (Shader*)Resources::getResource("shader;ssaoUpsample");
 	volumetricProgramId = (Shader*)Resources::getResource("shader;volumetricLighting");
+	volumetricFroxelInjectShader = (Shader*)Resources::getResource("shader;volumetricFroxelInject");
+	volumetricFroxelIntegrateShader = (Shader*)Resources::getResource("shader;volumetricFroxelIntegrate");
+	volumetricFroxelApplyShader = (Shader*)Resources::getResource("shader;volumetricFroxelApply");
 	blurXProgramId = (Shader*)Resources::getResource("shader;blurX");
 	blurYProgramId = (Shader*)Resources::getResource("shader;blurY");
 	blurX3ProgramId = (Shader*)Resources::getResource("shader;blurX3");
 	blurY3ProgramId = (Shader*)Resources::getResource("shader;blurY3");
-	cloudNoiseGenerateShader = (Shader*)Resources::getResource("shader;cloudNoiseGenerate");
-	cloudNoiseFractalShader = (Shader*)Resources::getResource("shader;cloudNoiseFractal");
-	cloudNoiseCombineShader = (Shader*)Resources::getResource("shader;cloudNoiseCombine");
 	cloudEffectShader = (Shader*)Resources::getResource("shader;cloudEffectSS");
 	cloudEffectFloodFillShaderX = (Shader*)Resources::getResource("shader;cloudEffectDepthFloodfillX");
 	cloudEffectFloodFillShaderY = (Shader*)Resources::getResource("shader;cloudEffectDepthFloodfillY");
@@ -1599,6 +1239,7 @@ void RenderManager::destroyShaderPrograms()
 {
 	Resources::unloadResource("shader;skybox");
 	Resources::unloadResource("shader;skyboxDetails");
+	Resources::unloadResource("shader;atmosphericScatteringLUT");
 	Resources::unloadResource("shader;debugCSM");
 	Resources::unloadResource("shader;debugCloudNoise");
 	Resources::unloadResource("shader;text");
@@ -1608,21 +1249,26 @@ void RenderManager::destroyShaderPrograms()
 	Resources::unloadResource("shader;environmentMapMixer");
 	Resources::unloadResource("shader;luminance_postprocessing");
 	Resources::unloadResource("shader;computeLuminanceAdaptation");
+	Resources::unloadResource("shader;luminanceReduction");
 	Resources::unloadResource("shader;bloom_postprocessing");
 	Resources::unloadResource("shader;postprocessing");
 	Resources::unloadResource("shader;fxaa_postprocessing");
+	Resources::unloadResource("shader;bloomDownsampleCompute");
+	Resources::unloadResource("shader;bloomUpsampleCompute");
 	Resources::unloadResource("shader;pbr");
 	Resources::unloadResource("shader;notificationUI");
 	Resources::unloadResource("shader;zPassShader");
 	Resources::unloadResource("shader;ssao");
+	Resources::unloadResource("shader;ssaoLinearDepth");
+	Resources::unloadResource("shader;ssaoUpsample");
 	Resources::unloadResource("shader;volumetricLighting");
+	Resources::unloadResource("shader;volumetricFroxelInject");
+	Resources::unloadResource("shader;volumetricFroxelIntegrate");
+	Resources::unloadResource("shader;volumetricFroxelApply");
 	Resources::unloadResource("shader;blurX");
 	Resources::unloadResource("shader;blurY");
 	Resources::unloadResource("shader;blurX3");
 	Resources::unloadResource("shader;blurY3");
-	Resources::unloadResource("shader;cloudNoiseGenerate");
-	Resources::unloadResource("shader;cloudNoiseFractal");
-	Resources::unloadResource("shader;cloudNoiseCombine");
 	Resources::unloadResource("shader;cloudEffectSS");
 	Resources::unloadResource("shader;cloudEffectDepthFloodfillX");
 	Resources::unloadResource("shader;cloudEffectDepthFloodfillY");
@@ -1736,6 +1382,15 @@ void RenderManager::render()
 	createShaderPrograms();
 #endif
 
+	//
+	// Dynamic resolution
+	// NOTE: the frame time is from a few frames ago, which the controller's cooldown covers
+	//
+	float gpuFrameTimeMs;
+	if (gpuFrameTimer.getLatestFrameTimeMs(gpuFrameTimeMs) && dynamicResolution.update(gpuFrameTimeMs))
+		recreateRenderBuffers();
+	gpuFrameTimer.begin();
+
 	//
 	// Keyboard shortcuts for wireframe and physics debug
 	// 
@@ -1774,333 +1429,658 @@ void RenderManager::render()
 		updateCameraInfoUBO(cameraProjection, cameraView);
 	}
 
+	DebugDraw::getInstance().beginFrame(MainLoop::getInstance().unscaledDeltaTime);		// NOTE: before anything adds debug lines this frame (the imgui pass does a bunch). Unscaled so timed lines still run out while paused
+
 #ifdef _DEVELOP
 	renderImGuiPass();
 #endif
 
+	//
+	// Skin all of the animated meshes once for the whole frame
+	//
+	skinningPrepass.beginFrame();
+	if (skinningPrepass.enabled)
+	{
+		if (MainLoop::getInstance().timelineViewerMode)
+		{
+			if (modelForTimelineViewer != nullptr)
+				modelForTimelineViewer->submitSkinning(&skinningPrepass);
+		}
+		else
+			for (size_t i = 0; i < MainLoop::getInstance().renderObjects.size(); i++)
+				MainLoop::getInstance().renderObjects[i]->submitSkinning(&skinningPrepass);
+		skinningPrepass.dispatch();
+	}
+
 	//
 	// Render shadow map(s) to depth framebuffer(s)
 	//
+	shadowLayerPass.stats = {};
+	CascadeScheduler::INTERNALresetStats();
+
+	// Find the shadow casters that moved, so that the cached CSM cascades (and point light atlas tiles) know if they need a re-render
+	for (size_t i = 0; i < MainLoop::getInstance().renderObjects.size(); i++)
+		MainLoop::getInstance().renderObjects[i]->submitShadowCasterChanges(changedShadowCasterBounds);
+
 	for (size_t i = 0; i < MainLoop::getInstance().lightObjects.size(); i++)
 	{
-		if (!MainLoop::getInstance().lightObjects[i]->castsShadows)
+		if (!MainLoop::getInstance().lightObjects[i]->castsShadows || MainLoop::getInstance().lightObjects[i]->lightType == LightType::POINT)
 			continue;
 
 		MainLoop::getInstance().lightObjects[i]->renderPassShadowMap();
 	}
 
+	// NOTE: point lights get their space in the atlas handed out by priority, so they're all done here at once
+	shadowAtlas.update(MainLoop::getInstance().lightObjects.getValues(), MainLoop::getInstance().camera, changedShadowCasterBounds);
+	shadowAtlas.render();
+
+	changedShadowCasterBounds.clear();
 	setupSceneShadows();
 
 	
 #ifdef _DEVELOP
+	if (DEBUGdoPicking)
+		updatePicking();
+#endif
+
+	updateLightInformationUBO();
+	renderScene();
+
 	//
-	// Render Picking texture
+	// Find the main light (directional light) for volumetric lighting
 	//
-	if (!MainLoop::getInstance().timelineViewerMode && DEBUGdoPicking)
+	LightComponent* mainlight = nullptr;
+	for (size_t i = 0; i < MainLoop::getInstance().lightObjects.size(); i++)
 	{
-		if (!MainLoop::getInstance().playMode)		// NOTE: no reason in particular for making this !playmode only
+		if (MainLoop::getInstance().lightObjects[i]->lightType == LightType::DIRECTIONAL)
 		{
-			static int mostRecentPickedIndex = -1;
+			mainlight = MainLoop::getInstance().lightObjects[i];
+			assert(mainlight->castsShadows);		// NOTE: turn off volumetric lighting if shadows are turned off
+			break;
+		}
+	}
+	assert(mainlight != nullptr);		// NOTE: turn off volumetric lighting if shadows are turned off
 
-			// Render out picking data
-			glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
-			glBindFramebuffer(GL_FRAMEBUFFER, pickingFBO);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	//
+	// Post processing render graph
+	// @NOTE: the passes only get declared (and the graph compiled) when something that changes the shape
+	// of the graph changes (the resolution or one of the toggles). Everything that changes every frame goes
+	// thru postProcessingFrame, which the passes read when they run.
+	//
+	const uint32_t screenWidth = (uint32_t)MainLoop::getInstance().camera.width;
+	const uint32_t screenHeight = (uint32_t)MainLoop::getInstance().camera.height;
+	const bool isUpscaling = (renderWidth != screenWidth || renderHeight != screenHeight);
 
-			pickingRenderFormatShader = (Shader*)Resources::getResource("shader;pickingRenderFormat");
-			pickingRenderFormatShader->use();
-			for (uint32_t i = 0; i < (uint32_t)MainLoop::getInstance().objects.size(); i++)
-			{
-				if (i == (uint32_t)mostRecentPickedIndex)
-					continue;
+	PostProcessingGraphKey graphKey;
+	graphKey.renderWidth = renderWidth;
+	graphKey.renderHeight = renderHeight;
+	graphKey.screenWidth = screenWidth;
+	graphKey.screenHeight = screenHeight;
+	graphKey.doVolumetricLighting = (mainlight->colorIntensity > 0.0f);
+	graphKey.doFroxelVolumetricLighting = doFroxelVolumetricLighting;
+	graphKey.doComputeLuminanceReduction = doComputeLuminanceReduction;
+	graphKey.doFXAAInPostprocessing = fuseFXAAIntoPostprocessing && !doCloudDenoiseNontemporal && !isUpscaling;
+	graphKey.doComputeBloom = doComputeBloom;
+	graphKey.doCloudDenoiseNontemporal = doCloudDenoiseNontemporal;
 
-				RenderComponent* rc = MainLoop::getInstance().objects[i]->getRenderComponent();
-				if (rc == nullptr)
-					continue;
+	postProcessingFrame.mainlight = mainlight;
+	postProcessingFrame.sunLightColor = mainlight->color * mainlight->colorIntensity * volumetricLightingStrength * volumetricLightingStrengthExternal;
 
-				pickingRenderFormatShader->setUint("objectID", i + 1);
-				rc->renderShadow(pickingRenderFormatShader);
-			}
+	if (graphKey.doFroxelVolumetricLighting && graphKey.doVolumetricLighting)
+	{
+		const float farPlane = ShaderExtCSM_shadow::farPlane;
+		if (volumetricFroxelHistory.isValid && volumetricFroxelHistory.farPlane != farPlane)
+			volumetricFroxelHistory.isValid = false;		// The slices moved
+
+		// Where in the slice each froxel samples (van der Corput, so any 2^n frames in a row cover the slice evenly)
+		constexpr float depthJitters[8] = { 0.5f, 0.25f, 0.75f, 0.125f, 0.625f, 0.375f, 0.875f, 0.0625f };
+		postProcessingFrame.froxelFarPlane = farPlane;
+		postProcessingFrame.froxelDepthJitter = depthJitters[volumetricFroxelHistory.frameIndex % 8];
+		postProcessingFrame.froxelHistory = volumetricFroxelHistory;
+		postProcessingFrame.froxelLitHistory = volumetricFroxelLit[volumetricFroxelLitIndex]->getHandle();
+		postProcessingFrame.froxelLit = volumetricFroxelLit[1 - volumetricFroxelLitIndex]->getHandle();
+
+		// This frame's grid is next frame's history
+		volumetricFroxelLitIndex = 1 - volumetricFroxelLitIndex;
+		volumetricFroxelHistory.isValid = true;
+		volumetricFroxelHistory.projectionView = cameraInfo.projectionView;
+		volumetricFroxelHistory.cameraPosition = MainLoop::getInstance().camera.position;
+		volumetricFroxelHistory.farPlane = farPlane;
+		volumetricFroxelHistory.frameIndex++;
+	}
+	else
+		volumetricFroxelHistory.isValid = false;
 
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!isPostProcessingGraphBuilt || !(graphKey == postProcessingGraphKey))
+	{
+		buildPostProcessingGraph(graphKey);
+		postProcessingGraphKey = graphKey;
+		isPostProcessingGraphBuilt = true;
+	}
 
-			// Read pixel
-			double mouseX, mouseY;
-			glfwGetCursorPos(MainLoop::getInstance().window, &mouseX, &mouseY);
-			PixelInfo pixInfo = readPixelFromPickingBuffer((uint32_t)mouseX, (uint32_t)(MainLoop::getInstance().camera.height - mouseY - 1));
-			size_t id = (size_t)pixInfo.objectID;
+	// NOTE: the imported textures get swapped around (ping-pongs) and recreated (resizes), which doesn't change the graph
+	renderGraph.setImportedTexture(postProcessingImports.hdrColor, hdrColorBuffer);
+	renderGraph.setImportedTexture(postProcessingImports.lumDownsampling, hdrLumDownsampling->getHandle());
+	renderGraph.setImportedTexture(postProcessingImports.lumPrevious, hdrLumAdaptationPrevious->getHandle());
+	renderGraph.setImportedTexture(postProcessingImports.lumProcessed, hdrLumAdaptationProcessed->getHandle());
+	if (postProcessingImports.froxelLit != RenderGraph::INVALID_TEXTURE)
+	{
+		renderGraph.setImportedTexture(postProcessingImports.froxelLitHistory, postProcessingFrame.froxelLitHistory);
+		renderGraph.setImportedTexture(postProcessingImports.froxelLit, postProcessingFrame.froxelLit);
+		renderGraph.setImportedTexture(postProcessingImports.froxelIntegrated, volumetricFroxelIntegrated->getHandle());
+	}
 
-			mostRecentPickedIndex = (int)id - 1;
+	renderGraph.execute();
 
-			if (!glfwGetKey(MainLoop::getInstance().window, GLFW_KEY_LEFT_CONTROL) &&
-				!glfwGetKey(MainLoop::getInstance().window, GLFW_KEY_RIGHT_CONTROL))
-				deselectAllSelectedObject();
-			if (mostRecentPickedIndex >= 0)
-			{
-				if (isObjectSelected((size_t)mostRecentPickedIndex))
-					deselectObject((size_t)mostRecentPickedIndex);
-				else
-					addSelectObject((size_t)mostRecentPickedIndex);
-			}
-		}
+	//
+	// Debug lines and triangles (on top of the tonemapped image)
+	//
+	DebugDraw::getInstance().render(
+		MainLoop::getInstance().camera.width,
+		MainLoop::getInstance().camera.height,
+		MainLoop::getInstance().camera.zNear,
+		MainLoop::getInstance().camera.zFar
+	);
 
-		// Unset flag
-		DEBUGdoPicking = false;
-	}
+	gpuFrameTimer.end();		// NOTE: ImGui isn't included. It's always native resolution
+
+	// Swap the hdrLumAdaptation ping-pong textures
+	std::swap(hdrLumAdaptationPrevious, hdrLumAdaptationProcessed);
+
+#ifdef _DEVELOP
+	// ImGui buffer swap
+	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 #endif
+}
 
-	updateLightInformationUBO();
-	renderScene();
+
+void RenderManager::buildPostProcessingGraph(const PostProcessingGraphKey& key)
+{
+	// NOTE: the passes stick around until the next rebuild, so they can't capture anything from a render() by reference. Only
+	// handles and stuff from the key get captured, and the rest comes from the members (see postProcessingFrame)
+	renderGraph.reset();
+
+	const bool doVolumetricLighting = key.doVolumetricLighting;
+	const bool doFXAAInPostprocessing = key.doFXAAInPostprocessing;
+
+	postProcessingImports = {};
+	postProcessingImports.hdrColor = renderGraph.importTexture("hdrColorBuffer", hdrColorBuffer, { key.renderWidth, key.renderHeight, GL_RGBA16F, GL_LINEAR, GL_LINEAR });
+	postProcessingImports.lumDownsampling = renderGraph.importTexture("hdrLumDownsampling", hdrLumDownsampling->getHandle(), { (uint32_t)luminanceTextureSize, (uint32_t)luminanceTextureSize, GL_R16F, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR });
+	postProcessingImports.lumPrevious = renderGraph.importTexture("hdrLumAdaptationPrevious", hdrLumAdaptationPrevious->getHandle(), { 1, 1, GL_R16F, GL_LINEAR, GL_LINEAR });
+	postProcessingImports.lumProcessed = renderGraph.importTexture("hdrLumAdaptationProcessed", hdrLumAdaptationProcessed->getHandle(), { 1, 1, GL_R16F, GL_LINEAR, GL_LINEAR });
+	const RenderGraph::TextureHandle rgHDRColor = postProcessingImports.hdrColor;
+	const RenderGraph::TextureHandle rgLumDownsampling = postProcessingImports.lumDownsampling;
+	const RenderGraph::TextureHandle rgLumPrevious = postProcessingImports.lumPrevious;
+	const RenderGraph::TextureHandle rgLumProcessed = postProcessingImports.lumProcessed;
 
 	//
 	// Compute volumetric lighting for just main light (directional light)
+	// NOTE: when the sun is off nothing reads these, so they get culled
 	//
-	LightComponent* mainlight = nullptr;
-	for (size_t i = 0; i < MainLoop::getInstance().lightObjects.size(); i++)
+	constexpr float volumetricTextureScale = 0.25f;  // 0.125f;
+	const RenderGraphTextureDesc volumetricDesc = { std::max(1u, (uint32_t)(key.renderWidth * volumetricTextureScale)), std::max(1u, (uint32_t)(key.renderHeight * volumetricTextureScale)), GL_R32F, GL_NEAREST, GL_LINEAR };
+	const RenderGraph::TextureHandle rgVolumetric = renderGraph.createTexture("volumetric", volumetricDesc);
+	if (key.doFroxelVolumetricLighting)
 	{
-		if (MainLoop::getInstance().lightObjects[i]->lightType == LightType::DIRECTIONAL)
+		//
+		// Froxel grid: how lit each froxel is (w/ last frame's reprojected in), then integrated front to back
+		// NOTE: these write to imported textures, which keeps them alive, so only add them when something's gonna read the grid
+		//
+		if (doVolumetricLighting)
 		{
-			mainlight = MainLoop::getInstance().lightObjects[i];
-			assert(mainlight->castsShadows);		// NOTE: turn off volumetric lighting if shadows are turned off
-			break;
+			const RenderGraphTextureDesc froxelLitDesc = { (uint32_t)volumetricFroxelGridWidth, (uint32_t)volumetricFroxelGridHeight, GL_R16F, GL_LINEAR, GL_LINEAR };				// NOTE: the graph doesn't know about the depth. It's only for the stats
+			const RenderGraphTextureDesc froxelIntegratedDesc = { (uint32_t)volumetricFroxelGridWidth, (uint32_t)volumetricFroxelGridHeight, GL_RGBA32F, GL_LINEAR, GL_LINEAR };
+			postProcessingImports.froxelLitHistory = renderGraph.importTexture("volumetricFroxelLitHistory", volumetricFroxelLit[volumetricFroxelLitIndex]->getHandle(), froxelLitDesc);
+			postProcessingImports.froxelLit = renderGraph.importTexture("volumetricFroxelLit", volumetricFroxelLit[1 - volumetricFroxelLitIndex]->getHandle(), froxelLitDesc);
+			postProcessingImports.froxelIntegrated = renderGraph.importTexture("volumetricFroxelIntegrated", volumetricFroxelIntegrated->getHandle(), froxelIntegratedDesc);
+
+			size_t pass = renderGraph.addPass("Volumetric Froxel Inject", RenderGraphPassType::COMPUTE, [this](RenderGraph& graph)
+			{
+				const PostProcessingFrame& frame = postProcessingFrame;
+				volumetricFroxelInjectShader->use();
+				volumetricFroxelInjectShader->setSampler("froxelLitHistory", frame.froxelLitHistory);
+				volumetricFroxelInjectShader->setVec3("mainlightDirection", frame.mainlight->facingDirection);
+				volumetricFroxelInjectShader->setVec3("mainCameraPosition", MainLoop::getInstance().camera.position);
+				volumetricFroxelInjectShader->setMat4("inverseProjectionMatrix", glm::inverse(cameraInfo.projection));
+				volumetricFroxelInjectShader->setMat4("inverseViewMatrix", glm::inverse(cameraInfo.view));
+				volumetricFroxelInjectShader->setFloat("depthJitter", frame.froxelDepthJitter);
+				volumetricFroxelInjectShader->setBool("historyValid", frame.froxelHistory.isValid);
+				volumetricFroxelInjectShader->setFloat("historyBlend", volumetricFroxelHistoryBlend);
+				volumetricFroxelInjectShader->setMat4("prevCameraProjectionView", frame.froxelHistory.projectionView);
+				volumetricFroxelInjectShader->setVec3("prevCameraPosition", frame.froxelHistory.cameraPosition);
+				glBindImageTexture(0, frame.froxelLit, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16F);
+				glDispatchCompute((volumetricFroxelGridWidth + 3) / 4, (volumetricFroxelGridHeight + 3) / 4, (volumetricFroxelGridDepth + 3) / 4);
+			});
+			renderGraph.read(pass, postProcessingImports.froxelLitHistory);
+			renderGraph.write(pass, postProcessingImports.froxelLit);
+
+			pass = renderGraph.addPass("Volumetric Froxel Integrate", RenderGraphPassType::COMPUTE, [this](RenderGraph& graph)
+			{
+				volumetricFroxelIntegrateShader->use();
+				volumetricFroxelIntegrateShader->setSampler("froxelLit", postProcessingFrame.froxelLit);
+				volumetricFroxelIntegrateShader->setFloat("farPlane", postProcessingFrame.froxelFarPlane);
+				volumetricFroxelIntegrateShader->setFloat("extinction", volumetricFroxelExtinction);
+				glBindImageTexture(0, volumetricFroxelIntegrated->getHandle(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+				glDispatchCompute((volumetricFroxelGridWidth + 7) / 8, (volumetricFroxelGridHeight + 7) / 8, 1);		// One thread per column
+			});
+			renderGraph.read(pass, postProcessingImports.froxelLit);
+			renderGraph.write(pass, postProcessingImports.froxelIntegrated);
+
+			pass = renderGraph.addPass("Volumetric Froxel Apply", RenderGraphPassType::GRAPHICS, [this, rgVolumetric](RenderGraph& graph)
+			{
+				graph.bindRenderTarget(rgVolumetric);
+				volumetricFroxelApplyShader->use();
+				volumetricFroxelApplyShader->setSampler("froxelIntegrated", volumetricFroxelIntegrated->getHandle());
+				volumetricFroxelApplyShader->setVec3("mainlightDirection", postProcessingFrame.mainlight->facingDirection);
+				volumetricFroxelApplyShader->setVec3("mainCameraPosition", MainLoop::getInstance().camera.position);
+				volumetricFroxelApplyShader->setMat4("inverseProjectionMatrix", glm::inverse(cameraInfo.projection));
+				volumetricFroxelApplyShader->setMat4("inverseViewMatrix", glm::inverse(cameraInfo.view));
+				volumetricFroxelApplyShader->setFloat("farPlane", postProcessingFrame.froxelFarPlane);
+				renderQuad();
+			});
+			renderGraph.read(pass, postProcessingImports.froxelIntegrated);
+			renderGraph.write(pass, rgVolumetric);
 		}
 	}
-	assert(mainlight != nullptr);		// NOTE: turn off volumetric lighting if shadows are turned off
-
-	if (mainlight->colorIntensity > 0.0f)
+	else
 	{
-
-		glViewport(0, 0, volumetricTextureWidth, volumetricTextureHeight);
-		glBindFramebuffer(GL_FRAMEBUFFER, volumetricFBO);
-		volumetricProgramId->use();
-		volumetricProgramId->setVec3("mainCameraPosition", MainLoop::getInstance().camera.position);
-		volumetricProgramId->setVec3("mainlightDirection", mainlight->facingDirection);
-		volumetricProgramId->setMat4("inverseProjectionMatrix", glm::inverse(cameraInfo.projection));
-		volumetricProgramId->setMat4("inverseViewMatrix", glm::inverse(cameraInfo.view));
-		renderQuad();
+		const RenderGraph::TextureHandle rgVolumetricRaw = renderGraph.createTexture("volumetricRaw", volumetricDesc);
+		const RenderGraph::TextureHandle rgVolumetricBlurX = renderGraph.createTexture("volumetricBlurX", volumetricDesc);
+		size_t pass = renderGraph.addPass("Volumetric", RenderGraphPassType::GRAPHICS, [this, rgVolumetricRaw](RenderGraph& graph)
+		{
+			graph.bindRenderTarget(rgVolumetricRaw);
+			volumetricProgramId->use();
+			volumetricProgramId->setVec3("mainCameraPosition", MainLoop::getInstance().camera.position);
+			volumetricProgramId->setVec3("mainlightDirection", postProcessingFrame.mainlight->facingDirection);
+			volumetricProgramId->setMat4("inverseProjectionMatrix", glm::inverse(cameraInfo.projection));
+			volumetricProgramId->setMat4("inverseViewMatrix", glm::inverse(cameraInfo.view));
+			renderQuad();
+		});
+		renderGraph.write(pass, rgVolumetricRaw);
 
 		//
 		// Blur volumetric lighting pass
 		//
-		glBindFramebuffer(GL_FRAMEBUFFER, volumetricBlurFBO);
-		glClear(GL_COLOR_BUFFER_BIT);
-		blurXProgramId->use();
-		blurXProgramId->setSampler("textureMap", volumetricTexture->getHandle());
-		renderQuad();
+		pass = renderGraph.addPass("Volumetric Blur X", RenderGraphPassType::GRAPHICS, [this, rgVolumetricRaw, rgVolumetricBlurX](RenderGraph& graph)
+		{
+			graph.bindRenderTarget(rgVolumetricBlurX);
+			glClear(GL_COLOR_BUFFER_BIT);
+			blurXProgramId->use();
+			blurXProgramId->setSampler("textureMap", graph.getTexture(rgVolumetricRaw));
+			renderQuad();
+		});
+		renderGraph.read(pass, rgVolumetricRaw);
+		renderGraph.write(pass, rgVolumetricBlurX);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, volumetricFBO);
-		glClear(GL_COLOR_BUFFER_BIT);
-		blurYProgramId->use();
-		blurYProgramId->setSampler("textureMap", volumetricBlurTexture->getHandle());
-		renderQuad();
+		pass = renderGraph.addPass("Volumetric Blur Y", RenderGraphPassType::GRAPHICS, [this, rgVolumetricBlurX, rgVolumetric](RenderGraph& graph)
+		{
+			graph.bindRenderTarget(rgVolumetric);
+			glClear(GL_COLOR_BUFFER_BIT);
+			blurYProgramId->use();
+			blurYProgramId->setSampler("textureMap", graph.getTexture(rgVolumetricBlurX));
+			renderQuad();
+		});
+		renderGraph.read(pass, rgVolumetricBlurX);
+		renderGraph.write(pass, rgVolumetric);
 	}
 
-	//
-	// Do luminance
-	//
-	glViewport(0, 0, luminanceTextureSize, luminanceTextureSize);
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrLumFBO);
-	glClear(GL_COLOR_BUFFER_BIT);
-	hdrLuminanceProgramId->use();
-	hdrLuminanceProgramId->setSampler("hdrColorBuffer", hdrColorBuffer);
-	hdrLuminanceProgramId->setSampler("volumetricLighting", volumetricTexture->getHandle());
-	hdrLuminanceProgramId->setVec3("sunLightColor", mainlight->color * mainlight->colorIntensity * volumetricLightingStrength * volumetricLightingStrengthExternal);
-	renderQuad();
-	glGenerateTextureMipmap(hdrLumDownsampling->getHandle());		// This gets the FBO's luminance down to 1x1
+	// NOTE: w/o the volumetric texture the sun color is 0 anyways, so whatever's bound there doesn't matter
+	auto getVolumetricTexture = [this, doVolumetricLighting, rgVolumetric](RenderGraph& graph) { return doVolumetricLighting ? graph.getTexture(rgVolumetric) : hdrLumAdaptationProcessed->getHandle(); };
 
-	//
-	// Kick off light adaptation compute shader
-	//
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-	hdrLumAdaptationComputeProgramId->use();
-	glBindImageTexture(0, hdrLumAdaptationPrevious->getHandle(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R16F);
-	glBindImageTexture(1, hdrLumAdaptation1x1, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R16F);
-	glBindImageTexture(2, hdrLumAdaptationProcessed->getHandle(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16F);
-	//constexpr glm::vec2 adaptationSpeeds(0.5f, 2.5f);
-	constexpr glm::vec2 adaptationSpeeds(1.5f, 2.5f);
-	hdrLumAdaptationComputeProgramId->setVec2("adaptationSpeed", adaptationSpeeds* MainLoop::getInstance().deltaTime);
-	glDispatchCompute(1, 1, 1);
-	//glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);		// See this later
+	//static constexpr glm::vec2 adaptationSpeeds(0.5f, 2.5f);
+	static constexpr glm::vec2 adaptationSpeeds(1.5f, 2.5f);
+	if (key.doComputeLuminanceReduction)
+	{
+		//
+		// Do luminance: reduce it and adapt to it in one dispatch (see luminance_reduction.comp)
+		//
+		size_t pass = renderGraph.addPass("Luminance Reduction", RenderGraphPassType::COMPUTE, [this, doVolumetricLighting, rgVolumetric](RenderGraph& graph)
+		{
+			hdrLumReductionComputeProgramId->use();
+			hdrLumReductionComputeProgramId->setSampler("hdrColorBuffer", hdrColorBuffer);
+			hdrLumReductionComputeProgramId->setSampler("volumetricLighting", doVolumetricLighting ? graph.getTexture(rgVolumetric) : hdrLumAdaptationPrevious->getHandle());		// NOTE: not the processed one, since that's getting written to here
+			hdrLumReductionComputeProgramId->setVec3("sunLightColor", postProcessingFrame.sunLightColor);
+			hdrLumReductionComputeProgramId->setVec2("adaptationSpeed", adaptationSpeeds * MainLoop::getInstance().deltaTime);
+			hdrLumReductionComputeProgramId->setBool("useHistogram", luminanceUseHistogram);
+			hdrLumReductionComputeProgramId->setVec2("logLuminanceRange", luminanceHistogramLogRange);
+			hdrLumReductionComputeProgramId->setVec2("histogramPercentiles", luminanceHistogramPercentiles);
+			glBindImageTexture(0, hdrLumAdaptationPrevious->getHandle(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R16F);
+			glBindImageTexture(1, hdrLumAdaptationProcessed->getHandle(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16F);
+			glDispatchCompute(1, 1, 1);
+		});
+		renderGraph.read(pass, rgHDRColor);
+		if (doVolumetricLighting)
+			renderGraph.read(pass, rgVolumetric);
+		renderGraph.read(pass, rgLumPrevious);
+		renderGraph.write(pass, rgLumProcessed);
+	}
+	else
+	{
+		//
+		// Do luminance
+		//
+		{
+			size_t pass = renderGraph.addPass("Luminance", RenderGraphPassType::GRAPHICS, [this, getVolumetricTexture](RenderGraph& graph)
+			{
+				glViewport(0, 0, luminanceTextureSize, luminanceTextureSize);
+				glBindFramebuffer(GL_FRAMEBUFFER, hdrLumFBO);
+				glClear(GL_COLOR_BUFFER_BIT);
+				hdrLuminanceProgramId->use();
+				hdrLuminanceProgramId->setSampler("hdrColorBuffer", hdrColorBuffer);
+				hdrLuminanceProgramId->setSampler("volumetricLighting", getVolumetricTexture(graph));
+				hdrLuminanceProgramId->setVec3("sunLightColor", postProcessingFrame.sunLightColor);
+				renderQuad();
+				glGenerateTextureMipmap(hdrLumDownsampling->getHandle());		// This gets the FBO's luminance down to 1x1
+			});
+			renderGraph.read(pass, rgHDRColor);
+			if (doVolumetricLighting)
+				renderGraph.read(pass, rgVolumetric);
+			renderGraph.write(pass, rgLumDownsampling);
+		}
+
+		//
+		// Kick off light adaptation compute shader
+		//
+		{
+			size_t pass = renderGraph.addPass("Luminance Adaptation", RenderGraphPassType::COMPUTE, [this](RenderGraph& graph)
+			{
+				hdrLumAdaptationComputeProgramId->use();
+				glBindImageTexture(0, hdrLumAdaptationPrevious->getHandle(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R16F);
+				glBindImageTexture(1, hdrLumAdaptation1x1, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R16F);
+				glBindImageTexture(2, hdrLumAdaptationProcessed->getHandle(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16F);
+				hdrLumAdaptationComputeProgramId->setVec2("adaptationSpeed", adaptationSpeeds* MainLoop::getInstance().deltaTime);
+				glDispatchCompute(1, 1, 1);
+			});
+			renderGraph.read(pass, rgLumPrevious);
+			renderGraph.read(pass, rgLumDownsampling);		// NOTE: hdrLumAdaptation1x1 is a view of its last mip
+			renderGraph.write(pass, rgLumProcessed);
+		}
+	}
 
 #ifdef _DEVELOP
 	//
 	// @Debug: Render wireframe of selected object
 	//
-	static float selectedColorIntensityTime = -1.15f;
-	static size_t prevNumSelectedObjs = 0;
-	if (glfwGetKey(MainLoop::getInstance().window, GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE &&		// @NOTE: when pressing shift, this is the start to doing group append for voxel groups, so in the even that this happens, now the creator can see better by not rendering the wireframe (I believe)
-		!MainLoop::getInstance().playMode)														// @NOTE: don't render the wireframe if in playmode. It's annoying.
 	{
-		if (prevNumSelectedObjs != selectedObjectIndices.size())
+		size_t pass = renderGraph.addPass("Selection Wireframe", RenderGraphPassType::GRAPHICS, [this](RenderGraph& graph)
 		{
-			// Reset @Copypasta
-			prevNumSelectedObjs = selectedObjectIndices.size();
-			selectedColorIntensityTime = -1.15f;
-		}
-
-		auto objs = getSelectedObjects();
-		if (!objs.empty())
-		{
-			// Render that selected objects!!!!
-			Shader* selectionWireframeShader =
-				(Shader*)Resources::getResource("shader;selectionSkinnedWireframe");
-			selectionWireframeShader->use();
-
-			glDepthMask(GL_FALSE);
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			static float selectedColorIntensityTime = -1.15f;
+			static size_t prevNumSelectedObjs = 0;
+			if (glfwGetKey(MainLoop::getInstance().window, GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE &&		// @NOTE: when pressing shift, this is the start to doing group append for voxel groups, so in the even that this happens, now the creator can see better by not rendering the wireframe (I believe)
+				!MainLoop::getInstance().playMode)														// @NOTE: don't render the wireframe if in playmode. It's annoying.
 			{
-				glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-				glViewport(0, 0, MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height);
+				if (prevNumSelectedObjs != selectedObjectHandles.size())
+				{
+					// Reset @Copypasta
+					prevNumSelectedObjs = selectedObjectHandles.size();
+					selectedColorIntensityTime = -1.15f;
+				}
 
-				for (size_t i = 0; i < objs.size(); i++)
+				auto objs = getSelectedObjects();
+				if (!objs.empty())
 				{
-					RenderComponent* rc = objs[i]->getRenderComponent();
-					if (rc != nullptr)
+					// Render that selected objects!!!!
+					Shader* selectionWireframeShader =
+						(Shader*)Resources::getResource("shader;selectionSkinnedWireframe");
+					selectionWireframeShader->use();
+
+					glDepthMask(GL_FALSE);
+					glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 					{
-						float evaluatedIntensityValue = (sinf(selectedColorIntensityTime) + 1);
-						//std::cout << evaluatedIntensityValue << std::endl;		@DEBUG
-						selectionWireframeShader->setVec4("color", { 0.973f, 0.29f, 1.0f, std::clamp(evaluatedIntensityValue, 0.0f, 1.0f) });
-						selectionWireframeShader->setFloat("colorIntensity", evaluatedIntensityValue);
-						rc->renderShadow(selectionWireframeShader);
+						glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+						glViewport(0, 0, renderWidth, renderHeight);
+
+						for (size_t i = 0; i < objs.size(); i++)
+						{
+							RenderComponent* rc = objs[i]->getRenderComponent();
+							if (rc != nullptr)
+							{
+								float evaluatedIntensityValue = (sinf(selectedColorIntensityTime) + 1);
+								//std::cout << evaluatedIntensityValue << std::endl;		@DEBUG
+								selectionWireframeShader->setVec4("color", { 0.973f, 0.29f, 1.0f, std::clamp(evaluatedIntensityValue, 0.0f, 1.0f) });
+								selectionWireframeShader->setFloat("colorIntensity", evaluatedIntensityValue);
+								rc->renderShadow(selectionWireframeShader);
+							}
+						}
 					}
+					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+					glDepthMask(GL_TRUE);
+
+					selectedColorIntensityTime += MainLoop::getInstance().deltaTime * 4.0f;
 				}
 			}
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			glDepthMask(GL_TRUE);
-
-			selectedColorIntensityTime += MainLoop::getInstance().deltaTime * 4.0f;
-		}
-	}
-	else
-	{
-		// Reset @Copypasta
-		prevNumSelectedObjs = selectedObjectIndices.size();
-		selectedColorIntensityTime = -1.15f;
+			else
+			{
+				// Reset @Copypasta
+				prevNumSelectedObjs = selectedObjectHandles.size();
+				selectedColorIntensityTime = -1.15f;
+			}
+		});
+		renderGraph.write(pass, rgHDRColor);
 	}
 #endif
 
-	// Check to make sure the luminance adaptation compute shader is fimished
-	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
-
 	//
 	// Apply @FXAA
-	//
-	glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFXAAFBO);
-	glClear(GL_COLOR_BUFFER_BIT);
-	fxaaPostProcessingShader->use();
-	fxaaPostProcessingShader->setSampler("hdrColorBuffer", hdrColorBuffer);
-	fxaaPostProcessingShader->setSampler("luminanceProcessed", hdrLumAdaptationProcessed->getHandle());
-	fxaaPostProcessingShader->setFloat("exposure", exposure);
-	fxaaPostProcessingShader->setVec2("invFullResolution", { 1.0f / MainLoop::getInstance().camera.width, 1.0f / MainLoop::getInstance().camera.height });
-	renderQuad();
+	// NOTE: the graph puts the barrier for the luminance adaptation compute shader in before this
+	// @NOTE: w/ fuseFXAAIntoPostprocessing this happens in the tonemapping pass instead, and the UI goes
+	// straight onto the hdr buffer (so the UI gets FXAA'd too). The cloud denoise hack has the tonemapping
+	// pass render into the hdr buffer, so it can't read from there and has to use the separate pass.
+	// @NOTE: w/ dynamic resolution the separate pass is also where it gets upscaled to native res. That way
+	// the UI, bloom and tonemapping are all at native res. (FXAA's offsets are in the scene's texels)
+	//
+	RenderGraph::TextureHandle rgPostprocessingSource = rgHDRColor;
+	if (!doFXAAInPostprocessing)
+	{
+		rgPostprocessingSource = renderGraph.createTexture("hdrFXAA", { key.screenWidth, key.screenHeight, GL_RGBA16F, GL_LINEAR, GL_LINEAR });
+
+		size_t pass = renderGraph.addPass("FXAA", RenderGraphPassType::GRAPHICS, [this, rgPostprocessingSource](RenderGraph& graph)
+		{
+			graph.bindRenderTarget(rgPostprocessingSource);
+			glClear(GL_COLOR_BUFFER_BIT);
+			fxaaPostProcessingShader->use();
+			fxaaPostProcessingShader->setSampler("hdrColorBuffer", hdrColorBuffer);
+			fxaaPostProcessingShader->setSampler("luminanceProcessed", hdrLumAdaptationProcessed->getHandle());
+			fxaaPostProcessingShader->setFloat("exposure", exposure);
+			fxaaPostProcessingShader->setVec2("invFullResolution", { 1.0f / renderWidth, 1.0f / renderHeight });
+			renderQuad();
+		});
+		renderGraph.read(pass, rgHDRColor);
+		renderGraph.read(pass, rgLumProcessed);
+		renderGraph.write(pass, rgPostprocessingSource);
+	}
 
 	//
 	// Render ui
 	// @NOTE: the cameraUBO changes from the normal world space camera to the UI space camera mat4's.
 	// @NOTE: this change does not effect the post processing. Simply just the renderUI contents.
 	//
-	renderUI();
+	{
+		size_t pass = renderGraph.addPass("UI", RenderGraphPassType::GRAPHICS, [this, doFXAAInPostprocessing, rgPostprocessingSource](RenderGraph& graph)
+		{
+			if (doFXAAInPostprocessing)
+				glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+			else
+				graph.bindRenderTarget(rgPostprocessingSource);
+			renderUI();
+		});
+		renderGraph.read(pass, rgPostprocessingSource);
+		renderGraph.write(pass, rgPostprocessingSource);
+	}
 
-	//
-	// Do bloom: breakdown-preprocessing
-	//
-	bool firstcopy = true;
-	float downscaledFactor = 4.0f;						// NOTE: bloom starts at 1/4 the size
-	for (size_t i = 0; i < bloomBufferCount / 2; i++)
+	RenderGraph::TextureHandle rgBloom;
+	if (doComputeBloom)
 	{
-		for (size_t j = 0; j < 3; j++)																		// There are three stages in each pass: 1: copy, 2: horiz gauss, 3: vert gauss
+		//
+		// Do bloom: compute downsample chain
+		// NOTE: all 7 mips of the pyramid come out of one dispatch (see bloom_downsample.comp)
+		//
+		constexpr uint32_t numBloomMips = 7;
+		const RenderGraphTextureDesc bloomDesc = { std::max(1u, key.screenWidth / 4), std::max(1u, key.screenHeight / 4), GL_RGBA16F, GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR, numBloomMips };		// NOTE: Bloom should start at 1/4 the size.
+		rgBloom = renderGraph.createTexture("bloomPyramid", bloomDesc);
+
+		size_t pass = renderGraph.addPass("Bloom Downsample", RenderGraphPassType::COMPUTE, [this, bloomDesc, rgBloom, rgPostprocessingSource](RenderGraph& graph)
 		{
-			size_t bloomFBOIndex = i * 2 + j % 2;					// Needs to have a sequence of i(0):  0,1,0; i(1): 2,3,2; i(2): 4,5,4; i(3): 6,7,6; i(4): 8,9,8
-			size_t colorBufferIndex = i * 2 - 1 + j;				// Needs to have a sequence of i(0): -1,0,1; i(1): 1,2,3; i(2): 3,4,5; i(3): 5,6,7; i(4): 7,8,9
-			GLint stageNumber = (GLint)j + 1;						// Needs to have a sequence of i(n):  1,2,3
+			const GLuint bloomTexture = graph.getTexture(rgBloom);
+			bloomDownsampleComputeShader->use();
+			bloomDownsampleComputeShader->setSampler("hdrColorBuffer", graph.getTexture(rgPostprocessingSource));
+			for (GLuint i = 0; i < numBloomMips; i++)
+				glBindImageTexture(i, bloomTexture, (GLint)i, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+			glDispatchCompute((bloomDesc.width + 63) / 64, (bloomDesc.height + 63) / 64, 1);		// Each workgroup does a 64x64 tile of mip 0
+		});
+		renderGraph.read(pass, rgPostprocessingSource);
+		renderGraph.write(pass, rgBloom);
 
-			glBindFramebuffer(GL_FRAMEBUFFER, bloomFBOs[bloomFBOIndex]);
-			glClear(GL_COLOR_BUFFER_BIT);
-			bloom_postprocessing_program_id->use();
-			bloom_postprocessing_program_id->setSampler("hdrColorBuffer", firstcopy ? hdrFXAAColorBuffer : bloomColorBuffers[colorBufferIndex]);
-			bloom_postprocessing_program_id->setInt("stage", stageNumber);
-			bloom_postprocessing_program_id->setInt("firstcopy", firstcopy);
-			bloom_postprocessing_program_id->setFloat("downscaledFactor", downscaledFactor);
-			renderQuad();
+		//
+		// Do bloom: additive reconstruction, smallest mip first		NOTE: the final reconstructed bloom is mip 0
+		//
+		pass = renderGraph.addPass("Bloom Upsample", RenderGraphPassType::COMPUTE, [this, bloomDesc, rgBloom](RenderGraph& graph)
+		{
+			const GLuint bloomTexture = graph.getTexture(rgBloom);
+			bloomUpsampleComputeShader->use();
+			bloomUpsampleComputeShader->setSampler("bloomTexture", bloomTexture);
+			for (int mip = (int)numBloomMips - 2; mip >= 0; mip--)
+			{
+				if (mip != (int)numBloomMips - 2)
+					glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);		// The smaller mip has to be done first
+
+				const GLuint mipWidth = std::max(1u, bloomDesc.width >> mip);
+				const GLuint mipHeight = std::max(1u, bloomDesc.height >> mip);
+				bloomUpsampleComputeShader->setInt("smallerMip", mip + 1);
+				glBindImageTexture(0, bloomTexture, mip, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+				glDispatchCompute((mipWidth + 7) / 8, (mipHeight + 7) / 8, 1);
+			}
+		});
+		renderGraph.read(pass, rgBloom);
+		renderGraph.write(pass, rgBloom);
+	}
+	else
+	{
+		//
+		// Do bloom: breakdown-preprocessing (the old fragment shader version)
+		// NOTE: every stage gets its own texture, and the graph has the ones that are done share
+		// memory. It ends up being the same ping-ponging there was before.
+		// @NOTE: bindRenderTarget() sets the viewport to the bloom texture's size, so the downscaledFactor is always 1 now (it used to undo the full-screen viewport).
+		//
+		constexpr size_t numBloomLevels = 7;
+		static_assert(numBloomLevels >= 2);				// NOTE: for the reconstruction to work, there must be at least 2 passes so that there will be a copy into the needed texture for use in the tonemapping pass after this.
+		RenderGraph::TextureHandle rgBloomHorizontal[numBloomLevels], rgBloomVertical[numBloomLevels], rgBloomReconstruct[numBloomLevels - 1];
+		RenderGraphTextureDesc bloomDescs[numBloomLevels];
+		{
+			glm::vec2 bufferDimensions(key.screenWidth, key.screenHeight);
+			bufferDimensions /= 2.0f;		// NOTE: Bloom should start at 1/4 the size.
+			RenderGraph::TextureHandle sourceTexture = rgPostprocessingSource;
+			for (size_t i = 0; i < numBloomLevels; i++)
+			{
+				bufferDimensions /= 2.0f;
+				bloomDescs[i] = { (uint32_t)bufferDimensions.x, (uint32_t)bufferDimensions.y, GL_RGBA16F, GL_LINEAR, GL_LINEAR };		// @TODO: We don't need the alpha channel for this yo.
 
-			firstcopy = false;
-		}
+				RenderGraph::TextureHandle rgBloomCopy = renderGraph.createTexture("bloomCopy" + std::to_string(i), bloomDescs[i]);
+				rgBloomHorizontal[i] = renderGraph.createTexture("bloomHorizontal" + std::to_string(i), bloomDescs[i]);
+				rgBloomVertical[i] = renderGraph.createTexture("bloomVertical" + std::to_string(i), bloomDescs[i]);
 
-		downscaledFactor *= 2.0f;
-	}
+				// There are three stages in each level: 1: copy, 2: horiz gauss, 3: vert gauss
+				const RenderGraph::TextureHandle stageInputs[3] = { sourceTexture, rgBloomCopy, rgBloomHorizontal[i] };
+				const RenderGraph::TextureHandle stageOutputs[3] = { rgBloomCopy, rgBloomHorizontal[i], rgBloomVertical[i] };
+				for (size_t j = 0; j < 3; j++)
+				{
+					const bool firstcopy = (i == 0 && j == 0);
+					const GLint stageNumber = (GLint)j + 1;
+					const RenderGraph::TextureHandle input = stageInputs[j], output = stageOutputs[j];
+					size_t pass = renderGraph.addPass("Bloom " + std::to_string(i) + " Stage " + std::to_string(stageNumber), RenderGraphPassType::GRAPHICS, [this, firstcopy, stageNumber, input, output](RenderGraph& graph)
+					{
+						graph.bindRenderTarget(output);
+						glClear(GL_COLOR_BUFFER_BIT);
+						bloom_postprocessing_program_id->use();
+						bloom_postprocessing_program_id->setSampler("hdrColorBuffer", graph.getTexture(input));
+						bloom_postprocessing_program_id->setInt("stage", stageNumber);
+						bloom_postprocessing_program_id->setInt("firstcopy", firstcopy);
+						bloom_postprocessing_program_id->setFloat("downscaledFactor", 1.0f);
+						renderQuad();
+					});
+					renderGraph.read(pass, input);
+					renderGraph.write(pass, output);
+				}
 
-	//
-	// Do bloom: additive color buffer reconstruction		NOTE: the final reconstructed bloom buffer is on [1]
-	//
-	assert(bloomBufferCount >= 4);											// NOTE: for this algorithm to work, there must be at least 2 passes(aka 4 fbo's) so that there will be a copy into the needed texture for use in the tonemapping pass after this.
-	bool firstReconstruction = true;
-	downscaledFactor /= 2.0f;
-	for (int i = (int)(bloomBufferCount / 2 - 2) * 2; i >= 0; i -= 2)		// NOTE: must use signed int so that it goes negative
-	{
-		downscaledFactor /= 2.0f;
+				sourceTexture = rgBloomHorizontal[i];		// NOTE: the next level copies from the horizontal gauss of this one (it always has)
+			}
+		}
 
-		size_t bloomFBOIndex = i + 1;
-		size_t colorBufferIndex = i;
-		size_t smallerColorBufferIndex = i + 3 - (firstReconstruction ? 1 : 0);
+		//
+		// Do bloom: additive color buffer reconstruction		NOTE: the final reconstructed bloom buffer is rgBloomReconstruct[0]
+		//
+		for (int i = (int)numBloomLevels - 2; i >= 0; i--)		// NOTE: must use signed int so that it goes negative
+		{
+			rgBloomReconstruct[i] = renderGraph.createTexture("bloomReconstruct" + std::to_string(i), bloomDescs[i]);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, bloomFBOs[bloomFBOIndex]);
-		glClear(GL_COLOR_BUFFER_BIT);
-		bloom_postprocessing_program_id->use();
-		bloom_postprocessing_program_id->setSampler("hdrColorBuffer", bloomColorBuffers[colorBufferIndex]);
-		bloom_postprocessing_program_id->setSampler("smallerReconstructHDRColorBuffer", bloomColorBuffers[smallerColorBufferIndex]);
-		bloom_postprocessing_program_id->setInt("stage", 4);
-		bloom_postprocessing_program_id->setInt("firstcopy", firstcopy);
-		bloom_postprocessing_program_id->setFloat("downscaledFactor", downscaledFactor);
-		renderQuad();
+			const RenderGraph::TextureHandle input = rgBloomVertical[i];
+			const RenderGraph::TextureHandle smallerInput = (i == (int)numBloomLevels - 2) ? rgBloomVertical[i + 1] : rgBloomReconstruct[i + 1];
+			const RenderGraph::TextureHandle output = rgBloomReconstruct[i];
+			size_t pass = renderGraph.addPass("Bloom Reconstruct " + std::to_string(i), RenderGraphPassType::GRAPHICS, [this, input, smallerInput, output](RenderGraph& graph)
+			{
+				graph.bindRenderTarget(output);
+				glClear(GL_COLOR_BUFFER_BIT);
+				bloom_postprocessing_program_id->use();
+				bloom_postprocessing_program_id->setSampler("hdrColorBuffer", graph.getTexture(input));
+				bloom_postprocessing_program_id->setSampler("smallerReconstructHDRColorBuffer", graph.getTexture(smallerInput));
+				bloom_postprocessing_program_id->setInt("stage", 4);
+				bloom_postprocessing_program_id->setInt("firstcopy", false);
+				bloom_postprocessing_program_id->setFloat("downscaledFactor", 1.0f);
+				renderQuad();
+			});
+			renderGraph.read(pass, input);
+			renderGraph.read(pass, smallerInput);
+			renderGraph.write(pass, output);
+		}
 
-		firstReconstruction = false;
+		rgBloom = rgBloomReconstruct[0];
 	}
 
 	//
 	// Do tonemapping and post-processing
 	// with the fbo and render to a quad
 	//
-	glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
-	glBindFramebuffer(GL_FRAMEBUFFER, doCloudDenoiseNontemporal ? hdrFBO : 0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	postprocessing_program_id->use();
-	postprocessing_program_id->setSampler("hdrColorBuffer", hdrFXAAColorBuffer);
-	postprocessing_program_id->setSampler("bloomColorBuffer", bloomColorBuffers[1]);	// 1 is the final color buffer of the reconstructed bloom
-	postprocessing_program_id->setSampler("luminanceProcessed", hdrLumAdaptationProcessed->getHandle());
-	postprocessing_program_id->setSampler("volumetricLighting", volumetricTexture->getHandle());
-	postprocessing_program_id->setVec3("sunLightColor", mainlight->color* mainlight->colorIntensity* volumetricLightingStrength* volumetricLightingStrengthExternal);
-	postprocessing_program_id->setFloat("exposure", exposure);
-	postprocessing_program_id->setFloat("bloomIntensity", bloomIntensity);
-	renderQuad();
-
-	// @HACK: Oh so hack lol hahahahaha  -Timo
-	if (doCloudDenoiseNontemporal)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);		// Sorry blur FBO! Gotta use ya for this D:
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		simpleDenoiseShader->use();
-		simpleDenoiseShader->setSampler("textureMap", hdrColorBuffer);
-		renderQuad();
+		size_t pass = renderGraph.addPass("Tonemapping", RenderGraphPassType::GRAPHICS, [this, doFXAAInPostprocessing, rgPostprocessingSource, rgBloom, getVolumetricTexture](RenderGraph& graph)
+		{
+			if (doCloudDenoiseNontemporal)
+				glViewport(0, 0, (GLsizei)renderWidth, (GLsizei)renderHeight);
+			else
+				glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
+			glBindFramebuffer(GL_FRAMEBUFFER, doCloudDenoiseNontemporal ? hdrFBO : 0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			postprocessing_program_id->use();
+			postprocessing_program_id->setSampler("hdrColorBuffer", graph.getTexture(rgPostprocessingSource));
+			postprocessing_program_id->setSampler("bloomColorBuffer", graph.getTexture(rgBloom));
+			postprocessing_program_id->setSampler("luminanceProcessed", hdrLumAdaptationProcessed->getHandle());
+			postprocessing_program_id->setSampler("volumetricLighting", getVolumetricTexture(graph));
+			postprocessing_program_id->setVec3("sunLightColor", postProcessingFrame.sunLightColor);
+			postprocessing_program_id->setFloat("exposure", exposure);
+			postprocessing_program_id->setFloat("bloomIntensity", bloomIntensity);
+			postprocessing_program_id->setBool("doFXAA", doFXAAInPostprocessing);
+			postprocessing_program_id->setVec2("invFullResolution", { 1.0f / renderWidth, 1.0f / renderHeight });
+			renderQuad();
 
-		// Arrrgh, since we can't do ping pong, we just have to blit the result over to here too :(  -Timo
-		//glBlitNamedFramebuffer(
-		//	cloudEffectBlurFBO,
-		//	cloudEffectFBO,
-		//	0, 0, cloudEffectTextureWidth, cloudEffectTextureHeight,
-		//	0, 0, cloudEffectTextureWidth, cloudEffectTextureHeight,
-		//	GL_COLOR_BUFFER_BIT,
-		//	GL_NEAREST
-		//);
+			// @HACK: Oh so hack lol hahahahaha  -Timo
+			if (doCloudDenoiseNontemporal)
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);		// Sorry blur FBO! Gotta use ya for this D:
+				glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				simpleDenoiseShader->use();
+				simpleDenoiseShader->setSampler("textureMap", hdrColorBuffer);
+				renderQuad();
+			}
+		});
+		renderGraph.read(pass, rgPostprocessingSource);
+		renderGraph.read(pass, rgBloom);
+		renderGraph.read(pass, rgLumProcessed);
+		if (doVolumetricLighting)
+			renderGraph.read(pass, rgVolumetric);
+		if (key.doCloudDenoiseNontemporal)
+			renderGraph.write(pass, rgHDRColor);
+		renderGraph.setHasSideEffects(pass);		// Renders to the screen
 	}
-
-	// Swap the hdrLumAdaptation ping-pong textures
-	std::swap(hdrLumAdaptationPrevious, hdrLumAdaptationProcessed);
-
-#ifdef _DEVELOP
-	// ImGui buffer swap
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-#endif
 }
 
 
@@ -2146,6 +2126,7 @@ void RenderManager::setupSceneShadows()
 				ShaderExtCSM_shadow::cascadePlaneDistances = ((DirectionalLightLight*)MainLoop::getInstance().lightObjects[i])->shadowCascadeLevels;
 				ShaderExtCSM_shadow::cascadeShadowMapTexelSize = ((DirectionalLightLight*)MainLoop::getInstance().lightObjects[i])->shadowCascadeTexelSize;
 				ShaderExtCSM_shadow::cascadeCount = (GLint)((DirectionalLightLight*)MainLoop::getInstance().lightObjects[i])->shadowCascadeLevels.size();
+				ShaderExtCSM_shadow::cascadeStaleMask = (GLint)((DirectionalLightLight*)MainLoop::getInstance().lightObjects[i])->getStaleCascadeMask();
 				ShaderExtCSM_shadow::nearPlane = MainLoop::getInstance().camera.zNear;
 				ShaderExtCSM_shadow::farPlane = MainLoop::getInstance().lightObjects[i]->shadowFarPlane;
 			}
@@ -2158,18 +2139,13 @@ void RenderManager::setupSceneShadows()
 
 			numShadows++;
 		}
-		else if (MainLoop::getInstance().lightObjects[i]->lightType == LightType::POINT)
-		{
-			ShaderExtShadow::pointLightShadows[numShadows] = MainLoop::getInstance().lightObjects[i]->shadowMapTexture;
-			ShaderExtShadow::pointLightShadowFarPlanes[numShadows] = ((PointLightLight*)MainLoop::getInstance().lightObjects[i])->farPlane;
-
-			numShadows++;
-		}
 
 		// Break out early
 		if (numShadows >= ShaderExtShadow::MAX_SHADOWS && setupCSM)
 			break;
 	}
+
+	ShaderExtShadow::shadowAtlas = shadowAtlas.getTexture();
 }
 
 
@@ -2180,13 +2156,26 @@ void RenderManager::renderScene()
 	//
 	// Z-PASS and RENDER QUEUE SORTING
 	//
-	glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
+	glViewport(0, 0, (GLsizei)renderWidth, (GLsizei)renderHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, zPrePassFBO);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	INTERNALzPassShader->use();
 	ViewFrustum cookedViewFrustum = ViewFrustum::createFrustumFromCamera(MainLoop::getInstance().camera);		// @Optimize: this can be optimized via a mat4 that just changes the initial view frustum
 	
+	//
+	// Rasterize the occluders for CPU occlusion culling
+	//
+	OcclusionCuller* occlusionCullerPtr = nullptr;
+	if (doOcclusionCulling)
+	{
+		occlusionCuller.beginFrame(cameraInfo.projectionView);
+		for (unsigned int i = 0; i < MainLoop::getInstance().renderObjects.size(); i++)
+			MainLoop::getInstance().renderObjects[i]->submitOccluders(&cookedViewFrustum, &occlusionCuller);
+		occlusionCuller.rasterizeOccluders();
+		occlusionCullerPtr = &occlusionCuller;
+	}
+
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CCW);
@@ -2202,7 +2191,7 @@ void RenderManager::renderScene()
 	for (unsigned int i = 0; i < MainLoop::getInstance().renderObjects.size(); i++)
 	{
 		// NOTE: viewfrustum culling is handled at the mesh level with some magic. Peek in if ya wanna. -Timo
-		MainLoop::getInstance().renderObjects[i]->render(&cookedViewFrustum, INTERNALzPassShader);
+		MainLoop::getInstance().renderObjects[i]->render(&cookedViewFrustum, INTERNALzPassShader, occlusionCullerPtr);
 	}
 
 	glDisable(GL_CULL_FACE);
@@ -2210,19 +2199,54 @@ void RenderManager::renderScene()
 	//
 	// Capture z-passed screen for SSAO
 	//
-	glViewport(0, 0, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);  // ssaoFBOSize, ssaoFBOSize);
+	glViewport(0, 0, (GLsizei)ssaoWidth, (GLsizei)ssaoHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
 	glClear(GL_COLOR_BUFFER_BIT);
 	if (!isWireFrameMode)
 	{
+		float ssaoGPUTimeMs;
+		if (ssaoGPUTimer.getLatestFrameTimeMs(ssaoGPUTimeMs))
+		{
+			// NOTE: each call can eat more than one result, so skipping by calls might throw out a couple good ones, but never keeps an old one
+			if (ssaoGPUTimerResultsToSkip > 0)
+				ssaoGPUTimerResultsToSkip--;
+			else
+			{
+				float& smoothedTimeMs = ssaoGPUTimesMs[ssaoResolutionDivisor == 1 ? 0 : (ssaoResolutionDivisor == 2 ? 1 : 2)];
+				smoothedTimeMs = (smoothedTimeMs == 0.0f) ? ssaoGPUTimeMs : glm::mix(smoothedTimeMs, ssaoGPUTimeMs, 0.1f);
+			}
+		}
+		ssaoGPUTimer.begin();
+
+		//
+		// Linearize the z-prepass down to the ssao resolution, then make its mips
+		//
+		ssaoLinearDepthComputeShader->use();
+		ssaoLinearDepthComputeShader->setSampler("depthTexture", zPrePassDepthTexture->getHandle());
+		ssaoLinearDepthComputeShader->setSampler("linearDepthTexture", ssaoLinearDepthTexture->getHandle());
+		ssaoLinearDepthComputeShader->setInt("fullResDivisor", (int)ssaoResolutionDivisor);
+		ssaoLinearDepthComputeShader->setFloat("zNear", MainLoop::getInstance().camera.zNear);
+		ssaoLinearDepthComputeShader->setFloat("zFar", MainLoop::getInstance().camera.zFar);
+		for (uint32_t mip = 0; mip < ssaoNumMips; mip++)
+		{
+			if (mip > 0)
+				glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);		// The mip before this one has to be done first
+
+			const uint32_t mipWidth = std::max(1u, ssaoWidth >> mip);
+			const uint32_t mipHeight = std::max(1u, ssaoHeight >> mip);
+			ssaoLinearDepthComputeShader->setInt("mipLevel", (int)mip);
+			glBindImageTexture(0, ssaoLinearDepthTexture->getHandle(), (GLint)mip, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glDispatchCompute((mipWidth + 7) / 8, (mipHeight + 7) / 8, 1);
+		}
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
 		ssaoProgramId->use();
+		ssaoProgramId->setSampler("linearDepthTexture", ssaoLinearDepthTexture->getHandle());
 		ssaoProgramId->setSampler("rotationTexture", ssaoRotationTexture->getHandle());
-		ssaoProgramId->setVec2("fullResolution", { MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height });
-		ssaoProgramId->setVec2("invFullResolution", { 1.0f / MainLoop::getInstance().camera.width, 1.0f / MainLoop::getInstance().camera.height });
+		ssaoProgramId->setVec2("fullResolution", { (float)ssaoWidth, (float)ssaoHeight });
+		ssaoProgramId->setVec2("invFullResolution", { 1.0f / (float)ssaoWidth, 1.0f / (float)ssaoHeight });
 		ssaoProgramId->setFloat("cameraFOV", MainLoop::getInstance().camera.fov);
-		ssaoProgramId->setFloat("zNear", MainLoop::getInstance().camera.zNear);
-		ssaoProgramId->setFloat("zNear", MainLoop::getInstance().camera.zNear);
-		ssaoProgramId->setFloat("zFar", MainLoop::getInstance().camera.zFar);
+		ssaoProgramId->setInt("maxMipLevel", (int)ssaoNumMips - 1);
 		ssaoProgramId->setFloat("powExponent", ssaoScale);
 		ssaoProgramId->setFloat("radius", ssaoRadius);
 		ssaoProgramId->setFloat("bias", ssaoBias);
@@ -2249,13 +2273,37 @@ void RenderManager::renderScene()
 		blurYProgramId->use();
 		blurYProgramId->setSampler("textureMap", ssaoBlurTexture->getHandle());
 		renderQuad();
+
+		//
+		// Bilateral upsample to full res
+		//
+		if (ssaoFullResTexture != nullptr)
+		{
+			glViewport(0, 0, (GLsizei)renderWidth, (GLsizei)renderHeight);
+			glBindFramebuffer(GL_FRAMEBUFFER, ssaoUpsampleFBO);
+			ssaoUpsampleProgramId->use();
+			ssaoUpsampleProgramId->setSampler("ssaoLowResTexture", ssaoTexture->getHandle());
+			ssaoUpsampleProgramId->setSampler("linearDepthTexture", ssaoLinearDepthTexture->getHandle());
+			ssaoUpsampleProgramId->setFloat("zNear", MainLoop::getInstance().camera.zNear);
+			ssaoUpsampleProgramId->setFloat("zFar", MainLoop::getInstance().camera.zFar);
+			ssaoUpsampleProgramId->setFloat("depthSensitivity", ssaoUpsampleDepthSensitivity);
+			renderQuad();
+		}
+
+		ssaoGPUTimer.end();
+	}
+	else if (ssaoFullResTexture != nullptr)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, ssaoUpsampleFBO);
+		glClear(GL_COLOR_BUFFER_BIT);
 	}
+	glViewport(0, 0, (GLsizei)renderWidth, (GLsizei)renderHeight);
 
 	glBlitNamedFramebuffer(
 		zPrePassFBO,
 		hdrFBO,
-		0, 0, MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height,
-		0, 0, MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height,
+		0, 0, renderWidth, renderHeight,
+		0, 0, renderWidth, renderHeight,
 		GL_DEPTH_BUFFER_BIT,
 		GL_NEAREST
 	);
@@ -2291,43 +2339,67 @@ void RenderManager::renderScene()
 	sunSpinAmount = glm::toMat3(glm::quat(flatSunOrientation, glm::vec3(1, 0, 0)));
 
 	// Render it out!
-	// Irradiance map
-	environmentMapMixerShader->use();		// Cubemap.vert & EnvMapMixer.frag
-	environmentMapMixerShader->setMat4("projection", captureProjection);
-	environmentMapMixerShader->setFloat("mapInterpolationAmt", mapInterpolationAmt);
-	environmentMapMixerShader->setMat3("sunSpinAmount", sunSpinAmount);
-	environmentMapMixerShader->setSampler("texture1", irradianceMap[whichMap]);
-	environmentMapMixerShader->setSampler("texture2", irradianceMap[std::clamp(whichMap + 1, (size_t)0, numSkyMaps - 1)]);
-	environmentMapMixerShader->setFloat("lod", 0.0f);
-	glViewport(0, 0, irradianceMapSize, irradianceMapSize);
-	glBindFramebuffer(GL_FRAMEBUFFER, irradianceMapInterpolatedFBO);
-	for (unsigned int i = 0; i < 6; i++)
-	{
-		environmentMapMixerShader->setMat4("view", captureViews[i]);
-		glNamedFramebufferTextureLayer(irradianceMapInterpolatedFBO, GL_COLOR_ATTACHMENT0, irradianceMapInterpolated->getHandle(), 0, i);
-		glClear(GL_COLOR_BUFFER_BIT);
-		renderCube();
-	}
-
-	// Prefilter map
-	environmentMapMixerShader->setSampler("texture1", prefilterMap[whichMap]);
-	environmentMapMixerShader->setSampler("texture2", prefilterMap[std::clamp(whichMap + 1, (size_t)0, numSkyMaps - 1)]);
-	glBindFramebuffer(GL_FRAMEBUFFER, prefilterMapInterpolatedFBO);
-	for (unsigned int mip = 0; mip < maxMipLevels; mip++)
+	// NOTE: only the faces the scheduler hands out get mixed, and they go into the back buffer
+	IBLMixParams iblParams;
+	iblParams.whichMap = whichMap;
+	iblParams.mapInterpolationAmt = mapInterpolationAmt;
+	iblParams.flatSunOrientation = flatSunOrientation;
+	IBLScheduler::INTERNALresetStats();
+	const IBLUpdate iblUpdate = iblScheduler.schedule(iblParams);
+
+	if (iblUpdate.numFaces > 0)
 	{
-		environmentMapMixerShader->setFloat("lod", (float)mip);
+		const uint32_t iblBackBuffer = 1 - iblFrontBuffer;
+		const size_t nextMap = std::clamp(iblUpdate.params.whichMap + 1, (size_t)0, numSkyMaps - 1);
+		const glm::mat3 iblSunSpinAmount = glm::toMat3(glm::quat(iblUpdate.params.flatSunOrientation, glm::vec3(1, 0, 0)));
 
-		unsigned int mipWidth = (unsigned int)(prefilterMapSize * std::pow(0.5, mip));
-		unsigned int mipHeight = (unsigned int)(prefilterMapSize * std::pow(0.5, mip));
-		glViewport(0, 0, mipWidth, mipHeight);
+		environmentMapMixerShader->use();		// Cubemap.vert & EnvMapMixer.frag
+		environmentMapMixerShader->setMat4("projection", captureProjection);
+		environmentMapMixerShader->setFloat("mapInterpolationAmt", iblUpdate.params.mapInterpolationAmt);
+		environmentMapMixerShader->setMat3("sunSpinAmount", iblSunSpinAmount);
 
-		for (unsigned int i = 0; i < 6; i++)
+		for (uint32_t face = iblUpdate.firstFace; face < iblUpdate.firstFace + iblUpdate.numFaces; face++)
 		{
+			const uint32_t i = face % 6;
+			if (face < IBLScheduler::NUM_IRRADIANCE_FACES)
+			{
+				// Irradiance map
+				// @NOTE: use() resets the sampler units, so the samplers get set again every face
+				environmentMapMixerShader->use();
+				environmentMapMixerShader->setSampler("texture1", irradianceMap[iblUpdate.params.whichMap]);
+				environmentMapMixerShader->setSampler("texture2", irradianceMap[nextMap]);
+				environmentMapMixerShader->setFloat("lod", 0.0f);
+				glViewport(0, 0, irradianceMapSize, irradianceMapSize);
+				glBindFramebuffer(GL_FRAMEBUFFER, irradianceMapInterpolatedFBO);
+				glNamedFramebufferTextureLayer(irradianceMapInterpolatedFBO, GL_COLOR_ATTACHMENT0, irradianceMapInterpolated[iblBackBuffer]->getHandle(), 0, i);
+			}
+			else
+			{
+				// Prefilter map
+				const uint32_t mip = (face - IBLScheduler::NUM_IRRADIANCE_FACES) / 6;
+				unsigned int mipWidth = (unsigned int)(prefilterMapSize * std::pow(0.5, mip));
+				unsigned int mipHeight = (unsigned int)(prefilterMapSize * std::pow(0.5, mip));
+
+				environmentMapMixerShader->use();
+				environmentMapMixerShader->setSampler("texture1", prefilterMap[iblUpdate.params.whichMap]);
+				environmentMapMixerShader->setSampler("texture2", prefilterMap[nextMap]);
+				environmentMapMixerShader->setFloat("lod", (float)mip);
+				glViewport(0, 0, mipWidth, mipHeight);
+				glBindFramebuffer(GL_FRAMEBUFFER, prefilterMapInterpolatedFBO);
+				glNamedFramebufferTextureLayer(prefilterMapInterpolatedFBO, GL_COLOR_ATTACHMENT0, prefilterMapInterpolated[iblBackBuffer]->getHandle(), mip, i);
+			}
+
 			environmentMapMixerShader->setMat4("view", captureViews[i]);
-			glNamedFramebufferTextureLayer(prefilterMapInterpolatedFBO, GL_COLOR_ATTACHMENT0, prefilterMapInterpolated->getHandle(), mip, i);
 			glClear(GL_COLOR_BUFFER_BIT);
 			renderCube();
 		}
+
+		if (iblUpdate.swapAfter)
+		{
+			iblFrontBuffer = iblBackBuffer;
+			ShaderExtPBR_daynight_cycle::irradianceMap = irradianceMapInterpolated[iblFrontBuffer]->getHandle();
+			ShaderExtPBR_daynight_cycle::prefilterMap = prefilterMapInterpolated[iblFrontBuffer]->getHandle();
+		}
 	}
 
 	//
@@ -2364,15 +2436,35 @@ void RenderManager::renderScene()
 	const float zSliceDistance = 32000.0f;		// Supposed to be 32km (see https://sebh.github.io/publications/egsr2020.pdf)		@NOTE: since this could get applied to clouds as well which don't follow the ZFar limit of geometry, it has a possibility of spanning past that 32km range. That's why this value isn't set to the camera's zfar.
 	// @NOTE: I know that the raymarching goes out 32km, but I ended up doing the camera zFar for the geometry application. Unusual? Maybe. We'll see how it looks when applying this to the clouds as well. I think the clouds should be 32km threshold.  -Timo
 	const float zSliceSize = zSliceDistance / (float)skyboxDepthSlicedLUTSize * 3.2f;  // @NOTE: IT'S SUPPOSED TO BE 32km... but I like the feel of the area getting foggier quicker. And this'll do it for ya
-	glViewport(0, 0, skyboxDepthSlicedLUTSize, skyboxDepthSlicedLUTSize);
-	for (size_t i = 0; i < skyboxDepthSlicedLUTSize; i++)
+	// NOTE: the whole LUT is one dispatch now, and it only gets redone when the sun or the camera moved
 	{
-		// @NOTE: skybox_program_id should already be in use right here.
-		// Hence doing this before the blurring pass on the main background atmosphere  -Timo
-		glBindFramebuffer(GL_FRAMEBUFFER, skyboxDepthSlicedLUTFBOs[i]);
-		glClear(GL_COLOR_BUFFER_BIT);
-		skybox_program_id->setFloat("depthZFar", zSliceSize * (float)(i + 1));
-		renderCube();
+		AtmosphericScatteringLUTCache& cache = atmosphericScatteringLUTCache;
+		const glm::vec3 cameraPosition = MainLoop::getInstance().camera.position;
+		const glm::mat4 projectionView = cameraInfo.projection * glm::mat4(glm::mat3(cameraInfo.view));
+
+		cache.refreshedThisFrame =
+			!cache.isValid ||
+			cache.projectionView != projectionView ||
+			glm::dot(glm::normalize(skyboxParams.sunOrientation), glm::normalize(cache.sunOrientation)) < glm::cos(glm::radians(cache.maxSunChangeDegrees)) ||
+			std::abs(cameraPosition.y - cache.cameraPosition.y) > cache.maxCameraHeightChange ||
+			glm::length(glm::vec2(cameraPosition.x - cache.cameraPosition.x, cameraPosition.z - cache.cameraPosition.z)) > cache.maxCameraHorizontalChange;
+
+		if (cache.refreshedThisFrame)
+		{
+			atmosphericScatteringLUTComputeShader->use();
+			atmosphericScatteringLUTComputeShader->setMat4("inverseProjectionView", glm::inverse(projectionView));
+			atmosphericScatteringLUTComputeShader->setVec3("mainCameraPosition", cameraPosition);
+			atmosphericScatteringLUTComputeShader->setVec3("sunOrientation", skyboxParams.sunOrientation);
+			atmosphericScatteringLUTComputeShader->setFloat("zSliceSize", zSliceSize);
+			glBindImageTexture(0, skyboxDepthSlicedLUT->getHandle(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+			glDispatchCompute((skyboxDepthSlicedLUTSize + 7) / 8, (skyboxDepthSlicedLUTSize + 7) / 8, 1);
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+			cache.isValid = true;
+			cache.projectionView = projectionView;
+			cache.sunOrientation = skyboxParams.sunOrientation;
+			cache.cameraPosition = cameraPosition;
+		}
 	}
 
 	//
@@ -2394,7 +2486,7 @@ void RenderManager::renderScene()
 	//
 	// Render the detailed skybox separately (sun and nighttime mainly)
 	//
-	glViewport(0, 0, MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height);
+	glViewport(0, 0, renderWidth, renderHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, skyboxDetailsSSFBO);
 	glClear(GL_COLOR_BUFFER_BIT);
 	skyboxDetailsShader->use();
@@ -2501,6 +2593,8 @@ void RenderManager::renderScene()
 	cloudEffectShader->setFloat("lightAbsorptionThroughCloud", cloudEffectInfo.lightAbsorptionThroughCloud);
 	cloudEffectShader->setSampler("cloudNoiseTexture", cloudNoise1->getHandle());
 	cloudEffectShader->setSampler("cloudNoiseDetailTexture", cloudNoise2->getHandle());
+	cloudEffectShader->setSampler("cloudDensityBoundsTexture", cloudDensityBounds->getHandle());
+	cloudEffectShader->setInt("doEmptySpaceSkipping", (int)doCloudEmptySpaceSkipping);
 	cloudEffectShader->setFloat("raymarchOffset", cloudEffectInfo.raymarchOffset);
 	cloudEffectShader->setInt("raymarchOffsetDitherIndexOffset", raymarchOffsetDitherIndexOffset);		// @TAA @POC
 	cloudEffectShader->setSampler("atmosphericScattering", skyboxDepthSlicedLUT->getHandle());
@@ -2625,7 +2719,7 @@ void RenderManager::renderScene()
 	//
 	// Apply the @Clouds layer
 	//
-	glViewport(0, 0, MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height);
+	glViewport(0, 0, renderWidth, renderHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
 	glClear(GL_COLOR_BUFFER_BIT);
 	cloudEffectApplyShader->use();
@@ -2648,13 +2742,20 @@ void RenderManager::renderScene()
 	glFrontFace(GL_CCW);
 
 	glDepthFunc(GL_EQUAL);		// NOTE: this is so that the Z prepass gets used and only fragments that are actually visible will get rendered
+	for (size_t i = 0; i < opaqueRQ.terrainsToRender.size(); i++)
+	{
+		opaqueRQ.terrainsToRender[i]->INTERNALrenderOpaque();
+	}
+	opaqueRQ.terrainsToRender.clear();
 	for (size_t i = 0; i < opaqueRQ.meshesToRender.size(); i++)
 	{
-		opaqueRQ.meshesToRender[i]->render(opaqueRQ.modelMatrices[i], 0, opaqueRQ.boneMatrixMemAddrs[i], RenderStage::OPAQUE_RENDER_QUEUE);
+		opaqueRQ.meshesToRender[i]->render(opaqueRQ.modelMatrices[i], 0, opaqueRQ.boneMatrixMemAddrs[i], RenderStage::OPAQUE_RENDER_QUEUE, opaqueRQ.lodIndices[i], opaqueRQ.lodFadeAlphas[i]);
 	}
 	opaqueRQ.meshesToRender.clear();
 	opaqueRQ.modelMatrices.clear();
 	opaqueRQ.boneMatrixMemAddrs.clear();
+	opaqueRQ.lodIndices.clear();
+	opaqueRQ.lodFadeAlphas.clear();
 	glDepthFunc(GL_LEQUAL);
 
 	//
@@ -2703,12 +2804,14 @@ void RenderManager::renderScene()
 
 	for (size_t& index : transparentRQ.commandingIndices)
 	{
-		transparentRQ.meshesToRender[index]->render(transparentRQ.modelMatrices[index], 0, transparentRQ.boneMatrixMemAddrs[index], RenderStage::TRANSPARENT_RENDER_QUEUE);
+		transparentRQ.meshesToRender[index]->render(transparentRQ.modelMatrices[index], 0, transparentRQ.boneMatrixMemAddrs[index], RenderStage::TRANSPARENT_RENDER_QUEUE, transparentRQ.lodIndices[index], transparentRQ.lodFadeAlphas[index]);
 	}
 	transparentRQ.commandingIndices.clear();
 	transparentRQ.meshesToRender.clear();
 	transparentRQ.modelMatrices.clear();
 	transparentRQ.boneMatrixMemAddrs.clear();
+	transparentRQ.lodIndices.clear();
+	transparentRQ.lodFadeAlphas.clear();
 	transparentRQ.distancesToCamera.clear();
 
 	glDisable(GL_BLEND);
@@ -2724,7 +2827,7 @@ void RenderManager::renderScene()
 	//
 	static bool imguizmoIsUsingPrevious = false;
 
-	if (ImGuizmo::IsUsing() && !selectedObjectIndices.empty())
+	if (ImGuizmo::IsUsing() && !selectedObjectHandles.empty())
 	{
 		static bool showXGrid = false;
 		static bool showYGrid = false;
@@ -2856,19 +2959,28 @@ void RenderManager::renderScene()
 }
 
 
-void RenderManager::INTERNALaddMeshToOpaqueRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms)
+void RenderManager::INTERNALaddMeshToOpaqueRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms, size_t lodIndex, float lodFadeAlpha)
 {
 	opaqueRQ.meshesToRender.push_back(mesh);
 	opaqueRQ.modelMatrices.push_back(modelMatrix);
 	opaqueRQ.boneMatrixMemAddrs.push_back(boneTransforms);
+	opaqueRQ.lodIndices.push_back(lodIndex);
+	opaqueRQ.lodFadeAlphas.push_back(lodFadeAlpha);
 }
 
-void RenderManager::INTERNALaddMeshToTransparentRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms)
+void RenderManager::INTERNALaddTerrainToOpaqueRenderQueue(TerrainRenderer* terrainRenderer)
+{
+	opaqueRQ.terrainsToRender.push_back(terrainRenderer);
+}
+
+void RenderManager::INTERNALaddMeshToTransparentRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms, size_t lodIndex, float lodFadeAlpha)
 {
 	transparentRQ.commandingIndices.push_back(transparentRQ.meshesToRender.size());
 	transparentRQ.meshesToRender.push_back(mesh);
 	transparentRQ.modelMatrices.push_back(modelMatrix);
 	transparentRQ.boneMatrixMemAddrs.push_back(boneTransforms);
+	transparentRQ.lodIndices.push_back(lodIndex);
+	transparentRQ.lodFadeAlphas.push_back(lodFadeAlpha);
 
 	float distanceToCamera = (cameraInfo.projectionView * modelMatrix * glm::vec4(mesh->getCenterOfGravity(), 1.0f)).z;
 	transparentRQ.distancesToCamera.push_back(distanceToCamera);
@@ -2893,6 +3005,65 @@ void RenderManager::renderSceneShadowPass(Shader* shader)
 	}
 }
 
+void RenderManager::renderSceneShadowLayers(Shader* shader, GLuint shadowMapTexture, const std::vector<glm::mat4>& layerMatrices, bool clampsDepth, uint32_t layersToRender)
+{
+	shadowLayerPass.begin(layerMatrices, clampsDepth, layersToRender);
+	shader->setBool("layersAreViewports", false);
+
+	if (ShadowLayerPass::isLayeredRenderingSupported() && !shadowLayerPass.forcePerLayerPasses)
+	{
+		// All of the layers at once. Each draw gets instanced for the layers it touches
+		renderSceneShadowPass(shader);
+	}
+	else
+	{
+		// One pass per layer w/ just that layer attached
+		for (size_t i = 0; i < layerMatrices.size(); i++)
+		{
+			if ((layersToRender & (1u << i)) == 0)
+				continue;
+
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMapTexture, 0, (GLint)i);
+			shadowLayerPass.setCurrentLayer((int)i);
+			renderSceneShadowPass(shader);
+		}
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMapTexture, 0);
+	}
+
+	shadowLayerPass.end();
+}
+
+void RenderManager::renderSceneShadowViewports(Shader* shader, const std::vector<glm::mat4>& layerMatrices, const std::vector<glm::ivec4>& layerViewports)
+{
+	shadowLayerPass.begin(layerMatrices, false);
+	shader->setBool("layersAreViewports", true);
+
+	if (ShadowLayerPass::isViewportArrayRenderingSupported() && !shadowLayerPass.forcePerLayerPasses)
+	{
+		// All of the viewports at once
+		for (size_t i = 0; i < layerViewports.size(); i++)
+		{
+			const glm::ivec4& viewport = layerViewports[i];
+			glViewportIndexedf((GLuint)i, (float)viewport.x, (float)viewport.y, (float)viewport.z, (float)viewport.w);
+			glScissorIndexed((GLuint)i, viewport.x, viewport.y, viewport.z, viewport.w);
+		}
+		renderSceneShadowPass(shader);
+	}
+	else
+	{
+		for (size_t i = 0; i < layerViewports.size(); i++)
+		{
+			const glm::ivec4& viewport = layerViewports[i];
+			glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+			glScissor(viewport.x, viewport.y, viewport.z, viewport.w);
+			shadowLayerPass.setCurrentLayer((int)i);
+			renderSceneShadowPass(shader);
+		}
+	}
+
+	shadowLayerPass.end();
+}
+
 
 void RenderManager::renderUI()
 {
@@ -2928,7 +3099,7 @@ void RenderManager::renderUI()
 	// Render Message boxes UI
 	//
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, hdrFXAAFBO);		// @NOTE: Switched from hdrFBO bc the fxaa postprocessing step happens right before this, so kinda need to do this at this time.
+		// @NOTE: the render graph's UI pass already has the FXAA target bound (the fxaa postprocessing step happens right before this, so kinda need to do this at this time).
 		glViewport(0, 0, camWidth, camHeight);
 		glClear(GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_BLEND);
@@ -3529,6 +3700,114 @@ void RenderManager::renderImGuiContents()
 		if (ImGui::Begin("Example: Simple overlay", &showAnalyticsOverlay, window_flags))
 		{
 			ImGui::Text(fpsReportString.c_str());
+			ImGui::Text(
+				"Anim: %i evals, %i skipped, %i frozen (%.3fms / %.3fms budget)",
+				(int)Animator::lodStats.numEvaluations,
+				(int)Animator::lodStats.numSkippedEvaluations,
+				(int)Animator::lodStats.numFrozen,
+				Animator::lodStats.evaluationTimeMs,
+				Animator::lodSettings.frameBudgetMs
+			);
+			ImGui::Text(
+				"Occlusion: %i/%i culled, %i occluder tris (%.3fms)",
+				(int)occlusionCuller.stats.numCulled,
+				(int)occlusionCuller.stats.numTested,
+				(int)occlusionCuller.stats.numRasterizedTriangles,
+				occlusionCuller.stats.rasterizeTimeMs
+			);
+			ImGui::Text(
+				"LOD: %i/%i tris, %i crossfading (bias %.2f)",
+				(int)Model::lodStats.numTrianglesRendered,
+				(int)Model::lodStats.numTrianglesFullDetail,
+				(int)Model::lodStats.numCrossfading,
+				Model::lodSettings.lodBias
+			);
+			ImGui::Text(
+				"Skinning: %i dispatches (%i verts), %i/%i draws prepassed, %i palette + %i bone UBO uploads",
+				(int)skinningPrepass.stats.numDispatches,
+				(int)skinningPrepass.stats.numSkinnedVertices,
+				(int)skinningPrepass.stats.numPrepassDraws,
+				(int)(skinningPrepass.stats.numPrepassDraws + skinningPrepass.stats.numFallbackDraws),
+				(int)skinningPrepass.stats.numPaletteUploads,
+				(int)skinningPrepass.stats.numBoneUBOUploads
+			);
+			ImGui::Text(
+				"Shadows: %i draws, %i layer submissions (%i culled)",
+				(int)shadowLayerPass.stats.numDraws,
+				(int)shadowLayerPass.stats.numLayerSubmissions,
+				(int)shadowLayerPass.stats.numLayerSubmissionsCulled
+			);
+			ImGui::Text(
+				"Cascades: %i rendered, %i cached (%i stale), %i caster invalidations",
+				(int)CascadeScheduler::stats.numCascadesRendered,
+				(int)CascadeScheduler::stats.numCascadesCached,
+				(int)CascadeScheduler::stats.numCascadesStale,
+				(int)CascadeScheduler::stats.numCasterInvalidations
+			);
+			ImGui::Text(
+				"Shadow atlas: %i lights (%i offscreen, %i out of space), %i faces rendered, %i cached (%i stale), %i waiting, %i resizes deferred, %.1f%% used",
+				(int)shadowAtlas.stats.numShadowedLights,
+				(int)shadowAtlas.stats.numLightsOffscreen,
+				(int)shadowAtlas.stats.numLightsOutOfSpace,
+				(int)shadowAtlas.stats.numFacesRendered,
+				(int)shadowAtlas.stats.numFacesCached,
+				(int)shadowAtlas.stats.numFacesStale,
+				(int)shadowAtlas.stats.numFacesWaiting,
+				(int)shadowAtlas.stats.numResizesDeferred,
+				shadowAtlas.stats.atlasUsage * 100.0f
+			);
+			ImGui::Text(
+				"Render graph: %i/%i passes (%i culled), %i barriers, %i transient textures -> %i physical, %.1fMB -> %.1fMB",
+				(int)(renderGraph.stats.numPasses - renderGraph.stats.numPassesCulled),
+				(int)renderGraph.stats.numPasses,
+				(int)renderGraph.stats.numPassesCulled,
+				(int)renderGraph.stats.numBarriers,
+				(int)renderGraph.stats.numTransientTextures,
+				(int)renderGraph.stats.numPhysicalTextures,
+				renderGraph.stats.transientBytesWithoutAliasing / (1024.0f * 1024.0f),
+				renderGraph.stats.transientBytesWithAliasing / (1024.0f * 1024.0f)
+			);
+			ImGui::Text(
+				"Resolution: %i%% (%ix%i), GPU %.2fms (target %.2fms)",
+				(int)std::round(dynamicResolution.getRenderScale() * 100.0f),
+				(int)renderWidth,
+				(int)renderHeight,
+				dynamicResolution.getSmoothedFrameTimeMs(),
+				dynamicResolution.settings.targetFrameTimeMs
+			);
+			ImGui::Text(
+				"SSAO: %ix%i, %i mips, GPU %.2fms",
+				(int)ssaoWidth,
+				(int)ssaoHeight,
+				(int)ssaoNumMips,
+				ssaoGPUTimesMs[ssaoResolutionDivisor == 1 ? 0 : (ssaoResolutionDivisor == 2 ? 1 : 2)]
+			);
+			ImGui::Text(
+				"IBL: %i cubemap face renders%s%s",
+				(int)IBLScheduler::stats.numFaceRenders,
+				iblScheduler.isUpdating() ? " (re-mixing)" : "",
+				IBLScheduler::stats.numSwaps > 0 ? " (swapped)" : ""
+			);
+			ImGui::Text("Atmospheric scattering LUT: %s", atmosphericScatteringLUTCache.refreshedThisFrame ? "refreshed" : "cached");
+			ImGui::Text(
+				"Picking: %i objects, %i/%i nodes, %i candidates, %i tris (%.3fms build, %.3fms pick)",
+				(int)scenePicker.stats.numObjects,
+				(int)scenePicker.stats.numNodesVisited,
+				(int)scenePicker.stats.numNodes,
+				(int)scenePicker.stats.numCandidates,
+				(int)scenePicker.stats.numTrianglesTested,
+				scenePicker.stats.buildTimeMs,
+				scenePicker.stats.pickTimeMs
+			);
+			ImGui::Text(
+				"Debug draw: %i/%i lines, %i/%i tris (%i retained, %i dropped)",
+				(int)DebugDraw::getInstance().stats.numLines,
+				(int)DebugDraw::getInstance().stats.lineCapacity,
+				(int)DebugDraw::getInstance().stats.numTriangles,
+				(int)DebugDraw::getInstance().stats.triangleCapacity,
+				(int)DebugDraw::getInstance().stats.numRetained,
+				(int)DebugDraw::getInstance().stats.numDropped
+			);
 			/*if (ImGui::BeginPopupContextWindow())
 			{
 				if (ImGui::MenuItem("Custom", NULL, corner == -1)) corner = -1;
@@ -3555,47 +3834,20 @@ void RenderManager::renderImGuiContents()
 	// @PHYSX_VISUALIZATION
 	//
 	if (renderPhysicsDebug &&
-		MainLoop::getInstance().playMode &&
-		physxVisDebugLines != nullptr)
+		MainLoop::getInstance().playMode)
 	{
-		std::vector<physx::PxDebugLine> debugLinesCopy = *physxVisDebugLines;		// @NOTE: this is to prevent the debugLines object from getting deleted while this render function is running
-		for (size_t i = 0; i < debugLinesCopy.size(); i++)
+		for (size_t i = 0; i < physxVisDebugLines.size(); i++)
 		{
-			//
-			// Convert to screen space
-			//
-			physx::PxDebugLine& debugLine = debugLinesCopy[i];
+			const physx::PxDebugLine& debugLine = physxVisDebugLines[i];
 			physx::PxU32 lineColor = debugLine.color0;		// @Checkup: would there be any situation where color0 and color1 would differ????
 
 			// Change ugly purple color to the collision green!
 			if (lineColor == 0xFFFF00FF)
 				lineColor = ImColor::HSV(0.39f, 0.88f, 0.92f);
+			else
+				lineColor = (lineColor & 0xFF00FF00) | ((lineColor >> 16) & 0xFF) | ((lineColor & 0xFF) << 16);		// NOTE: physx is ARGB and ImU32 is ABGR
 
-			bool willBeOnScreen = true;
-			glm::vec3 pointsOnScreen[] = {
-				MainLoop::getInstance().camera.PositionToClipSpace(PhysicsUtils::toGLMVec3(debugLine.pos0)),
-				MainLoop::getInstance().camera.PositionToClipSpace(PhysicsUtils::toGLMVec3(debugLine.pos1))
-			};
-			for (size_t ii = 0; ii < 2; ii++)
-			{
-				if (pointsOnScreen[ii].z < 0.0f)
-				{
-					// Short circuit bc it won't be on screen anymore
-					willBeOnScreen = false;
-					break;
-				}
-
-				pointsOnScreen[ii] /= pointsOnScreen[ii].z;
-				pointsOnScreen[ii].x = ImGui::GetWindowPos().x + pointsOnScreen[ii].x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-				pointsOnScreen[ii].y = ImGui::GetWindowPos().y - pointsOnScreen[ii].y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-			}
-
-			if (!willBeOnScreen)
-				continue;
-
-			ImVec2 point1(pointsOnScreen[0].x, pointsOnScreen[0].y);
-			ImVec2 point2(pointsOnScreen[1].x, pointsOnScreen[1].y);
-			ImGui::GetBackgroundDrawList()->AddLine(point1, point2, lineColor, 1.0f);
+			DebugDraw::getInstance().addLine(PhysicsUtils::toGLMVec3(debugLine.pos0), PhysicsUtils::toGLMVec3(debugLine.pos1), lineColor, 0.0f, false);
 		}
 	}
 #endif
@@ -3721,10 +3973,14 @@ void RenderManager::renderImGuiContents()
 
 							if (isShiftHeld)
 							{
-								if (!isSelected && !selectedObjectIndices.empty())
+								const size_t lastSelectedIndex =
+									selectedObjectHandles.empty() ?
+									SlotMap<BaseObject*>::NO_DENSE_INDEX :
+									MainLoop::getInstance().objects.getDenseIndex(selectedObjectHandles.back());
+								if (!isSelected && lastSelectedIndex != SlotMap<BaseObject*>::NO_DENSE_INDEX)
 								{
-									shiftSelectRequest[0] = glm::min((size_t)selectedObjectIndices[selectedObjectIndices.size() - 1], n);
-									shiftSelectRequest[1] = glm::max((size_t)selectedObjectIndices[selectedObjectIndices.size() - 1], n);
+									shiftSelectRequest[0] = (int)glm::min(lastSelectedIndex, n);
+									shiftSelectRequest[1] = (int)glm::max(lastSelectedIndex, n);
 								}
 							}
 							else
@@ -3831,12 +4087,37 @@ void RenderManager::renderImGuiContents()
 					ImGui::DragFloat("Cloud noise view layer", &debugCloudNoiseLayerNum);
 				}
 
+				if (ImGui::TreeNode("Cloud Noise Generation"))
+				{
+					for (CloudNoiseVolumeParams* params : { &cloudNoiseInfo.baseNoiseParams, &cloudNoiseInfo.detailNoiseParams })
+					{
+						ImGui::PushID(params);
+						ImGui::Text(params == &cloudNoiseInfo.baseNoiseParams ? "Base noise" : "Detail noise");
+						ImGui::DragInt("Seed", (int*)&params->seed);
+						for (uint32_t channel = 0; channel < params->numChannels; channel++)
+						{
+							ImGui::PushID(channel);
+							ImGui::DragInt3("Octave grid sizes", (int*)params->octaveGridSizes[channel], 0.1f, 1, 128);
+							ImGui::PopID();
+						}
+						ImGui::PopID();
+					}
+
+					if (ImGui::Button("Regenerate Cloud Noise"))
+					{
+						destroyCloudNoise();
+						createCloudNoise();
+					}
+					ImGui::TreePop();
+				}
+
 				ImGui::Checkbox("Toggle Cloud TAA", &doCloudHistoryTAA);
 				if (!doCloudHistoryTAA)
 					ImGui::Checkbox("Toggle Cloud Color Floodfill", &doCloudColorFloodFill);
 				else
 					ImGui::Text("*NOTE: to show option for cloud color floodfill, disable cloud taa");
 				ImGui::Checkbox("Toggle Cloud Denoise (non-temporal method)", &doCloudDenoiseNontemporal);
+				ImGui::Checkbox("Toggle Cloud Empty Space Skipping", &doCloudEmptySpaceSkipping);
 
 				static bool cloudHistoryTAAVelocityBufferTemp = false;
 				ImGui::Checkbox("Show Cloud History TAA Buffer", &cloudHistoryTAAVelocityBufferTemp);
@@ -3849,8 +4130,12 @@ void RenderManager::renderImGuiContents()
 				ImGui::Checkbox("Show Luminance Texture", &showLuminanceTextures);
 				if (showLuminanceTextures)
 				{
-					ImGui::Image((void*)(intptr_t)hdrLumDownsampling->getHandle(), ImVec2(256, 256));
-					ImGui::Image((void*)(intptr_t)hdrLumAdaptation1x1, ImVec2(256, 256));
+					if (!doComputeLuminanceReduction)
+					{
+						// NOTE: the compute reduction doesn't fill these in
+						ImGui::Image((void*)(intptr_t)hdrLumDownsampling->getHandle(), ImVec2(256, 256));
+						ImGui::Image((void*)(intptr_t)hdrLumAdaptation1x1, ImVec2(256, 256));
+					}
 					ImGui::Image((void*)(intptr_t)hdrLumAdaptationProcessed->getHandle(), ImVec2(256, 256));
 				}
 				ImGui::Separator();
@@ -3859,31 +4144,77 @@ void RenderManager::renderImGuiContents()
 				ImGui::Checkbox("Show SSAO Texture", &showSSAOTexture);
 				if (showSSAOTexture)
 				{
-					ImGui::Image((void*)(intptr_t)ssaoTexture->getHandle(), ImVec2(512, 288));
+					ImGui::Image((void*)(intptr_t)ShaderExtSSAO::ssaoTexture, ImVec2(512, 288));
 				}
 
 				ImGui::DragFloat("SSAO Scale", &ssaoScale, 0.001f);
 				ImGui::DragFloat("SSAO Bias", &ssaoBias, 0.001f);
 				ImGui::DragFloat("SSAO Radius", &ssaoRadius, 0.001f);
+
+				static const char* ssaoResolutionNames[] = { "Full", "Half", "Quarter" };
+				int ssaoResolutionIndex = (ssaoResolutionDivisor == 1) ? 0 : (ssaoResolutionDivisor == 2 ? 1 : 2);
+				if (ImGui::Combo("SSAO Resolution", &ssaoResolutionIndex, ssaoResolutionNames, IM_ARRAYSIZE(ssaoResolutionNames)))
+				{
+					ssaoResolutionDivisor = 1u << ssaoResolutionIndex;
+					ssaoGPUTimerResultsToSkip = 4;		// NOTE: same as GPUFrameTimer's frames in flight
+					destroySSAOBuffers();
+					createSSAOBuffers();
+				}
+				ImGui::DragFloat("SSAO Upsample Depth Sensitivity", &ssaoUpsampleDepthSensitivity, 0.1f, 0.0f, 1000.0f);
+
+				// NOTE: these keep the last time each resolution was used, so flip thru them to compare
+				ImGui::Text("SSAO GPU time: Full %.3fms, Half %.3fms, Quarter %.3fms", ssaoGPUTimesMs[0], ssaoGPUTimesMs[1], ssaoGPUTimesMs[2]);
 				ImGui::Separator();
 
-				static bool showBloomProcessingBuffers = false;
-				ImGui::Checkbox("Show Bloom preprocessing buffers", &showBloomProcessingBuffers);
-				if (showBloomProcessingBuffers)
+				static bool showRenderGraphTextures = false;
+				ImGui::Checkbox("Show Render Graph textures", &showRenderGraphTextures);
+				if (showRenderGraphTextures)
 				{
-					static int colBufNum = 0;
-					ImGui::InputInt("Color Buffer Index", &colBufNum);
-					ImGui::Image((void*)(intptr_t)bloomColorBuffers[colBufNum], ImVec2(512, 288));
+					// @NOTE: these are from last frame, and aliased textures share memory, so a texture can have what got rendered after it in there.
+					static std::vector<std::string> textureNames;
+					renderGraph.DEBUGgetLastFrameTextureNames(textureNames);
+
+					static int textureIndex = 0;
+					ImGui::InputInt("Texture Index", &textureIndex);
+					if (!textureNames.empty())
+					{
+						textureIndex = std::clamp(textureIndex, 0, (int)textureNames.size() - 1);
+						ImGui::Text("%s", textureNames[textureIndex].c_str());
+						ImGui::Image((void*)(intptr_t)renderGraph.DEBUGgetLastFrameTexture(textureNames[textureIndex]), ImVec2(512, 288));
+					}
 				}
 
 
 				ImGui::Separator();
 				ImGui::DragFloat("Volumetric Lighting Strength", &volumetricLightingStrength);
 				ImGui::DragFloat("External Volumetric Lighting Strength", &volumetricLightingStrengthExternal);
+				ImGui::Checkbox("Use Froxel Volumetric Lighting", &doFroxelVolumetricLighting);
+				if (doFroxelVolumetricLighting)
+				{
+					ImGui::DragFloat("Froxel History Blend", &volumetricFroxelHistoryBlend, 0.005f, 0.01f, 1.0f);
+					ImGui::DragFloat("Froxel Extinction (per meter)", &volumetricFroxelExtinction, 0.0001f, 0.0f, 1.0f, "%.4f");
+					ImGui::Text("Froxel grid: %ix%ix%i", volumetricFroxelGridWidth, volumetricFroxelGridHeight, volumetricFroxelGridDepth);
+				}
 
 				ImGui::Separator();
 				ImGui::DragFloat("Scene Tonemapping Exposure", &exposure);
 				ImGui::DragFloat("Bloom Intensity", &bloomIntensity, 0.05f, 0.0f, 5.0f);
+				ImGui::Checkbox("Use Compute Bloom", &doComputeBloom);
+				ImGui::Checkbox("Fuse FXAA Into Tonemapping Pass", &fuseFXAAIntoPostprocessing);
+				ImGui::Checkbox("Use Compute Luminance Reduction", &doComputeLuminanceReduction);
+				if (doComputeLuminanceReduction)
+				{
+					ImGui::Checkbox("Use Luminance Histogram", &luminanceUseHistogram);
+					if (luminanceUseHistogram)
+					{
+						ImGui::DragFloat2("Luminance Histogram Percentiles", &luminanceHistogramPercentiles[0], 0.005f, 0.0f, 1.0f);
+						ImGui::DragFloat2("Luminance Histogram log2 Range", &luminanceHistogramLogRange[0], 0.1f);
+						luminanceHistogramPercentiles.y = std::max(luminanceHistogramPercentiles.x, luminanceHistogramPercentiles.y);
+						luminanceHistogramLogRange.y = std::max(luminanceHistogramLogRange.x + 0.1f, luminanceHistogramLogRange.y);
+					}
+				}
+				else
+					ImGui::Text("*NOTE: the luminance histogram only works w/ the compute luminance reduction");
 
 				ImGui::Separator();
 				ImGui::DragFloat2("notifExtents", &notifExtents[0]);
@@ -3914,6 +4245,68 @@ void RenderManager::renderImGuiContents()
 				ImGui::DragInt("Which ibl map", (int*)&whichMap, 1.0f, 0, 4);
 				ImGui::DragFloat("Map Interpolation amount", &mapInterpolationAmt);
 
+				ImGui::Separator();
+				ImGui::Checkbox("Do CPU Occlusion Culling", &doOcclusionCulling);
+				ImGui::Checkbox("Do Compute Skinning Prepass", &skinningPrepass.enabled);
+				ImGui::Checkbox("Force Per Layer Shadow Passes", &shadowLayerPass.forcePerLayerPasses);
+
+				ImGui::Separator();
+				ImGui::Text("CSM Cascade Caching");
+				ImGui::Checkbox("Enable cascade caching", &CascadeScheduler::settings.enabled);
+				ImGui::DragInt("Cascades rendered every frame", (int*)&CascadeScheduler::settings.numCascadesEveryFrame, 1.0f, 1, 16);
+				ImGui::DragInt("Far cascade update interval", (int*)&CascadeScheduler::settings.farCascadeUpdateInterval, 1.0f, 1, 60);
+				ImGui::DragInt("Far cascade refresh interval", (int*)&CascadeScheduler::settings.farCascadeRefreshInterval, 1.0f, 1, 600);
+				ImGui::DragInt("Max staggered cascades per frame", (int*)&CascadeScheduler::settings.maxStaggeredCascadesPerFrame, 1.0f, 0, 16);
+				ImGui::DragFloat("Max light direction change (degrees)", &CascadeScheduler::settings.maxLightDirectionChangeDegrees, 0.01f, 0.0f, 10.0f);
+
+				ImGui::Separator();
+				ImGui::Text("Shadow Atlas");
+				static int atlasResolutionIndex = 1;
+				if (ImGui::Combo("Atlas resolution", &atlasResolutionIndex, "2048\0" "4096\0" "8192\0"))
+					shadowAtlas.atlasResolution = 2048u << atlasResolutionIndex;
+				ImGui::DragInt("Min tile size", (int*)&shadowAtlas.minTileSize, 1.0f, 16, (int)shadowAtlas.maxTileSize);
+				ImGui::DragInt("Max tile size", (int*)&shadowAtlas.maxTileSize, 1.0f, (int)shadowAtlas.minTileSize, 2048);
+				ImGui::DragInt("Max faces rendered per frame", (int*)&shadowAtlas.maxFacesRenderedPerFrame, 1.0f, 6, 192);
+				ImGui::DragFloat("Tile size scale", &shadowAtlas.tileSizeScale, 0.01f, 0.1f, 4.0f);
+
+				ImGui::Separator();
+				ImGui::Text("Dynamic Resolution");
+				ImGui::Checkbox("Enable Dynamic Resolution", &dynamicResolution.settings.enabled);
+				ImGui::DragFloat("Target GPU frame time (ms)", &dynamicResolution.settings.targetFrameTimeMs, 0.1f, 1.0f, 100.0f);
+				ImGui::DragFloatRange2("Render scale bounds", &dynamicResolution.settings.minRenderScale, &dynamicResolution.settings.maxRenderScale, 0.01f, 0.25f, 1.0f);
+				ImGui::DragInt("Frames before change", (int*)&dynamicResolution.settings.framesBeforeChange, 1.0f, 1, 120);
+				ImGui::DragInt("Cooldown frames", (int*)&dynamicResolution.settings.cooldownFrames, 1.0f, 0, 600);
+
+				ImGui::Separator();
+				ImGui::Text("IBL Re-mixing");
+				ImGui::Checkbox("Enable incremental IBL re-mixing", &IBLScheduler::settings.enabled);
+				ImGui::DragInt("Max cubemap faces per frame", (int*)&IBLScheduler::settings.maxFaceRendersPerFrame, 1.0f, 1, 36);
+				ImGui::DragFloat("Min interpolation change", &IBLScheduler::settings.minInterpolationChange, 0.001f, 0.0f, 1.0f);
+				ImGui::DragFloat("Min sun spin change (degrees)", &IBLScheduler::settings.minSunSpinChangeDegrees, 0.01f, 0.0f, 45.0f);
+
+				ImGui::Separator();
+				ImGui::Text("Mesh LOD");
+				ImGui::Checkbox("Enable Mesh LOD", &Model::lodSettings.enabled);
+				ImGui::DragFloat("Max LOD pixel error", &Model::lodSettings.maxPixelError, 0.01f, 0.0f, 64.0f);
+				ImGui::DragFloat("LOD hysteresis", &Model::lodSettings.hysteresis, 0.01f, 0.0f, 0.9f);
+				ImGui::DragFloat("LOD crossfade time", &Model::lodSettings.crossfadeTime, 0.01f, 0.0f, 5.0f);
+				ImGui::DragFloat("LOD bias", &Model::lodSettings.lodBias, 0.01f, Model::lodSettings.minLODBias, Model::lodSettings.maxLODBias);
+				ImGui::Checkbox("Auto LOD bias", &Model::lodSettings.autoLODBias);
+				ImGui::DragFloat("Auto LOD bias target frame time (ms)", &Model::lodSettings.targetFrameTimeMs, 0.1f, 1.0f, 100.0f);
+				ImGui::DragFloat("Min LOD bias", &Model::lodSettings.minLODBias, 0.01f, 0.01f, Model::lodSettings.maxLODBias);
+				ImGui::DragFloat("Max LOD bias", &Model::lodSettings.maxLODBias, 0.01f, Model::lodSettings.minLODBias, 16.0f);
+
+				ImGui::Separator();
+				ImGui::Text("Animation LOD");
+				ImGui::Checkbox("Enable Animation LOD", &Animator::lodSettings.enabled);
+				ImGui::DragFloat("Every frame screen size", &Animator::lodSettings.everyFrameScreenSize, 0.001f, 0.0f, 1.0f);
+				ImGui::DragFloat("Every 2nd frame screen size", &Animator::lodSettings.every2ndFrameScreenSize, 0.001f, 0.0f, 1.0f);
+				ImGui::DragFloat("Reduced bones screen size", &Animator::lodSettings.reducedBonesScreenSize, 0.001f, 0.0f, 1.0f);
+				ImGui::DragInt("Reduced bone depth", &Animator::lodSettings.reducedBoneDepth, 1.0f, 0, 64);
+				ImGui::DragInt("Offscreen frames until frozen", &Animator::lodSettings.offscreenFramesUntilFrozen);
+				ImGui::DragFloat("Animation frame budget (ms)", &Animator::lodSettings.frameBudgetMs, 0.01f, 0.0f, 16.0f);
+				ImGui::Text("Over budget deferrals: %i", (int)Animator::lodStats.numOverBudgetDeferrals);
+
 				ImGui::Separator();
 				ImGui::Text("Player Stamina Properties");
 				ImGui::DragInt("Stamina Max", &GameState::getInstance().maxPlayerStaminaAmount);
@@ -4014,7 +4407,21 @@ void RenderManager::renderImGuiContents()
 			}
 			ImGui::End();
 		}
-		
+
+		//
+		// Picking rectangle (while dragging)
+		//
+		if (DEBUGdoPicking)
+		{
+			const ImVec2 mousePos = ImGui::GetMousePos();
+			if (std::abs(mousePos.x - pickingCursorStart.x) >= pickingRectMinSize || std::abs(mousePos.y - pickingCursorStart.y) >= pickingRectMinSize)
+			{
+				ImDrawList* drawList = ImGui::GetForegroundDrawList();
+				drawList->AddRectFilled(ImVec2(pickingCursorStart.x, pickingCursorStart.y), mousePos, IM_COL32(66, 150, 250, 40));
+				drawList->AddRect(ImVec2(pickingCursorStart.x, pickingCursorStart.y), mousePos, IM_COL32(66, 150, 250, 200));
+			}
+		}
+
 		//
 		// ImGuizmo (NOTE: keep this at the very end so that imguizmo stuff can be rendered after everything else in the background draw list has been rendered)
 		//
@@ -5540,47 +5947,111 @@ void RenderManager::renderText(TextRenderer& tr)		// @Cleanup: this needs to go
 }
 
 #ifdef _DEVELOP
-void RenderManager::createPickingBuffer()			// @Copypasta with createHDRBuffer()
+void RenderManager::flagForPicking()
 {
-	glGenFramebuffers(1, &pickingFBO);
-	// Create floating point color buffer
-	glGenTextures(1, &pickingColorBuffer);
-	glBindTexture(GL_TEXTURE_2D, pickingColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height, 0, GL_RED, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// Create depth buffer (renderbuffer)
-	glGenRenderbuffers(1, &pickingRBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, pickingRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, (GLsizei)MainLoop::getInstance().camera.width, (GLsizei)MainLoop::getInstance().camera.height);
-	// Attach buffers
-	glBindFramebuffer(GL_FRAMEBUFFER, pickingFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pickingColorBuffer, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, pickingRBO);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete! (picking Framebuffer)" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	double mouseX, mouseY;
+	glfwGetCursorPos(MainLoop::getInstance().window, &mouseX, &mouseY);
+	pickingCursorStart = glm::vec2((float)mouseX, (float)mouseY);
+	DEBUGdoPicking = true;
 }
 
-void RenderManager::destroyPickingBuffer()
+void RenderManager::buildScenePicker()
 {
-	glDeleteTextures(1, &pickingColorBuffer);
-	glDeleteRenderbuffers(1, &pickingRBO);
-	glDeleteFramebuffers(1, &pickingFBO);
+	// NOTE: the objects move around whenever, so the BVH just gets remade for every pick. It's only the bounds, so it's quick
+	scenePicker.beginBuild();
+	for (size_t i = 0; i < MainLoop::getInstance().objects.size(); i++)
+	{
+		RenderComponent* rc = MainLoop::getInstance().objects[i]->getRenderComponent();
+		if (rc == nullptr)
+			continue;
+
+		glm::vec3 minPoint, maxPoint;
+		if (rc->getPickingBounds(minPoint, maxPoint))
+			scenePicker.addObject(i, minPoint, maxPoint);
+	}
+	scenePicker.build();
 }
 
-PixelInfo RenderManager::readPixelFromPickingBuffer(uint32_t x, uint32_t y)
+void RenderManager::updatePicking()
 {
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, pickingFBO);
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	if (MainLoop::getInstance().timelineViewerMode ||
+		MainLoop::getInstance().playMode ||			// NOTE: no reason in particular for making this !playmode only
+		ImGuizmo::IsUsing())						// Dragging the gizmo around isn't a pick
+	{
+		DEBUGdoPicking = false;
+		return;
+	}
 
-	PixelInfo pixel;
-	glReadPixels(x, y, 1, 1, GL_RED, GL_FLOAT, &pixel);
+	GLFWwindow* window = MainLoop::getInstance().window;
+	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+		return;		// Still dragging
+	DEBUGdoPicking = false;
+
+	double mouseX, mouseY;
+	glfwGetCursorPos(window, &mouseX, &mouseY);
+	const glm::vec2 pickingCursorEnd((float)mouseX, (float)mouseY);
+	const glm::vec2 screenSize(MainLoop::getInstance().camera.width, MainLoop::getInstance().camera.height);
+	auto cursorToNDC = [&](const glm::vec2& cursor) { return glm::vec2(cursor.x / screenSize.x * 2.0f - 1.0f, 1.0f - cursor.y / screenSize.y * 2.0f); };
+
+	buildScenePicker();
+	ScenePicker::MeshFunc getMeshes = [](size_t objectIndex, std::vector<ScenePickerMesh>& out_meshes)
+	{
+		MainLoop::getInstance().objects[objectIndex]->getRenderComponent()->submitPickingMeshes(out_meshes);
+	};
+
+	const bool isControlHeld =
+		glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) ||
+		glfwGetKey(window, GLFW_KEY_RIGHT_CONTROL);
+
+	const glm::vec2 dragSize = glm::abs(pickingCursorEnd - pickingCursorStart);
+	if (dragSize.x >= pickingRectMinSize || dragSize.y >= pickingRectMinSize)
+	{
+		//
+		// Rectangle select (w/ ctrl it adds onto the selection instead of toggling)
+		//
+		std::vector<size_t> pickedIndices;
+		scenePicker.pickRect(cameraInfo.projectionView, cursorToNDC(pickingCursorStart), cursorToNDC(pickingCursorEnd), getMeshes, pickedIndices);
+
+		if (!isControlHeld)
+			deselectAllSelectedObject();
+		for (size_t index : pickedIndices)
+			addSelectObject(index);
+		mostRecentPickedHandle = SlotMapHandle();
+		return;
+	}
 
-	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	//
+	// Click select. Ray from the near plane thru the cursor
+	//
+	const glm::mat4 inverseProjectionView = glm::inverse(cameraInfo.projectionView);
+	const glm::vec2 cursorNDC = cursorToNDC(pickingCursorEnd);
+	glm::vec4 nearPoint = inverseProjectionView * glm::vec4(cursorNDC, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseProjectionView * glm::vec4(cursorNDC, 1.0f, 1.0f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	// NOTE: the most recent pick gets skipped, so clicking on the same spot again picks whatever's behind it
+	size_t pickedIndex;
+	float pickedDistance;
+	const bool isHit = scenePicker.pickRay(
+		glm::vec3(nearPoint),
+		glm::normalize(glm::vec3(farPoint - nearPoint)),
+		getMeshes,
+		pickedIndex,
+		pickedDistance,
+		MainLoop::getInstance().objects.getDenseIndex(mostRecentPickedHandle)		// NOTE: NO_DENSE_INDEX is the same as NO_ID, so a stale handle just doesn't skip anything
+	);
+	mostRecentPickedHandle = isHit ? MainLoop::getInstance().objects.getHandle(pickedIndex) : SlotMapHandle();
 
-	return pixel;
+	if (!isControlHeld)
+		deselectAllSelectedObject();
+	if (isHit)
+	{
+		if (isObjectSelected(pickedIndex))
+			deselectObject(pickedIndex);
+		else
+			addSelectObject(pickedIndex);
+	}
 }
 #endif
 
@@ -5604,6 +6075,17 @@ void RenderManager::INTERNALupdateSkeletalBonesUBO(const std::vector<glm::mat4>*
 	assignedBoneMatricesMemAddr = boneTransforms;
 
 	glNamedBufferSubData(skeletalAnimationUBO, 0, sizeof(glm::mat4x4) * boneTransforms->size(), &(*boneTransforms)[0]);
+	skinningPrepass.stats.numBoneUBOUploads++;
+}
+
+GLuint RenderManager::INTERNALgetPrepassSkinnedVAO(Mesh* mesh, const std::vector<glm::mat4>* boneTransforms, GLuint meshEBO)
+{
+	return skinningPrepass.getSkinnedVAO(mesh, boneTransforms, meshEBO);
+}
+
+void RenderManager::INTERNALaddChangedShadowCasterBounds(const RenderAABB& worldBounds)
+{
+	changedShadowCasterBounds.push_back(worldBounds);
 }
 
 void RenderManager::createLightInformationUBO()
@@ -5642,7 +6124,12 @@ void RenderManager::updateLightInformationUBO()
 			TEMPJOJOJOJOJOJOO = true;
 		}
 
-		if (shadowIndex < ShaderExtShadow::MAX_SHADOWS && light->castsShadows)
+		if (light->lightType == LightType::POINT)
+		{
+			// NOTE: for point lights it's the index into the shadow atlas + 1 (0 means no shadow this frame)
+			lightInformation.lightDirections[i].a = (float)(shadowAtlas.getShadowIndex(light) + 1);
+		}
+		else if (shadowIndex < ShaderExtShadow::MAX_SHADOWS && light->castsShadows)
 		{
 			lightInformation.lightDirections[i].a = 1;
 			shadowIndex++;
@@ -13,6 +13,16 @@
 #include "../../objects/BaseObject.h"
 
 #include "../camera/Camera.h"
+#include "OcclusionCuller.h"
+#include "ScenePicker.h"
+#include "SkinningPrepass.h"
+#include "ShadowLayerPass.h"
+#include "ShadowAtlas.h"
+#include "CascadeScheduler.h"
+#include "IBLScheduler.h"
+#include "RenderGraph.h"
+#include "DynamicResolution.h"
+#include "CloudNoiseGenerator.h"
 
 
 class Texture;
@@ -34,19 +44,7 @@ struct TextCharacter
 };
 
 class Mesh;
-
-
-#ifdef _DEVELOP
-struct PixelInfo
-{
-	float objectID;
-
-	PixelInfo()
-	{
-		objectID = 0.0f;
-	}
-};
-#endif
+class TerrainRenderer;
 
 
 struct SkyboxParams
@@ -71,6 +69,9 @@ struct OpaqueRenderQueue
 	std::vector<Mesh*> meshesToRender;
 	std::vector<glm::mat4> modelMatrices;
 	std::vector<const std::vector<glm::mat4>*> boneMatrixMemAddrs;
+	std::vector<size_t> lodIndices;
+	std::vector<float> lodFadeAlphas;
+	std::vector<TerrainRenderer*> terrainsToRender;
 };
 
 
@@ -80,6 +81,8 @@ struct TransparentRenderQueue
 	std::vector<Mesh*> meshesToRender;
 	std::vector<glm::mat4> modelMatrices;
 	std::vector<const std::vector<glm::mat4>*> boneMatrixMemAddrs;
+	std::vector<size_t> lodIndices;
+	std::vector<float> lodFadeAlphas;
 	std::vector<float> distancesToCamera;
 };
 
@@ -112,7 +115,9 @@ struct CameraInformation
 
 struct CloudNoiseInformation
 {
-	std::vector<glm::vec4> worleyPoints;
+	// NOTE: changing any of these makes a new cache file (see CloudNoiseGenerator)
+	CloudNoiseVolumeParams baseNoiseParams = { 128, 4, { { 3, 7, 11 }, { 9, 20, 33 }, { 12, 24, 40 }, { 20, 35, 49 } }, 1 };
+	CloudNoiseVolumeParams detailNoiseParams = { 32, 3, { { 3, 7, 11 }, { 9, 20, 33 }, { 12, 24, 40 } }, 2 };
 };
 
 // Added values from (https://github.com/SebLague/Clouds/blob/fcc997c40d36c7bedf95a294cd2136b8c5127009/Assets/_Scenes/Clouds%20Test.unity)
@@ -154,6 +159,8 @@ public:
 	void render();
 	void renderScene();
 	void renderSceneShadowPass(Shader* shader);
+	void renderSceneShadowLayers(Shader* shader, GLuint shadowMapTexture, const std::vector<glm::mat4>& layerMatrices, bool clampsDepth, uint32_t layersToRender = ~0u);		// NOTE: the light's FBO needs to be bound already. Layers not in layersToRender get left alone
+	void renderSceneShadowViewports(Shader* shader, const std::vector<glm::mat4>& layerMatrices, const std::vector<glm::ivec4>& layerViewports);		// NOTE: for the shadow atlas. Each layer is a viewport (x, y, width, height) in the bound FBO
 	void renderUI();
 
 	glm::vec3 sunColorForClouds;  // @TEMP: @REFACTOR: this is the saved sunlight intensity and color
@@ -164,10 +171,14 @@ public:
 
 	void recreateRenderBuffers();
 
+	// Internal resolution of the scene (w/ dynamic resolution). The UI and final output are at the window's resolution
+	inline uint32_t getRenderWidth() const { return renderWidth; }
+	inline uint32_t getRenderHeight() const { return renderHeight; }
+
 #ifdef _DEVELOP
-	std::vector<size_t> selectedObjectIndices;
+	std::vector<SlotMapHandle> selectedObjectHandles;		// NOTE: handles so that deleting other objects doesn't shift the selection around
 	std::vector<BaseObject*> getSelectedObjects();
-	bool isObjectSelected(size_t index);
+	bool isObjectSelected(size_t index);		// NOTE: the index functions take indices into MainLoop::objects
 	bool isObjectSelected(const std::string& guid);
 	void addSelectObject(size_t index);
 	void deselectObject(size_t index);
@@ -180,14 +191,19 @@ public:
 #endif
 
 	void INTERNALupdateSkeletalBonesUBO(const std::vector<glm::mat4>* boneTransforms);
+	ShadowLayerPass* INTERNALgetActiveShadowLayerPass() { return shadowLayerPass.isActive() ? &shadowLayerPass : nullptr; }
+	void INTERNALaddChangedShadowCasterBounds(const RenderAABB& worldBounds);
+	const std::vector<RenderAABB>& INTERNALgetChangedShadowCasterBounds() { return changedShadowCasterBounds; }		// NOTE: world space. For the CSM cascade caching (see CascadeScheduler) and the point light shadow atlas
+	GLuint INTERNALgetPrepassSkinnedVAO(Mesh* mesh, const std::vector<glm::mat4>* boneTransforms, GLuint meshEBO);		// NOTE: 0 means it needs to get skinned in the vertex shader
 
 	// Render Queues
-	void INTERNALaddMeshToOpaqueRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms);
-	void INTERNALaddMeshToTransparentRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms);
+	void INTERNALaddMeshToOpaqueRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms, size_t lodIndex, float lodFadeAlpha);
+	void INTERNALaddMeshToTransparentRenderQueue(Mesh* mesh, const glm::mat4& modelMatrix, const std::vector<glm::mat4>* boneTransforms, size_t lodIndex, float lodFadeAlpha);
+	void INTERNALaddTerrainToOpaqueRenderQueue(TerrainRenderer* terrainRenderer);
 
 #ifdef _DEVELOP
 	// @PHYSX_VISUALIZATION
-	void physxVisSetDebugLineList(std::vector<physx::PxDebugLine>* lineList);
+	void physxVisSetDebugLineList(const physx::PxDebugLine* lines, size_t numLines);
 #endif
 
 	// @DEBUG: @WHEN_RELEASE: remove these when done with game.
@@ -210,39 +226,66 @@ public:
 	void pushMessage(const std::string& text);
 
 private:
-	Shader* debug_csm_program_id, *debug_cloud_noise_program_id, *text_program_id, *irradiance_program_id, *prefilter_program_id, *brdf_program_id, *bloom_postprocessing_program_id, *postprocessing_program_id, *fxaaPostProcessingShader, *pbrShaderProgramId, *notificationUIProgramId;
+	Shader* debug_csm_program_id, *debug_cloud_noise_program_id, *text_program_id, *irradiance_program_id, *prefilter_program_id, *brdf_program_id, *bloom_postprocessing_program_id, *postprocessing_program_id, *fxaaPostProcessingShader, *bloomDownsampleComputeShader, *bloomUpsampleComputeShader, *pbrShaderProgramId, *notificationUIProgramId;
 
-	GLuint hdrFBO, hdrFXAAFBO, hdrDepthRBO, hdrColorBuffer, hdrFXAAColorBuffer, hdrPBRGenCaptureFBO, hdrPBRGenCaptureRBO;
+	GLuint hdrFBO, hdrDepthRBO, hdrColorBuffer, hdrPBRGenCaptureFBO, hdrPBRGenCaptureRBO;
 
 	// HDR screen luminance adjustment
-	Shader* hdrLuminanceProgramId, *hdrLumAdaptationComputeProgramId;
+	Shader* hdrLuminanceProgramId, *hdrLumAdaptationComputeProgramId, *hdrLumReductionComputeProgramId;
 	GLuint hdrLumFBO, hdrLumAdaptation1x1;
 	Texture *hdrLumDownsampling, *hdrLumAdaptationPrevious, *hdrLumAdaptationProcessed;
 	float exposure = 0.3f;
+	bool doComputeLuminanceReduction = true;					// Single dispatch reduction + adaptation instead of mipmapping hdrLumDownsampling down to 1x1
+	bool luminanceUseHistogram = false;							// Average only between the percentiles instead of everything
+	glm::vec2 luminanceHistogramPercentiles = { 0.5f, 0.95f };
+	glm::vec2 luminanceHistogramLogRange = { -16.0f, 8.0f };	// log2 of the luminance the histogram covers
 
 	// Volumetric lighting
 	Shader* volumetricProgramId, *blurXProgramId, *blurYProgramId;
-	GLuint volumetricFBO, volumetricBlurFBO;
-	Texture* volumetricTexture;
-	Texture* volumetricBlurTexture;
-	int volumetricTextureWidth, volumetricTextureHeight;
 	float volumetricLightingStrength, volumetricLightingStrengthExternal;
 
+	// Volumetric lighting (froxels)	NOTE: the froxel grid covers the view frustum out to the shadow far plane
+	Shader* volumetricFroxelInjectShader, *volumetricFroxelIntegrateShader, *volumetricFroxelApplyShader;
+	bool doFroxelVolumetricLighting = true;			// @NOTE: the old per pixel raymarch + blur is still there to compare against
+	const static int volumetricFroxelGridWidth = 128;
+	const static int volumetricFroxelGridHeight = 72;
+	const static int volumetricFroxelGridDepth = 64;
+	Texture* volumetricFroxelLit[2];				// Ping-pong, so last frame's can get reprojected
+	Texture* volumetricFroxelIntegrated;
+	size_t volumetricFroxelLitIndex = 0;
+	float volumetricFroxelHistoryBlend = 0.1f;		// How much of this frame's froxels goes in
+	float volumetricFroxelExtinction = 0.0f;		// Per meter. 0 is the same as the old raymarch (no transmittance)
+	struct VolumetricFroxelHistory
+	{
+		bool isValid = false;
+		glm::mat4 projectionView;
+		glm::vec3 cameraPosition;
+		float farPlane;
+		uint32_t frameIndex = 0;					// For the depth jitter
+	} volumetricFroxelHistory;
+
 	// SSAO effect		(Uses NVIDIA's HBAO effect) (@NOTE: @TODO: I took out the plus (+) from HBAO+... there's no more temporal reprojection bc I didn't understand how it worked lol  -Timo)
-	Shader* ssaoProgramId;
-	GLuint ssaoFBO, ssaoBlurFBO;
-	float ssaoFBOSize = 1024;
+	Shader* ssaoProgramId, *ssaoLinearDepthComputeShader, *ssaoUpsampleProgramId;
+	GLuint ssaoFBO, ssaoBlurFBO, ssaoUpsampleFBO;
 	Texture* ssaoRotationTexture;
-	Texture* ssaoTexture;
+	Texture* ssaoLinearDepthTexture;				// Linearized z-prepass at the ssao resolution w/ mips for the far samples
+	Texture* ssaoTexture;							// NOTE: this and the blur texture are at the ssao resolution
 	Texture* ssaoBlurTexture;
+	Texture* ssaoFullResTexture;					// Bilateral upsampled. Only exists when ssaoResolutionDivisor > 1
+	uint32_t ssaoResolutionDivisor = 2;			// 1 (full), 2 (half), or 4 (quarter) res
+	uint32_t ssaoWidth, ssaoHeight, ssaoNumMips;
 	float ssaoScale = 0.5f;
 	float ssaoBias = 0.1f;
 	float ssaoRadius = 2.0f;
+	float ssaoUpsampleDepthSensitivity = 32.0f;
+	GPUFrameTimer ssaoGPUTimer;
+	float ssaoGPUTimesMs[3] = {};					// Smoothed, one for each divisor so the resolutions can be compared
+	uint32_t ssaoGPUTimerResultsToSkip = 0;		// Results still in flight after a resolution change are from the old one
 
 	// Bloom effect
-	static const uint32_t bloomBufferCount = 7 * 2;			// 7 passes with 2 pingpong buffers each
-	GLuint bloomFBOs[bloomBufferCount], bloomColorBuffers[bloomBufferCount];
 	float bloomIntensity = 0.005f;
+	bool doComputeBloom = true;						// Single dispatch compute downsample chain instead of the per level gaussian passes
+	bool fuseFXAAIntoPostprocessing = true;			// @NOTE: both of these have toggles so the old path can be compared against
 
 	// Cloud noises
 	GLuint cloudEffectFBO, cloudEffectBlurFBO, cloudEffectDepthFloodFillXFBO, cloudEffectDepthFloodFillYFBO, cloudEffectTAAHistoryFBO;
@@ -250,10 +293,9 @@ private:
 	int cloudEffectTextureWidth, cloudEffectTextureHeight;
 	Texture* cloudNoise1;
 	Texture* cloudNoise2;
-	Shader* cloudNoiseGenerateShader,
-		*cloudNoiseFractalShader,
-		*cloudNoiseCombineShader,
-		*cloudEffectShader,
+	Texture* cloudDensityBounds;		// NOTE: for empty space skipping (see CloudDensityBounds)
+	bool doCloudEmptySpaceSkipping = true;
+	Shader* cloudEffectShader,
 		*cloudEffectFloodFillShaderX,
 		*cloudEffectFloodFillShaderY,
 		*cloudEffectColorFloodFillShaderX,
@@ -275,14 +317,27 @@ private:
 	const static int irradianceMapSize = 32;
 	const static int prefilterMapSize = 128;
 	const static unsigned int maxMipLevels = 5;  // glm::floor(glm::log2((float_t)prefilterMapSize)) + 1;
-	GLuint skyboxFBO, skyboxBlurFBO, skyboxDepthSlicedLUTFBOs[skyboxDepthSlicedLUTSize], skyboxDetailsSSFBO;
+	GLuint skyboxFBO, skyboxBlurFBO, skyboxDetailsSSFBO;
 	Texture* skyboxLowResTexture, *skyboxLowResBlurTexture, *skyboxDepthSlicedLUT, *nightSkyboxCubemap, * skyboxDetailsSS;
-	Shader* skybox_program_id, *skyboxDetailsShader;
+	Shader* skybox_program_id, *skyboxDetailsShader, *atmosphericScatteringLUTComputeShader;
+	struct AtmosphericScatteringLUTCache
+	{
+		bool isValid = false;
+		glm::mat4 projectionView;		// NOTE: the LUT is screen space, so turning the camera means a refresh too
+		glm::vec3 sunOrientation;
+		glm::vec3 cameraPosition;
+		float maxSunChangeDegrees = 0.05f;
+		float maxCameraHeightChange = 1.0f;
+		float maxCameraHorizontalChange = 100.0f;		// The planet's so big that moving sideways barely changes anything
+		bool refreshedThisFrame = false;
+	} atmosphericScatteringLUTCache;
 	SkyboxParams skyboxParams;
 	static const size_t numSkyMaps = 6;
 	GLuint envCubemap, brdfLUTTexture, irradianceMap[numSkyMaps], prefilterMap[numSkyMaps];
-	Texture* irradianceMapInterpolated, *prefilterMapInterpolated;
+	Texture* irradianceMapInterpolated[2], *prefilterMapInterpolated[2];		// NOTE: double buffered. The shaders read the front one while the back one gets mixed over a few frames (see IBLScheduler)
 	GLuint irradianceMapInterpolatedFBO, prefilterMapInterpolatedFBO;
+	uint32_t iblFrontBuffer = 0;
+	IBLScheduler iblScheduler;
 	Shader* environmentMapMixerShader;
 	float_t preBakedSkyMapAngles[numSkyMaps] = { 90.0f, 10.0f, 5.0f, 0.0f, -10.0f, -30.0f };			// NOTE: these values must be listed in descending order
 	size_t whichMap = 0;
@@ -314,9 +369,17 @@ private:
 	void destroyShaderPrograms();
 	void createHDRBuffer();
 	void destroyHDRBuffer();
+	void createRenderResolutionBuffers();		// NOTE: everything that has to get remade when the render resolution changes (see recreateRenderBuffers())
+	void destroyRenderResolutionBuffers();
+	void createSSAOBuffers();
+	void destroySSAOBuffers();
 	void createLumenAdaptationTextures();
 	void destroyLumenAdaptationTextures();
+	void createVolumetricFroxelTextures();
+	void destroyVolumetricFroxelTextures();
 	void createCloudNoise();
+	Texture* createCloudNoiseVolume(const std::string& name, const CloudNoiseVolumeParams& params, GLenum internalFormat, GLenum format, std::vector<uint8_t>& texels);		// NOTE: texels gets filled w/ what got uploaded
+	void createCloudDensityBounds(const std::vector<uint8_t>& baseNoiseTexels);
 	void destroyCloudNoise();
 
     void createHDRSkybox(bool first, size_t index, const glm::vec3& sunOrientation);
@@ -331,6 +394,68 @@ private:
 	TransparentRenderQueue transparentRQ;
 	TextRenderQueue textRQ;
 
+	// CPU occlusion culling
+	OcclusionCuller occlusionCuller;
+	bool doOcclusionCulling = true;
+
+	// Compute skinning (once per frame for all passes)
+	SkinningPrepass skinningPrepass;
+
+	// Layered shadow maps w/o the geometry shader
+	ShadowLayerPass shadowLayerPass;
+
+	// Point light shadows
+	ShadowAtlas shadowAtlas;
+
+	// Post processing (volumetric lighting, luminance, FXAA, UI, bloom, tonemapping)
+	// NOTE: the graph only gets rebuilt (and recompiled) when the key changes. The stuff that changes every frame goes in postProcessingFrame
+	struct PostProcessingGraphKey
+	{
+		uint32_t renderWidth = 0, renderHeight = 0;
+		uint32_t screenWidth = 0, screenHeight = 0;
+		bool doVolumetricLighting = false;
+		bool doFroxelVolumetricLighting = false;
+		bool doComputeLuminanceReduction = false;
+		bool doFXAAInPostprocessing = false;
+		bool doComputeBloom = false;
+		bool doCloudDenoiseNontemporal = false;
+
+		bool operator==(const PostProcessingGraphKey& other) const = default;
+	} postProcessingGraphKey;
+	bool isPostProcessingGraphBuilt = false;
+
+	struct PostProcessingFrame
+	{
+		LightComponent* mainlight = nullptr;
+		glm::vec3 sunLightColor = glm::vec3(0.0f);
+		float froxelFarPlane = 0.0f;
+		float froxelDepthJitter = 0.5f;
+		VolumetricFroxelHistory froxelHistory;
+		GLuint froxelLitHistory = 0, froxelLit = 0;
+	} postProcessingFrame;
+
+	struct PostProcessingImports
+	{
+		RenderGraph::TextureHandle hdrColor = RenderGraph::INVALID_TEXTURE;
+		RenderGraph::TextureHandle lumDownsampling = RenderGraph::INVALID_TEXTURE;
+		RenderGraph::TextureHandle lumPrevious = RenderGraph::INVALID_TEXTURE;
+		RenderGraph::TextureHandle lumProcessed = RenderGraph::INVALID_TEXTURE;
+		RenderGraph::TextureHandle froxelLitHistory = RenderGraph::INVALID_TEXTURE;		// NOTE: the froxel ones are only there w/ froxel volumetric lighting on
+		RenderGraph::TextureHandle froxelLit = RenderGraph::INVALID_TEXTURE;
+		RenderGraph::TextureHandle froxelIntegrated = RenderGraph::INVALID_TEXTURE;
+	} postProcessingImports;
+
+	RenderGraph renderGraph;
+	void buildPostProcessingGraph(const PostProcessingGraphKey& key);
+
+	// Dynamic resolution
+	DynamicResolutionController dynamicResolution;
+	GPUFrameTimer gpuFrameTimer;
+	uint32_t renderWidth = 1, renderHeight = 1;
+
+	// Shadow casters that moved this frame (old and new bounds)
+	std::vector<RenderAABB> changedShadowCasterBounds;
+
 #ifdef _DEVELOP
 	// ImGui Debug stuff
 	void renderImGuiPass();
@@ -346,25 +471,22 @@ private:
 
 #ifdef _DEVELOP
 	// @PHYSX_VISUALIZATION
-	std::vector<physx::PxDebugLine>* physxVisDebugLines;
+	std::vector<physx::PxDebugLine> physxVisDebugLines;		// NOTE: drawn thru DebugDraw every frame until the next physics step replaces them
 #endif
 
 #ifdef _DEVELOP
-	// Picking texture
-	void createPickingBuffer();
-	void destroyPickingBuffer();
-	PixelInfo readPixelFromPickingBuffer(uint32_t x, uint32_t y);
+	// Picking (ray-casts on the CPU against the objects' meshes, see ScenePicker)
+	void updatePicking();
+	void buildScenePicker();
 
 public:
-	void flagForPicking() { DEBUGdoPicking = true; }
+	void flagForPicking();		// NOTE: call when the left mouse button goes down. The pick happens when it comes back up (dragging selects everything in the rectangle)
 private:
 	bool DEBUGdoPicking = false;
-
-	Shader* pickingRenderFormatShader;
-
-	GLuint pickingFBO;
-	GLuint pickingRBO;
-	GLuint pickingColorBuffer;
+	glm::vec2 pickingCursorStart;
+	SlotMapHandle mostRecentPickedHandle;
+	ScenePicker scenePicker;
+	const static int pickingRectMinSize = 4;		// Pixels. Drags smaller than this are just clicks
 #endif
 
 	// Skeletal Animation UBO
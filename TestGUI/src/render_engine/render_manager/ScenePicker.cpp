@@ -0,0 +1,470 @@
+#include "ScenePicker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+
+namespace
+{
+	constexpr uint32_t MAX_LEAF_SIZE = 4;
+	constexpr uint32_t NUM_SAH_BINS = 8;
+	constexpr uint32_t MAX_DEPTH = 48;		// NOTE: keeps the traversal stacks from overflowing if the objects are lined up weird
+
+	float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// Returns where the ray goes into the box (0 if it starts inside), or FLT_MAX if it misses (or the box is farther than maxT)
+	float intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& min, const glm::vec3& max, float maxT, float* out_tExit = nullptr)
+	{
+		const glm::vec3 t0 = (min - origin) * inverseDirection;
+		const glm::vec3 t1 = (max - origin) * inverseDirection;
+		const glm::vec3 tNear = glm::min(t0, t1);
+		const glm::vec3 tFar = glm::max(t0, t1);
+		const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+		if (out_tExit != nullptr)
+			*out_tExit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+		return (tEnter <= tExit) ? tEnter : FLT_MAX;
+	}
+
+	// Moller-Trumbore. Both sides count (same as the old picking buffer, which didn't cull anything)
+	bool intersectRayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& out_t)
+	{
+		const glm::vec3 edge1 = v1 - v0;
+		const glm::vec3 edge2 = v2 - v0;
+		const glm::vec3 p = glm::cross(direction, edge2);
+		const float determinant = glm::dot(edge1, p);
+		if (std::abs(determinant) < 1e-12f)
+			return false;		// Parallel
+
+		const float inverseDeterminant = 1.0f / determinant;
+		const glm::vec3 s = origin - v0;
+		const float u = glm::dot(s, p) * inverseDeterminant;
+		if (u < 0.0f || u > 1.0f)
+			return false;
+
+		const glm::vec3 q = glm::cross(s, edge1);
+		const float v = glm::dot(direction, q) * inverseDeterminant;
+		if (v < 0.0f || u + v > 1.0f)
+			return false;
+
+		out_t = glm::dot(edge2, q) * inverseDeterminant;
+		return out_t > 0.0f;
+	}
+
+	//
+	// The selection rectangle's frustum. Each plane is a dot product w/ a clip space position
+	// (>= 0 is inside), so the triangles can get clipped right in clip space
+	//
+	constexpr size_t NUM_RECT_PLANES = 5;
+
+	void getRectClipPlanes(const glm::vec2& ndcMin, const glm::vec2& ndcMax, glm::vec4 out_planes[NUM_RECT_PLANES])
+	{
+		out_planes[0] = glm::vec4(1, 0, 0, -ndcMin.x);		// x >= ndcMin.x * w
+		out_planes[1] = glm::vec4(-1, 0, 0, ndcMax.x);		// x <= ndcMax.x * w
+		out_planes[2] = glm::vec4(0, 1, 0, -ndcMin.y);
+		out_planes[3] = glm::vec4(0, -1, 0, ndcMax.y);
+		out_planes[4] = glm::vec4(0, 0, 1, 1);				// Near plane (z >= -w)
+	}
+
+	bool isTriangleInRect(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2, const glm::vec4 planes[NUM_RECT_PLANES])
+	{
+		// Quick outs before doing the actual clipping
+		bool anyVertexInside = false;
+		const glm::vec4* triangle[3] = { &c0, &c1, &c2 };
+		for (size_t i = 0; i < 3 && !anyVertexInside; i++)
+		{
+			bool inside = true;
+			for (size_t j = 0; j < NUM_RECT_PLANES && inside; j++)
+				inside = (glm::dot(planes[j], *triangle[i]) >= 0.0f);
+			anyVertexInside = inside;
+		}
+		if (anyVertexInside)
+			return true;
+
+		for (size_t j = 0; j < NUM_RECT_PLANES; j++)
+			if (glm::dot(planes[j], c0) < 0.0f && glm::dot(planes[j], c1) < 0.0f && glm::dot(planes[j], c2) < 0.0f)
+				return false;
+
+		//
+		// Clip the triangle against every plane. If anything's left, it's touching the rectangle
+		//
+		constexpr size_t MAX_POLYGON_SIZE = 3 + NUM_RECT_PLANES;
+		glm::vec4 polygon[MAX_POLYGON_SIZE] = { c0, c1, c2 };
+		glm::vec4 clipped[MAX_POLYGON_SIZE];
+		size_t polygonSize = 3;
+		for (size_t j = 0; j < NUM_RECT_PLANES && polygonSize > 0; j++)
+		{
+			size_t clippedSize = 0;
+			for (size_t i = 0; i < polygonSize; i++)
+			{
+				const glm::vec4& a = polygon[i];
+				const glm::vec4& b = polygon[(i + 1) % polygonSize];
+				const float da = glm::dot(planes[j], a);
+				const float db = glm::dot(planes[j], b);
+				if (da >= 0.0f)
+					clipped[clippedSize++] = a;
+				if ((da >= 0.0f) != (db >= 0.0f))
+					clipped[clippedSize++] = a + (b - a) * (da / (da - db));
+			}
+
+			polygonSize = clippedSize;
+			std::copy(clipped, clipped + clippedSize, polygon);
+		}
+		return polygonSize > 0;
+	}
+}
+
+
+void ScenePicker::beginBuild()
+{
+	objects.clear();
+	nodes.clear();
+	isBuilt = false;
+}
+
+
+void ScenePicker::addObject(size_t id, const glm::vec3& worldMin, const glm::vec3& worldMax)
+{
+	objects.push_back({ id, worldMin, worldMax, (worldMin + worldMax) * 0.5f });
+}
+
+
+void ScenePicker::build()
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	nodes.clear();
+	if (!objects.empty())
+	{
+		nodes.reserve(objects.size() * 2);
+		Node root;
+		root.leftOrFirst = 0;
+		root.count = (uint32_t)objects.size();
+		nodes.push_back(root);
+		updateNodeBounds(nodes[0]);
+		subdivide(0, 0);
+	}
+	isBuilt = true;
+
+	stats.numObjects = objects.size();
+	stats.numNodes = nodes.size();
+	stats.buildTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+
+void ScenePicker::updateNodeBounds(Node& node)
+{
+	node.min = glm::vec3(FLT_MAX);
+	node.max = glm::vec3(-FLT_MAX);
+	for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+	{
+		node.min = glm::min(node.min, objects[i].min);
+		node.max = glm::max(node.max, objects[i].max);
+	}
+}
+
+
+void ScenePicker::subdivide(uint32_t nodeIndex, uint32_t depth)
+{
+	const Node node = nodes[nodeIndex];		// NOTE: copy, since pushing the children can move the nodes around
+	if (node.count <= 2 || depth >= MAX_DEPTH)
+		return;
+
+	glm::vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+	for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+	{
+		centerMin = glm::min(centerMin, objects[i].center);
+		centerMax = glm::max(centerMax, objects[i].center);
+	}
+
+	//
+	// Binned SAH along every axis
+	//
+	int bestAxis = -1;
+	uint32_t bestSplitBin = 0;
+	float bestCost = FLT_MAX;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float extent = centerMax[axis] - centerMin[axis];
+		if (extent <= 0.0f)
+			continue;
+
+		struct Bin { glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX); uint32_t count = 0; } bins[NUM_SAH_BINS];
+		const float binScale = NUM_SAH_BINS / extent;
+		for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+		{
+			const uint32_t bin = std::min(NUM_SAH_BINS - 1, (uint32_t)((objects[i].center[axis] - centerMin[axis]) * binScale));
+			bins[bin].min = glm::min(bins[bin].min, objects[i].min);
+			bins[bin].max = glm::max(bins[bin].max, objects[i].max);
+			bins[bin].count++;
+		}
+
+		// Sweep from both sides for the cost of splitting after each bin
+		float leftAreas[NUM_SAH_BINS - 1], rightAreas[NUM_SAH_BINS - 1];
+		uint32_t leftCounts[NUM_SAH_BINS - 1], rightCounts[NUM_SAH_BINS - 1];
+		glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX), rightMin(FLT_MAX), rightMax(-FLT_MAX);
+		uint32_t leftCount = 0, rightCount = 0;
+		for (uint32_t i = 0; i < NUM_SAH_BINS - 1; i++)
+		{
+			leftCount += bins[i].count;
+			leftMin = glm::min(leftMin, bins[i].min);
+			leftMax = glm::max(leftMax, bins[i].max);
+			leftCounts[i] = leftCount;
+			leftAreas[i] = surfaceArea(leftMin, leftMax);
+
+			const uint32_t j = NUM_SAH_BINS - 1 - i;
+			rightCount += bins[j].count;
+			rightMin = glm::min(rightMin, bins[j].min);
+			rightMax = glm::max(rightMax, bins[j].max);
+			rightCounts[j - 1] = rightCount;
+			rightAreas[j - 1] = surfaceArea(rightMin, rightMax);
+		}
+
+		for (uint32_t i = 0; i < NUM_SAH_BINS - 1; i++)
+		{
+			if (leftCounts[i] == 0 || rightCounts[i] == 0)
+				continue;
+
+			const float cost = leftCounts[i] * leftAreas[i] + rightCounts[i] * rightAreas[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplitBin = i;
+			}
+		}
+	}
+
+	const float leafCost = node.count * surfaceArea(node.min, node.max);
+	if (bestAxis < 0 || (bestCost >= leafCost && node.count <= MAX_LEAF_SIZE))
+		return;		// All the centers are in the same spot, or splitting doesn't help
+
+	//
+	// Partition the objects and make the children
+	//
+	const float binScale = NUM_SAH_BINS / (centerMax[bestAxis] - centerMin[bestAxis]);
+	auto middle = std::partition(objects.begin() + node.leftOrFirst, objects.begin() + node.leftOrFirst + node.count, [&](const Object& object)
+	{
+		return std::min(NUM_SAH_BINS - 1, (uint32_t)((object.center[bestAxis] - centerMin[bestAxis]) * binScale)) <= bestSplitBin;
+	});
+	const uint32_t leftCount = (uint32_t)(middle - (objects.begin() + node.leftOrFirst));
+
+	const uint32_t leftIndex = (uint32_t)nodes.size();
+	Node left, right;
+	left.leftOrFirst = node.leftOrFirst;
+	left.count = leftCount;
+	right.leftOrFirst = node.leftOrFirst + leftCount;
+	right.count = node.count - leftCount;
+	nodes.push_back(left);
+	nodes.push_back(right);
+	updateNodeBounds(nodes[leftIndex]);
+	updateNodeBounds(nodes[leftIndex + 1]);
+
+	nodes[nodeIndex].leftOrFirst = leftIndex;
+	nodes[nodeIndex].count = 0;
+
+	subdivide(leftIndex, depth + 1);
+	subdivide(leftIndex + 1, depth + 1);
+}
+
+
+bool ScenePicker::pickRay(const glm::vec3& origin, const glm::vec3& direction, const MeshFunc& getMeshes, size_t& out_id, float& out_distance, size_t ignoreId)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	stats.numNodesVisited = 0;
+	stats.numCandidates = 0;
+	stats.numTrianglesTested = 0;
+
+	out_id = NO_ID;
+	out_distance = FLT_MAX;
+	if (!isBuilt || nodes.empty())
+		return false;
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+
+	// Objects w/o any meshes only have their AABB, which is way bigger than what's actually in it. So those
+	// only get picked if the ray doesn't hit any real triangles (and they don't cut the traversal short either)
+	size_t boxOnlyId = NO_ID;
+	float boxOnlyDistance = FLT_MAX;
+
+	uint32_t stack[64];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+		stats.numNodesVisited++;
+		if (intersectRayAABB(origin, inverseDirection, node.min, node.max, out_distance) == FLT_MAX)
+			continue;
+
+		if (node.count == 0)
+		{
+			// Visit the closer child first, so the farther one can get skipped more often
+			const uint32_t children[2] = { node.leftOrFirst, node.leftOrFirst + 1 };
+			const float t0 = intersectRayAABB(origin, inverseDirection, nodes[children[0]].min, nodes[children[0]].max, out_distance);
+			const float t1 = intersectRayAABB(origin, inverseDirection, nodes[children[1]].min, nodes[children[1]].max, out_distance);
+			const bool leftIsCloser = (t0 <= t1);
+			if ((leftIsCloser ? t1 : t0) != FLT_MAX)
+				stack[stackSize++] = children[leftIsCloser ? 1 : 0];
+			if ((leftIsCloser ? t0 : t1) != FLT_MAX)
+				stack[stackSize++] = children[leftIsCloser ? 0 : 1];
+			continue;
+		}
+
+		for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+		{
+			const Object& object = objects[i];
+			if (object.id == ignoreId)
+				continue;
+
+			float tBoxExit;
+			const float tBox = intersectRayAABB(origin, inverseDirection, object.min, object.max, out_distance, &tBoxExit);
+			if (tBox == FLT_MAX)
+				continue;
+
+			stats.numCandidates++;
+			meshesScratch.clear();
+			getMeshes(object.id, meshesScratch);
+			if (meshesScratch.empty())
+			{
+				// NOTE: if the ray starts inside the box, where it comes back out is a lot closer to where the thing is than 0
+				const float boxDistance = (tBox > 0.0f) ? tBox : tBoxExit;
+				if (boxDistance < boxOnlyDistance)
+				{
+					boxOnlyId = object.id;
+					boxOnlyDistance = boxDistance;
+				}
+				continue;
+			}
+
+			for (const ScenePickerMesh& mesh : meshesScratch)
+			{
+				// NOTE: the ray goes into the mesh's space instead of the other way around. The t stays the same since the transform's affine
+				if (glm::determinant(mesh.modelMatrix) == 0.0f)
+					continue;
+				const glm::mat4 inverseModelMatrix = glm::inverse(mesh.modelMatrix);
+				const glm::vec3 localOrigin = glm::vec3(inverseModelMatrix * glm::vec4(origin, 1.0f));
+				const glm::vec3 localDirection = glm::mat3(inverseModelMatrix) * direction;
+
+				for (size_t j = 0; j + 2 < mesh.numIndices; j += 3)
+				{
+					float t;
+					if (intersectRayTriangle(localOrigin, localDirection, mesh.positions[mesh.indices[j]], mesh.positions[mesh.indices[j + 1]], mesh.positions[mesh.indices[j + 2]], t) &&
+						t < out_distance)
+					{
+						out_id = object.id;
+						out_distance = t;
+					}
+				}
+				stats.numTrianglesTested += mesh.numIndices / 3;
+			}
+		}
+	}
+
+	if (out_id == NO_ID && boxOnlyId != NO_ID)
+	{
+		out_id = boxOnlyId;
+		out_distance = boxOnlyDistance;
+	}
+
+	stats.pickTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	return out_id != NO_ID;
+}
+
+
+void ScenePicker::pickRect(const glm::mat4& projectionView, const glm::vec2& ndcMin, const glm::vec2& ndcMax, const MeshFunc& getMeshes, std::vector<size_t>& out_ids)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	stats.numNodesVisited = 0;
+	stats.numCandidates = 0;
+	stats.numTrianglesTested = 0;
+
+	out_ids.clear();
+	if (!isBuilt || nodes.empty())
+		return;
+
+	glm::vec4 clipPlanes[NUM_RECT_PLANES];
+	getRectClipPlanes(glm::min(ndcMin, ndcMax), glm::max(ndcMin, ndcMax), clipPlanes);
+
+	glm::vec4 worldPlanes[NUM_RECT_PLANES];
+	for (size_t i = 0; i < NUM_RECT_PLANES; i++)
+		worldPlanes[i] = clipPlanes[i] * projectionView;		// NOTE: row vector * matrix, so dot(worldPlane, worldPos) == dot(clipPlane, projectionView * worldPos)
+
+	// 0: outside, 1: partly inside, 2: all the way inside
+	auto classifyAABB = [&](const glm::vec3& min, const glm::vec3& max)
+	{
+		bool allTheWayInside = true;
+		for (size_t i = 0; i < NUM_RECT_PLANES; i++)
+		{
+			const glm::vec3 normal = glm::vec3(worldPlanes[i]);
+			const glm::vec3 farthestInside = glm::mix(min, max, glm::vec3(glm::greaterThanEqual(normal, glm::vec3(0.0f))));
+			const glm::vec3 farthestOutside = glm::mix(max, min, glm::vec3(glm::greaterThanEqual(normal, glm::vec3(0.0f))));
+			if (glm::dot(normal, farthestInside) + worldPlanes[i].w < 0.0f)
+				return 0;
+			if (glm::dot(normal, farthestOutside) + worldPlanes[i].w < 0.0f)
+				allTheWayInside = false;
+		}
+		return allTheWayInside ? 2 : 1;
+	};
+
+	std::vector<glm::vec4> clipPositions;
+
+	uint32_t stack[64];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+		stats.numNodesVisited++;
+		if (classifyAABB(node.min, node.max) == 0)
+			continue;
+
+		if (node.count == 0)
+		{
+			stack[stackSize++] = node.leftOrFirst;
+			stack[stackSize++] = node.leftOrFirst + 1;
+			continue;
+		}
+
+		for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+		{
+			const Object& object = objects[i];
+			const int classification = classifyAABB(object.min, object.max);
+			if (classification == 0)
+				continue;
+
+			stats.numCandidates++;
+			meshesScratch.clear();
+			if (classification == 1)
+				getMeshes(object.id, meshesScratch);		// NOTE: all the way inside doesn't need the triangles
+
+			bool isTouching = (classification == 2 || meshesScratch.empty());
+			for (size_t m = 0; m < meshesScratch.size() && !isTouching; m++)
+			{
+				const ScenePickerMesh& mesh = meshesScratch[m];
+				const glm::mat4 modelProjectionView = projectionView * mesh.modelMatrix;
+				clipPositions.resize(mesh.numPositions);
+				for (size_t j = 0; j < mesh.numPositions; j++)
+					clipPositions[j] = modelProjectionView * glm::vec4(mesh.positions[j], 1.0f);
+
+				for (size_t j = 0; j + 2 < mesh.numIndices && !isTouching; j += 3)
+				{
+					isTouching = isTriangleInRect(clipPositions[mesh.indices[j]], clipPositions[mesh.indices[j + 1]], clipPositions[mesh.indices[j + 2]], clipPlanes);
+					stats.numTrianglesTested++;
+				}
+			}
+
+			if (isTouching)
+				out_ids.push_back(object.id);
+		}
+	}
+
+	std::sort(out_ids.begin(), out_ids.end());
+	stats.pickTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
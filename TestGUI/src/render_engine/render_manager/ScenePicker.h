@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+
+//
+// A mesh for the precise picking tests. The data only needs to stay alive until
+// the pick call that asked for it returns.
+//
+struct ScenePickerMesh
+{
+	const glm::vec3* positions;
+	size_t numPositions;
+	const uint32_t* indices;
+	size_t numIndices;
+	glm::mat4 modelMatrix;
+};
+
+
+//
+// Editor picking on the CPU. Objects go into a BVH by their world AABB, and then
+// whatever the ray (or the selection rectangle) reaches in the BVH gets tested
+// against its actual triangles. The triangles only get asked for (w/ getMeshes)
+// for objects that make it past their AABB, so only the things that actually
+// get clicked near get their triangles looked at.
+//
+// NOTE: an object that gives back no meshes (none of them kept CPU copies) just gets picked by its AABB,
+// but only if the ray doesn't hit any triangles. Otherwise a big box around something small would cover
+// up everything in it or behind it.
+//
+class ScenePicker
+{
+public:
+	typedef std::function<void(size_t id, std::vector<ScenePickerMesh>& out_meshes)> MeshFunc;
+	static constexpr size_t NO_ID = (size_t)-1;
+
+	void beginBuild();
+	void addObject(size_t id, const glm::vec3& worldMin, const glm::vec3& worldMax);
+	void build();
+
+	// Closest hit along the ray. Skips ignoreId (so clicking on the same spot again can get whatever's behind it)
+	bool pickRay(const glm::vec3& origin, const glm::vec3& direction, const MeshFunc& getMeshes, size_t& out_id, float& out_distance, size_t ignoreId = NO_ID);
+
+	// Everything that's touching the rectangle (NDC, [-1, 1]). Only the part in front of the near plane counts
+	void pickRect(const glm::mat4& projectionView, const glm::vec2& ndcMin, const glm::vec2& ndcMax, const MeshFunc& getMeshes, std::vector<size_t>& out_ids);
+
+	struct Stats
+	{
+		size_t numObjects;
+		size_t numNodes;
+		size_t numNodesVisited;
+		size_t numCandidates;			// Objects that made it past the AABB test
+		size_t numTrianglesTested;
+		float buildTimeMs;
+		float pickTimeMs;
+	} stats = {};
+
+private:
+	struct Object
+	{
+		size_t id;
+		glm::vec3 min, max;
+		glm::vec3 center;
+	};
+	std::vector<Object> objects;
+
+	struct Node
+	{
+		glm::vec3 min, max;
+		uint32_t leftOrFirst;			// The left child if it's an interior node (the right one comes right after it), or the first object if it's a leaf
+		uint32_t count;					// 0 if it's an interior node
+	};
+	std::vector<Node> nodes;
+	bool isBuilt = false;
+
+	void subdivide(uint32_t nodeIndex, uint32_t depth);
+	void updateNodeBounds(Node& node);
+
+	std::vector<ScenePickerMesh> meshesScratch;
+};
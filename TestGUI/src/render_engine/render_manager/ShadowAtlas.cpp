@@ -0,0 +1,509 @@
+#include "ShadowAtlas.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+#include "RenderManager.h"
+#include "../camera/Camera.h"
+#include "../model/Mesh.h"
+#include "../../mainloop/MainLoop.h"
+#include "../../objects/PointLight.h"
+#include "../../utils/PhysicsUtils.h"
+
+
+//
+// ShadowAtlasAllocator
+//
+void ShadowAtlasAllocator::reset(uint32_t atlasSize, uint32_t minTileSize)
+{
+	ShadowAtlasAllocator::atlasSize = atlasSize;
+	usedPixels = 0;
+
+	levels.clear();
+	for (uint32_t level = 0; (atlasSize >> level) >= minTileSize && (atlasSize >> level) > 0; level++)
+		levels.push_back(std::vector<NodeState>((size_t)1 << (2 * level), NodeState::FREE));
+}
+
+bool ShadowAtlasAllocator::allocate(uint32_t tileSize, ShadowAtlasTile& out_tile)
+{
+	uint32_t targetLevel = 0;
+	while (targetLevel < levels.size() && (atlasSize >> targetLevel) > tileSize)
+		targetLevel++;
+	if (targetLevel >= levels.size() || (atlasSize >> targetLevel) != tileSize)
+		return false;		// Not a power of 2, or smaller than the min tile size
+
+	if (!allocateInNode(0, 0, 0, targetLevel, out_tile))
+		return false;
+
+	usedPixels += (size_t)tileSize * tileSize;
+	return true;
+}
+
+bool ShadowAtlasAllocator::allocateInNode(uint32_t level, uint32_t x, uint32_t y, uint32_t targetLevel, ShadowAtlasTile& out_tile)
+{
+	NodeState& node = getNode(level, x, y);
+	if (node == NodeState::USED)
+		return false;
+
+	if (level == targetLevel)
+	{
+		if (node != NodeState::FREE)
+			return false;
+
+		node = NodeState::USED;
+		out_tile.size = atlasSize >> level;
+		out_tile.x = x * out_tile.size;
+		out_tile.y = y * out_tile.size;
+		return true;
+	}
+
+	// NOTE: go into the nodes that are already split up first, so that the big free nodes stay whole
+	for (int pass = 0; pass < 2; pass++)
+	{
+		const NodeState wantedState = (pass == 0) ? NodeState::SPLIT : NodeState::FREE;
+		for (uint32_t child = 0; child < 4; child++)
+		{
+			const uint32_t childX = x * 2 + (child % 2);
+			const uint32_t childY = y * 2 + (child / 2);
+			if (getNode(level + 1, childX, childY) != wantedState)
+				continue;
+
+			if (allocateInNode(level + 1, childX, childY, targetLevel, out_tile))
+			{
+				node = NodeState::SPLIT;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void ShadowAtlasAllocator::free(const ShadowAtlasTile& tile)
+{
+	uint32_t level = 0;
+	while (level < levels.size() && (atlasSize >> level) > tile.size)
+		level++;
+	if (level >= levels.size())
+		return;
+
+	uint32_t x = tile.x / tile.size;
+	uint32_t y = tile.y / tile.size;
+	if (getNode(level, x, y) != NodeState::USED)
+		return;
+	getNode(level, x, y) = NodeState::FREE;
+	usedPixels -= (size_t)tile.size * tile.size;
+
+	// Merge the parents back together if all 4 of their children are free
+	while (level > 0)
+	{
+		const uint32_t parentX = x / 2, parentY = y / 2;
+		for (uint32_t child = 0; child < 4; child++)
+			if (getNode(level, parentX * 2 + (child % 2), parentY * 2 + (child / 2)) != NodeState::FREE)
+				return;
+
+		level--;
+		x = parentX;
+		y = parentY;
+		getNode(level, x, y) = NodeState::FREE;
+	}
+}
+
+
+//
+// ShadowAtlas
+//
+static uint32_t floorToPowerOf2(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result * 2 <= value)
+		result *= 2;
+	return result;
+}
+
+ShadowAtlas::ShadowAtlas()
+{
+	// NOTE: the GL stuff gets created on the first update, since this gets constructed along w/ the RenderManager
+	stats = {};
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	destroyGLResources();
+}
+
+void ShadowAtlas::createGLResources()
+{
+	glCreateTextures(GL_TEXTURE_2D, 1, &atlasTexture);
+	glTextureStorage2D(atlasTexture, 1, GL_DEPTH_COMPONENT32F, atlasResolution, atlasResolution);
+	glTextureParameteri(atlasTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(atlasTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(atlasTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(atlasTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glCreateFramebuffers(1, &atlasFBO);
+	glNamedFramebufferTexture(atlasFBO, GL_DEPTH_ATTACHMENT, atlasTexture, 0);
+	glNamedFramebufferDrawBuffer(atlasFBO, GL_NONE);
+	glNamedFramebufferReadBuffer(atlasFBO, GL_NONE);
+	if (glCheckNamedFramebufferStatus(atlasFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Shadow atlas framebuffer is not complete!" << std::endl;
+
+	// Clear the whole thing to the far plane once. After that only the tiles that get re-rendered get cleared
+	glBindFramebuffer(GL_FRAMEBUFFER, atlasFBO);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glCreateBuffers(1, &shadowInformationUBO);
+	glNamedBufferData(shadowInformationUBO, sizeof(glm::vec4) * MAX_SHADOWED_POINT_LIGHTS * 7, nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 5, shadowInformationUBO);
+
+	allocator.reset(atlasResolution, minTileSize);
+	allocatedResolution = atlasResolution;
+	allocatedMinTileSize = minTileSize;
+	lightShadows.clear();
+}
+
+void ShadowAtlas::destroyGLResources()
+{
+	if (atlasTexture == 0)
+		return;
+
+	glDeleteTextures(1, &atlasTexture);
+	glDeleteFramebuffers(1, &atlasFBO);
+	glDeleteBuffers(1, &shadowInformationUBO);
+	atlasTexture = atlasFBO = shadowInformationUBO = 0;
+}
+
+static bool isAABBInLightRange(const RenderAABB& worldBounds, const glm::vec3& lightPosition, float farPlane)
+{
+	const glm::vec3 closestPoint = glm::clamp(lightPosition, worldBounds.center - worldBounds.extents, worldBounds.center + worldBounds.extents);
+	const glm::vec3 delta = closestPoint - lightPosition;
+	return glm::dot(delta, delta) <= farPlane * farPlane;
+}
+
+void ShadowAtlas::update(const std::vector<LightComponent*>& lights, const Camera& camera, const std::vector<RenderAABB>& changedCasterBounds)
+{
+	// NOTE: the allocator only does power of 2 tiles
+	minTileSize = floorToPowerOf2(glm::clamp(minTileSize, 16u, atlasResolution));
+	maxTileSize = floorToPowerOf2(glm::clamp(maxTileSize, minTileSize, atlasResolution));
+
+	if (atlasTexture == 0 || atlasResolution != allocatedResolution || minTileSize != allocatedMinTileSize)
+	{
+		destroyGLResources();
+		createGLResources();
+	}
+
+	stats = {};
+	lightsToRender.clear();
+	for (auto& it : lightShadows)
+	{
+		it.second.activeThisFrame = false;
+		it.second.shadowIndex = -1;
+	}
+
+	//
+	// Figure out which lights are important
+	//
+	struct Candidate
+	{
+		LightComponent* light;
+		glm::vec3 position;
+		float farPlane;
+		float screenCoverage;
+	};
+	std::vector<Candidate> candidates;
+
+	const ViewFrustum viewFrustum = ViewFrustum::createFrustumFromCamera(camera);
+	for (LightComponent* light : lights)
+	{
+		if (!light->castsShadows || light->lightType != LightType::POINT)
+			continue;
+
+		const glm::vec3 position = PhysicsUtils::getPosition(light->baseObject->getTransform());
+		const float farPlane = ((PointLightLight*)light)->farPlane;
+
+		// If the light's range is offscreen, then none of its shadows are onscreen either
+		const RenderAABB rangeBounds = { position, glm::vec3(farPlane) };
+		if (!viewFrustum.checkIfInViewFrustum(rangeBounds, glm::mat4(1.0f)))
+		{
+			stats.numLightsOffscreen++;
+			continue;
+		}
+
+		const float distance = glm::length(camera.position - position);
+		const float screenCoverage = (distance <= farPlane) ? 1.0f : farPlane / distance;
+		candidates.push_back({ light, position, farPlane, screenCoverage });
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.screenCoverage > b.screenCoverage; });
+	if (candidates.size() > MAX_SHADOWED_POINT_LIGHTS)
+	{
+		stats.numLightsOutOfSpace += candidates.size() - MAX_SHADOWED_POINT_LIGHTS;
+		candidates.resize(MAX_SHADOWED_POINT_LIGHTS);
+	}
+
+	//
+	// Pick the tile sizes. Free up the tiles that changed size or aren't needed anymore
+	//
+	// NOTE: resizing throws away the shadow that's in the old tiles, so a light w/ a
+	// rendered shadow only gets resized if there's still budget to re-render it this frame.
+	// The lights w/o a shadow go first in the render schedule, so they take their budget first
+	//
+	std::vector<uint32_t> tileSizes(candidates.size());
+	uint32_t resizeBudget = maxFacesRenderedPerFrame;
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		const LightShadow& lightShadow = lightShadows[candidates[i].light];
+		if (!lightShadow.hasTiles || !lightShadow.isRendered)
+			resizeBudget -= std::min(resizeBudget, 6u);
+	}
+
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		LightShadow& lightShadow = lightShadows[candidates[i].light];
+		lightShadow.activeThisFrame = true;
+		lightShadow.priority = candidates[i].screenCoverage;
+
+		const float exactSize = (float)maxTileSize * candidates[i].screenCoverage * tileSizeScale;
+		uint32_t tileSize = maxTileSize;
+		while (tileSize > minTileSize && (float)tileSize > exactSize)
+			tileSize /= 2;
+
+		// NOTE: a little hysteresis so that lights right at the edge don't keep on swapping sizes (and re-rendering)
+		const uint32_t currentSize = lightShadow.faceTiles[0].size;
+		if (lightShadow.hasTiles && tileSize < currentSize && exactSize >= (float)currentSize * 0.75f)
+			tileSize = currentSize;
+
+		if (lightShadow.hasTiles && lightShadow.isRendered && tileSize != currentSize)
+		{
+			if (resizeBudget < 6)
+			{
+				tileSize = currentSize;
+				stats.numResizesDeferred++;
+			}
+			else
+				resizeBudget -= 6;
+		}
+
+		if (lightShadow.hasTiles && tileSize != currentSize)
+		{
+			for (ShadowAtlasTile& tile : lightShadow.faceTiles)
+				allocator.free(tile);
+			lightShadow.hasTiles = false;
+		}
+		tileSizes[i] = tileSize;
+	}
+
+	for (auto it = lightShadows.begin(); it != lightShadows.end();)
+	{
+		if (it->second.activeThisFrame)
+		{
+			it++;
+			continue;
+		}
+
+		if (it->second.hasTiles)
+			for (ShadowAtlasTile& tile : it->second.faceTiles)
+				allocator.free(tile);
+		it = lightShadows.erase(it);
+	}
+
+	//
+	// Allocate the tiles, most important first. If there's no room, then the least
+	// important light w/ tiles gives them up, and then it tries smaller tiles
+	//
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		LightShadow& lightShadow = lightShadows[candidates[i].light];
+		if (!lightShadow.hasTiles)
+		{
+			uint32_t tileSize = tileSizes[i];
+			while (!lightShadow.hasTiles && tileSize >= minTileSize)
+			{
+				size_t numAllocated = 0;
+				while (numAllocated < 6 && allocator.allocate(tileSize, lightShadow.faceTiles[numAllocated]))
+					numAllocated++;
+
+				if (numAllocated == 6)
+				{
+					lightShadow.hasTiles = true;
+					lightShadow.isRendered = false;
+					lightShadow.isStale = false;
+					break;
+				}
+
+				for (size_t j = 0; j < numAllocated; j++)
+					allocator.free(lightShadow.faceTiles[j]);
+
+				bool evicted = false;
+				for (size_t j = candidates.size() - 1; j > i; j--)
+				{
+					LightShadow& lessImportant = lightShadows[candidates[j].light];
+					if (!lessImportant.hasTiles)
+						continue;
+
+					for (ShadowAtlasTile& tile : lessImportant.faceTiles)
+						allocator.free(tile);
+					lessImportant.hasTiles = false;
+					evicted = true;
+					break;
+				}
+				if (!evicted)
+					tileSize /= 2;
+			}
+
+			if (!lightShadow.hasTiles)
+			{
+				lightShadow.faceTiles[0].size = 0;
+				stats.numLightsOutOfSpace++;
+				continue;
+			}
+		}
+
+		// Moving the light (or changing its range), or a caster moving inside its range makes the old shadow out of date.
+		// It still gets used until the re-render though, since an old shadow looks a lot better than none
+		if (!lightShadow.isRendered || lightShadow.isStale)
+			continue;
+
+		if (lightShadow.renderedPosition != candidates[i].position || lightShadow.renderedFarPlane != candidates[i].farPlane)
+			lightShadow.isStale = true;
+		else
+			for (const RenderAABB& bounds : changedCasterBounds)
+				if (isAABBInLightRange(bounds, candidates[i].position, candidates[i].farPlane))
+				{
+					lightShadow.isStale = true;
+					break;
+				}
+	}
+
+	//
+	// Schedule the renders. The ones w/o a shadow go first, then the out of date ones
+	// (both by importance), then the cached ones that have gone the longest w/o an update
+	//
+	std::vector<LightComponent*> unrendered, stale, cached;
+	for (const Candidate& candidate : candidates)
+	{
+		const LightShadow& lightShadow = lightShadows[candidate.light];
+		if (!lightShadow.hasTiles)
+			continue;
+		if (!lightShadow.isRendered)
+			unrendered.push_back(candidate.light);
+		else if (lightShadow.isStale)
+			stale.push_back(candidate.light);
+		else
+			cached.push_back(candidate.light);
+	}
+	std::stable_sort(cached.begin(), cached.end(), [&](LightComponent* a, LightComponent* b) { return lightShadows[a].framesSinceRender > lightShadows[b].framesSinceRender; });
+
+	uint32_t facesBudget = maxFacesRenderedPerFrame;
+	for (LightComponent* light : unrendered)
+	{
+		if (facesBudget < 6)
+		{
+			stats.numFacesWaiting += 6;
+			continue;
+		}
+		lightsToRender.push_back(light);
+		facesBudget -= 6;
+	}
+	for (LightComponent* light : stale)
+	{
+		if (facesBudget < 6)
+		{
+			stats.numFacesStale += 6;
+			continue;
+		}
+		lightsToRender.push_back(light);
+		facesBudget -= 6;
+	}
+	for (LightComponent* light : cached)
+	{
+		if (facesBudget < 6)
+		{
+			stats.numFacesCached += 6;
+			continue;
+		}
+		lightsToRender.push_back(light);
+		facesBudget -= 6;
+	}
+
+	//
+	// Hand out the shadow indices for the shader
+	//
+	int shadowIndex = 0;
+	for (const Candidate& candidate : candidates)
+	{
+		LightShadow& lightShadow = lightShadows[candidate.light];
+		const bool willBeRendered = (std::find(lightsToRender.begin(), lightsToRender.end(), candidate.light) != lightsToRender.end());
+		if (!lightShadow.hasTiles || (!lightShadow.isRendered && !willBeRendered))
+			continue;
+		lightShadow.shadowIndex = shadowIndex++;
+	}
+	stats.numShadowedLights = (size_t)shadowIndex;
+	stats.atlasUsage = (float)allocator.getUsedPixels() / ((float)atlasResolution * (float)atlasResolution);
+
+	uploadShadowInformation();
+}
+
+void ShadowAtlas::uploadShadowInformation()
+{
+	glm::vec4 shadowInformation[MAX_SHADOWED_POINT_LIGHTS * 7] = {};		// 6 face rects for each light, and then the light info after all of them
+	const float invResolution = 1.0f / (float)atlasResolution;
+	for (auto& it : lightShadows)
+	{
+		const LightShadow& lightShadow = it.second;
+		if (lightShadow.shadowIndex < 0)
+			continue;
+
+		for (int face = 0; face < 6; face++)
+		{
+			const ShadowAtlasTile& tile = lightShadow.faceTiles[face];
+			shadowInformation[lightShadow.shadowIndex * 6 + face] = glm::vec4(tile.x, tile.y, tile.size, tile.size) * invResolution;
+		}
+		shadowInformation[MAX_SHADOWED_POINT_LIGHTS * 6 + lightShadow.shadowIndex] = glm::vec4(((PointLightLight*)it.first)->farPlane, invResolution, 0.0f, 0.0f);
+	}
+	glNamedBufferSubData(shadowInformationUBO, 0, sizeof(shadowInformation), shadowInformation);
+}
+
+void ShadowAtlas::render()
+{
+	for (auto& it : lightShadows)
+		it.second.framesSinceRender++;
+
+	if (lightsToRender.empty())
+		return;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, atlasFBO);
+	glEnable(GL_SCISSOR_TEST);
+
+	std::vector<glm::ivec4> faceViewports(6);
+	for (LightComponent* light : lightsToRender)
+	{
+		LightShadow& lightShadow = lightShadows[light];
+		for (int face = 0; face < 6; face++)
+		{
+			const ShadowAtlasTile& tile = lightShadow.faceTiles[face];
+			faceViewports[face] = glm::ivec4(tile.x, tile.y, tile.size, tile.size);
+
+			glScissor(tile.x, tile.y, tile.size, tile.size);
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+
+		((PointLightLight*)light)->renderPassShadowAtlas(faceViewports);
+
+		lightShadow.renderedPosition = PhysicsUtils::getPosition(light->baseObject->getTransform());
+		lightShadow.renderedFarPlane = ((PointLightLight*)light)->farPlane;
+		lightShadow.isRendered = true;
+		lightShadow.isStale = false;
+		lightShadow.framesSinceRender = 0;
+		stats.numFacesRendered += 6;
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+int ShadowAtlas::getShadowIndex(LightComponent* light) const
+{
+	auto it = lightShadows.find(light);
+	return (it != lightShadows.end()) ? it->second.shadowIndex : -1;
+}
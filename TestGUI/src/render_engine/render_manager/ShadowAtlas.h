@@ -0,0 +1,128 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+typedef unsigned int GLuint;
+class LightComponent;
+class Camera;
+struct RenderAABB;
+
+
+//
+// Quadtree (buddy) allocator for square power of 2 tiles in the shadow atlas.
+// Tiles stay where they are until they get freed, so a light keeps its tiles
+// (and whatever's already rendered in them) for as long as its size doesn't change.
+//
+struct ShadowAtlasTile
+{
+	uint32_t x = 0, y = 0;		// In pixels
+	uint32_t size = 0;
+};
+
+class ShadowAtlasAllocator
+{
+public:
+	void reset(uint32_t atlasSize, uint32_t minTileSize);
+	bool allocate(uint32_t tileSize, ShadowAtlasTile& out_tile);
+	void free(const ShadowAtlasTile& tile);
+
+	inline uint32_t getAtlasSize() const { return atlasSize; }
+	inline size_t getUsedPixels() const { return usedPixels; }
+
+private:
+	enum class NodeState : uint8_t { FREE, SPLIT, USED };
+
+	bool allocateInNode(uint32_t level, uint32_t x, uint32_t y, uint32_t targetLevel, ShadowAtlasTile& out_tile);
+	inline NodeState& getNode(uint32_t level, uint32_t x, uint32_t y) { return levels[level][(size_t)y * ((size_t)1 << level) + x]; }
+
+	uint32_t atlasSize = 0;
+	std::vector<std::vector<NodeState>> levels;		// levels[0] is the whole atlas. Each level is a (2^level)x(2^level) grid
+	size_t usedPixels = 0;
+};
+
+
+//
+// All of the point light shadows (6 cube faces each) live in one big depth texture.
+// Every frame the shadowed lights get sorted by how much of the screen their range
+// covers, and the more important ones get bigger tiles. Lights that are offscreen
+// don't get any.
+//
+// Tiles get cached. Only the lights that are new, moved, changed tile sizes, or had a
+// shadow caster move inside their range need to get re-rendered, plus the ones that have
+// gone the longest without an update, up to maxFacesRenderedPerFrame.
+//
+// NOTE: a light that's out of date but didn't make the budget keeps showing its old
+// shadow until it gets its turn, and a light only switches tile sizes on a frame that
+// it can get re-rendered (the old tiles stay until then). Otherwise going over the
+// budget would make lights pop to unshadowed.
+//
+// NOTE: the CSM isn't in here. It's got its own texture array (see DirectionalLightLight)
+//
+class ShadowAtlas
+{
+public:
+	static constexpr int MAX_SHADOWED_POINT_LIGHTS = 32;		// NOTE: same as MAX_POINT_LIGHT_SHADOWS in the shaders
+
+	ShadowAtlas();
+	~ShadowAtlas();
+
+	ShadowAtlas(const ShadowAtlas&) = delete;
+	ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+	void update(const std::vector<LightComponent*>& lights, const Camera& camera, const std::vector<RenderAABB>& changedCasterBounds);		// NOTE: changedCasterBounds are world space (see RenderManager::INTERNALgetChangedShadowCasterBounds)
+	void render();
+	int getShadowIndex(LightComponent* light) const;		// -1 if the light doesn't have a shadow this frame
+
+	inline GLuint getTexture() const { return atlasTexture; }
+
+	uint32_t atlasResolution = 4096;
+	uint32_t minTileSize = 64;
+	uint32_t maxTileSize = 512;
+	uint32_t maxFacesRenderedPerFrame = 24;
+	float tileSizeScale = 1.0f;			// Multiplies the screen coverage before picking the tile size
+
+	struct Stats
+	{
+		size_t numShadowedLights;
+		size_t numLightsOffscreen;
+		size_t numLightsOutOfSpace;
+		size_t numFacesRendered;
+		size_t numFacesCached;
+		size_t numFacesWaiting;			// Need a render, but went over maxFacesRenderedPerFrame
+		size_t numFacesStale;			// Out of date, but the old shadow's getting shown until there's budget
+		size_t numResizesDeferred;		// Wanted a different tile size, but there wasn't budget to re-render it
+		float atlasUsage;
+	} stats;
+
+private:
+	void createGLResources();
+	void destroyGLResources();
+	void uploadShadowInformation();
+
+	struct LightShadow
+	{
+		ShadowAtlasTile faceTiles[6];
+		glm::vec3 renderedPosition;
+		float renderedFarPlane = 0.0f;
+		bool hasTiles = false;
+		bool isRendered = false;		// Tiles have a shadow in them (could be an old one though)
+		bool isStale = false;			// The light moved or a caster moved inside its range since the render
+		uint32_t framesSinceRender = 0;
+		float priority = 0.0f;
+		int shadowIndex = -1;
+		bool activeThisFrame = false;
+	};
+	std::map<LightComponent*, LightShadow> lightShadows;
+	std::vector<LightComponent*> lightsToRender;
+
+	ShadowAtlasAllocator allocator;
+	uint32_t allocatedResolution = 0;
+	uint32_t allocatedMinTileSize = 0;
+
+	GLuint atlasTexture = 0;
+	GLuint atlasFBO = 0;
+	GLuint shadowInformationUBO = 0;
+};
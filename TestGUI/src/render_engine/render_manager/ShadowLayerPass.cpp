@@ -0,0 +1,126 @@
+#include "ShadowLayerPass.h"
+
+#include <glad/glad.h>
+#include <iostream>
+#include <string>
+#include "../model/Mesh.h"
+#include "../material/Shader.h"
+
+
+static int layeredRenderingSupported = -1;
+static int viewportArrayRenderingSupported = -1;
+
+void ShadowLayerPass::checkExtensions()
+{
+	if (layeredRenderingSupported >= 0)
+		return;
+
+	layeredRenderingSupported = 0;
+	viewportArrayRenderingSupported = 0;
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for (GLint i = 0; i < numExtensions; i++)
+	{
+		const std::string extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension == "GL_ARB_shader_viewport_layer_array")
+			layeredRenderingSupported = viewportArrayRenderingSupported = 1;
+		else if (extension == "GL_AMD_vertex_shader_layer")
+			layeredRenderingSupported = 1;
+	}
+
+	std::cout << "SHADOW::LAYERS:: " << (layeredRenderingSupported ? "gl_Layer from the vertex shader is supported. Rendering all layers at once" : "gl_Layer from the vertex shader isn't supported. Falling back to one pass per layer") << std::endl;
+	std::cout << "SHADOW::LAYERS:: " << (viewportArrayRenderingSupported ? "gl_ViewportIndex from the vertex shader is supported. Rendering all atlas tiles of a light at once" : "gl_ViewportIndex from the vertex shader isn't supported. Falling back to one pass per atlas tile") << std::endl;
+}
+
+bool ShadowLayerPass::isLayeredRenderingSupported()
+{
+	checkExtensions();
+	return layeredRenderingSupported;
+}
+
+bool ShadowLayerPass::isViewportArrayRenderingSupported()
+{
+	checkExtensions();
+	return viewportArrayRenderingSupported;
+}
+
+void ShadowLayerPass::begin(const std::vector<glm::mat4>& layerMatrices, bool clampsDepth, uint32_t layersToRender)
+{
+	ShadowLayerPass::layerMatrices = layerMatrices;
+	ShadowLayerPass::clampsDepth = clampsDepth;
+	ShadowLayerPass::layersToRender = layersToRender;
+	currentLayer = -1;
+	active = true;
+}
+
+void ShadowLayerPass::end()
+{
+	active = false;
+}
+
+uint32_t ShadowLayerPass::getLayerMask(const RenderAABB& bounds, const glm::mat4& modelMatrix) const
+{
+	glm::vec4 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		const glm::vec3 sign((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+		corners[i] = modelMatrix * glm::vec4(bounds.center + bounds.extents * sign, 1.0f);
+	}
+
+	//
+	// The box misses the layer if all of its corners are outside of the same clip plane.
+	// NOTE: with depth clamping (CSM), stuff in front of the near plane still casts shadows,
+	// so the near plane doesn't cull
+	//
+	uint32_t mask = 0;
+	for (size_t layer = 0; layer < layerMatrices.size(); layer++)
+	{
+		if ((layersToRender & (1u << layer)) == 0)
+			continue;
+
+		uint32_t outsideAll = 0x3F;
+		for (int i = 0; i < 8; i++)
+		{
+			const glm::vec4 clip = layerMatrices[layer] * corners[i];
+			uint32_t outside = 0;
+			if (clip.x < -clip.w) outside |= 0x01;
+			if (clip.x >  clip.w) outside |= 0x02;
+			if (clip.y < -clip.w) outside |= 0x04;
+			if (clip.y >  clip.w) outside |= 0x08;
+			if (clip.z < -clip.w && !clampsDepth) outside |= 0x10;
+			if (clip.z >  clip.w) outside |= 0x20;
+			outsideAll &= outside;
+		}
+
+		if (outsideAll == 0)
+			mask |= (1u << layer);
+	}
+	return mask;
+}
+
+void ShadowLayerPass::drawElements(Shader* shader, const RenderAABB& bounds, const glm::mat4& modelMatrix, GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	uint32_t mask = getLayerMask(bounds, modelMatrix);
+	if (currentLayer >= 0)
+	{
+		const uint32_t currentLayerBit = (1u << currentLayer);
+		if ((mask & currentLayerBit) == 0)
+		{
+			stats.numLayerSubmissionsCulled++;
+			return;
+		}
+		mask = currentLayerBit;
+	}
+
+	const int numLayers = glm::bitCount(mask);
+	const int numLayersRendering = glm::bitCount(layersToRender & (uint32_t)((1ull << layerMatrices.size()) - 1));
+	stats.numLayerSubmissionsCulled += (currentLayer >= 0) ? 0 : numLayersRendering - numLayers;
+	if (numLayers == 0)
+		return;
+
+	shader->setUint("layerMask", mask);
+	glDrawElementsInstanced(mode, count, type, indices, numLayers);
+
+	stats.numDraws++;
+	stats.numLayerSubmissions += numLayers;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+typedef unsigned int GLenum;
+typedef int GLsizei;
+class Shader;
+struct RenderAABB;
+
+
+//
+// Renders the layers of a shadow map (CSM cascades, point light cube faces)
+// without a geometry shader. If the driver can write gl_Layer from the vertex
+// shader (GL_ARB_shader_viewport_layer_array or GL_AMD_vertex_shader_layer),
+// every draw gets instanced once for each layer that its AABB actually reaches
+// and the vertex shader picks the layer from the instance. Otherwise the scene
+// gets rendered once per layer, with just that layer attached to the FBO.
+//
+// The layers can also be viewports instead (the shadow atlas). Then it's
+// gl_ViewportIndex (needs GL_ARB_shader_viewport_layer_array) and the fallback
+// just sets the viewport for each pass.
+//
+// NOTE: the shadow vertex shaders need a "uniform uint layerMask", and the
+// instance is the n-th layer that's on in the mask (see csm_shadow.vert)
+//
+class ShadowLayerPass
+{
+public:
+	static bool isLayeredRenderingSupported();
+	static bool isViewportArrayRenderingSupported();
+
+	void begin(const std::vector<glm::mat4>& layerMatrices, bool clampsDepth, uint32_t layersToRender = ~0u);		// NOTE: layersToRender is for the CSM cascade caching
+	void end();
+	inline bool isActive() const { return active; }
+
+	void setCurrentLayer(int layer) { currentLayer = layer; }		// -1 renders all of the layers at once (layered rendering)
+	inline bool isRenderingAllLayers() const { return currentLayer < 0; }
+
+	uint32_t getLayerMask(const RenderAABB& bounds, const glm::mat4& modelMatrix) const;
+	void drawElements(Shader* shader, const RenderAABB& bounds, const glm::mat4& modelMatrix, GLenum mode, GLsizei count, GLenum type, const void* indices);
+
+	bool forcePerLayerPasses = false;
+
+	struct Stats
+	{
+		size_t numDraws;
+		size_t numLayerSubmissions;			// What actually got drawn (instances, or draws in the per layer passes)
+		size_t numLayerSubmissionsCulled;	// What the geometry shader would've drawn on top of that
+	} stats;
+
+private:
+	static void checkExtensions();
+
+	bool active = false;
+	std::vector<glm::mat4> layerMatrices;
+	bool clampsDepth;
+	uint32_t layersToRender;
+	int currentLayer = -1;
+};
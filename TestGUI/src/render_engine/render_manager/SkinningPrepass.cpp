@@ -0,0 +1,160 @@
+#include "SkinningPrepass.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include "../model/Mesh.h"
+#include "../material/Shader.h"
+#include "../resources/Resources.h"
+
+
+SkinningPrepass::SkinningPrepass()
+{
+	// NOTE: the GL stuff gets created on the first dispatch, since this gets constructed along w/ the RenderManager
+	stats = {};
+	skinningShader = nullptr;
+}
+
+SkinningPrepass::~SkinningPrepass()
+{
+	if (skinnedVAO == 0)
+		return;
+
+	glDeleteVertexArrays(1, &skinnedVAO);
+	glDeleteBuffers(1, &skinnedVBO);
+	glDeleteBuffers(1, &paletteSSBO);
+}
+
+void SkinningPrepass::refreshResources()
+{
+	skinningShader = (Shader*)Resources::getResource("shader;computeSkinning");
+}
+
+void SkinningPrepass::beginFrame()
+{
+	jobs.clear();
+	jobLookup.clear();
+	paletteLookup.clear();
+	palette.clear();
+	numOutputVertices = 0;
+	isDispatched = false;
+	stats = {};
+}
+
+void SkinningPrepass::addMesh(Mesh* mesh, const std::vector<glm::mat4>* boneTransforms)
+{
+	if (!enabled || boneTransforms == nullptr || boneTransforms->empty() || !mesh->getIsSkinned())
+		return;
+
+	const auto key = std::make_pair((const Mesh*)mesh, boneTransforms);
+	if (jobLookup.find(key) != jobLookup.end())
+		return;
+
+	// All of the palettes go into one buffer, so meshes that share an animator share the palette too
+	auto paletteIt = paletteLookup.find(boneTransforms);
+	if (paletteIt == paletteLookup.end())
+	{
+		paletteIt = paletteLookup.insert({ boneTransforms, (uint32_t)palette.size() }).first;
+		palette.insert(palette.end(), boneTransforms->begin(), boneTransforms->end());
+	}
+
+	SkinningJob job;
+	job.mesh = mesh;
+	job.paletteOffset = paletteIt->second;
+	job.numBones = (uint32_t)std::min(boneTransforms->size(), (size_t)100);		// NOTE: same limit as the bone UBO (MAX_BONES)
+	job.outputOffset = numOutputVertices;
+	numOutputVertices += (uint32_t)mesh->getNumVertices();
+
+	jobLookup[key] = jobs.size();
+	jobs.push_back(job);
+}
+
+void SkinningPrepass::dispatch()
+{
+	if (!enabled || jobs.empty())
+		return;
+
+	if (skinnedVAO == 0)
+	{
+		refreshResources();
+		glCreateBuffers(1, &paletteSSBO);
+		glCreateBuffers(1, &skinnedVBO);
+
+		// The skinned vertices come out in the static layout. The bone attributes are
+		// left disabled, so Mesh::render() gives them the constant zero weights (no skinning)
+		glCreateVertexArrays(1, &skinnedVAO);
+		glEnableVertexArrayAttrib(skinnedVAO, 0);
+		glVertexArrayAttribFormat(skinnedVAO, 0, 3, GL_FLOAT, GL_FALSE, offsetof(StaticVertexQuantized, position));
+		glVertexArrayAttribBinding(skinnedVAO, 0, 0);
+		glEnableVertexArrayAttrib(skinnedVAO, 1);
+		glVertexArrayAttribFormat(skinnedVAO, 1, 2, GL_SHORT, GL_TRUE, offsetof(StaticVertexQuantized, normalOctahedral));
+		glVertexArrayAttribBinding(skinnedVAO, 1, 0);
+		glEnableVertexArrayAttrib(skinnedVAO, 2);
+		glVertexArrayAttribFormat(skinnedVAO, 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(StaticVertexQuantized, texCoords));
+		glVertexArrayAttribBinding(skinnedVAO, 2, 0);
+	}
+#ifdef _DEVELOP
+	else
+		refreshResources();
+#endif
+
+	//
+	// Upload all of the palettes at once
+	//
+	if (palette.size() > paletteCapacity)
+	{
+		paletteCapacity = std::max(palette.size(), paletteCapacity * 2);
+		glNamedBufferData(paletteSSBO, sizeof(glm::mat4) * paletteCapacity, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glNamedBufferSubData(paletteSSBO, 0, sizeof(glm::mat4) * palette.size(), palette.data());
+	stats.numPaletteUploads++;
+
+	if (numOutputVertices > skinnedVBOCapacity)
+	{
+		// @NOTE: this orphans the old buffer, so it's fine even if last frame's draws are still in flight
+		skinnedVBOCapacity = std::max((size_t)numOutputVertices, skinnedVBOCapacity * 2);
+		glNamedBufferData(skinnedVBO, sizeof(StaticVertexQuantized) * skinnedVBOCapacity, nullptr, GL_DYNAMIC_COPY);
+	}
+
+	//
+	// Skin everything
+	//
+	skinningShader->use();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, skinnedVBO);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, paletteSSBO);
+	for (const SkinningJob& job : jobs)
+	{
+		const uint32_t numVertices = (uint32_t)job.mesh->getNumVertices();
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, job.mesh->INTERNALgetVertexBuffer());
+		skinningShader->setUint("numVertices", numVertices);
+		skinningShader->setUint("paletteOffset", job.paletteOffset);
+		skinningShader->setUint("numBones", job.numBones);
+		skinningShader->setUint("outputOffset", job.outputOffset);
+		glDispatchCompute((numVertices + 63) / 64, 1, 1);
+
+		stats.numDispatches++;
+		stats.numSkinnedVertices += numVertices;
+	}
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	isDispatched = true;
+}
+
+GLuint SkinningPrepass::getSkinnedVAO(Mesh* mesh, const std::vector<glm::mat4>* boneTransforms, GLuint meshEBO)
+{
+	if (isDispatched)
+	{
+		auto it = jobLookup.find(std::make_pair((const Mesh*)mesh, boneTransforms));
+		if (it != jobLookup.end())
+		{
+			// NOTE: every mesh shares the one VAO, so just point it at this mesh's range of the skinned buffer
+			glVertexArrayVertexBuffer(skinnedVAO, 0, skinnedVBO, (GLintptr)jobs[it->second].outputOffset * sizeof(StaticVertexQuantized), sizeof(StaticVertexQuantized));
+			glVertexArrayElementBuffer(skinnedVAO, meshEBO);
+			stats.numPrepassDraws++;
+			return skinnedVAO;
+		}
+	}
+
+	stats.numFallbackDraws++;
+	return 0;
+}
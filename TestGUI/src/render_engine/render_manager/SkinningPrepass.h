@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+typedef unsigned int GLuint;
+class Mesh;
+class Shader;
+
+
+//
+// Skins all of the animated meshes once at the start of the frame w/ a compute
+// shader (shader/src/skinning.comp) and writes them out as StaticVertexQuantized
+// into one transient vertex buffer. Every pass after that (z prepass, opaque,
+// transparent, CSM, point light shadows) draws that buffer like a static
+// mesh, so the bone palettes only get uploaded once per frame instead of once per draw.
+//
+// NOTE: anything that didn't get submitted this frame (e.g. it just came into view)
+// still gets skinned in the vertex shader w/ the bone UBO like before.
+//
+class SkinningPrepass
+{
+public:
+	SkinningPrepass();
+	~SkinningPrepass();
+
+	SkinningPrepass(const SkinningPrepass&) = delete;
+	SkinningPrepass& operator=(const SkinningPrepass&) = delete;
+
+	void beginFrame();
+	void addMesh(Mesh* mesh, const std::vector<glm::mat4>* boneTransforms);
+	void dispatch();
+
+	GLuint getSkinnedVAO(Mesh* mesh, const std::vector<glm::mat4>* boneTransforms, GLuint meshEBO);		// 0 if the mesh wasn't skinned this frame
+
+	bool enabled = true;
+
+	struct Stats
+	{
+		size_t numDispatches;
+		size_t numSkinnedVertices;
+		size_t numPaletteUploads;
+		size_t numBoneUBOUploads;			// From the vertex shader fallback (see RenderManager::INTERNALupdateSkeletalBonesUBO())
+		size_t numPrepassDraws;
+		size_t numFallbackDraws;
+	} stats;
+
+private:
+	void refreshResources();
+
+	struct SkinningJob
+	{
+		Mesh* mesh;
+		uint32_t paletteOffset;				// In bones
+		uint32_t numBones;
+		uint32_t outputOffset;				// In vertices
+	};
+	std::vector<SkinningJob> jobs;
+	std::map<std::pair<const Mesh*, const std::vector<glm::mat4>*>, size_t> jobLookup;
+	std::map<const std::vector<glm::mat4>*, uint32_t> paletteLookup;
+	std::vector<glm::mat4> palette;
+	uint32_t numOutputVertices = 0;
+	bool isDispatched = false;
+
+	GLuint paletteSSBO = 0;
+	size_t paletteCapacity = 0;				// In bones
+	GLuint skinnedVBO = 0;
+	size_t skinnedVBOCapacity = 0;			// In vertices
+	GLuint skinnedVAO = 0;
+
+	Shader* skinningShader;
+};
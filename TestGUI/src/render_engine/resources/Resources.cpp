@@ -329,7 +329,7 @@ void* loadModel(const std::string& modelName, bool isUnloading, const char* path
 {
 	if (!isUnloading)
 	{
-		Model* model = new Model(path);
+		Model* model = new Model(path, Model::getCPUMeshDataNeed(modelName));
 		return model;
 	}
 	else
@@ -343,7 +343,7 @@ void* loadModel(const std::string& modelName, bool isUnloading, const char* path
 {
 	if (!isUnloading)
 	{
-		Model* model = new Model(path, animationNames);
+		Model* model = new Model(path, animationNames, Model::getCPUMeshDataNeed(modelName));
 		return model;
 	}
 	else
@@ -382,7 +382,7 @@ void* loadModelFromHSMM(const std::string& modelName, bool isUnloading, const ch
 			}
 		}
 
-		Model* model = new Model(std::string(hsmm["model_path"]).c_str(), animationsToInclude);
+		Model* model = new Model(std::string(hsmm["model_path"]).c_str(), animationsToInclude, Model::getCPUMeshDataNeed(modelName));
 
 		// Setup importing the material paths (and load those materials at the same time)
 		// @NOTE: need to import the animations and the model before touching the materials
@@ -0,0 +1,337 @@
+#include "TerrainQuadtree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+//
+// Heightfield
+//
+glm::vec2 Heightfield::getSampleSpacing() const
+{
+	return glm::vec2(
+		(boundsMax.x - boundsMin.x) / (float)std::max(1u, resolutionX - 1),
+		(boundsMax.z - boundsMin.z) / (float)std::max(1u, resolutionZ - 1)
+	);
+}
+
+float Heightfield::sampleHeight(float localX, float localZ) const
+{
+	const glm::vec2 spacing = getSampleSpacing();
+	const float fx = glm::clamp((localX - boundsMin.x) / spacing.x, 0.0f, (float)(resolutionX - 1));
+	const float fz = glm::clamp((localZ - boundsMin.z) / spacing.y, 0.0f, (float)(resolutionZ - 1));
+	const uint32_t x0 = std::min((uint32_t)fx, resolutionX - 2);
+	const uint32_t z0 = std::min((uint32_t)fz, resolutionZ - 2);
+	const float tx = fx - (float)x0;
+	const float tz = fz - (float)z0;
+
+	return glm::mix(
+		glm::mix(getHeight(x0, z0), getHeight(x0 + 1, z0), tx),
+		glm::mix(getHeight(x0, z0 + 1), getHeight(x0 + 1, z0 + 1), tx),
+		tz
+	);
+}
+
+Heightfield Heightfield::createFromTriangles(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, uint32_t maxResolution)
+{
+	Heightfield heightfield;
+	if (positions.empty() || indices.size() < 3 || maxResolution < 2)
+		return heightfield;
+
+	heightfield.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	heightfield.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+	for (const glm::vec3& position : positions)
+	{
+		heightfield.boundsMin = glm::min(heightfield.boundsMin, position);
+		heightfield.boundsMax = glm::max(heightfield.boundsMax, position);
+	}
+
+	// The longer side gets maxResolution, and the other side gets however many keeps the samples square
+	const glm::vec3 extents = heightfield.boundsMax - heightfield.boundsMin;
+	const float longestSide = std::max(extents.x, extents.z);
+	if (longestSide <= 0.0f)
+		return heightfield;
+	heightfield.resolutionX = std::max(2u, (uint32_t)std::ceil(extents.x / longestSide * (float)(maxResolution - 1)) + 1);
+	heightfield.resolutionZ = std::max(2u, (uint32_t)std::ceil(extents.z / longestSide * (float)(maxResolution - 1)) + 1);
+	heightfield.heights.resize((size_t)heightfield.resolutionX * heightfield.resolutionZ, std::numeric_limits<float>::lowest());
+
+	const glm::vec2 spacing = heightfield.getSampleSpacing();
+	const glm::vec2 invSpacing(
+		(spacing.x > 0.0f) ? 1.0f / spacing.x : 0.0f,
+		(spacing.y > 0.0f) ? 1.0f / spacing.y : 0.0f
+	);
+
+	//
+	// Rasterize every triangle onto the sample grid (top down)
+	//
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const glm::vec3& a = positions[indices[i]];
+		const glm::vec3& b = positions[indices[i + 1]];
+		const glm::vec3& c = positions[indices[i + 2]];
+
+		// Into sample space
+		const glm::vec2 sa = (glm::vec2(a.x, a.z) - glm::vec2(heightfield.boundsMin.x, heightfield.boundsMin.z)) * invSpacing;
+		const glm::vec2 sb = (glm::vec2(b.x, b.z) - glm::vec2(heightfield.boundsMin.x, heightfield.boundsMin.z)) * invSpacing;
+		const glm::vec2 sc = (glm::vec2(c.x, c.z) - glm::vec2(heightfield.boundsMin.x, heightfield.boundsMin.z)) * invSpacing;
+
+		const float area = (sb.x - sa.x) * (sc.y - sa.y) - (sc.x - sa.x) * (sb.y - sa.y);
+		if (std::abs(area) < 1e-8f)
+			continue;		// Vertical (or degenerate) triangle. Doesn't show up from the top
+
+		const int minX = std::max(0, (int)std::ceil(std::min({ sa.x, sb.x, sc.x }) - 1e-4f));
+		const int maxX = std::min((int)heightfield.resolutionX - 1, (int)std::floor(std::max({ sa.x, sb.x, sc.x }) + 1e-4f));
+		const int minZ = std::max(0, (int)std::ceil(std::min({ sa.y, sb.y, sc.y }) - 1e-4f));
+		const int maxZ = std::min((int)heightfield.resolutionZ - 1, (int)std::floor(std::max({ sa.y, sb.y, sc.y }) + 1e-4f));
+
+		const float invArea = 1.0f / area;
+		for (int z = minZ; z <= maxZ; z++)
+		for (int x = minX; x <= maxX; x++)
+		{
+			const glm::vec2 p((float)x, (float)z);
+			const float w0 = ((sb.x - p.x) * (sc.y - p.y) - (sc.x - p.x) * (sb.y - p.y)) * invArea;
+			const float w1 = ((sc.x - p.x) * (sa.y - p.y) - (sa.x - p.x) * (sc.y - p.y)) * invArea;
+			const float w2 = 1.0f - w0 - w1;
+
+			constexpr float edgeEpsilon = -1e-4f;		// So that samples right on shared edges don't fall through the cracks
+			if (w0 < edgeEpsilon || w1 < edgeEpsilon || w2 < edgeEpsilon)
+				continue;
+
+			float& height = heightfield.heights[(size_t)z * heightfield.resolutionX + x];
+			height = std::max(height, w0 * a.y + w1 * b.y + w2 * c.y);
+		}
+	}
+
+	//
+	// Anything that didn't get covered is a hole
+	//
+	heightfield.holes.resize(heightfield.heights.size(), 0);
+	for (size_t i = 0; i < heightfield.heights.size(); i++)
+	{
+		if (heightfield.heights[i] == std::numeric_limits<float>::lowest())
+		{
+			heightfield.heights[i] = heightfield.boundsMin.y;
+			heightfield.holes[i] = 1;
+		}
+	}
+
+	//
+	// Find the triangles that didn't make it in. A triangle's lost if it's vertical (it never
+	// got rasterized), or if any of its corners is under the lowest of the samples around it
+	// by more than a sample's width (i.e. there's a surface above it that won)
+	//
+	const float tolerance = std::max(spacing.x, spacing.y);
+	std::vector<uint32_t> leftoverRemap(positions.size(), std::numeric_limits<uint32_t>::max());
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		bool isLeftover = false;
+		glm::vec2 samplePositions[3];
+		for (size_t j = 0; j < 3; j++)
+		{
+			const glm::vec3& position = positions[indices[i + j]];
+			samplePositions[j] = (glm::vec2(position.x, position.z) - glm::vec2(heightfield.boundsMin.x, heightfield.boundsMin.z)) * invSpacing;
+
+			const uint32_t x0 = std::min((uint32_t)std::max(0.0f, std::floor(samplePositions[j].x)), heightfield.resolutionX - 1);
+			const uint32_t z0 = std::min((uint32_t)std::max(0.0f, std::floor(samplePositions[j].y)), heightfield.resolutionZ - 1);
+			const uint32_t x1 = std::min(x0 + 1, heightfield.resolutionX - 1);
+			const uint32_t z1 = std::min(z0 + 1, heightfield.resolutionZ - 1);
+			const float lowestAround = std::min({ heightfield.getHeight(x0, z0), heightfield.getHeight(x1, z0), heightfield.getHeight(x0, z1), heightfield.getHeight(x1, z1) });
+			if (position.y < lowestAround - tolerance)
+				isLeftover = true;
+		}
+
+		const glm::vec2& sa = samplePositions[0];
+		const glm::vec2& sb = samplePositions[1];
+		const glm::vec2& sc = samplePositions[2];
+		const float area = (sb.x - sa.x) * (sc.y - sa.y) - (sc.x - sa.x) * (sb.y - sa.y);
+		if (std::abs(area) < 1e-8f)
+		{
+			const glm::vec3 edgeA = positions[indices[i + 1]] - positions[indices[i]];
+			const glm::vec3 edgeB = positions[indices[i + 2]] - positions[indices[i]];
+			isLeftover |= (glm::length(glm::cross(edgeA, edgeB)) > 1e-8f);		// NOTE: truly degenerate triangles can just get thrown out
+		}
+
+		if (!isLeftover)
+			continue;
+
+		for (size_t j = 0; j < 3; j++)
+		{
+			uint32_t& remappedIndex = leftoverRemap[indices[i + j]];
+			if (remappedIndex == std::numeric_limits<uint32_t>::max())
+			{
+				remappedIndex = (uint32_t)heightfield.leftoverPositions.size();
+				heightfield.leftoverPositions.push_back(positions[indices[i + j]]);
+			}
+			heightfield.leftoverIndices.push_back(remappedIndex);
+		}
+	}
+
+	return heightfield;
+}
+
+
+//
+// Quadtree
+//
+void TerrainQuadtree::build(const Heightfield& heightfield, const TerrainQuadtreeSettings& settings)
+{
+	TerrainQuadtree::settings = settings;
+	nodes.clear();
+	lodRanges.clear();
+
+	if (!heightfield.isValid() || settings.leafChunkQuads == 0)
+		return;
+
+	boundsMin = heightfield.boundsMin;
+	sampleSpacing = heightfield.getSampleSpacing();
+	resolutionX = heightfield.resolutionX;
+	resolutionZ = heightfield.resolutionZ;
+
+	// Enough LODs so that the root covers the whole heightfield
+	const uint32_t numQuads = std::max(resolutionX, resolutionZ) - 1;
+	uint32_t numLODs = 1;
+	while (settings.leafChunkQuads * (1u << (numLODs - 1)) < numQuads)
+		numLODs++;
+
+	// @NOTE: a LOD's range has to be bigger than its chunks are wide, otherwise the morphing
+	// can't finish before the neighbor is 2 LODs away. 2x the leaf's size is pretty safe.
+	const float leafChunkSize = (float)settings.leafChunkQuads * std::max(sampleSpacing.x, sampleSpacing.y);
+	float range = (settings.firstLODDistance > 0.0f) ? settings.firstLODDistance : leafChunkSize * 2.0f;
+	for (uint32_t i = 0; i < numLODs; i++)
+	{
+		lodRanges.push_back(range);
+		range *= std::max(settings.lodDistanceRatio, 2.0f);
+	}
+
+	nodes.reserve(64);
+	buildNode(heightfield, 0, 0, settings.leafChunkQuads * (1u << (numLODs - 1)), numLODs - 1);
+}
+
+uint32_t TerrainQuadtree::buildNode(const Heightfield& heightfield, uint32_t originX, uint32_t originZ, uint32_t size, uint32_t lodLevel)
+{
+	const uint32_t nodeIndex = (uint32_t)nodes.size();
+	nodes.push_back({ originX, originZ, size, lodLevel, std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), { noChild, noChild, noChild, noChild } });
+
+	if (lodLevel == 0)
+	{
+		// Leaf gets the min/max right off of the samples
+		const uint32_t maxX = std::min(originX + size, resolutionX - 1);
+		const uint32_t maxZ = std::min(originZ + size, resolutionZ - 1);
+		float minHeight = std::numeric_limits<float>::max();
+		float maxHeight = std::numeric_limits<float>::lowest();
+		for (uint32_t z = originZ; z <= maxZ; z++)
+		for (uint32_t x = originX; x <= maxX; x++)
+		{
+			minHeight = std::min(minHeight, heightfield.getHeight(x, z));
+			maxHeight = std::max(maxHeight, heightfield.getHeight(x, z));
+		}
+		nodes[nodeIndex].minHeight = minHeight;
+		nodes[nodeIndex].maxHeight = maxHeight;
+		return nodeIndex;
+	}
+
+	const uint32_t halfSize = size / 2;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const uint32_t childX = originX + (i % 2) * halfSize;
+		const uint32_t childZ = originZ + (i / 2) * halfSize;
+		if (childX >= resolutionX - 1 || childZ >= resolutionZ - 1)
+			continue;		// Totally off of the heightfield
+
+		// NOTE: nodes can get reallocated while building the child, so no holding onto references here
+		const uint32_t childIndex = buildNode(heightfield, childX, childZ, halfSize, lodLevel - 1);
+		nodes[nodeIndex].children[i] = childIndex;
+		nodes[nodeIndex].minHeight = std::min(nodes[nodeIndex].minHeight, nodes[childIndex].minHeight);
+		nodes[nodeIndex].maxHeight = std::max(nodes[nodeIndex].maxHeight, nodes[childIndex].maxHeight);
+	}
+	return nodeIndex;
+}
+
+void TerrainQuadtree::select(const glm::vec3& cameraPosition, const glm::mat4& modelMatrix, const VisibilityFunc& isVisible, float lodDistanceMultiplier, std::vector<TerrainChunkSelection>& out_selection) const
+{
+	out_selection.clear();
+	if (nodes.empty())
+		return;
+
+	// Ranges are in local space, so scale them by the biggest axis of the transform
+	const float modelScale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+
+	SelectContext context;
+	context.cameraPosition = cameraPosition;
+	context.modelMatrix = &modelMatrix;
+	context.isVisible = &isVisible;
+	context.rangeScale = modelScale * lodDistanceMultiplier;
+	context.out_selection = &out_selection;
+
+	if (!selectNode(0, context))
+	{
+		// Camera's past the last LOD's range, so just the root at the coarsest LOD
+		const Node& root = nodes[0];
+		glm::vec3 worldMin, worldMax;
+		getNodeWorldBounds(root, modelMatrix, worldMin, worldMax);
+		if (!isVisible || isVisible(worldMin, worldMax))
+			out_selection.push_back({ root.originX, root.originZ, root.size, root.lodLevel, -1 });
+	}
+}
+
+bool TerrainQuadtree::selectNode(uint32_t nodeIndex, const SelectContext& context) const
+{
+	const Node& node = nodes[nodeIndex];
+
+	glm::vec3 worldMin, worldMax;
+	getNodeWorldBounds(node, *context.modelMatrix, worldMin, worldMax);
+
+	auto intersectsSphere = [&](float radius)
+	{
+		const glm::vec3 closestPoint = glm::clamp(context.cameraPosition, worldMin, worldMax);
+		const glm::vec3 delta = closestPoint - context.cameraPosition;
+		return glm::dot(delta, delta) <= radius * radius;
+	};
+
+	if (!intersectsSphere(lodRanges[node.lodLevel] * context.rangeScale))
+		return false;		// Parent needs to cover this area
+
+	if (*context.isVisible && !(*context.isVisible)(worldMin, worldMax))
+		return true;		// Taken care of (by not drawing it)
+
+	if (node.lodLevel == 0 || !intersectsSphere(lodRanges[node.lodLevel - 1] * context.rangeScale))
+	{
+		context.out_selection->push_back({ node.originX, node.originZ, node.size, node.lodLevel, -1 });
+		return true;
+	}
+
+	// Children that are too far away for their LOD get drawn as this node's quadrant instead
+	for (int i = 0; i < 4; i++)
+	{
+		if (node.children[i] == noChild)
+			continue;
+		if (!selectNode(node.children[i], context))
+			context.out_selection->push_back({ node.originX, node.originZ, node.size, node.lodLevel, i });
+	}
+	return true;
+}
+
+glm::vec2 TerrainQuadtree::getMorphRange(uint32_t lodLevel, const glm::mat4& modelMatrix, float lodDistanceMultiplier) const
+{
+	const float modelScale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+	const float rangeEnd = lodRanges[lodLevel];
+	const float rangeStart = (lodLevel > 0) ? lodRanges[lodLevel - 1] : 0.0f;
+	const float morphStart = glm::mix(rangeStart, rangeEnd, glm::clamp(settings.morphStartRatio, 0.0f, 0.99f));
+	return glm::vec2(morphStart, rangeEnd) * modelScale * lodDistanceMultiplier;
+}
+
+void TerrainQuadtree::getNodeWorldBounds(const Node& node, const glm::mat4& modelMatrix, glm::vec3& out_min, glm::vec3& out_max) const
+{
+	const glm::vec3 localMin(boundsMin.x + node.originX * sampleSpacing.x, node.minHeight, boundsMin.z + node.originZ * sampleSpacing.y);
+	const glm::vec3 localMax(boundsMin.x + (node.originX + node.size) * sampleSpacing.x, node.maxHeight, boundsMin.z + (node.originZ + node.size) * sampleSpacing.y);
+
+	// Arvo's AABB transform
+	const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+	const glm::vec3 localExtents = (localMax - localMin) * 0.5f;
+	const glm::mat3 absMatrix(glm::abs(glm::vec3(modelMatrix[0])), glm::abs(glm::vec3(modelMatrix[1])), glm::abs(glm::vec3(modelMatrix[2])));
+	const glm::vec3 extents = absMatrix * localExtents;
+
+	out_min = center - extents;
+	out_max = center + extents;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+
+//
+// Heightfield terrain data + the CDLOD quadtree that picks which chunks to draw
+// (Strugar, "Continuous Distance-Dependent Level of Detail for Rendering Heightmaps").
+//
+struct Heightfield
+{
+	uint32_t resolutionX = 0, resolutionZ = 0;		// Number of samples along each axis
+	glm::vec3 boundsMin = glm::vec3(0.0f);			// Local space. The first sample is at boundsMin.xz and the last one is at boundsMax.xz
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	std::vector<float> heights;						// z * resolutionX + x. Local space
+	std::vector<uint8_t> holes;						// 1 if no triangle was over the sample (its height is just boundsMin.y)
+
+	// The source triangles that a heightfield can't show (vertical faces, and undersides of overhangs/caves
+	// that are under the top surface). These are just copied as-is so they can still be collided with
+	std::vector<glm::vec3> leftoverPositions;
+	std::vector<uint32_t> leftoverIndices;
+
+	inline float getHeight(uint32_t x, uint32_t z) const { return heights[(size_t)z * resolutionX + x]; }
+	inline bool isValid() const { return resolutionX >= 2 && resolutionZ >= 2; }
+	glm::vec2 getSampleSpacing() const;
+	float sampleHeight(float localX, float localZ) const;		// Bilinear. Clamps to the edges
+
+	// Rasterizes the triangles top down (the highest surface wins). The longer side gets maxResolution samples.
+	// Whatever doesn't make it in gets put into leftoverPositions/leftoverIndices
+	static Heightfield createFromTriangles(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, uint32_t maxResolution);
+};
+
+
+struct TerrainQuadtreeSettings
+{
+	uint32_t leafChunkQuads = 32;			// Every chunk gets drawn with a grid this many quads wide. Leaf chunks are 1 quad per heightfield sample. Needs to be a power of 2
+	float firstLODDistance = 0.0f;			// Local space (scales with the terrain). 0 means it's figured out from the leaf chunk size
+	float lodDistanceRatio = 2.0f;			// Each LOD's range is this much farther than the previous one's. Min 2 (chunks double in size each LOD)
+	float morphStartRatio = 0.66f;			// How far into a LOD's range the morph into the next LOD starts
+};
+
+struct TerrainChunkSelection
+{
+	uint32_t originX, originZ;				// In heightfield samples
+	uint32_t size;							// In heightfield quads. This is the node's size, not the quadrant's
+	uint32_t lodLevel;						// 0 is the most detailed
+	int quadrant;							// -1 is the whole chunk. 0-3 is only that quarter of the grid (x + 2 * z)
+};
+
+class TerrainQuadtree
+{
+public:
+	typedef std::function<bool(const glm::vec3& worldMin, const glm::vec3& worldMax)> VisibilityFunc;
+
+	void build(const Heightfield& heightfield, const TerrainQuadtreeSettings& settings);
+
+	// NOTE: cameraPosition is in world space. isVisible is optional (no culling if empty). lodDistanceMultiplier < 1 gives coarser chunks (e.g. for shadows)
+	void select(const glm::vec3& cameraPosition, const glm::mat4& modelMatrix, const VisibilityFunc& isVisible, float lodDistanceMultiplier, std::vector<TerrainChunkSelection>& out_selection) const;
+
+	glm::vec2 getMorphRange(uint32_t lodLevel, const glm::mat4& modelMatrix, float lodDistanceMultiplier) const;		// (start, end) in world space
+
+	inline uint32_t getNumLODs() const { return (uint32_t)lodRanges.size(); }
+	inline uint32_t getLeafChunkQuads() const { return settings.leafChunkQuads; }
+	inline bool isEmpty() const { return nodes.empty(); }
+
+private:
+	static constexpr uint32_t noChild = UINT32_MAX;
+	struct Node
+	{
+		uint32_t originX, originZ, size, lodLevel;
+		float minHeight, maxHeight;
+		uint32_t children[4];				// noChild if the quarter is totally off the heightfield
+	};
+
+	struct SelectContext
+	{
+		glm::vec3 cameraPosition;
+		const glm::mat4* modelMatrix;
+		const VisibilityFunc* isVisible;
+		float rangeScale;
+		std::vector<TerrainChunkSelection>* out_selection;
+	};
+
+	uint32_t buildNode(const Heightfield& heightfield, uint32_t originX, uint32_t originZ, uint32_t size, uint32_t lodLevel);
+	bool selectNode(uint32_t nodeIndex, const SelectContext& context) const;
+	void getNodeWorldBounds(const Node& node, const glm::mat4& modelMatrix, glm::vec3& out_min, glm::vec3& out_max) const;
+
+	TerrainQuadtreeSettings settings;
+	std::vector<Node> nodes;				// NOTE: nodes[0] is the root
+	std::vector<float> lodRanges;			// Local space. Gets scaled by the model matrix when selecting
+
+	glm::vec3 boundsMin;
+	glm::vec2 sampleSpacing;
+	uint32_t resolutionX, resolutionZ;
+};
@@ -0,0 +1,358 @@
+#include "TerrainRenderer.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include "../model/Mesh.h"
+#include "../material/Material.h"
+#include "../material/Shader.h"
+#include "../material/Texture.h"
+#include "../camera/Camera.h"
+#include "../resources/Resources.h"
+#include "../render_manager/RenderManager.h"
+#include "../render_manager/OcclusionCuller.h"
+#include "../render_manager/ScenePicker.h"
+#include "../render_manager/ShadowLayerPass.h"
+#include "../../mainloop/MainLoop.h"
+
+
+TerrainRenderer::TerrainRenderer(const Heightfield& heightfield, Material* material, const TerrainQuadtreeSettings& settings) : material(material)
+{
+	quadtree.build(heightfield, settings);
+	heightfieldResolution = glm::vec2(heightfield.resolutionX, heightfield.resolutionZ);
+	heightfieldBoundsMin = heightfield.boundsMin;
+	heightfieldBoundsMax = heightfield.boundsMax;
+	heightfieldSampleSpacing = heightfield.getSampleSpacing();
+	stats = {};
+
+	refreshResources();
+	if (!heightfield.isValid())
+		return;
+
+	//
+	// Heightmap
+	//
+	glCreateTextures(GL_TEXTURE_2D, 1, &heightmapTexture);
+	glTextureStorage2D(heightmapTexture, 1, GL_R32F, heightfield.resolutionX, heightfield.resolutionZ);
+	glTextureSubImage2D(heightmapTexture, 0, 0, 0, heightfield.resolutionX, heightfield.resolutionZ, GL_RED, GL_FLOAT, heightfield.heights.data());
+	glTextureParameteri(heightmapTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);		// NOTE: linear is for the morphed vertices that land in between samples
+	glTextureParameteri(heightmapTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(heightmapTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(heightmapTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	//
+	// The one grid mesh that all of the chunks use. The indices are split up by
+	// quadrant so that a chunk can draw just a quarter of itself
+	//
+	const uint32_t gridQuads = quadtree.getLeafChunkQuads();
+	const uint32_t halfQuads = gridQuads / 2;
+	std::vector<glm::vec2> gridVertices;
+	gridVertices.reserve((size_t)(gridQuads + 1) * (gridQuads + 1));
+	for (uint32_t z = 0; z <= gridQuads; z++)
+		for (uint32_t x = 0; x <= gridQuads; x++)
+			gridVertices.push_back(glm::vec2((float)x, (float)z) / (float)gridQuads);
+
+	std::vector<uint32_t> gridIndices;
+	gridIndices.reserve((size_t)gridQuads * gridQuads * 6);
+	for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+	{
+		const uint32_t startX = (quadrant % 2) * halfQuads;
+		const uint32_t startZ = (quadrant / 2) * halfQuads;
+		for (uint32_t z = startZ; z < startZ + halfQuads; z++)
+			for (uint32_t x = startX; x < startX + halfQuads; x++)
+			{
+				const uint32_t i = z * (gridQuads + 1) + x;
+				gridIndices.insert(gridIndices.end(), { i, i + gridQuads + 1, i + 1, i + 1, i + gridQuads + 1, i + gridQuads + 2 });
+			}
+	}
+	quadrantIndexCount = (uint32_t)gridIndices.size() / 4;
+
+	glGenVertexArrays(1, &gridVAO);
+	glGenBuffers(1, &gridVBO);
+	glGenBuffers(1, &gridEBO);
+
+	glBindVertexArray(gridVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+	glBufferData(GL_ARRAY_BUFFER, gridVertices.size() * sizeof(glm::vec2), gridVertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, gridIndices.size() * sizeof(uint32_t), gridIndices.data(), GL_STATIC_DRAW);
+
+	// grid position [0-1]
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+	glBindVertexArray(0);
+
+	createShadowProxyAndOccluder(heightfield);
+}
+
+TerrainRenderer::~TerrainRenderer()
+{
+	delete shadowProxyMesh;
+	glDeleteTextures(1, &heightmapTexture);
+	glDeleteVertexArrays(1, &gridVAO);
+	glDeleteBuffers(1, &gridVBO);
+	glDeleteBuffers(1, &gridEBO);
+}
+
+void TerrainRenderer::refreshResources()
+{
+	terrainShader = (Shader*)Resources::getResource("shader;terrainCDLOD");
+	terrainZPassShader = (Shader*)Resources::getResource("shader;terrainCDLODZPass");
+	terrainCSMShadowShader = (Shader*)Resources::getResource("shader;terrainCDLODCSMShadow");
+	csmShadowShader = (Shader*)Resources::getResource("shader;csmShadowPass");
+}
+
+void TerrainRenderer::createShadowProxyAndOccluder(const Heightfield& heightfield)
+{
+	//
+	// Shadow proxy: the heightfield at a max of 128x128 quads
+	//
+	{
+		const uint32_t step = std::max(1u, (std::max(heightfield.resolutionX, heightfield.resolutionZ) - 1) / 128);
+		const uint32_t numX = (heightfield.resolutionX - 1 + step - 1) / step + 1;		// NOTE: the last row/column gets clamped onto the edge
+		const uint32_t numZ = (heightfield.resolutionZ - 1 + step - 1) / step + 1;
+
+		std::vector<Vertex> vertices;
+		vertices.reserve((size_t)numX * numZ);
+		for (uint32_t z = 0; z < numZ; z++)
+			for (uint32_t x = 0; x < numX; x++)
+			{
+				const uint32_t sampleX = std::min(x * step, heightfield.resolutionX - 1);
+				const uint32_t sampleZ = std::min(z * step, heightfield.resolutionZ - 1);
+
+				Vertex vertex;
+				vertex.position = glm::vec3(
+					heightfieldBoundsMin.x + sampleX * heightfieldSampleSpacing.x,
+					heightfield.getHeight(sampleX, sampleZ),
+					heightfieldBoundsMin.z + sampleZ * heightfieldSampleSpacing.y
+				);
+				vertex.normal = glm::vec3(0, 1, 0);			// NOTE: the shadow passes don't use the normals
+				vertex.texCoords = glm::vec2(sampleX, sampleZ) / (heightfieldResolution - 1.0f);
+				for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+				{
+					vertex.boneIds[i] = -1;
+					vertex.boneWeights[i] = 0.0f;
+				}
+				vertices.push_back(vertex);
+			}
+
+		std::vector<uint32_t> indices;
+		indices.reserve((size_t)(numX - 1) * (numZ - 1) * 6);
+		for (uint32_t z = 0; z + 1 < numZ; z++)
+			for (uint32_t x = 0; x + 1 < numX; x++)
+			{
+				const uint32_t i = z * numX + x;
+				indices.insert(indices.end(), { i, i + numX, i + 1, i + 1, i + numX, i + numX + 1 });
+			}
+
+		const RenderAABB bounds = { (heightfieldBoundsMin + heightfieldBoundsMax) * 0.5f, (heightfieldBoundsMax - heightfieldBoundsMin) * 0.5f };
+		shadowProxyMesh = new Mesh(bounds.center, vertices, indices, bounds, "terrain");
+		shadowProxyMesh->pickFromMaterialList({ { "terrain", material } });
+	}
+
+	//
+	// Occluder: 64x64 quads, where each vertex takes the lowest height around it
+	// so that the occluder is always under the real surface
+	//
+	{
+		const uint32_t step = std::max(1u, (std::max(heightfield.resolutionX, heightfield.resolutionZ) - 1) / 64);
+		const uint32_t numX = (heightfield.resolutionX - 1 + step - 1) / step + 1;
+		const uint32_t numZ = (heightfield.resolutionZ - 1 + step - 1) / step + 1;
+
+		occluderPositions.clear();
+		occluderPositions.reserve((size_t)numX * numZ);
+		for (uint32_t z = 0; z < numZ; z++)
+			for (uint32_t x = 0; x < numX; x++)
+			{
+				const uint32_t sampleX = std::min(x * step, heightfield.resolutionX - 1);
+				const uint32_t sampleZ = std::min(z * step, heightfield.resolutionZ - 1);
+
+				float minHeight = heightfield.getHeight(sampleX, sampleZ);
+				for (uint32_t sz = (sampleZ > step ? sampleZ - step : 0); sz <= std::min(sampleZ + step, heightfield.resolutionZ - 1); sz++)
+					for (uint32_t sx = (sampleX > step ? sampleX - step : 0); sx <= std::min(sampleX + step, heightfield.resolutionX - 1); sx++)
+						minHeight = std::min(minHeight, heightfield.getHeight(sx, sz));
+
+				occluderPositions.push_back(glm::vec3(
+					heightfieldBoundsMin.x + sampleX * heightfieldSampleSpacing.x,
+					minHeight,
+					heightfieldBoundsMin.z + sampleZ * heightfieldSampleSpacing.y
+				));
+			}
+
+		occluderIndices.clear();
+		occluderIndices.reserve((size_t)(numX - 1) * (numZ - 1) * 6);
+		for (uint32_t z = 0; z + 1 < numZ; z++)
+			for (uint32_t x = 0; x + 1 < numX; x++)
+			{
+				const uint32_t i = z * numX + x;
+				occluderIndices.insert(occluderIndices.end(), { i, i + numX, i + 1, i + 1, i + numX, i + numX + 1 });
+			}
+	}
+}
+
+void TerrainRenderer::submitOccluder(const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, OcclusionCuller* occlusionCuller)
+{
+	if (occluderIndices.empty())
+		return;
+
+	const RenderAABB bounds = { (heightfieldBoundsMin + heightfieldBoundsMax) * 0.5f, (heightfieldBoundsMax - heightfieldBoundsMin) * 0.5f };
+	if (!viewFrustum->checkIfInViewFrustum(bounds, modelMatrix))
+		return;
+
+	occlusionCuller->addOccluder(occluderPositions.data(), sizeof(glm::vec3), occluderPositions.size(), occluderIndices.data(), occluderIndices.size(), modelMatrix);
+}
+
+void TerrainRenderer::submitPickingMesh(const glm::mat4& modelMatrix, std::vector<ScenePickerMesh>& out_meshes)
+{
+	if (occluderIndices.empty())
+		return;
+
+	out_meshes.push_back({ occluderPositions.data(), occluderPositions.size(), occluderIndices.data(), occluderIndices.size(), modelMatrix });
+}
+
+void TerrainRenderer::render(const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, Shader* zPassShader, OcclusionCuller* occlusionCuller)
+{
+#ifdef _DEVELOP
+	refreshResources();
+#endif
+
+	stats.numChunks = 0;
+	stats.numTriangles = 0;
+	selection.clear();
+	if (quadtree.isEmpty())
+		return;
+
+	//
+	// Pick the chunks
+	//
+	TerrainQuadtree::VisibilityFunc isVisible = [&](const glm::vec3& worldMin, const glm::vec3& worldMax)
+	{
+		const RenderAABB bounds = { (worldMin + worldMax) * 0.5f, (worldMax - worldMin) * 0.5f };
+		if (!viewFrustum->checkIfInViewFrustum(bounds, glm::mat4(1.0f)))
+			return false;
+		return occlusionCuller == nullptr || occlusionCuller->isVisible(worldMin, worldMax);
+	};
+	quadtree.select(MainLoop::getInstance().camera.position, modelMatrix, isVisible, lodDistanceMultiplier, selection);
+	selectionModelMatrix = modelMatrix;
+	if (selection.empty())
+		return;
+
+	//
+	// Z prepass
+	//
+	terrainZPassShader->use();
+	if (material != nullptr)
+	{
+		terrainZPassShader->setFloat("ditherAlpha", material->ditherAlpha);
+		Texture* mainTexture = material->getMainTexture();
+		if (mainTexture != nullptr)
+		{
+			terrainZPassShader->setSampler("ubauTexture", mainTexture->getHandle());
+			terrainZPassShader->setFloat("fadeAlpha", material->fadeAlpha);
+		}
+	}
+	terrainZPassShader->setFloat("lodFadeAlpha", 1.0f);
+
+	glm::vec3 x, y, z;		// @Copypasta: Mesh::render()
+	z = -glm::normalize(MainLoop::getInstance().camera.orientation);
+	x = glm::normalize(glm::vec3(z.z, 0.0f, -z.x));
+	y = glm::cross(z, x);
+	glm::mat3 normalToViewSpace(x, y, z);
+	terrainZPassShader->setMat3("normalToViewSpace", normalToViewSpace);
+
+	stats.numTriangles = drawChunks(terrainZPassShader, selection, modelMatrix, lodDistanceMultiplier);
+	stats.numChunks = selection.size();
+
+	zPassShader->use();		// For the rest of the z prepass
+	MainLoop::getInstance().renderManager->INTERNALaddTerrainToOpaqueRenderQueue(this);
+}
+
+void TerrainRenderer::INTERNALrenderOpaque()
+{
+	if (selection.empty() || material == nullptr)
+		return;
+
+	// NOTE: the material's uniforms are the same as pbr.frag's, since that's what terrainShader uses too
+	material->applyTextureUniformsToShader(terrainShader);
+	terrainShader->setFloat("lodFadeAlpha", 1.0f);
+	drawChunks(terrainShader, selection, selectionModelMatrix, lodDistanceMultiplier);
+}
+
+void TerrainRenderer::renderShadow(const glm::mat4& modelMatrix, Shader* shadowShader)
+{
+#ifdef _DEVELOP
+	refreshResources();
+#endif
+
+	if (quadtree.isEmpty())
+		return;
+
+	if (shadowShader != csmShadowShader)
+	{
+		// Only the CSM has a terrain version of its shader, so everything else gets the proxy
+		shadowProxyMesh->render(modelMatrix, shadowShader, nullptr, RenderStage::OVERRIDE);
+		return;
+	}
+
+	// NOTE: no view frustum culling here, since stuff offscreen still casts shadows onto the screen. Just cull against the cascades
+	TerrainQuadtree::VisibilityFunc isVisible;
+	ShadowLayerPass* shadowLayerPass = MainLoop::getInstance().renderManager->INTERNALgetActiveShadowLayerPass();
+	if (shadowLayerPass != nullptr)
+		isVisible = [&](const glm::vec3& worldMin, const glm::vec3& worldMax)
+		{
+			const RenderAABB bounds = { (worldMin + worldMax) * 0.5f, (worldMax - worldMin) * 0.5f };
+			return shadowLayerPass->getLayerMask(bounds, glm::mat4(1.0f)) != 0;
+		};
+	quadtree.select(MainLoop::getInstance().camera.position, modelMatrix, isVisible, lodDistanceMultiplier * shadowLODDistanceMultiplier, shadowSelection);
+	stats.numShadowChunks = shadowSelection.size();
+
+	terrainCSMShadowShader->use();
+	if (material != nullptr && material->getMainTexture() != nullptr)
+	{
+		terrainCSMShadowShader->setSampler("ubauTexture", material->getMainTexture()->getHandle());
+		terrainCSMShadowShader->setFloat("fadeAlpha", material->fadeAlpha);
+	}
+	drawChunks(terrainCSMShadowShader, shadowSelection, modelMatrix, lodDistanceMultiplier * shadowLODDistanceMultiplier);
+
+	shadowShader->use();		// For the rest of the shadow pass
+}
+
+size_t TerrainRenderer::drawChunks(Shader* shader, const std::vector<TerrainChunkSelection>& chunks, const glm::mat4& modelMatrix, float lodDistanceMultiplier)
+{
+	shader->setSampler("heightmap", heightmapTexture);
+	shader->setVec2("heightfieldResolution", heightfieldResolution);
+	shader->setVec3("heightfieldBoundsMin", heightfieldBoundsMin);
+	shader->setVec2("heightfieldSampleSpacing", heightfieldSampleSpacing);
+	shader->setFloat("gridDimension", (float)quadtree.getLeafChunkQuads());
+	shader->setVec3("cameraPosition", MainLoop::getInstance().camera.position);
+	shader->setMat4("modelMatrix", modelMatrix);
+	shader->setMat3("normalsModelMatrix", glm::mat3(glm::transpose(glm::inverse(modelMatrix))));
+
+	ShadowLayerPass* shadowLayerPass = MainLoop::getInstance().renderManager->INTERNALgetActiveShadowLayerPass();
+
+	size_t numTriangles = 0;
+	glBindVertexArray(gridVAO);
+	for (const TerrainChunkSelection& chunk : chunks)
+	{
+		shader->setVec3("chunkOriginSize", glm::vec3(chunk.originX, chunk.originZ, chunk.size));
+		shader->setVec2("morphRange", quadtree.getMorphRange(chunk.lodLevel, modelMatrix, lodDistanceMultiplier));
+
+		const uint32_t firstIndex = (chunk.quadrant < 0) ? 0 : (uint32_t)chunk.quadrant * quadrantIndexCount;
+		const uint32_t indexCount = (chunk.quadrant < 0) ? quadrantIndexCount * 4 : quadrantIndexCount;
+		if (shadowLayerPass != nullptr)
+		{
+			// NOTE: the chunk's bounds just use the whole terrain's height range (close enough for picking the cascades)
+			const float quadrantSize = (chunk.quadrant < 0) ? (float)chunk.size : chunk.size * 0.5f;
+			const glm::vec2 quadrantOrigin = glm::vec2(chunk.originX, chunk.originZ) + ((chunk.quadrant < 0) ? glm::vec2(0.0f) : glm::vec2(chunk.quadrant % 2, chunk.quadrant / 2) * quadrantSize);
+			const glm::vec3 chunkMin(heightfieldBoundsMin.x + quadrantOrigin.x * heightfieldSampleSpacing.x, heightfieldBoundsMin.y, heightfieldBoundsMin.z + quadrantOrigin.y * heightfieldSampleSpacing.y);
+			const glm::vec3 chunkMax(chunkMin.x + quadrantSize * heightfieldSampleSpacing.x, heightfieldBoundsMax.y, chunkMin.z + quadrantSize * heightfieldSampleSpacing.y);
+			const RenderAABB chunkBounds = { (chunkMin + chunkMax) * 0.5f, (chunkMax - chunkMin) * 0.5f };
+			shadowLayerPass->drawElements(shader, chunkBounds, modelMatrix, GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(uint32_t)));
+		}
+		else
+			glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(uint32_t)));
+		numTriangles += indexCount / 3;
+	}
+	glBindVertexArray(0);
+
+	return numTriangles;
+}
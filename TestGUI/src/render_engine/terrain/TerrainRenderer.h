@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "TerrainQuadtree.h"
+
+typedef unsigned int GLuint;
+class Shader;
+class Material;
+class Mesh;
+class OcclusionCuller;
+struct ViewFrustum;
+struct ScenePickerMesh;
+
+
+//
+// CDLOD heightfield terrain. Every chunk is the same grid mesh that gets
+// displaced by the heightmap in the vertex shader (shader/src/terrain_cdlod.vert),
+// and the vertices morph into the next LOD's grid as they get farther away so
+// there's no popping or cracks between chunks.
+//
+// NOTE: the colour pass uses pbr.frag, so the material needs to be a PBRMaterial.
+// The texture coordinates are a planar projection over the whole heightfield.
+//
+class TerrainRenderer
+{
+public:
+	TerrainRenderer(const Heightfield& heightfield, Material* material, const TerrainQuadtreeSettings& settings = TerrainQuadtreeSettings());
+	~TerrainRenderer();
+
+	TerrainRenderer(const TerrainRenderer&) = delete;
+	TerrainRenderer& operator=(const TerrainRenderer&) = delete;
+
+	void render(const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, Shader* zPassShader, OcclusionCuller* occlusionCuller);		// Z prepass. Also adds itself to the opaque render queue
+	void INTERNALrenderOpaque();
+	void renderShadow(const glm::mat4& modelMatrix, Shader* shadowShader);
+	void submitOccluder(const glm::mat4& modelMatrix, const ViewFrustum* viewFrustum, OcclusionCuller* occlusionCuller);
+	void submitPickingMesh(const glm::mat4& modelMatrix, std::vector<ScenePickerMesh>& out_meshes);		// NOTE: this is the occluder grid, so it's a little under the real surface
+	void getLocalBounds(glm::vec3& out_minPoint, glm::vec3& out_maxPoint) const { out_minPoint = heightfieldBoundsMin; out_maxPoint = heightfieldBoundsMax; }
+
+	float lodDistanceMultiplier = 1.0f;				// > 1 keeps more detail
+	float shadowLODDistanceMultiplier = 0.5f;		// On top of lodDistanceMultiplier. Shadows can get away with coarser chunks
+
+	struct Stats
+	{
+		size_t numChunks;
+		size_t numShadowChunks;
+		size_t numTriangles;
+	} stats;
+
+private:
+	void refreshResources();
+	size_t drawChunks(Shader* shader, const std::vector<TerrainChunkSelection>& chunks, const glm::mat4& modelMatrix, float lodDistanceMultiplier);
+	void createShadowProxyAndOccluder(const Heightfield& heightfield);
+
+	TerrainQuadtree quadtree;
+	glm::vec2 heightfieldResolution;
+	glm::vec3 heightfieldBoundsMin;
+	glm::vec3 heightfieldBoundsMax;
+	glm::vec2 heightfieldSampleSpacing;
+
+	GLuint heightmapTexture = 0;
+	GLuint gridVAO = 0, gridVBO = 0, gridEBO = 0;
+	uint32_t quadrantIndexCount = 0;				// The grid's indices are split up into 4 quadrants, one after another (x + 2 * z)
+
+	Material* material;
+	Mesh* shadowProxyMesh = nullptr;				// Coarse regular mesh for shadow passes that don't have a terrain version (point lights)
+	std::vector<glm::vec3> occluderPositions;		// Coarse grid that's always under the real surface (so it never overoccludes)
+	std::vector<uint32_t> occluderIndices;
+
+	std::vector<TerrainChunkSelection> selection;	// From the z prepass, so that the opaque pass draws the exact same chunks (depth test is GL_EQUAL)
+	glm::mat4 selectionModelMatrix;
+	std::vector<TerrainChunkSelection> shadowSelection;
+
+	Shader* terrainShader;
+	Shader* terrainZPassShader;
+	Shader* terrainCSMShadowShader;
+	Shader* csmShadowShader;
+};
@@ -6,6 +6,7 @@
 
 #include "../mainloop/MainLoop.h"
 #include "../render_engine/render_manager/RenderManager.h"
+#include "../render_engine/model/Mesh.h"
 
 #include "../objects/BaseObject.h"
 #include "../objects/YosemiteTerrain.h"
@@ -164,6 +165,7 @@ void FileLoading::loadFileWithPrompt(bool withPrompt)
 	}
 
 	std::cout << "::Opening:: DONE!" << std::endl;
+	Mesh::reportMemoryStats();
 }
 
 void FileLoading::createObjectWithJson(nlohmann::json& object)
@@ -11,6 +11,7 @@
 
 #include "../render_engine/model/Mesh.h"
 #include "../mainloop/MainLoop.h"
+#include "../render_engine/render_manager/DebugDraw.h"
 
 
 namespace PhysicsUtils
@@ -378,34 +379,7 @@ namespace PhysicsUtils
 
 	void imguiRenderLine(glm::vec3 point1, glm::vec3 point2, ImU32 color)
 	{
-		//
-		// Convert to screen space
-		//
-		bool willBeOnScreen = true;
-		glm::vec3 pointsOnScreen[] = {
-			MainLoop::getInstance().camera.PositionToClipSpace(point1),
-			MainLoop::getInstance().camera.PositionToClipSpace(point2)
-		};
-		for (size_t ii = 0; ii < 2; ii++)
-		{
-			if (pointsOnScreen[ii].z < 0.0f)
-			{
-				// Short circuit bc it won't be on screen anymore
-				willBeOnScreen = false;
-				break;
-			}
-
-			pointsOnScreen[ii] /= pointsOnScreen[ii].z;
-			pointsOnScreen[ii].x = ImGui::GetWindowPos().x + pointsOnScreen[ii].x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointsOnScreen[ii].y = ImGui::GetWindowPos().y - pointsOnScreen[ii].y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-		}
-
-		if (!willBeOnScreen)
-			return;
-
-		ImVec2 screenSpacePoint1(pointsOnScreen[0].x, pointsOnScreen[0].y);
-		ImVec2 screenSpacePoint2(pointsOnScreen[1].x, pointsOnScreen[1].y);
-		ImGui::GetBackgroundDrawList()->AddLine(screenSpacePoint1, screenSpacePoint2, color, 1.0f);
+		DebugDraw::getInstance().addLine(point1, point2, color, 0.0f, false);
 	}
 
 	void imguiRenderRay(glm::vec3 origin, glm::vec3 direction, ImU32 color)
@@ -415,61 +389,7 @@ namespace PhysicsUtils
 
 	void imguiRenderBoxCollider(glm::mat4 modelMatrix, physx::PxBoxGeometry& boxGeometry, ImU32 color)
 	{
-		physx::PxVec3 halfExtents = boxGeometry.halfExtents;
-		std::vector<glm::vec4> points = {
-			modelMatrix * glm::vec4(halfExtents.x, halfExtents.y, halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(-halfExtents.x, halfExtents.y, halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(halfExtents.x, -halfExtents.y, halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(-halfExtents.x, -halfExtents.y, halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(halfExtents.x, halfExtents.y, -halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(-halfExtents.x, halfExtents.y, -halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(halfExtents.x, -halfExtents.y, -halfExtents.z, 1.0f),
-			modelMatrix * glm::vec4(-halfExtents.x, -halfExtents.y, -halfExtents.z, 1.0f),
-		};
-		std::vector<glm::vec3> screenSpacePoints;
-		unsigned int indices[4][4] = {
-			{0, 1, 2, 3},
-			{4, 5, 6, 7},
-			{0, 4, 2, 6},
-			{1, 5, 3, 7}
-		};
-		for (unsigned int i = 0; i < points.size(); i++)
-		{
-			//
-			// Convert to screen space
-			//
-			glm::vec3 point = glm::vec3(points[i]);
-			glm::vec3 pointOnScreen = MainLoop::getInstance().camera.PositionToClipSpace(point);
-			float clipZ = pointOnScreen.z;
-			pointOnScreen /= clipZ;
-			pointOnScreen.x = ImGui::GetWindowPos().x + pointOnScreen.x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointOnScreen.y = ImGui::GetWindowPos().y - pointOnScreen.y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-			pointOnScreen.z = clipZ;		// Reassign for test later
-			screenSpacePoints.push_back(pointOnScreen);
-		}
-
-		for (unsigned int i = 0; i < 4; i++)
-		{
-			//
-			// Draw quads if in the screen
-			//
-			glm::vec3 ssPoints[] = {
-				screenSpacePoints[indices[i][0]],
-				screenSpacePoints[indices[i][1]],
-				screenSpacePoints[indices[i][2]],
-				screenSpacePoints[indices[i][3]]
-			};
-			if (ssPoints[0].z < 0.0f || ssPoints[1].z < 0.0f || ssPoints[2].z < 0.0f || ssPoints[3].z < 0.0f) continue;
-
-			ImGui::GetBackgroundDrawList()->AddQuad(
-				ImVec2(ssPoints[0].x, ssPoints[0].y),
-				ImVec2(ssPoints[1].x, ssPoints[1].y),
-				ImVec2(ssPoints[3].x, ssPoints[3].y),
-				ImVec2(ssPoints[2].x, ssPoints[2].y),
-				color,
-				1.0f
-			);
-		}
+		DebugDraw::getInstance().addBox(modelMatrix, toGLMVec3(boxGeometry.halfExtents), color, 0.0f, false);
 	}
 
 	void imguiRenderSphereCollider(glm::mat4 modelMatrix, float radius)
@@ -502,55 +422,32 @@ namespace PhysicsUtils
 
 	void imguiRenderCircle(glm::mat4 modelMatrix, float radius, glm::vec3 eulerAngles, glm::vec3 offset, unsigned int numVertices, ImU32 color)
 	{
-		std::vector<glm::vec4> ringVertices;
+		std::vector<glm::vec3> ringVertices;
 		float angle = 0;
 		for (unsigned int i = 0; i < numVertices; i++)
 		{
 			// Set point
 			glm::vec4 point = glm::vec4(cosf(angle) * radius, sinf(angle) * radius, 0.0f, 1.0f);
-			ringVertices.push_back(modelMatrix * (glm::toMat4(glm::quat(eulerAngles)) * point + glm::vec4(offset, 0.0f)));
+			ringVertices.push_back(glm::vec3(modelMatrix * (glm::toMat4(glm::quat(eulerAngles)) * point + glm::vec4(offset, 0.0f))));
 
 			// Increment angle
 			angle += physx::PxTwoPi / (float)numVertices;
 		}
 
-		//
-		// Convert to screen space
-		//
-		std::vector<ImVec2> screenSpacePoints;
-		for (unsigned int i = 0; i < ringVertices.size(); i++)
-		{
-			glm::vec3 point = glm::vec3(ringVertices[i]);
-			glm::vec3 pointOnScreen = MainLoop::getInstance().camera.PositionToClipSpace(point);
-			float clipZ = pointOnScreen.z;
-			if (clipZ < 0.0f) return;							// NOTE: this is to break away from any rings that are intersecting with the near space
-
-			pointOnScreen /= clipZ;
-			pointOnScreen.x = ImGui::GetWindowPos().x + pointOnScreen.x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointOnScreen.y = ImGui::GetWindowPos().y - pointOnScreen.y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-			screenSpacePoints.push_back(ImVec2(pointOnScreen.x, pointOnScreen.y));
-		}
-
-		ImGui::GetBackgroundDrawList()->AddPolyline(
-			&screenSpacePoints[0],
-			(int)screenSpacePoints.size(),
-			color,
-			ImDrawFlags_Closed,
-			1.0f
-		);
+		DebugDraw::getInstance().addPolyline(ringVertices.data(), ringVertices.size(), true, color, 0.0f, false);
 	}
 
 	void imguiRenderSausage(glm::mat4 modelMatrix, float radius, float halfHeight, glm::vec3 eulerAngles, unsigned int numVertices)					// NOTE: this is very similar to the function imguiRenderCircle
 	{
 		assert(numVertices % 2 == 0);		// Needs to be even number of vertices to work
 
-		std::vector<glm::vec4> ringVertices;
+		std::vector<glm::vec3> ringVertices;
 		float angle = glm::radians(90.0f);
 		for (unsigned int i = 0; i <= numVertices / 2; i++)
 		{
 			// Set point
 			glm::vec4 point = glm::vec4(cosf(angle) * radius - halfHeight, sinf(angle) * radius, 0.0f, 1.0f);
-			ringVertices.push_back(modelMatrix * glm::toMat4(glm::quat(eulerAngles)) * point);
+			ringVertices.push_back(glm::vec3(modelMatrix * glm::toMat4(glm::quat(eulerAngles)) * point));
 
 			// Increment angle
 			if (i < numVertices / 2)
@@ -561,37 +458,14 @@ namespace PhysicsUtils
 		{
 			// Set point
 			glm::vec4 point = glm::vec4(cosf(angle) * radius + halfHeight, sinf(angle) * radius, 0.0f, 1.0f);
-			ringVertices.push_back(modelMatrix * glm::toMat4(glm::quat(eulerAngles)) * point);
+			ringVertices.push_back(glm::vec3(modelMatrix * glm::toMat4(glm::quat(eulerAngles)) * point));
 
 			// Increment angle
 			if (i < numVertices / 2)
 				angle += physx::PxTwoPi / (float)numVertices;
 		}
 
-		//
-		// Convert to screen space
-		//
-		std::vector<ImVec2> screenSpacePoints;
-		for (unsigned int i = 0; i < ringVertices.size(); i++)
-		{
-			glm::vec3 point = glm::vec3(ringVertices[i]);
-			glm::vec3 pointOnScreen = MainLoop::getInstance().camera.PositionToClipSpace(point);
-			float clipZ = pointOnScreen.z;
-			if (clipZ < 0.0f) return;							// NOTE: this is to break away from any rings that are intersecting with the near space
-
-			pointOnScreen /= clipZ;
-			pointOnScreen.x = ImGui::GetWindowPos().x + pointOnScreen.x * MainLoop::getInstance().camera.width / 2 + MainLoop::getInstance().camera.width / 2;
-			pointOnScreen.y = ImGui::GetWindowPos().y - pointOnScreen.y * MainLoop::getInstance().camera.height / 2 + MainLoop::getInstance().camera.height / 2;
-			screenSpacePoints.push_back(ImVec2(pointOnScreen.x, pointOnScreen.y));
-		}
-
-		ImGui::GetBackgroundDrawList()->AddPolyline(
-			&screenSpacePoints[0],
-			(int)screenSpacePoints.size(),
-			ImColor::HSV(0.39f, 0.88f, 0.92f),
-			ImDrawFlags_Closed,
-			1.0f
-		);
+		DebugDraw::getInstance().addPolyline(ringVertices.data(), ringVertices.size(), true, ImColor::HSV(0.39f, 0.88f, 0.92f), 0.0f, false);
 	}
 
 #pragma endregion
@@ -83,6 +83,7 @@ namespace PhysicsUtils
 
 #pragma region imgui draw functions
 
+	// NOTE: these all go thru DebugDraw now (w/o the depth test, so they still draw over everything like they did w/ imgui)
 	void imguiRenderLine(glm::vec3 point1, glm::vec3 point2, ImU32 color = ImColor::HSV(0.39f, 0.88f, 0.92f));
 
 	void imguiRenderRay(glm::vec3 origin, glm::vec3 direction, ImU32 color = ImColor::HSV(0.39f, 0.88f, 0.92f));		// @NOTE: the direction does not have to be normalized.
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+
+//
+// A handle into a SlotMap. Stays the same for as long as the thing it points to is
+// alive, no matter what else gets added or removed.
+//
+struct SlotMapHandle
+{
+	static constexpr uint32_t NO_INDEX = (uint32_t)-1;
+
+	uint32_t index = NO_INDEX;
+	uint32_t generation = 0;
+
+	inline bool operator==(const SlotMapHandle& other) const { return index == other.index && generation == other.generation; }
+	inline bool operator!=(const SlotMapHandle& other) const { return !(*this == other); }
+};
+
+
+//
+// Storage for stuff that gets added and removed all the time (objects and their components).
+// All the values are packed together in one vector, so iterating is just going down the
+// vector, and removing moves the last value into the hole (so it's O(1), but the order
+// changes). Handles go thru a slot that keeps track of where the value ended up.
+//
+// Every time a slot gets freed its generation goes up, so a handle to something that got
+// removed doesn't match anymore (get() gives back nullptr) even after the slot gets reused.
+//
+// NOTE: the dense indices (operator[], size()) are only good until the next remove. Hold onto handles instead.
+//
+template<typename T>
+class SlotMap
+{
+public:
+	static constexpr size_t NO_DENSE_INDEX = (size_t)-1;
+
+	SlotMapHandle add(const T& value)
+	{
+		uint32_t slotIndex;
+		if (freeListHead != SlotMapHandle::NO_INDEX)
+		{
+			slotIndex = freeListHead;
+			freeListHead = slots[slotIndex].denseIndexOrNextFree;
+		}
+		else
+		{
+			slotIndex = (uint32_t)slots.size();
+			slots.push_back({ 0, 1 });		// NOTE: generations start at 1 so that a default handle never matches anything
+		}
+
+		Slot& slot = slots[slotIndex];
+		slot.denseIndexOrNextFree = (uint32_t)values.size();
+		values.push_back(value);
+		denseToSlot.push_back(slotIndex);
+		return { slotIndex, slot.generation };
+	}
+
+	bool remove(SlotMapHandle handle)
+	{
+		if (!contains(handle))
+			return false;
+
+		// Swap n pop
+		Slot& slot = slots[handle.index];
+		const uint32_t denseIndex = slot.denseIndexOrNextFree;
+		const uint32_t lastDenseIndex = (uint32_t)values.size() - 1;
+		if (denseIndex != lastDenseIndex)
+		{
+			values[denseIndex] = std::move(values[lastDenseIndex]);
+			denseToSlot[denseIndex] = denseToSlot[lastDenseIndex];
+			slots[denseToSlot[denseIndex]].denseIndexOrNextFree = denseIndex;
+		}
+		values.pop_back();
+		denseToSlot.pop_back();
+
+		slot.generation++;
+		slot.denseIndexOrNextFree = freeListHead;
+		freeListHead = handle.index;
+		return true;
+	}
+
+	void clear()
+	{
+		for (size_t i = 0; i < denseToSlot.size(); i++)
+		{
+			Slot& slot = slots[denseToSlot[i]];
+			slot.generation++;
+			slot.denseIndexOrNextFree = freeListHead;
+			freeListHead = denseToSlot[i];
+		}
+		values.clear();
+		denseToSlot.clear();
+	}
+
+	inline bool contains(SlotMapHandle handle) const
+	{
+		return handle.index < slots.size() &&
+			slots[handle.index].generation == handle.generation;
+	}
+
+	// nullptr if the handle's stale
+	inline T* get(SlotMapHandle handle)
+	{
+		return contains(handle) ? &values[slots[handle.index].denseIndexOrNextFree] : nullptr;
+	}
+
+	inline size_t getDenseIndex(SlotMapHandle handle) const
+	{
+		return contains(handle) ? (size_t)slots[handle.index].denseIndexOrNextFree : NO_DENSE_INDEX;
+	}
+
+	inline SlotMapHandle getHandle(size_t denseIndex) const
+	{
+		const uint32_t slotIndex = denseToSlot[denseIndex];
+		return { slotIndex, slots[slotIndex].generation };
+	}
+
+	//
+	// Dense iteration
+	//
+	inline size_t size() const { return values.size(); }
+	inline bool empty() const { return values.empty(); }
+	inline T& operator[](size_t denseIndex) { return values[denseIndex]; }
+	inline const T& operator[](size_t denseIndex) const { return values[denseIndex]; }
+	inline const std::vector<T>& getValues() const { return values; }
+
+	inline typename std::vector<T>::iterator begin() { return values.begin(); }
+	inline typename std::vector<T>::iterator end() { return values.end(); }
+	inline typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+	inline typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+	struct Slot
+	{
+		uint32_t denseIndexOrNextFree;		// Where the value is if the slot's in use, otherwise the next slot in the free list
+		uint32_t generation;
+	};
+	std::vector<Slot> slots;
+	uint32_t freeListHead = SlotMapHandle::NO_INDEX;
+
+	std::vector<T> values;
+	std::vector<uint32_t> denseToSlot;
+};
@@ -0,0 +1,135 @@
+#include "TestCommon.h"
+#include "../src/render_engine/render_manager/CloudDensityBounds.h"
+#include "../src/render_engine/render_manager/CloudNoiseGenerator.h"
+
+#include <random>
+
+
+namespace
+{
+	// CPU version of sampling cloudNoiseTexture w/ GL_LINEAR and GL_REPEAT, then weighting it like sampleDensityAtPoint()
+	float sampleWeightedDensity(const std::vector<uint8_t>& noiseRGBA, uint32_t noiseSize, float u, float v, float w)
+	{
+		auto wrap = [noiseSize](int64_t coord) { return (uint32_t)(((coord % noiseSize) + noiseSize) % noiseSize); };
+
+		const float texelCoords[3] = { u * noiseSize - 0.5f, v * noiseSize - 0.5f, w * noiseSize - 0.5f };
+		int64_t base[3];
+		float fraction[3];
+		for (int i = 0; i < 3; i++)
+		{
+			base[i] = (int64_t)std::floor(texelCoords[i]);
+			fraction[i] = texelCoords[i] - (float)base[i];
+		}
+
+		float channels[4] = {};
+		for (int corner = 0; corner < 8; corner++)
+		{
+			const int dx = corner & 1, dy = (corner >> 1) & 1, dz = (corner >> 2) & 1;
+			const float weight =
+				(dx ? fraction[0] : 1.0f - fraction[0]) *
+				(dy ? fraction[1] : 1.0f - fraction[1]) *
+				(dz ? fraction[2] : 1.0f - fraction[2]);
+			const size_t index = ((size_t)wrap(base[2] + dz) * noiseSize + wrap(base[1] + dy)) * noiseSize + wrap(base[0] + dx);
+			for (int channel = 0; channel < 4; channel++)
+				channels[channel] += weight * noiseRGBA[index * 4 + channel];
+		}
+
+		return (0.5333333f * channels[0] + 0.2666667f * channels[1] + 0.1333333f * channels[2] + 0.0666667f * channels[3]) / 255.0f;
+	}
+
+	// Same lookup as the shader (texelFetch() of the cell the point's in)
+	float getBound(const std::vector<uint8_t>& bounds, uint32_t boundsSize, float u, float v, float w)
+	{
+		const uint32_t cx = std::min(boundsSize - 1, (uint32_t)(u * boundsSize));
+		const uint32_t cy = std::min(boundsSize - 1, (uint32_t)(v * boundsSize));
+		const uint32_t cz = std::min(boundsSize - 1, (uint32_t)(w * boundsSize));
+		return bounds[((size_t)cz * boundsSize + cy) * boundsSize + cx] / 255.0f;
+	}
+}
+
+
+TEST(cloud_density_bounds_single_texel_reaches_its_neighbor_cells)
+{
+	constexpr uint32_t noiseSize = 16, cellSize = 4, boundsSize = noiseSize / cellSize;
+	std::vector<uint8_t> noiseRGBA((size_t)noiseSize * noiseSize * noiseSize * 4, 0);
+
+	// Right on the edge of cell (1, 1, 1), so linear filtering bleeds it into cell (0, 1, 1) too
+	const size_t hotIndex = ((size_t)5 * noiseSize + 5) * noiseSize + 4;
+	for (int channel = 0; channel < 4; channel++)
+		noiseRGBA[hotIndex * 4 + channel] = 255;
+
+	std::vector<uint8_t> bounds;
+	CloudDensityBounds::generate(noiseRGBA.data(), noiseSize, cellSize, bounds);
+	CHECK(bounds.size() == (size_t)boundsSize * boundsSize * boundsSize);
+
+	auto getCell = [&](uint32_t x, uint32_t y, uint32_t z) { return bounds[((size_t)z * boundsSize + y) * boundsSize + x]; };
+	CHECK(getCell(1, 1, 1) == 255);
+	CHECK(getCell(0, 1, 1) == 255);
+	CHECK(getCell(2, 1, 1) == 0);
+	CHECK(getCell(3, 3, 3) == 0);
+}
+
+TEST(cloud_density_bounds_wrap_around)
+{
+	constexpr uint32_t noiseSize = 16, cellSize = 4, boundsSize = noiseSize / cellSize;
+	std::vector<uint8_t> noiseRGBA((size_t)noiseSize * noiseSize * noiseSize * 4, 0);
+
+	// The very last texel gets filtered into the very first cell (GL_REPEAT)
+	const size_t lastIndex = (size_t)noiseSize * noiseSize * noiseSize - 1;
+	noiseRGBA[lastIndex * 4] = 255;
+
+	std::vector<uint8_t> bounds;
+	CloudDensityBounds::generate(noiseRGBA.data(), noiseSize, cellSize, bounds);
+	CHECK(bounds[0] > 0);
+	CHECK(bounds[bounds.size() - 1] > 0);
+	CHECK(bounds[((size_t)1 * boundsSize + 1) * boundsSize + 1] == 0);
+}
+
+TEST(cloud_density_bounds_are_conservative_for_worley_noise)
+{
+	CloudNoiseVolumeParams params = { 32, 4, { { 3, 7, 11 }, { 9, 20, 33 }, { 12, 24, 40 }, { 20, 35, 49 } }, 1 };
+	std::vector<uint8_t> noiseRGBA;
+	CloudNoiseGenerator::generate(params, noiseRGBA, 2);
+	CHECK(noiseRGBA.size() == (size_t)32 * 32 * 32 * 4);
+
+	constexpr uint32_t cellSize = 4, boundsSize = 32 / cellSize;
+	std::vector<uint8_t> bounds;
+	CloudDensityBounds::generate(noiseRGBA.data(), params.size, cellSize, bounds);
+
+	// Anywhere the raymarcher could sample (incl. right on the cell edges), the filtered density can't go over the cell's bound
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	size_t numOverBound = 0;
+	for (int i = 0; i < 200000; i++)
+	{
+		float uvw[3] = { distribution(random), distribution(random), distribution(random) };
+		if (i % 4 == 0)
+			uvw[i % 3] = std::floor(uvw[i % 3] * boundsSize) / boundsSize;		// Snap onto a cell boundary
+
+		const float density = sampleWeightedDensity(noiseRGBA, params.size, uvw[0], uvw[1], uvw[2]);
+		const float bound = getBound(bounds, boundsSize, uvw[0], uvw[1], uvw[2]);
+		if (density > bound + 1e-5f)
+			numOverBound++;
+	}
+	CHECK(numOverBound == 0);
+
+	// Not just saying 1 everywhere either
+	size_t numBelowMax = 0;
+	for (uint8_t bound : bounds)
+		if (bound < 255)
+			numBelowMax++;
+	CHECK(numBelowMax > 0);
+}
+
+TEST(cloud_density_bounds_round_up)
+{
+	// 1 on just the alpha channel is 0.0666667/255 of density, which is way under 1/255. The bound can't round that down to 0
+	constexpr uint32_t noiseSize = 8, cellSize = 8;
+	std::vector<uint8_t> noiseRGBA((size_t)noiseSize * noiseSize * noiseSize * 4, 0);
+	noiseRGBA[3] = 1;
+
+	std::vector<uint8_t> bounds;
+	CloudDensityBounds::generate(noiseRGBA.data(), noiseSize, cellSize, bounds);
+	CHECK(bounds.size() == 1);
+	CHECK(bounds[0] == 1);
+}
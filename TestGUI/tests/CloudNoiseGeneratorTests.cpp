@@ -0,0 +1,176 @@
+#include "TestCommon.h"
+#include "../src/render_engine/render_manager/CloudNoiseGenerator.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+
+namespace
+{
+	//
+	// Brute force reference: every texel checks every feature point (w/ the closest wrapped
+	// around copy of it), instead of just the neighboring cells.
+	// @Copypasta: the feature point hashing in CloudNoiseGenerator.cpp
+	//
+	uint64_t splitmix64(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	float randomFloat01(uint64_t& state)
+	{
+		return (float)(splitmix64(state) >> 40) * (1.0f / 16777216.0f);
+	}
+
+	// Smallest square distance along one axis to the point in cell `cell`, out of it and its wrapped around copies
+	float closestAxisDistanceSqr(float position, int32_t cell, float pointOffset, int32_t gridSize)
+	{
+		float closest = 1e30f;
+		for (int32_t shift = -1; shift <= 1; shift++)
+		{
+			const float delta = position - ((float)(cell + shift * gridSize) + pointOffset);
+			closest = std::min(closest, delta * delta);
+		}
+		return closest;
+	}
+
+	void generateBruteForce(const CloudNoiseVolumeParams& params, std::vector<uint8_t>& out_texels)
+	{
+		constexpr float octaveWeights[CloudNoiseVolumeParams::NUM_OCTAVES] = { 0.5333333f, 0.2666667f, 0.1333333f };
+		const uint32_t size = params.size;
+		out_texels.assign((size_t)size * size * size * params.numChannels, 0);
+
+		for (uint32_t channel = 0; channel < params.numChannels; channel++)
+		{
+			std::vector<uint8_t> octaves[CloudNoiseVolumeParams::NUM_OCTAVES];
+			for (uint32_t octave = 0; octave < CloudNoiseVolumeParams::NUM_OCTAVES; octave++)
+			{
+				const int32_t gridSize = (int32_t)std::max(1u, params.octaveGridSizes[channel][octave]);
+				const size_t numCells = (size_t)gridSize * gridSize * gridSize;
+				std::vector<float> pointsX(numCells), pointsY(numCells), pointsZ(numCells);
+				uint64_t state = ((uint64_t)params.seed << 32) ^ ((uint64_t)channel << 8) ^ (uint64_t)octave;
+				for (size_t i = 0; i < numCells; i++)
+				{
+					pointsX[i] = randomFloat01(state);
+					pointsY[i] = randomFloat01(state);
+					pointsZ[i] = randomFloat01(state);
+				}
+
+				octaves[octave].resize((size_t)size * size * size);
+				for (uint32_t z = 0; z < size; z++)
+				for (uint32_t y = 0; y < size; y++)
+				for (uint32_t x = 0; x < size; x++)
+				{
+					const float positionX = ((float)x + 0.5f) / (float)size * (float)gridSize;
+					const float positionY = ((float)y + 0.5f) / (float)size * (float)gridSize;
+					const float positionZ = ((float)z + 0.5f) / (float)size * (float)gridSize;
+
+					float minDistanceSqr = 1.0f;
+					for (int32_t cz = 0; cz < gridSize; cz++)
+					for (int32_t cy = 0; cy < gridSize; cy++)
+					for (int32_t cx = 0; cx < gridSize; cx++)
+					{
+						const size_t cellIndex = ((size_t)cz * gridSize + cy) * gridSize + cx;
+						const float deltaYZSqr = closestAxisDistanceSqr(positionY, cy, pointsY[cellIndex], gridSize) + closestAxisDistanceSqr(positionZ, cz, pointsZ[cellIndex], gridSize);
+						minDistanceSqr = std::min(minDistanceSqr, closestAxisDistanceSqr(positionX, cx, pointsX[cellIndex], gridSize) + deltaYZSqr);
+					}
+
+					const float value = 1.0f - std::clamp(std::sqrt(minDistanceSqr) * 1.25f, 0.0f, 1.0f);
+					octaves[octave][((size_t)z * size + y) * size + x] = (uint8_t)std::lround(value * 255.0f);
+				}
+			}
+
+			for (size_t i = 0; i < (size_t)size * size * size; i++)
+			{
+				float value = 0.0f;
+				for (uint32_t octave = 0; octave < CloudNoiseVolumeParams::NUM_OCTAVES; octave++)
+					value += octaveWeights[octave] * ((float)octaves[octave][i] / 255.0f);
+				out_texels[i * params.numChannels + channel] = (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+			}
+		}
+	}
+
+	// NOTE: the last channel has more cells than there are texels, so some cells don't have any texels in them
+	const CloudNoiseVolumeParams testParams = { 16, 3, { { 3, 7, 11 }, { 2, 5, 13 }, { 6, 17, 24 } }, 7 };
+
+	std::string getTestCachePath()
+	{
+		return (std::filesystem::temp_directory_path() / "solanine_tests" / "cloud_noise_test.cldn").string();
+	}
+}
+
+
+TEST(cloud_noise_neighbor_search_matches_brute_force)
+{
+	std::vector<uint8_t> texels, reference;
+	CloudNoiseGenerator::generate(testParams, texels, 1);
+	generateBruteForce(testParams, reference);
+
+	CHECK(texels.size() == reference.size());
+	size_t numDifferent = 0;
+	for (size_t i = 0; i < std::min(texels.size(), reference.size()); i++)
+		if (texels[i] != reference[i])
+			numDifferent++;
+	CHECK(numDifferent == 0);
+
+	// And it's actually noise, not all 0's or something
+	CHECK(*std::max_element(texels.begin(), texels.end()) > 128);
+	CHECK(*std::min_element(texels.begin(), texels.end()) < 64);
+}
+
+TEST(cloud_noise_is_the_same_w_any_number_of_threads)
+{
+	std::vector<uint8_t> singleThreaded, multiThreaded;
+	CloudNoiseGenerator::generate(testParams, singleThreaded, 1);
+	CloudNoiseGenerator::generate(testParams, multiThreaded, 5);
+	CHECK(singleThreaded == multiThreaded);
+
+	// Same params, same noise
+	std::vector<uint8_t> again;
+	CloudNoiseGenerator::generate(testParams, again, 0);
+	CHECK(singleThreaded == again);
+}
+
+TEST(cloud_noise_hash_changes_w_the_params)
+{
+	const uint64_t hash = CloudNoiseGenerator::hashParams(testParams);
+	CHECK(hash == CloudNoiseGenerator::hashParams(testParams));
+
+	CloudNoiseVolumeParams otherSeed = testParams;
+	otherSeed.seed++;
+	CHECK(hash != CloudNoiseGenerator::hashParams(otherSeed));
+
+	CloudNoiseVolumeParams otherGrid = testParams;
+	otherGrid.octaveGridSizes[2][1]++;
+	CHECK(hash != CloudNoiseGenerator::hashParams(otherGrid));
+}
+
+TEST(cloud_noise_cache_round_trip)
+{
+	const std::string cachePath = getTestCachePath();
+	const uint64_t hash = CloudNoiseGenerator::hashParams(testParams);
+
+	std::vector<uint8_t> texels;
+	CloudNoiseGenerator::generate(testParams, texels);
+	CHECK(CloudNoiseGenerator::saveToFile(cachePath, hash, testParams, texels));
+
+	std::vector<uint8_t> loaded;
+	CHECK(CloudNoiseGenerator::loadFromFile(cachePath, hash, testParams, loaded));
+	CHECK(loaded == texels);
+
+	// Different params can't load it
+	CloudNoiseVolumeParams otherSeed = testParams;
+	otherSeed.seed++;
+	CHECK(!CloudNoiseGenerator::loadFromFile(cachePath, CloudNoiseGenerator::hashParams(otherSeed), otherSeed, loaded));
+
+	// Cut short
+	std::filesystem::resize_file(cachePath, std::filesystem::file_size(cachePath) - 100);
+	CHECK(!CloudNoiseGenerator::loadFromFile(cachePath, hash, testParams, loaded));
+
+	std::filesystem::remove(cachePath);
+	CHECK(!CloudNoiseGenerator::loadFromFile(cachePath, hash, testParams, loaded));
+}
@@ -0,0 +1,99 @@
+#include "TestCommon.h"
+#include "../src/render_engine/render_manager/DynamicResolution.h"
+
+
+namespace
+{
+	DynamicResolutionController createEnabledController()
+	{
+		DynamicResolutionController controller;
+		controller.settings.enabled = true;
+		controller.reset();
+		return controller;
+	}
+
+	// Returns which frame (starting at 1) the scale changed on, or 0 if it didn't
+	uint32_t feedUntilChange(DynamicResolutionController& controller, float gpuFrameTimeMs, uint32_t maxFrames)
+	{
+		for (uint32_t i = 1; i <= maxFrames; i++)
+			if (controller.update(gpuFrameTimeMs))
+				return i;
+		return 0;
+	}
+}
+
+
+TEST(dynamic_resolution_is_off_by_default)
+{
+	DynamicResolutionController controller;
+	CHECK(!controller.settings.enabled);
+	CHECK(feedUntilChange(controller, 100.0f, 200) == 0);
+	CHECK(controller.getRenderScale() == 1.0f);
+}
+
+TEST(dynamic_resolution_steady_at_target_doesnt_change)
+{
+	DynamicResolutionController controller = createEnabledController();
+	CHECK(feedUntilChange(controller, 16.0f, 500) == 0);
+	CHECK(controller.getRenderScale() == 1.0f);
+}
+
+TEST(dynamic_resolution_over_budget_jumps_to_the_ideal_scale)
+{
+	DynamicResolutionController controller = createEnabledController();
+
+	// 2x over the target means half the pixels, so ~0.71 on each axis. Snapped to 0.05's
+	CHECK(feedUntilChange(controller, 33.2f, 100) == controller.settings.framesBeforeChange);
+	CHECK_NEAR(controller.getRenderScale(), 0.7f, 0.001f);
+
+	// The smoothed time gets guessed for the new scale, so it's right around the target now
+	CHECK_NEAR(controller.getSmoothedFrameTimeMs(), 33.2f * 0.7f * 0.7f, 0.01f);
+}
+
+TEST(dynamic_resolution_cooldown_holds_the_scale)
+{
+	DynamicResolutionController controller = createEnabledController();
+	CHECK(feedUntilChange(controller, 33.2f, 100) != 0);
+	const float scaleAfterDrop = controller.getRenderScale();
+
+	// Still over budget, but it has to wait out the cooldown plus framesBeforeChange again
+	const uint32_t changedOn = feedUntilChange(controller, 100.0f, 1000);
+	CHECK(changedOn > controller.settings.cooldownFrames);
+	CHECK(controller.getRenderScale() < scaleAfterDrop);
+}
+
+TEST(dynamic_resolution_under_budget_goes_up_one_step_at_a_time)
+{
+	DynamicResolutionController controller = createEnabledController();
+	controller.reset(0.5f);
+
+	CHECK(feedUntilChange(controller, 4.0f, 100) == controller.settings.framesBeforeChange);
+	CHECK_NEAR(controller.getRenderScale(), 0.55f, 0.001f);
+
+	CHECK(feedUntilChange(controller, 4.0f, 100) != 0);
+	CHECK_NEAR(controller.getRenderScale(), 0.6f, 0.001f);
+}
+
+TEST(dynamic_resolution_stays_in_bounds)
+{
+	DynamicResolutionController controller = createEnabledController();
+	for (int i = 0; i < 1000; i++)
+		controller.update(500.0f);
+	CHECK_NEAR(controller.getRenderScale(), controller.settings.minRenderScale, 0.001f);
+
+	for (int i = 0; i < 5000; i++)
+		controller.update(1.0f);
+	CHECK_NEAR(controller.getRenderScale(), controller.settings.maxRenderScale, 0.001f);
+}
+
+TEST(dynamic_resolution_turning_it_off_goes_back_to_native)
+{
+	DynamicResolutionController controller = createEnabledController();
+	CHECK(feedUntilChange(controller, 50.0f, 100) != 0);
+	CHECK(controller.getRenderScale() < 1.0f);
+
+	controller.settings.enabled = false;
+	CHECK(controller.update(50.0f));
+	CHECK(controller.getRenderScale() == 1.0f);
+	CHECK(!controller.update(50.0f));
+}
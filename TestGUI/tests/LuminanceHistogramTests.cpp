@@ -0,0 +1,201 @@
+#include "TestCommon.h"
+
+#include <algorithm>
+#include <random>
+
+
+//
+// The luminance histogram lives in luminance_reduction.comp, so there's nothing on the
+// CPU to link against. These are ports of the shader's math (keep them in sync w/ it)
+// checked against just sorting all of the samples.
+//
+namespace
+{
+	constexpr uint32_t NUM_HISTOGRAM_BINS = 256;
+	constexpr uint32_t NUM_SAMPLES = 64 * 64;		// SAMPLE_GRID_SIZE^2
+
+	struct HistogramSettings
+	{
+		float logLuminanceMin = -16.0f, logLuminanceMax = 8.0f;		// Same defaults as RenderManager
+		float lowPercentile = 0.5f, highPercentile = 0.95f;
+	};
+
+	// @Copypasta: getHistogramBin() in luminance_reduction.comp
+	uint32_t getHistogramBin(float luminance, const HistogramSettings& settings)
+	{
+		const float t = (std::log2(std::max(luminance, 1e-10f)) - settings.logLuminanceMin) / (settings.logLuminanceMax - settings.logLuminanceMin);
+		return (uint32_t)std::clamp(t * (float)(NUM_HISTOGRAM_BINS - 1), 0.0f, (float)(NUM_HISTOGRAM_BINS - 1));
+	}
+
+	// @Copypasta: getHistogramBinLuminance() in luminance_reduction.comp
+	float getHistogramBinLuminance(uint32_t bin, const HistogramSettings& settings)
+	{
+		const float t = ((float)bin + 0.5f) / (float)(NUM_HISTOGRAM_BINS - 1);
+		return std::exp2(settings.logLuminanceMin + (settings.logLuminanceMax - settings.logLuminanceMin) * t);
+	}
+
+	// @Copypasta: the end of main() in luminance_reduction.comp (w/o the adaptation)
+	float getShaderAverageLuminance(const std::vector<float>& samples, bool useHistogram, const HistogramSettings& settings)
+	{
+		uint32_t histogram[NUM_HISTOGRAM_BINS] = {};
+		float sum = 0.0f;
+		for (float luminance : samples)
+		{
+			sum += luminance;
+			histogram[getHistogramBin(luminance, settings)]++;
+		}
+
+		const float numSamples = (float)samples.size();
+		float lumCurr = sum / numSamples;
+		if (!useHistogram)
+			return lumCurr;
+
+		const float lowCount = settings.lowPercentile * numSamples;
+		const float highCount = settings.highPercentile * numSamples;
+		float runningCount = 0.0f;
+		float weightedSum = 0.0f;
+		float totalWeight = 0.0f;
+		for (uint32_t bin = 0; bin < NUM_HISTOGRAM_BINS; bin++)
+		{
+			const float binCount = (float)histogram[bin];
+			const float countInRange = std::clamp(runningCount + binCount, lowCount, highCount) - std::clamp(runningCount, lowCount, highCount);
+			weightedSum += countInRange * getHistogramBinLuminance(bin, settings);
+			totalWeight += countInRange;
+			runningCount += binCount;
+		}
+
+		if (totalWeight > 0.0f)
+			lumCurr = weightedSum / totalWeight;
+		return lumCurr;
+	}
+
+	// @Copypasta: the adaptation at the end of luminance_reduction.comp (and luminance_adaptation.comp)
+	float adapt(float lumPrev, float lumCurr, float adaptationSpeedDown, float adaptationSpeedUp)
+	{
+		const float adaptationSpeedChosen = (lumPrev > lumCurr) ? adaptationSpeedDown : adaptationSpeedUp;
+		return std::max(lumPrev + (lumCurr - lumPrev) * (1.0f - std::pow(0.98f, 30.0f * adaptationSpeedChosen)), 0.0f);
+	}
+
+	//
+	// Reference: sort everything and average the samples between the percentiles (partial samples at the ends count partially)
+	//
+	float getReferencePercentileMean(std::vector<float> samples, const HistogramSettings& settings)
+	{
+		std::sort(samples.begin(), samples.end());
+		const double lowCount = settings.lowPercentile * samples.size();
+		const double highCount = settings.highPercentile * samples.size();
+
+		double weightedSum = 0.0, totalWeight = 0.0;
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			const double countInRange = std::clamp((double)i + 1.0, lowCount, highCount) - std::clamp((double)i, lowCount, highCount);
+			weightedSum += countInRange * samples[i];
+			totalWeight += countInRange;
+		}
+		return (float)(weightedSum / totalWeight);
+	}
+
+	// Mostly log-uniform around some exposure, w/ some black/dark corners and bright sky mixed in
+	// NOTE: everything stays inside of the default log2 range. Past it gets clamped into the end bins (see the out of range test)
+	std::vector<float> makeRandomScene(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> sceneExposure(-8.0f, 0.0f);
+		std::uniform_real_distribution<float> spread(0.5f, 4.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const float centerLog = sceneExposure(random);
+		const float spreadLog = spread(random);
+		const float skyFraction = unit(random) * 0.3f;
+		const float darkFraction = unit(random) * 0.2f;
+
+		std::vector<float> samples(NUM_SAMPLES);
+		for (float& sample : samples)
+		{
+			const float roll = unit(random);
+			if (roll < skyFraction)
+				sample = std::exp2(centerLog + 6.0f + unit(random));
+			else if (roll < skyFraction + darkFraction)
+				sample = (unit(random) < 0.5f) ? 0.0f : std::exp2(centerLog - 6.0f - unit(random));
+			else
+				sample = std::exp2(centerLog + (unit(random) * 2.0f - 1.0f) * spreadLog);
+		}
+		return samples;
+	}
+}
+
+
+TEST(luminance_histogram_matches_sorted_percentile_mean)
+{
+	// The only error should be from snapping each sample to its bin's center. That's half a bin at most (in log2)
+	const HistogramSettings settings;
+	const float halfBinLog2 = 0.5f * (settings.logLuminanceMax - settings.logLuminanceMin) / (float)(NUM_HISTOGRAM_BINS - 1);
+	const float maxRelativeError = std::exp2(halfBinLog2) - 1.0f;
+
+	std::mt19937 random(46);
+	float worstRelativeError = 0.0f;
+	for (int scene = 0; scene < 200; scene++)
+	{
+		const std::vector<float> samples = makeRandomScene(random);
+		const float histogramMean = getShaderAverageLuminance(samples, true, settings);
+		const float referenceMean = getReferencePercentileMean(samples, settings);
+		worstRelativeError = std::max(worstRelativeError, std::abs(histogramMean - referenceMean) / referenceMean);
+	}
+	CHECK(worstRelativeError <= maxRelativeError);
+}
+
+TEST(luminance_histogram_single_luminance)
+{
+	const HistogramSettings settings;
+	for (float luminance : { 0.001f, 0.18f, 1.0f, 37.0f })
+	{
+		const std::vector<float> samples(NUM_SAMPLES, luminance);
+		const float histogramMean = getShaderAverageLuminance(samples, true, settings);
+		CHECK(std::abs(std::log2(histogramMean) - std::log2(luminance)) <= (settings.logLuminanceMax - settings.logLuminanceMin) / (float)(NUM_HISTOGRAM_BINS - 1));
+		CHECK_NEAR(getShaderAverageLuminance(samples, false, settings), luminance, luminance * 1e-4f);
+	}
+}
+
+TEST(luminance_histogram_ignores_a_patch_of_sky)
+{
+	// 10% of the screen is really bright sky. The plain mean gets dragged way up, but it's all above the 85th percentile
+	HistogramSettings settings;
+	settings.highPercentile = 0.85f;
+	std::vector<float> samples(NUM_SAMPLES, 0.1f);
+	for (size_t i = 0; i < NUM_SAMPLES / 10; i++)
+		samples[i] = 1000.0f;
+
+	CHECK(getShaderAverageLuminance(samples, false, settings) > 50.0f);
+	CHECK_NEAR(getShaderAverageLuminance(samples, true, settings), 0.1f, 0.1f * 0.05f);
+}
+
+TEST(luminance_histogram_out_of_range_and_black)
+{
+	const HistogramSettings settings;
+	CHECK(getHistogramBin(0.0f, settings) == 0);
+	CHECK(getHistogramBin(std::exp2(settings.logLuminanceMin - 4.0f), settings) == 0);
+	CHECK(getHistogramBin(std::exp2(settings.logLuminanceMax + 4.0f), settings) == NUM_HISTOGRAM_BINS - 1);
+	CHECK(getHistogramBin(1e30f, settings) == NUM_HISTOGRAM_BINS - 1);
+
+	// The percentiles being the same means nothing's in range, so it falls back to the mean
+	HistogramSettings samePercentiles;
+	samePercentiles.lowPercentile = samePercentiles.highPercentile = 0.5f;
+	const std::vector<float> samples(NUM_SAMPLES, 2.0f);
+	CHECK_NEAR(getShaderAverageLuminance(samples, true, samePercentiles), 2.0f, 1e-4f);
+}
+
+TEST(luminance_adaptation_moves_towards_the_target)
+{
+	// Speeds are the defaults * a 60fps deltaTime (see RenderManager)
+	const float speedDown = 1.5f / 60.0f, speedUp = 2.5f / 60.0f;
+
+	const float brighter = adapt(0.2f, 1.0f, speedDown, speedUp);
+	CHECK(brighter > 0.2f && brighter < 1.0f);
+	const float darker = adapt(1.0f, 0.2f, speedDown, speedUp);
+	CHECK(darker < 1.0f && darker > 0.2f);
+	CHECK((brighter - 0.2f) > (1.0f - darker));		// Going up is faster
+
+	// Converges, and never goes negative
+	float adapted = 5.0f;
+	for (int i = 0; i < 2000; i++)
+		adapted = adapt(adapted, 0.0f, speedDown, speedUp);
+	CHECK(adapted >= 0.0f && adapted < 1e-3f);
+}
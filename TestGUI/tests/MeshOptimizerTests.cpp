@@ -0,0 +1,199 @@
+#include "TestCommon.h"
+#include "../src/render_engine/model/MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+
+
+namespace
+{
+	// (n+1)x(n+1) vertex grid on the xz plane. bumpHeight > 0 gives it some curvature so the simplifier has something to do
+	void makeGrid(size_t n, float bumpHeight, std::vector<Vertex>& out_vertices, std::vector<uint32_t>& out_indices)
+	{
+		out_vertices.clear();
+		out_indices.clear();
+		for (size_t z = 0; z <= n; z++)
+			for (size_t x = 0; x <= n; x++)
+			{
+				Vertex vertex = {};
+				vertex.position = glm::vec3((float)x, bumpHeight * std::sin((float)x * 0.3f) * std::cos((float)z * 0.3f), (float)z);
+				vertex.normal = glm::vec3(0, 1, 0);
+				vertex.texCoords = glm::vec2(0.0f);		// NOTE: all the same so there's no attribute seams
+				out_vertices.push_back(vertex);
+			}
+
+		for (uint32_t z = 0; z < n; z++)
+			for (uint32_t x = 0; x < n; x++)
+			{
+				const uint32_t i = z * (uint32_t)(n + 1) + x;
+				out_indices.insert(out_indices.end(), { i, i + (uint32_t)n + 1, i + 1, i + 1, i + (uint32_t)n + 1, i + (uint32_t)n + 2 });
+			}
+	}
+
+	// Deterministic triangle shuffle so the cache starts out cold
+	void shuffleTriangles(std::vector<uint32_t>& indices)
+	{
+		uint32_t state = 12345;
+		const size_t numTriangles = indices.size() / 3;
+		for (size_t i = numTriangles - 1; i > 0; i--)
+		{
+			state = state * 1664525u + 1013904223u;
+			const size_t j = state % (i + 1);
+			for (size_t k = 0; k < 3; k++)
+				std::swap(indices[i * 3 + k], indices[j * 3 + k]);
+		}
+	}
+
+	// Triangles as position triples, rotated so the winding's kept but the starting corner doesn't matter
+	std::vector<std::array<float, 9>> getSortedTriangles(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount)
+	{
+		std::vector<std::array<float, 9>> triangles;
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			std::array<uint32_t, 3> corners = { indices[i], indices[i + 1], indices[i + 2] };
+			while (!(vertices[corners[0]].position.x <= vertices[corners[1]].position.x && vertices[corners[0]].position.x <= vertices[corners[2]].position.x))
+				std::rotate(corners.begin(), corners.begin() + 1, corners.end());
+
+			std::array<float, 9> triangle;
+			for (size_t j = 0; j < 3; j++)
+				for (size_t k = 0; k < 3; k++)
+					triangle[j * 3 + k] = vertices[corners[j]].position[(int)k];
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+
+TEST(mesh_optimizer_acmr_of_a_strip_order_grid)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(1, 0.0f, vertices, indices);
+	CHECK_NEAR(MeshOptimizer::calculateACMR(indices, vertices.size()), 2.0f, 1e-6f);		// 4 verts, 2 tris
+	CHECK(MeshOptimizer::calculateACMR({}, 0) == 0.0f);
+}
+
+TEST(mesh_optimizer_forsyth_lowers_acmr_and_keeps_the_triangles)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(32, 0.0f, vertices, indices);
+	shuffleTriangles(indices);
+
+	const auto trianglesBefore = getSortedTriangles(vertices, indices.data(), indices.size());
+	const float acmrBefore = MeshOptimizer::calculateACMR(indices, vertices.size());
+	MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+	const float acmrAfter = MeshOptimizer::calculateACMR(indices, vertices.size());
+
+	CHECK(acmrAfter < acmrBefore * 0.5f);
+	CHECK(acmrAfter < 1.0f);
+	CHECK(getSortedTriangles(vertices, indices.data(), indices.size()) == trianglesBefore);
+}
+
+TEST(mesh_optimizer_overdraw_keeps_the_triangles_and_most_of_the_acmr)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(32, 4.0f, vertices, indices);
+	shuffleTriangles(indices);
+	MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+
+	const auto trianglesBefore = getSortedTriangles(vertices, indices.data(), indices.size());
+	const float acmrBefore = MeshOptimizer::calculateACMR(indices, vertices.size());
+	MeshOptimizer::optimizeOverdraw(indices, vertices);
+
+	CHECK(getSortedTriangles(vertices, indices.data(), indices.size()) == trianglesBefore);
+	CHECK(MeshOptimizer::calculateACMR(indices, vertices.size()) <= acmrBefore * 1.1f);
+}
+
+TEST(mesh_optimizer_simplify_flat_grid_has_no_error)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(16, 0.0f, vertices, indices);
+
+	float error = -1.0f;
+	const std::vector<uint32_t> simplified = MeshOptimizer::simplify(vertices, indices, indices.size() / 4 / 3 * 3, 0.01f, error);
+	CHECK(!simplified.empty());
+	CHECK(simplified.size() <= indices.size() / 2);
+	CHECK(simplified.size() % 3 == 0);
+	CHECK(error >= 0.0f && error <= 0.01f);
+	for (uint32_t index : simplified)
+		CHECK(index < vertices.size());
+}
+
+TEST(mesh_optimizer_simplify_stays_under_the_max_error)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(24, 3.0f, vertices, indices);
+
+	float error = -1.0f;
+	const std::vector<uint32_t> simplified = MeshOptimizer::simplify(vertices, indices, 6, 0.25f, error);
+	CHECK(simplified.size() < indices.size());
+	CHECK(simplified.size() > 6);		// The bumps shouldn't be able to get flattened that far w/ that little error
+	CHECK(error <= 0.25f);
+}
+
+TEST(mesh_optimizer_lod_chain_is_packed_and_ordered)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(32, 2.0f, vertices, indices);
+	shuffleTriangles(indices);
+	const std::vector<Vertex> originalVertices = vertices;
+	const auto originalTriangles = getSortedTriangles(vertices, indices.data(), indices.size());
+
+	std::vector<uint32_t> lodIndices;
+	std::vector<MeshLOD> lods;
+	MeshOptimizer::LODChainStats stats;
+	MeshOptimizer::buildLODChain(vertices, indices, MeshOptimizer::LODSettings(), lodIndices, lods, &stats);
+
+	CHECK(vertices.size() == originalVertices.size());
+	CHECK(lods.size() >= 2);
+	CHECK(!stats.keptImportedOrder);
+	CHECK(stats.acmrAfter < stats.acmrBefore);
+
+	// LOD0 is the same triangles (the vertex fetch reordering just renames them), and each LOD after it is smaller w/ more error
+	CHECK(lods[0].indexOffset == 0 && lods[0].indexCount == indices.size() && lods[0].error == 0.0f);
+	CHECK(getSortedTriangles(vertices, lodIndices.data(), lods[0].indexCount) == originalTriangles);
+	CHECK_NEAR(MeshOptimizer::calculateACMR(std::vector<uint32_t>(lodIndices.begin(), lodIndices.begin() + lods[0].indexCount), vertices.size()), stats.acmrAfter, 1e-6f);
+	for (size_t i = 1; i < lods.size(); i++)
+	{
+		CHECK(lods[i].indexOffset == lods[i - 1].indexOffset + lods[i - 1].indexCount);
+		CHECK(lods[i].indexCount < lods[i - 1].indexCount);
+		CHECK(lods[i].error >= lods[i - 1].error);
+	}
+	CHECK(lods.back().indexOffset + lods.back().indexCount == lodIndices.size());
+	for (uint32_t index : lodIndices)
+		CHECK(index < vertices.size());
+
+	// Vertex fetch order: LOD0 uses the vertices in order
+	uint32_t nextNewVertex = 0;
+	for (size_t i = 0; i < lods[0].indexCount; i++)
+	{
+		CHECK(lodIndices[i] <= nextNewVertex);
+		if (lodIndices[i] == nextNewVertex)
+			nextNewVertex++;
+	}
+}
+
+TEST(mesh_optimizer_lod_chain_never_makes_the_acmr_worse)
+{
+	// Already in a decent (row by row) order, so the reordering only gets kept if it's at least as good
+	for (size_t n : { 1, 4, 8, 32 })
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		makeGrid(n, 1.0f, vertices, indices);
+
+		std::vector<uint32_t> lodIndices;
+		std::vector<MeshLOD> lods;
+		MeshOptimizer::LODChainStats stats;
+		MeshOptimizer::buildLODChain(vertices, indices, MeshOptimizer::LODSettings(), lodIndices, lods, &stats);
+		CHECK(stats.acmrAfter <= stats.acmrBefore);
+		CHECK_NEAR(MeshOptimizer::calculateACMR(std::vector<uint32_t>(lodIndices.begin(), lodIndices.begin() + lods[0].indexCount), vertices.size()), stats.acmrAfter, 1e-6f);
+	}
+}
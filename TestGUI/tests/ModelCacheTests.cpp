@@ -0,0 +1,163 @@
+#include "TestCommon.h"
+#include "../src/render_engine/model/ModelCache.h"
+
+#include <filesystem>
+#include <cstring>
+
+
+namespace
+{
+	// One 16 bit index quad w/ 2 LODs, one physics mesh, and a 3 node animation hierarchy (root -> a -> b)
+	BakedModel makeBakedModel()
+	{
+		BakedModel bakedModel;
+
+		MeshBakedData renderMesh = {};
+		renderMesh.materialName = "Material";
+		renderMesh.use16BitIndices = true;
+		renderMesh.numVertices = 4;
+		renderMesh.numIndices = 9;
+		renderMesh.lods = { { 0, 6, 0.0f }, { 6, 3, 0.5f } };
+		renderMesh.vertexData.resize(4 * sizeof(StaticVertexQuantized), 0);
+		const uint16_t indices[] = { 0, 1, 2, 2, 1, 3, 0, 1, 3 };
+		renderMesh.indexData.resize(sizeof(indices));
+		memcpy(renderMesh.indexData.data(), indices, sizeof(indices));
+		bakedModel.renderMeshes.push_back(renderMesh);
+
+		MeshBakedData physicsMesh = {};
+		physicsMesh.materialName = "Collision";
+		physicsMesh.isPhysicsOnly = true;
+		physicsMesh.numVertices = 3;
+		physicsMesh.numIndices = 3;
+		physicsMesh.vertexData.resize(3 * sizeof(glm::vec3), 0);
+		const uint32_t physicsIndices[] = { 0, 1, 2 };
+		physicsMesh.indexData.resize(sizeof(physicsIndices));
+		memcpy(physicsMesh.indexData.data(), physicsIndices, sizeof(physicsIndices));
+		bakedModel.physicsMeshes.push_back(physicsMesh);
+
+		BakedAnimation animation = {};
+		animation.name = "Idle";
+		animation.nodes = {
+			{ "root", glm::mat4(1.0f), -1, 1 },
+			{ "a", glm::mat4(1.0f), 0, 1 },
+			{ "b", glm::mat4(1.0f), 1, 0 },
+		};
+		bakedModel.animations.push_back(animation);
+		return bakedModel;
+	}
+
+	bool isValid(const BakedModel& bakedModel)
+	{
+		std::string error;
+		return ModelCache::validate(bakedModel, error);
+	}
+
+	std::string getTestCachePath()
+	{
+		return (std::filesystem::temp_directory_path() / "solanine_tests" / "model_cache_test.hmdl").string();
+	}
+}
+
+
+TEST(model_cache_valid_model_passes)
+{
+	CHECK(isValid(makeBakedModel()));
+}
+
+TEST(model_cache_rejects_bad_blob_lengths)
+{
+	BakedModel bakedModel = makeBakedModel();
+	bakedModel.renderMeshes[0].vertexData.pop_back();
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.renderMeshes[0].numIndices = 12;		// More than the index data has
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.renderMeshes[0].isSkinned = true;		// Skinned stride is bigger than what's there
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.physicsMeshes[0].use16BitIndices = true;
+	CHECK(!isValid(bakedModel));
+}
+
+TEST(model_cache_rejects_bad_lod_ranges)
+{
+	BakedModel bakedModel = makeBakedModel();
+	bakedModel.renderMeshes[0].lods[1].indexCount = 4;
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.renderMeshes[0].lods[1].indexOffset = 0xFFFFFFFF;		// Would overflow if it was added up in 32 bits
+	CHECK(!isValid(bakedModel));
+}
+
+TEST(model_cache_rejects_out_of_range_indices)
+{
+	BakedModel bakedModel = makeBakedModel();
+	((uint16_t*)bakedModel.renderMeshes[0].indexData.data())[8] = 4;
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	((uint32_t*)bakedModel.physicsMeshes[0].indexData.data())[2] = 3;
+	CHECK(!isValid(bakedModel));
+}
+
+TEST(model_cache_rejects_bad_node_hierarchies)
+{
+	BakedModel bakedModel = makeBakedModel();
+	bakedModel.animations[0].nodes[2].parentIndex = 3;
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.animations[0].nodes[1].parentIndex = 1;		// Itself
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.animations[0].nodes[0].parentIndex = 0;
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.animations[0].nodes[1].childrenCount = 5;
+	CHECK(!isValid(bakedModel));
+
+	bakedModel = makeBakedModel();
+	bakedModel.animations[0].nodes[2].parentIndex = 0;		// Counts don't add up anymore (root says 1 child, now it has 2)
+	CHECK(!isValid(bakedModel));
+}
+
+TEST(model_cache_round_trips_thru_the_file)
+{
+	const std::string cachePath = getTestCachePath();
+	const BakedModel bakedModel = makeBakedModel();
+	CHECK(ModelCache::saveToFile(cachePath, 1234, bakedModel));
+
+	BakedModel loaded;
+	CHECK(ModelCache::loadFromFile(cachePath, 1234, loaded));
+	CHECK(loaded.renderMeshes.size() == 1 && loaded.physicsMeshes.size() == 1 && loaded.animations.size() == 1);
+	if (loaded.renderMeshes.size() == 1)
+	{
+		CHECK(loaded.renderMeshes[0].indexData == bakedModel.renderMeshes[0].indexData);
+		CHECK(loaded.renderMeshes[0].lods.size() == 2);
+		CHECK(loaded.renderMeshes[0].materialName == "Material");
+	}
+
+	CHECK(!ModelCache::loadFromFile(cachePath, 4321, loaded));		// Stale hash
+	std::filesystem::remove(cachePath);
+}
+
+TEST(model_cache_file_that_fails_validation_gets_rejected)
+{
+	// Parses fine, but the indices are out of range. It needs to get turned away so the model gets reimported
+	const std::string cachePath = getTestCachePath();
+	BakedModel bakedModel = makeBakedModel();
+	((uint16_t*)bakedModel.renderMeshes[0].indexData.data())[0] = 100;
+	CHECK(ModelCache::saveToFile(cachePath, 1234, bakedModel));
+
+	BakedModel loaded;
+	CHECK(!ModelCache::loadFromFile(cachePath, 1234, loaded));
+	CHECK(loaded.renderMeshes.empty());
+	std::filesystem::remove(cachePath);
+}
@@ -0,0 +1,86 @@
+#include "TestCommon.h"
+#include "../src/render_engine/render_manager/OcclusionCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+namespace
+{
+	// Looking down -z from the origin, w/ a 100x100 wall at z=-10
+	const glm::vec3 wallPositions[] = { { -50, -50, -10 }, { 50, -50, -10 }, { 50, 50, -10 }, { -50, 50, -10 } };
+	const uint32_t wallIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+	glm::mat4 getProjectionView()
+	{
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+		return projection * view;
+	}
+
+	void rasterizeWall(OcclusionCuller& occlusionCuller, const glm::mat4& modelMatrix = glm::mat4(1.0f))
+	{
+		occlusionCuller.beginFrame(getProjectionView());
+		occlusionCuller.addOccluder(wallPositions, sizeof(glm::vec3), 4, wallIndices, 6, modelMatrix);
+		occlusionCuller.rasterizeOccluders();
+	}
+}
+
+
+TEST(occlusion_culler_wall_culls_whats_behind_it)
+{
+	OcclusionCuller occlusionCuller(256, 128, 4);
+	rasterizeWall(occlusionCuller);
+
+	CHECK(occlusionCuller.stats.numRasterizedTriangles == 2);
+	CHECK(!occlusionCuller.isVisible({ -1, -1, -21 }, { 1, 1, -20 }));		// Behind
+	CHECK(occlusionCuller.isVisible({ -1, -1, -6 }, { 1, 1, -5 }));			// In front
+	CHECK(occlusionCuller.isVisible({ -1, -1, -11 }, { 1, 1, -9 }));		// Straddling the wall
+	CHECK(occlusionCuller.isVisible({ -1, -1, 5 }, { 1, 1, 6 }));			// Behind the camera
+	CHECK(occlusionCuller.stats.numCulled == 1);
+}
+
+TEST(occlusion_culler_nothing_gets_culled_before_rasterizing)
+{
+	OcclusionCuller occlusionCuller(64, 32, 1);
+	occlusionCuller.beginFrame(getProjectionView());
+	occlusionCuller.addOccluder(wallPositions, sizeof(glm::vec3), 4, wallIndices, 6, glm::mat4(1.0f));
+	CHECK(occlusionCuller.isVisible({ -1, -1, -21 }, { 1, 1, -20 }));
+}
+
+TEST(occlusion_culler_gap_next_to_a_small_occluder_stays_visible)
+{
+	// Shrink the wall down to 2x2 and push it off to the left. What's behind the middle shouldn't get culled
+	OcclusionCuller occlusionCuller(256, 128, 2);
+	rasterizeWall(occlusionCuller, glm::translate(glm::mat4(1.0f), glm::vec3(-4, 0, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.02f, 0.02f, 1.0f)));
+
+	CHECK(!occlusionCuller.isVisible({ -12.5f, -0.5f, -30 }, { -11.5f, 0.5f, -29 }));
+	CHECK(occlusionCuller.isVisible({ -1, -1, -21 }, { 1, 1, -20 }));
+}
+
+TEST(occlusion_culler_near_plane_triangles_get_thrown_out)
+{
+	// A wall that goes thru the camera can't be rasterized (conservatively), so nothing gets culled
+	const glm::vec3 positions[] = { { -50, -50, 5 }, { 50, -50, 5 }, { 50, 50, -10 }, { -50, 50, -10 } };
+	OcclusionCuller occlusionCuller(128, 64, 1);
+	occlusionCuller.beginFrame(getProjectionView());
+	occlusionCuller.addOccluder(positions, sizeof(glm::vec3), 4, wallIndices, 6, glm::mat4(1.0f));
+	occlusionCuller.rasterizeOccluders();
+
+	CHECK(occlusionCuller.stats.numRasterizedTriangles == 0);
+	CHECK(occlusionCuller.isVisible({ -1, -1, -21 }, { 1, 1, -20 }));
+}
+
+TEST(occlusion_culler_worker_count_doesnt_change_the_depth_buffer)
+{
+	OcclusionCuller singleThreaded(200, 100, 1);
+	OcclusionCuller multiThreaded(200, 100, 3);		// NOTE: 100 rows don't split evenly into 3 bands
+
+	// Run a couple frames so that the pool gets reused
+	for (int frame = 0; frame < 3; frame++)
+	{
+		const glm::mat4 modelMatrix = glm::rotate(glm::mat4(1.0f), 0.3f * frame, glm::vec3(0, 0, 1));
+		rasterizeWall(singleThreaded, modelMatrix);
+		rasterizeWall(multiThreaded, modelMatrix);
+		CHECK(singleThreaded.getDepthBuffer() == multiThreaded.getDepthBuffer());
+	}
+}
@@ -0,0 +1,189 @@
+#include "TestCommon.h"
+#include "../src/render_engine/render_manager/RenderGraph.h"
+
+#include <glad/glad.h>
+
+
+//
+// NOTE: nothing here calls execute(), so no GL calls happen. compile() is all CPU
+//
+namespace
+{
+	const RenderGraphTextureDesc quarterResDesc = { 480, 270, GL_RGBA16F, GL_LINEAR, GL_LINEAR };
+	const RenderGraphTextureDesc singleChannelDesc = { 480, 270, GL_R32F, GL_NEAREST, GL_LINEAR };
+
+	void noop(RenderGraph&) {}
+}
+
+
+TEST(render_graph_culls_passes_nothing_reads)
+{
+	RenderGraph graph;
+	RenderGraph::TextureHandle used = graph.createTexture("used", quarterResDesc);
+	RenderGraph::TextureHandle unused = graph.createTexture("unused", quarterResDesc);
+
+	size_t writeUsed = graph.addPass("Write Used", RenderGraphPassType::GRAPHICS, noop);
+	graph.write(writeUsed, used);
+	size_t writeUnused = graph.addPass("Write Unused", RenderGraphPassType::GRAPHICS, noop);
+	graph.write(writeUnused, unused);
+	size_t present = graph.addPass("Present", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(present, used);
+	graph.setHasSideEffects(present);
+
+	CHECK(graph.compile());
+	CHECK(!graph.isPassCulled(writeUsed));
+	CHECK(graph.isPassCulled(writeUnused));
+	CHECK(!graph.isPassCulled(present));
+	CHECK(graph.stats.numPasses == 3);
+	CHECK(graph.stats.numPassesCulled == 1);
+	CHECK(graph.getPhysicalTextureIndex(unused) == ~0u);		// Only a culled pass used it
+}
+
+TEST(render_graph_writing_an_import_keeps_the_pass_alive)
+{
+	RenderGraph graph;
+	RenderGraph::TextureHandle history = graph.importTexture("history", 1234, quarterResDesc);
+	size_t pass = graph.addPass("Write History", RenderGraphPassType::COMPUTE, noop);
+	graph.write(pass, history);
+
+	CHECK(graph.compile());
+	CHECK(!graph.isPassCulled(pass));
+	CHECK(graph.getTexture(history) == 1234);
+}
+
+TEST(render_graph_aliases_textures_that_dont_overlap)
+{
+	// a -> b -> c -> screen. a is done by the time c gets written, so they can share
+	RenderGraph graph;
+	RenderGraph::TextureHandle a = graph.createTexture("a", quarterResDesc);
+	RenderGraph::TextureHandle b = graph.createTexture("b", quarterResDesc);
+	RenderGraph::TextureHandle c = graph.createTexture("c", quarterResDesc);
+
+	size_t pass = graph.addPass("A", RenderGraphPassType::GRAPHICS, noop);
+	graph.write(pass, a);
+	pass = graph.addPass("B", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, a);
+	graph.write(pass, b);
+	pass = graph.addPass("C", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, b);
+	graph.write(pass, c);
+	pass = graph.addPass("Present", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, c);
+	graph.setHasSideEffects(pass);
+
+	CHECK(graph.compile());
+	CHECK(graph.getPhysicalTextureIndex(a) == graph.getPhysicalTextureIndex(c));
+	CHECK(graph.getPhysicalTextureIndex(a) != graph.getPhysicalTextureIndex(b));
+	CHECK(graph.stats.numTransientTextures == 3);
+	CHECK(graph.stats.numPhysicalTextures == 2);
+}
+
+TEST(render_graph_doesnt_alias_different_descs_or_overlapping_lifetimes)
+{
+	RenderGraph graph;
+	RenderGraph::TextureHandle a = graph.createTexture("a", quarterResDesc);
+	RenderGraph::TextureHandle b = graph.createTexture("b", singleChannelDesc);
+	RenderGraph::TextureHandle c = graph.createTexture("c", quarterResDesc);
+
+	size_t pass = graph.addPass("A", RenderGraphPassType::GRAPHICS, noop);
+	graph.write(pass, a);
+	pass = graph.addPass("B", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, a);
+	graph.write(pass, b);
+	pass = graph.addPass("C", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, a);		// a's still alive here
+	graph.read(pass, b);
+	graph.write(pass, c);
+	graph.setHasSideEffects(pass);
+
+	CHECK(graph.compile());
+	CHECK(graph.getPhysicalTextureIndex(a) != graph.getPhysicalTextureIndex(b));
+	CHECK(graph.getPhysicalTextureIndex(a) != graph.getPhysicalTextureIndex(c));
+	CHECK(graph.stats.numPhysicalTextures == 3);
+}
+
+TEST(render_graph_vram_report)
+{
+	CHECK(RenderGraph::getTextureSizeInBytes(quarterResDesc) == (size_t)480 * 270 * 8);
+	CHECK(RenderGraph::getTextureSizeInBytes({ 64, 64, GL_R16F, GL_LINEAR, GL_LINEAR, 7 }) == (size_t)(64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1) * 2);
+	CHECK(RenderGraph::getTextureSizeInBytes({ 64, 16, GL_RGBA32F, GL_LINEAR, GL_LINEAR, 7 }) == (size_t)(64 * 16 + 32 * 8 + 16 * 4 + 8 * 2 + 4 + 2 + 1) * 16);		// The short side stops at 1
+
+	// Ping-pong chain: 4 textures, but only 2 are ever alive at once
+	RenderGraph graph;
+	RenderGraph::TextureHandle previous = graph.createTexture("chain0", quarterResDesc);
+	size_t pass = graph.addPass("Chain 0", RenderGraphPassType::GRAPHICS, noop);
+	graph.write(pass, previous);
+	for (int i = 1; i < 4; i++)
+	{
+		RenderGraph::TextureHandle next = graph.createTexture("chain" + std::to_string(i), quarterResDesc);
+		pass = graph.addPass("Chain " + std::to_string(i), RenderGraphPassType::GRAPHICS, noop);
+		graph.read(pass, previous);
+		graph.write(pass, next);
+		previous = next;
+	}
+	graph.setHasSideEffects(pass);
+
+	CHECK(graph.compile());
+	const size_t textureSize = RenderGraph::getTextureSizeInBytes(quarterResDesc);
+	CHECK(graph.stats.transientBytesWithoutAliasing == textureSize * 4);
+	CHECK(graph.stats.transientBytesWithAliasing == textureSize * 2);
+}
+
+TEST(render_graph_puts_barriers_after_compute_writes)
+{
+	RenderGraph graph;
+	RenderGraph::TextureHandle computed = graph.createTexture("computed", quarterResDesc);
+	RenderGraph::TextureHandle drawn = graph.createTexture("drawn", quarterResDesc);
+
+	size_t compute = graph.addPass("Compute", RenderGraphPassType::COMPUTE, noop);
+	graph.write(compute, computed);
+	size_t draw = graph.addPass("Draw", RenderGraphPassType::GRAPHICS, noop);
+	graph.write(draw, drawn);
+	size_t sample = graph.addPass("Sample", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(sample, computed);
+	graph.read(sample, drawn);
+	graph.setHasSideEffects(sample);
+
+	CHECK(graph.compile());
+	CHECK(graph.getBarrierBits(compute) == 0);
+	CHECK(graph.getBarrierBits(draw) == 0);
+	CHECK((graph.getBarrierBits(sample) & GL_TEXTURE_FETCH_BARRIER_BIT) != 0);
+	CHECK(graph.stats.numBarriers == 1);
+}
+
+TEST(render_graph_rejects_reading_before_writing)
+{
+	RenderGraph graph;
+	RenderGraph::TextureHandle texture = graph.createTexture("texture", quarterResDesc);
+	size_t pass = graph.addPass("Read", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, texture);
+	graph.setHasSideEffects(pass);
+
+	CHECK(!graph.compile());
+	CHECK(!graph.isCompiled());
+}
+
+TEST(render_graph_stays_compiled_until_reset)
+{
+	RenderGraph graph;
+	RenderGraph::TextureHandle history = graph.importTexture("history", 1, quarterResDesc);
+	RenderGraph::TextureHandle output = graph.createTexture("output", quarterResDesc);
+	size_t pass = graph.addPass("Resolve", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, history);
+	graph.write(pass, output);
+	pass = graph.addPass("Present", RenderGraphPassType::GRAPHICS, noop);
+	graph.read(pass, output);
+	graph.setHasSideEffects(pass);
+
+	CHECK(graph.compile());
+	CHECK(graph.isCompiled());
+
+	// Swapping a ping-pong texture doesn't need a recompile
+	graph.setImportedTexture(history, 2);
+	CHECK(graph.isCompiled());
+	CHECK(graph.getTexture(history) == 2);
+	CHECK(graph.stats.numPasses == 2);
+
+	graph.reset();
+	CHECK(!graph.isCompiled());
+}
@@ -0,0 +1,414 @@
+#include "TestCommon.h"
+#include "../src/render_engine/render_manager/ScenePicker.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <random>
+
+
+namespace
+{
+	struct TestObject
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		glm::mat4 modelMatrix;
+		bool isBoxOnly = false;		// Like an object w/o any CPU copies of its meshes
+		glm::vec3 worldMin, worldMax;
+	};
+
+	void addCube(TestObject& object)
+	{
+		for (int i = 0; i < 8; i++)
+			object.positions.push_back(glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f));
+		const uint32_t faces[6][4] = { { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 } };
+		for (const auto& face : faces)
+			object.indices.insert(object.indices.end(), { face[0], face[1], face[2], face[0], face[2], face[3] });
+	}
+
+	// A single slanted triangle, so the AABB has lots of empty space in it
+	void addSliver(TestObject& object)
+	{
+		object.positions = { glm::vec3(-1, -1, -1), glm::vec3(1, -1, 1), glm::vec3(0, 1, 0) };
+		object.indices = { 0, 1, 2 };
+	}
+
+	void updateWorldBounds(TestObject& object)
+	{
+		object.worldMin = glm::vec3(FLT_MAX);
+		object.worldMax = glm::vec3(-FLT_MAX);
+		for (const glm::vec3& position : object.positions)
+		{
+			const glm::vec3 worldPosition = glm::vec3(object.modelMatrix * glm::vec4(position, 1.0f));
+			object.worldMin = glm::min(object.worldMin, worldPosition);
+			object.worldMax = glm::max(object.worldMax, worldPosition);
+		}
+	}
+
+	std::vector<TestObject> makeRandomScene(std::mt19937& random, size_t numObjects, float boxOnlyChance)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+		std::uniform_real_distribution<float> scale(0.2f, 3.0f);
+
+		std::vector<TestObject> objects(numObjects);
+		for (TestObject& object : objects)
+		{
+			if (unit(random) < 0.5f)
+				addCube(object);
+			else
+				addSliver(object);
+
+			const glm::vec3 axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 0.01f);
+			object.modelMatrix =
+				glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random) * 0.25f, position(random))) *
+				glm::rotate(glm::mat4(1.0f), unit(random) * 6.28f, axis) *
+				glm::scale(glm::mat4(1.0f), glm::vec3(scale(random), scale(random), scale(random)));
+			object.isBoxOnly = (unit(random) < boxOnlyChance);
+			updateWorldBounds(object);
+		}
+		return objects;
+	}
+
+	void buildPicker(ScenePicker& picker, const std::vector<TestObject>& objects)
+	{
+		picker.beginBuild();
+		for (size_t i = 0; i < objects.size(); i++)
+			picker.addObject(i, objects[i].worldMin, objects[i].worldMax);
+		picker.build();
+	}
+
+	ScenePicker::MeshFunc makeMeshFunc(const std::vector<TestObject>& objects)
+	{
+		return [&objects](size_t id, std::vector<ScenePickerMesh>& out_meshes)
+		{
+			const TestObject& object = objects[id];
+			if (!object.isBoxOnly)
+				out_meshes.push_back({ object.positions.data(), object.positions.size(), object.indices.data(), object.indices.size(), object.modelMatrix });
+		};
+	}
+
+	//
+	// Brute force references. Everything's done in world space (the picker moves the ray into the mesh's space instead)
+	//
+	bool bruteForceRayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& out_t)
+	{
+		// Plane, then the barycentrics of the hit point
+		const glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+		const float denominator = glm::dot(normal, direction);
+		if (std::abs(denominator) < 1e-12f)
+			return false;
+		out_t = glm::dot(normal, v0 - origin) / denominator;
+		if (out_t <= 0.0f)
+			return false;
+
+		const glm::vec3 hit = origin + direction * out_t;
+		const float area = glm::dot(normal, normal);
+		const float b0 = glm::dot(glm::cross(v1 - hit, v2 - hit), normal) / area;
+		const float b1 = glm::dot(glm::cross(v2 - hit, v0 - hit), normal) / area;
+		return b0 >= 0.0f && b1 >= 0.0f && b0 + b1 <= 1.0f;
+	}
+
+	// Slab test, but w/ both ends of the ray in the box
+	bool bruteForceRayAABB(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& min, const glm::vec3& max, float& out_tEnter, float& out_tExit)
+	{
+		out_tEnter = 0.0f;
+		out_tExit = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (direction[axis] == 0.0f)
+			{
+				if (origin[axis] < min[axis] || origin[axis] > max[axis])
+					return false;
+				continue;
+			}
+			float t0 = (min[axis] - origin[axis]) / direction[axis];
+			float t1 = (max[axis] - origin[axis]) / direction[axis];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			out_tEnter = std::max(out_tEnter, t0);
+			out_tExit = std::min(out_tExit, t1);
+		}
+		return out_tEnter <= out_tExit;
+	}
+
+	// Closest triangle hit out of everything. Box only objects only count if nothing else got hit
+	void bruteForcePickRay(const std::vector<TestObject>& objects, const glm::vec3& origin, const glm::vec3& direction, size_t ignoreId, size_t& out_id, float& out_distance)
+	{
+		out_id = ScenePicker::NO_ID;
+		out_distance = FLT_MAX;
+		size_t boxOnlyId = ScenePicker::NO_ID;
+		float boxOnlyDistance = FLT_MAX;
+		for (size_t i = 0; i < objects.size(); i++)
+		{
+			const TestObject& object = objects[i];
+			if (i == ignoreId)
+				continue;
+
+			if (object.isBoxOnly)
+			{
+				float tEnter, tExit;
+				if (bruteForceRayAABB(origin, direction, object.worldMin, object.worldMax, tEnter, tExit))
+				{
+					const float distance = (tEnter > 0.0f) ? tEnter : tExit;
+					if (distance < boxOnlyDistance)
+					{
+						boxOnlyId = i;
+						boxOnlyDistance = distance;
+					}
+				}
+				continue;
+			}
+
+			for (size_t j = 0; j + 2 < object.indices.size(); j += 3)
+			{
+				glm::vec3 triangle[3];
+				for (size_t k = 0; k < 3; k++)
+					triangle[k] = glm::vec3(object.modelMatrix * glm::vec4(object.positions[object.indices[j + k]], 1.0f));
+
+				float t;
+				if (bruteForceRayTriangle(origin, direction, triangle[0], triangle[1], triangle[2], t) && t < out_distance)
+				{
+					out_id = i;
+					out_distance = t;
+				}
+			}
+		}
+
+		if (out_id == ScenePicker::NO_ID)
+		{
+			out_id = boxOnlyId;
+			out_distance = boxOnlyDistance;
+		}
+	}
+
+	// 2D separating axis test of the projected triangle against the rectangle. NOTE: only for triangles all the way in front of the camera
+	bool isProjectedTriangleInRect(const glm::vec2 triangle[3], const glm::vec2& rectMin, const glm::vec2& rectMax)
+	{
+		glm::vec2 triangleMin = glm::min(triangle[0], glm::min(triangle[1], triangle[2]));
+		glm::vec2 triangleMax = glm::max(triangle[0], glm::max(triangle[1], triangle[2]));
+		if (triangleMax.x < rectMin.x || triangleMin.x > rectMax.x || triangleMax.y < rectMin.y || triangleMin.y > rectMax.y)
+			return false;
+
+		const glm::vec2 corners[4] = { rectMin, glm::vec2(rectMax.x, rectMin.y), rectMax, glm::vec2(rectMin.x, rectMax.y) };
+		for (int i = 0; i < 3; i++)
+		{
+			const glm::vec2 edge = triangle[(i + 1) % 3] - triangle[i];
+			const glm::vec2 axis = glm::vec2(-edge.y, edge.x);
+			const float opposite = glm::dot(axis, triangle[(i + 2) % 3] - triangle[i]);
+			bool allCornersOutside = true;
+			for (const glm::vec2& corner : corners)
+				if (glm::dot(axis, corner - triangle[i]) * opposite >= 0.0f)
+					allCornersOutside = false;
+			if (allCornersOutside)
+				return false;
+		}
+		return true;
+	}
+
+	// Exactly what's touching the rectangle. Box only objects go by their whole AABB (as a cube mesh, since the camera's outside of it)
+	bool bruteForceIsInRect(const TestObject& object, const glm::mat4& projectionView, const glm::vec2& rectMin, const glm::vec2& rectMax)
+	{
+		if (object.isBoxOnly)
+		{
+			TestObject aabb;
+			addCube(aabb);
+			aabb.modelMatrix = glm::translate(glm::mat4(1.0f), (object.worldMin + object.worldMax) * 0.5f) * glm::scale(glm::mat4(1.0f), (object.worldMax - object.worldMin) * 0.5f);
+			return bruteForceIsInRect(aabb, projectionView, rectMin, rectMax);
+		}
+
+		const glm::mat4 modelProjectionView = projectionView * object.modelMatrix;
+		for (size_t j = 0; j + 2 < object.indices.size(); j += 3)
+		{
+			glm::vec2 triangle[3];
+			for (size_t k = 0; k < 3; k++)
+			{
+				const glm::vec4 clip = modelProjectionView * glm::vec4(object.positions[object.indices[j + k]], 1.0f);
+				triangle[k] = glm::vec2(clip) / clip.w;
+			}
+			if (isProjectedTriangleInRect(triangle, rectMin, rectMax))
+				return true;
+		}
+		return false;
+	}
+
+	// Somewhere inside one of the object's triangles (not near its edges, where the two sides can round differently)
+	glm::vec3 randomPointOnObject(std::mt19937& random, const TestObject& object)
+	{
+		std::uniform_real_distribution<float> barycentric(0.1f, 0.45f);
+		const size_t triangle = (random() % (object.indices.size() / 3)) * 3;
+		const float b0 = barycentric(random), b1 = barycentric(random);
+		const glm::vec3 position =
+			b0 * object.positions[object.indices[triangle]] +
+			b1 * object.positions[object.indices[triangle + 1]] +
+			(1.0f - b0 - b1) * object.positions[object.indices[triangle + 2]];
+		return glm::vec3(object.modelMatrix * glm::vec4(position, 1.0f));
+	}
+
+	glm::vec3 randomDirection(std::mt19937& random)
+	{
+		std::normal_distribution<float> normal;
+		return glm::normalize(glm::vec3(normal(random), normal(random), normal(random)));
+	}
+}
+
+
+TEST(scene_picker_ray_matches_brute_force)
+{
+	std::mt19937 random(48);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	const std::vector<TestObject> objects = makeRandomScene(random, 400, 0.0f);
+	ScenePicker picker;
+	buildPicker(picker, objects);
+	CHECK(picker.stats.numObjects == objects.size());
+
+	size_t numHits = 0, numMismatched = 0;
+	for (int i = 0; i < 3000; i++)
+	{
+		// Half of them aimed right at an object, so there's plenty of hits
+		const glm::vec3 origin(position(random), position(random) * 0.25f, position(random));
+		const TestObject& target = objects[random() % objects.size()];
+		const glm::vec3 direction = (i % 2 == 0) ? glm::normalize(randomPointOnObject(random, target) - origin) : randomDirection(random);
+
+		size_t id, referenceId;
+		float distance, referenceDistance;
+		const bool isHit = picker.pickRay(origin, direction, makeMeshFunc(objects), id, distance);
+		bruteForcePickRay(objects, origin, direction, ScenePicker::NO_ID, referenceId, referenceDistance);
+
+		// NOTE: just the distance, since a different id is fine if it's a tie (2 objects touching right where the ray hits)
+		if (isHit != (referenceId != ScenePicker::NO_ID))
+			numMismatched++;
+		else if (isHit && std::abs(distance - referenceDistance) > 1e-3f * std::max(1.0f, referenceDistance))
+			numMismatched++;
+		if (isHit)
+			numHits++;
+	}
+	CHECK(numHits > 1000);
+	CHECK(numMismatched == 0);
+}
+
+TEST(scene_picker_ignoring_the_last_pick_gets_whats_behind_it)
+{
+	std::mt19937 random(480);
+	const std::vector<TestObject> objects = makeRandomScene(random, 200, 0.2f);
+	ScenePicker picker;
+	buildPicker(picker, objects);
+
+	size_t numChecked = 0, numMismatched = 0;
+	for (int i = 0; i < 500; i++)
+	{
+		const glm::vec3 origin = glm::vec3(0.0f, 60.0f, 0.0f);
+		const TestObject& target = objects[random() % objects.size()];
+		const glm::vec3 direction = glm::normalize(randomPointOnObject(random, target) - origin);
+
+		size_t firstId, firstReferenceId;
+		float distance, referenceDistance;
+		if (!picker.pickRay(origin, direction, makeMeshFunc(objects), firstId, distance))
+			continue;
+		bruteForcePickRay(objects, origin, direction, ScenePicker::NO_ID, firstReferenceId, referenceDistance);
+
+		size_t secondId, secondReferenceId;
+		picker.pickRay(origin, direction, makeMeshFunc(objects), secondId, distance, firstId);
+		bruteForcePickRay(objects, origin, direction, firstId, secondReferenceId, referenceDistance);
+		CHECK(secondId != firstId);
+		if (firstId != firstReferenceId || secondId != secondReferenceId)
+			numMismatched++;
+		numChecked++;
+	}
+	CHECK(numChecked > 100);
+	CHECK(numMismatched == 0);
+}
+
+TEST(scene_picker_box_only_objects_rank_behind_triangles)
+{
+	// A box only object that the camera's inside of, w/ a cube a little ways in front of it
+	std::vector<TestObject> objects(3);
+	objects[0].isBoxOnly = true;
+	objects[0].modelMatrix = glm::mat4(1.0f);
+	objects[0].worldMin = glm::vec3(-20.0f);
+	objects[0].worldMax = glm::vec3(20.0f);
+	addCube(objects[1]);
+	objects[1].modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f));
+	updateWorldBounds(objects[1]);
+	addSliver(objects[2]);
+	objects[2].isBoxOnly = true;
+	objects[2].modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+	updateWorldBounds(objects[2]);
+
+	ScenePicker picker;
+	buildPicker(picker, objects);
+
+	// The cube's triangles win, even tho both of the boxes are closer
+	size_t id;
+	float distance;
+	CHECK(picker.pickRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), makeMeshFunc(objects), id, distance));
+	CHECK(id == 1);
+	CHECK_NEAR(distance, 9.0f, 1e-4f);
+
+	// Looking the other way there's only the box we're in. It goes by where the ray comes out of it, not 0
+	CHECK(picker.pickRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), makeMeshFunc(objects), id, distance));
+	CHECK(id == 0);
+	CHECK_NEAR(distance, 20.0f, 1e-4f);
+
+	// W/o the cube, the box in front (entered at 4) beats the one we're in (exited at 20)
+	CHECK(picker.pickRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), makeMeshFunc(objects), id, distance, 1));
+	CHECK(id == 2);
+	CHECK_NEAR(distance, 4.0f, 1e-4f);
+}
+
+TEST(scene_picker_rect_matches_brute_force)
+{
+	std::mt19937 random(4800);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<TestObject> objects = makeRandomScene(random, 300, 0.2f);
+
+	// Camera up high looking down, so everything's in front of it (the brute force doesn't clip against the near plane)
+	const glm::mat4 projectionView =
+		glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 500.0f) *
+		glm::lookAt(glm::vec3(0.0f, 80.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	ScenePicker picker;
+	buildPicker(picker, objects);
+
+	size_t numPicked = 0, numMismatched = 0;
+	for (int i = 0; i < 300; i++)
+	{
+		const glm::vec2 a(unit(random) * 2.4f - 1.2f, unit(random) * 2.4f - 1.2f);
+		const glm::vec2 b = a + glm::vec2(unit(random), unit(random)) * ((i % 3 == 0) ? 0.05f : 0.6f) * glm::vec2(unit(random) < 0.5f ? -1.0f : 1.0f, 1.0f);
+
+		std::vector<size_t> ids;
+		picker.pickRect(projectionView, a, b, makeMeshFunc(objects), ids);
+		CHECK(std::is_sorted(ids.begin(), ids.end()));
+		numPicked += ids.size();
+
+		// NOTE: box only objects just get their AABB checked against the rectangle's planes, which can let
+		// some thru that are right past a corner. So those only have to have everything that's actually touching
+		for (size_t id = 0; id < objects.size(); id++)
+		{
+			const bool isPicked = std::binary_search(ids.begin(), ids.end(), id);
+			const bool isTouching = bruteForceIsInRect(objects[id], projectionView, glm::min(a, b), glm::max(a, b));
+			if (objects[id].isBoxOnly ? (isTouching && !isPicked) : (isTouching != isPicked))
+				numMismatched++;
+		}
+	}
+	CHECK(numPicked > 300);
+	CHECK(numMismatched == 0);
+}
+
+TEST(scene_picker_empty_and_unbuilt)
+{
+	ScenePicker picker;
+	size_t id;
+	float distance;
+	std::vector<size_t> ids;
+	const std::vector<TestObject> noObjects;
+	CHECK(!picker.pickRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), makeMeshFunc(noObjects), id, distance));
+	CHECK(id == ScenePicker::NO_ID);
+
+	picker.beginBuild();
+	picker.build();
+	CHECK(!picker.pickRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), makeMeshFunc(noObjects), id, distance));
+	picker.pickRect(glm::mat4(1.0f), glm::vec2(-1.0f), glm::vec2(1.0f), makeMeshFunc(noObjects), ids);
+	CHECK(ids.empty());
+}
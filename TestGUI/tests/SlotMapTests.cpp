@@ -0,0 +1,179 @@
+#include "TestCommon.h"
+#include "../src/utils/SlotMap.h"
+
+#include <random>
+#include <string>
+
+
+namespace
+{
+	struct Reference
+	{
+		SlotMapHandle handle;
+		int value;
+	};
+
+	// Every live handle has to find its value, and its dense index has to map back to it
+	bool matchesReference(SlotMap<int>& slotMap, const std::vector<Reference>& live, const std::vector<SlotMapHandle>& dead)
+	{
+		if (slotMap.size() != live.size())
+			return false;
+		for (const Reference& reference : live)
+		{
+			const int* value = slotMap.get(reference.handle);
+			if (value == nullptr || *value != reference.value)
+				return false;
+			const size_t denseIndex = slotMap.getDenseIndex(reference.handle);
+			if (denseIndex >= slotMap.size() || slotMap[denseIndex] != reference.value || slotMap.getHandle(denseIndex) != reference.handle)
+				return false;
+		}
+		for (const SlotMapHandle& handle : dead)
+			if (slotMap.contains(handle) || slotMap.get(handle) != nullptr || slotMap.getDenseIndex(handle) != SlotMap<int>::NO_DENSE_INDEX)
+				return false;
+		return true;
+	}
+}
+
+
+TEST(slot_map_default_handle_never_matches)
+{
+	SlotMap<int> slotMap;
+	CHECK(!slotMap.contains(SlotMapHandle()));
+	slotMap.add(1);
+	CHECK(!slotMap.contains(SlotMapHandle()));
+
+	// Generations start at 1, so a zeroed out handle doesn't hit slot 0 either
+	CHECK(!slotMap.contains({ 0, 0 }));
+	CHECK(slotMap.get({ 0, 0 }) == nullptr);
+	CHECK(slotMap.getDenseIndex(SlotMapHandle()) == SlotMap<int>::NO_DENSE_INDEX);
+}
+
+TEST(slot_map_remove_keeps_the_other_handles)
+{
+	SlotMap<std::string> slotMap;
+	const SlotMapHandle a = slotMap.add("a");
+	const SlotMapHandle b = slotMap.add("b");
+	const SlotMapHandle c = slotMap.add("c");
+	CHECK(a.generation == 1 && b.generation == 1 && c.generation == 1);
+
+	// Removing the first one moves the last one into its spot
+	CHECK(slotMap.remove(a));
+	CHECK(!slotMap.remove(a));
+	CHECK(slotMap.size() == 2);
+	CHECK(slotMap.get(a) == nullptr);
+	CHECK(*slotMap.get(b) == "b");
+	CHECK(*slotMap.get(c) == "c");
+	CHECK(slotMap.getDenseIndex(c) == 0);
+	CHECK(slotMap[0] == "c");
+	CHECK(slotMap.getHandle(0) == c);
+
+	// Removing the last one doesn't move anything
+	CHECK(slotMap.remove(b));
+	CHECK(slotMap.size() == 1);
+	CHECK(*slotMap.get(c) == "c");
+	CHECK(slotMap.getDenseIndex(c) == 0);
+}
+
+TEST(slot_map_reused_slots_get_a_new_generation)
+{
+	SlotMap<int> slotMap;
+	const SlotMapHandle first = slotMap.add(10);
+	slotMap.add(11);
+	CHECK(slotMap.remove(first));
+
+	// Goes back into the freed slot, but the old handle still doesn't match it
+	const SlotMapHandle reused = slotMap.add(12);
+	CHECK(reused.index == first.index);
+	CHECK(reused.generation == first.generation + 1);
+	CHECK(reused != first);
+	CHECK(!slotMap.contains(first));
+	CHECK(slotMap.get(first) == nullptr);
+	CHECK(*slotMap.get(reused) == 12);
+	CHECK(!slotMap.remove(first));
+	CHECK(slotMap.size() == 2);
+
+	// Free list is last in first out
+	const SlotMapHandle x = slotMap.add(13);
+	const SlotMapHandle y = slotMap.add(14);
+	CHECK(slotMap.remove(x));
+	CHECK(slotMap.remove(y));
+	CHECK(slotMap.add(15).index == y.index);
+	CHECK(slotMap.add(16).index == x.index);
+	CHECK(slotMap.add(17).index == 4);		// Free list's empty, so it's a brand new slot
+}
+
+TEST(slot_map_clear_makes_every_handle_stale)
+{
+	SlotMap<int> slotMap;
+	std::vector<SlotMapHandle> handles;
+	for (int i = 0; i < 8; i++)
+		handles.push_back(slotMap.add(i));
+	slotMap.remove(handles[3]);
+
+	slotMap.clear();
+	CHECK(slotMap.empty());
+	for (const SlotMapHandle& handle : handles)
+		CHECK(!slotMap.contains(handle));
+
+	// All of the old slots get used again before any new ones
+	for (int i = 0; i < 8; i++)
+	{
+		const SlotMapHandle handle = slotMap.add(100 + i);
+		CHECK(handle.index < 8);
+		CHECK(handle.generation >= 2);
+		CHECK(handle != handles[handle.index]);
+	}
+	CHECK(slotMap.add(200).index == 8);
+	for (const SlotMapHandle& handle : handles)
+		CHECK(!slotMap.contains(handle));
+}
+
+TEST(slot_map_random_ops_match_a_reference)
+{
+	std::mt19937 random(50);
+	SlotMap<int> slotMap;
+	std::vector<Reference> live;
+	std::vector<SlotMapHandle> dead;
+	int nextValue = 0;
+	size_t numMismatched = 0;
+	for (int i = 0; i < 20000; i++)
+	{
+		const uint32_t roll = random() % 100;
+		if (roll < 55 || live.empty())
+		{
+			const int value = nextValue++;
+			live.push_back({ slotMap.add(value), value });
+		}
+		else if (roll < 99)
+		{
+			const size_t which = random() % live.size();
+			if (!slotMap.remove(live[which].handle))
+				numMismatched++;
+			dead.push_back(live[which].handle);
+			live[which] = live.back();
+			live.pop_back();
+		}
+		else
+		{
+			slotMap.clear();
+			for (const Reference& reference : live)
+				dead.push_back(reference.handle);
+			live.clear();
+		}
+
+		// Stale handles can't match anything, even after their slots got reused a bunch of times
+		if (i % 97 == 0 && !matchesReference(slotMap, live, dead))
+			numMismatched++;
+	}
+	CHECK(matchesReference(slotMap, live, dead));
+	CHECK(numMismatched == 0);
+	CHECK(dead.size() > 5000);
+
+	// Dense iteration goes over exactly the live values
+	long long sum = 0, referenceSum = 0;
+	for (int value : slotMap)
+		sum += value;
+	for (const Reference& reference : live)
+		referenceSum += reference.value;
+	CHECK(sum == referenceSum);
+}
@@ -0,0 +1,197 @@
+#include "TestCommon.h"
+#include "../src/render_engine/terrain/TerrainQuadtree.h"
+
+#include <algorithm>
+
+
+namespace
+{
+	// resolution x resolution samples over [0, resolution - 1] on x and z (1 unit per quad)
+	Heightfield makeFlatHeightfield(uint32_t resolution)
+	{
+		Heightfield heightfield;
+		heightfield.resolutionX = heightfield.resolutionZ = resolution;
+		heightfield.boundsMin = glm::vec3(0.0f);
+		heightfield.boundsMax = glm::vec3((float)(resolution - 1), 1.0f, (float)(resolution - 1));
+		heightfield.heights.resize((size_t)resolution * resolution, 0.0f);
+		heightfield.holes.resize(heightfield.heights.size(), 0);
+		return heightfield;
+	}
+
+	// How many times each heightfield quad got drawn by the selection (a quadrant only draws that quarter of the node)
+	std::vector<int> getQuadCoverage(const std::vector<TerrainChunkSelection>& selection, uint32_t numQuads)
+	{
+		std::vector<int> coverage((size_t)numQuads * numQuads, 0);
+		for (const TerrainChunkSelection& chunk : selection)
+		{
+			uint32_t originX = chunk.originX, originZ = chunk.originZ, size = chunk.size;
+			if (chunk.quadrant >= 0)
+			{
+				size /= 2;
+				originX += (chunk.quadrant % 2) * size;
+				originZ += (chunk.quadrant / 2) * size;
+			}
+
+			for (uint32_t z = originZ; z < std::min(originZ + size, numQuads); z++)
+				for (uint32_t x = originX; x < std::min(originX + size, numQuads); x++)
+					coverage[(size_t)z * numQuads + x]++;
+		}
+		return coverage;
+	}
+
+	TerrainQuadtreeSettings getSettings()
+	{
+		TerrainQuadtreeSettings settings;
+		settings.leafChunkQuads = 16;
+		return settings;
+	}
+}
+
+
+TEST(terrain_quadtree_far_camera_gets_just_the_root)
+{
+	const Heightfield heightfield = makeFlatHeightfield(257);
+	TerrainQuadtree quadtree;
+	quadtree.build(heightfield, getSettings());
+	CHECK(quadtree.getNumLODs() == 5);		// 16 * 2^4 = 256 quads
+
+	std::vector<TerrainChunkSelection> selection;
+	quadtree.select(glm::vec3(1e6f, 0.0f, 1e6f), glm::mat4(1.0f), {}, 1.0f, selection);
+	CHECK(selection.size() == 1);
+	if (selection.size() == 1)
+		CHECK(selection[0].lodLevel == 4 && selection[0].quadrant == -1 && selection[0].size == 256);
+}
+
+TEST(terrain_quadtree_selection_covers_everything_exactly_once)
+{
+	const Heightfield heightfield = makeFlatHeightfield(257);
+	TerrainQuadtree quadtree;
+	quadtree.build(heightfield, getSettings());
+
+	for (const glm::vec3& cameraPosition : { glm::vec3(0, 5, 0), glm::vec3(128, 5, 128), glm::vec3(250, 50, 10), glm::vec3(-100, 5, 128) })
+	{
+		std::vector<TerrainChunkSelection> selection;
+		quadtree.select(cameraPosition, glm::mat4(1.0f), {}, 1.0f, selection);
+
+		const std::vector<int> coverage = getQuadCoverage(selection, 256);
+		CHECK(std::all_of(coverage.begin(), coverage.end(), [](int count) { return count == 1; }));
+	}
+}
+
+TEST(terrain_quadtree_lods_get_coarser_w_distance)
+{
+	const Heightfield heightfield = makeFlatHeightfield(257);
+	TerrainQuadtree quadtree;
+	quadtree.build(heightfield, getSettings());
+
+	const glm::vec3 cameraPosition(0, 1, 0);
+	std::vector<TerrainChunkSelection> selection;
+	quadtree.select(cameraPosition, glm::mat4(1.0f), {}, 1.0f, selection);
+
+	bool hasLeafUnderCamera = false;
+	for (const TerrainChunkSelection& chunk : selection)
+	{
+		if (chunk.originX == 0 && chunk.originZ == 0 && chunk.lodLevel == 0)
+			hasLeafUnderCamera = true;
+
+		// A chunk can only be finer than the coarsest LOD if the camera is inside of its LOD's range
+		const glm::vec3 chunkMin((float)chunk.originX, 0.0f, (float)chunk.originZ);
+		const glm::vec3 chunkMax((float)(chunk.originX + chunk.size), 0.0f, (float)(chunk.originZ + chunk.size));
+		const float distance = glm::length(glm::clamp(cameraPosition, chunkMin, chunkMax) - cameraPosition);
+		CHECK(distance <= quadtree.getMorphRange(chunk.lodLevel, glm::mat4(1.0f), 1.0f).y);
+	}
+	CHECK(hasLeafUnderCamera);
+}
+
+TEST(terrain_quadtree_lod_distance_multiplier_makes_it_coarser)
+{
+	const Heightfield heightfield = makeFlatHeightfield(257);
+	TerrainQuadtree quadtree;
+	quadtree.build(heightfield, getSettings());
+
+	std::vector<TerrainChunkSelection> fullSelection, shadowSelection;
+	quadtree.select(glm::vec3(128, 5, 128), glm::mat4(1.0f), {}, 1.0f, fullSelection);
+	quadtree.select(glm::vec3(128, 5, 128), glm::mat4(1.0f), {}, 0.25f, shadowSelection);
+	auto countLeafChunks = [](const std::vector<TerrainChunkSelection>& selection) {
+		return std::count_if(selection.begin(), selection.end(), [](const TerrainChunkSelection& chunk) { return chunk.lodLevel == 0; });
+	};
+	CHECK(countLeafChunks(shadowSelection) < countLeafChunks(fullSelection));
+}
+
+TEST(terrain_quadtree_culled_chunks_dont_get_selected)
+{
+	const Heightfield heightfield = makeFlatHeightfield(257);
+	TerrainQuadtree quadtree;
+	quadtree.build(heightfield, getSettings());
+
+	// Everything at x >= 128 is "offscreen"
+	auto isVisible = [](const glm::vec3& worldMin, const glm::vec3&) { return worldMin.x < 128.0f; };
+	std::vector<TerrainChunkSelection> selection;
+	quadtree.select(glm::vec3(64, 5, 64), glm::mat4(1.0f), isVisible, 1.0f, selection);
+
+	CHECK(!selection.empty());
+	const std::vector<int> coverage = getQuadCoverage(selection, 256);
+	for (uint32_t z = 0; z < 256; z++)
+		for (uint32_t x = 0; x < 256; x++)
+			CHECK(coverage[(size_t)z * 256 + x] == ((x < 128) ? 1 : 0));
+}
+
+TEST(terrain_quadtree_scaled_model_scales_the_ranges)
+{
+	const Heightfield heightfield = makeFlatHeightfield(257);
+	TerrainQuadtree quadtree;
+	quadtree.build(heightfield, getSettings());
+
+	const glm::mat4 scale2 = glm::mat4(glm::mat3(2.0f));
+	const glm::vec2 morphRange = quadtree.getMorphRange(1, glm::mat4(1.0f), 1.0f);
+	const glm::vec2 scaledMorphRange = quadtree.getMorphRange(1, scale2, 1.0f);
+	CHECK_NEAR(scaledMorphRange.x, morphRange.x * 2.0f, 1e-3f);
+	CHECK_NEAR(scaledMorphRange.y, morphRange.y * 2.0f, 1e-3f);
+
+	// Same camera spot relative to the terrain gets the same selection
+	std::vector<TerrainChunkSelection> selection, scaledSelection;
+	quadtree.select(glm::vec3(40, 5, 40), glm::mat4(1.0f), {}, 1.0f, selection);
+	quadtree.select(glm::vec3(80, 10, 80), scale2, {}, 1.0f, scaledSelection);
+	CHECK(selection.size() == scaledSelection.size());
+}
+
+TEST(heightfield_from_triangles_takes_the_top_surface)
+{
+	// 10x10 quad at y=1, and a smaller one at y=3 on top of part of it
+	const std::vector<glm::vec3> positions = {
+		{ 0, 1, 0 }, { 10, 1, 0 }, { 10, 1, 10 }, { 0, 1, 10 },
+		{ 2, 3, 2 }, { 4, 3, 2 }, { 4, 3, 4 }, { 2, 3, 4 },
+	};
+	const std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 };
+	const Heightfield heightfield = Heightfield::createFromTriangles(positions, indices, 11);
+
+	CHECK(heightfield.resolutionX == 11 && heightfield.resolutionZ == 11);
+	CHECK_NEAR(heightfield.getHeight(0, 0), 1.0f, 1e-4f);
+	CHECK_NEAR(heightfield.getHeight(3, 3), 3.0f, 1e-4f);
+	CHECK_NEAR(heightfield.sampleHeight(7.5f, 7.5f), 1.0f, 1e-4f);
+	CHECK(std::none_of(heightfield.holes.begin(), heightfield.holes.end(), [](uint8_t hole) { return hole != 0; }));
+	CHECK(heightfield.leftoverIndices.empty());		// NOTE: the big quad's corners are all on the top surface, so it still counts as in there
+}
+
+TEST(heightfield_from_triangles_keeps_whatever_it_cant_hold)
+{
+	const std::vector<glm::vec3> positions = {
+		{ 0, 5, 0 }, { 10, 5, 0 }, { 10, 5, 10 }, { 0, 5, 10 },		// Roof
+		{ 3, 0, 3 }, { 6, 0, 3 }, { 6, 0, 6 },						// Cave floor under the roof
+		{ 2, 5, 8 }, { 8, 5, 8 }, { 8, 9, 8 },						// Vertical wall sticking up out of the roof
+		{ 1, 5, 1 }, { 1, 5, 1 }, { 1, 5, 1 },						// Degenerate. Doesn't matter
+	};
+	const std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+	const Heightfield heightfield = Heightfield::createFromTriangles(positions, indices, 11);
+
+	CHECK_NEAR(heightfield.getHeight(4, 4), 5.0f, 1e-4f);
+	CHECK(heightfield.leftoverIndices.size() == 6);
+	CHECK(heightfield.leftoverPositions.size() == 6);
+	for (uint32_t index : heightfield.leftoverIndices)
+		CHECK(index < heightfield.leftoverPositions.size());
+	if (heightfield.leftoverIndices.size() == 6)
+	{
+		CHECK(heightfield.leftoverPositions[heightfield.leftoverIndices[0]] == positions[4]);
+		CHECK(heightfield.leftoverPositions[heightfield.leftoverIndices[5]] == positions[9]);
+	}
+}
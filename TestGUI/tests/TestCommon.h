@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstdio>
+#include <cmath>
+
+
+//
+// Tiny headless test harness. Only the GL-free parts of the engine get tested here,
+// so nothing needs a window or a context (run w/ `make test`).
+//
+// @NOTE: didn't want to pull in a whole test framework just for this. Each TEST() registers
+// itself before main() runs, and CHECK() just counts up failures and keeps going.
+//
+namespace TestCommon
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*function)();
+	};
+
+	inline std::vector<TestCase>& getTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	inline int& getNumFailedChecks()
+	{
+		static int numFailedChecks = 0;
+		return numFailedChecks;
+	}
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, void (*function)()) { getTestCases().push_back({ name, function }); }
+	};
+}
+
+
+#define TEST(name) \
+	static void test_##name(); \
+	static TestCommon::TestRegistrar testRegistrar_##name(#name, &test_##name); \
+	static void test_##name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) \
+		{ \
+			std::printf("    FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+			TestCommon::getNumFailedChecks()++; \
+		} \
+	} while (false)
+
+#define CHECK_NEAR(a, b, epsilon) CHECK(std::abs((a) - (b)) <= (epsilon))
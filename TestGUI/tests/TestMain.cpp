@@ -0,0 +1,20 @@
+#include "TestCommon.h"
+
+
+int main()
+{
+	int numFailedTests = 0;
+	for (auto& testCase : TestCommon::getTestCases())
+	{
+		const int numFailedChecksBefore = TestCommon::getNumFailedChecks();
+		testCase.function();
+
+		const bool passed = (TestCommon::getNumFailedChecks() == numFailedChecksBefore);
+		std::printf("[%s] %s\n", passed ? "PASS" : "FAIL", testCase.name);
+		if (!passed)
+			numFailedTests++;
+	}
+
+	std::printf("\n%d/%d tests passed\n", (int)TestCommon::getTestCases().size() - numFailedTests, (int)TestCommon::getTestCases().size());
+	return (numFailedTests == 0) ? 0 : 1;
+}
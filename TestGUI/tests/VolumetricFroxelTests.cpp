@@ -0,0 +1,278 @@
+#include "TestCommon.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+
+//
+// The froxel volumetrics only live in shaders, so these are ports of the math (keep them
+// in sync w/ it) checked against a port of the old per pixel raymarch they replaced.
+//
+// NOTE: the lit fields here are 0-1 per slice, and the same everywhere in a slice. That's what
+// the froxel grid converges to w/ the depth jitter + history blend, and it keeps the edges of
+// the shadows the same for both sides, so the only difference left is the raymarch's steps.
+//
+namespace
+{
+	constexpr int NUM_SLICES = 64;		// volumetricFroxelGridDepth
+	constexpr float FAR_PLANE = 100.0f;
+
+	// @Copypasta: from volumetric_postprocessing.frag
+	constexpr int NB_RAYMARCH_STEPS = 10;
+	constexpr float PI = 3.14159265359f;
+	constexpr float G_SCATTERING = 0.7f;
+	constexpr float ACCUMULATION_CEILING = 15.0f;
+
+	float computeScattering(float lightDotView)
+	{
+		float result = 1.0f - G_SCATTERING * G_SCATTERING;
+		result /= (4.0f * PI * std::pow(1.0f + G_SCATTERING * G_SCATTERING - (2.0f * G_SCATTERING) * lightDotView, 1.5f));
+		return result;
+	}
+
+	float getAccentuatedLightDotView(float lightDotView)
+	{
+		return std::max(0.0f, 1.0f - std::pow(1.0f - (lightDotView * 0.5f + 0.5f), 5.0f));
+	}
+
+	float remap(float accumulatedFog)
+	{
+		return 1.0f - std::pow(1.0f - std::clamp(accumulatedFog / ACCUMULATION_CEILING, 0.0f, 1.0f), 5.0f);
+	}
+
+	// @Copypasta: sliceToT() in volumetric_froxel_integrate.comp
+	float sliceToT(float slice, int numSlices)
+	{
+		const float w = slice / (float)numSlices;
+		return w * w;
+	}
+
+	int tToSlice(float t)
+	{
+		return std::clamp((int)(std::sqrt(t) * (float)NUM_SLICES), 0, NUM_SLICES - 1);
+	}
+
+	//
+	// Old raymarch. @Copypasta: main() in volumetric_postprocessing.frag, walking along the ray
+	// in world space, w/ the shadow lookup swapped out for the lit field. numSteps can go past
+	// NB_RAYMARCH_STEPS for a converged version (it gets scaled back down to 10 steps' worth)
+	//
+	float raymarch(const std::vector<float>& litPerSlice, float rayLength, float lightDotView, float ditherOffset, int numSteps = NB_RAYMARCH_STEPS)
+	{
+		const float rayStepIncrement = std::min(rayLength, FAR_PLANE) / (float)numSteps;
+		const float lightDotViewSubsurfaceAccuentuated = getAccentuatedLightDotView(lightDotView);
+
+		float distanceStepped = rayStepIncrement * ditherOffset;
+		float distanceSteppedTowardsLight = rayStepIncrement * ditherOffset * lightDotView;
+		float accumulatedFog = 0.0f;
+		for (int i = 0; i < numSteps; i++)
+		{
+			const float lit = litPerSlice[tToSlice(distanceStepped / FAR_PLANE)];
+			const float linearFalloff = 1.0f - ((float)i + ditherOffset) / (float)numSteps;
+			const float falloffTowardsLightDirection = 1.0f - distanceSteppedTowardsLight / rayLength;
+			accumulatedFog += lit * computeScattering(lightDotViewSubsurfaceAccuentuated) * falloffTowardsLightDirection * linearFalloff;
+
+			distanceStepped += rayStepIncrement;
+			distanceSteppedTowardsLight += rayStepIncrement * lightDotView;
+		}
+		return accumulatedFog * (float)NB_RAYMARCH_STEPS / (float)numSteps;
+	}
+
+	// What the screen ends up w/ after the 4x4 dither pattern gets blurred out
+	float raymarchDitherAveraged(const std::vector<float>& litPerSlice, float rayLength, float lightDotView)
+	{
+		constexpr float ditherPattern[16] = {
+			0.0f, 0.5f, 0.125f, 0.625f,
+			0.75f, 0.22f, 0.875f, 0.375f,
+			0.1875f, 0.6875f, 0.0625f, 0.5625f,
+			0.9375f, 0.4375f, 0.8125f, 0.3125f
+		};
+		float sum = 0.0f;
+		for (float dither : ditherPattern)
+			sum += remap(raymarch(litPerSlice, rayLength, lightDotView, dither + 0.1f));
+		return sum / 16.0f;
+	}
+
+	struct FroxelTexel
+	{
+		float moments[3];
+		float transmittance;
+	};
+
+	// @Copypasta: main() in volumetric_froxel_integrate.comp (one column)
+	std::vector<FroxelTexel> integrateColumn(const std::vector<float>& litPerSlice, float extinction)
+	{
+		std::vector<FroxelTexel> column(NUM_SLICES);
+		float moments[3] = {};
+		for (int slice = 0; slice < NUM_SLICES; slice++)
+		{
+			const float frontT = sliceToT((float)slice, NUM_SLICES);
+			const float backT = sliceToT((float)(slice + 1), NUM_SLICES);
+			const float centerT = sliceToT((float)slice + 0.5f, NUM_SLICES);
+
+			const float lit = litPerSlice[slice] * std::exp(-extinction * FAR_PLANE * centerT);
+			moments[0] += lit * (backT - frontT);
+			moments[1] += lit * (backT * backT - frontT * frontT) / 2.0f;
+			moments[2] += lit * (backT * backT * backT - frontT * frontT * frontT) / 3.0f;
+
+			column[slice] = { { moments[0], moments[1], moments[2] }, std::exp(-extinction * FAR_PLANE * backT) };
+		}
+		return column;
+	}
+
+	// @Copypasta: main() in volumetric_froxel_apply.frag (w/o the remap)
+	float applyFroxels(const std::vector<FroxelTexel>& column, float rayLength, float lightDotView)
+	{
+		const float lightDotViewSubsurfaceAccuentuated = getAccentuatedLightDotView(lightDotView);
+
+		const float L = std::max(rayLength / FAR_PLANE, 1e-6f);
+		const float Lc = std::min(L, 1.0f);
+		const int endSlice = std::clamp((int)(std::sqrt(Lc) * (float)NUM_SLICES), 0, NUM_SLICES - 1);
+		const float sliceFrontT = sliceToT((float)endSlice, NUM_SLICES);
+		const float sliceBackT = sliceToT((float)(endSlice + 1), NUM_SLICES);
+
+		const float* momentsBack = column[endSlice].moments;
+		const float zeroMoments[3] = {};
+		const float* momentsFront = (endSlice > 0) ? column[endSlice - 1].moments : zeroMoments;
+
+		const float litDensity = (momentsBack[0] - momentsFront[0]) / (sliceBackT - sliceFrontT);
+		const float endT = std::min(Lc, sliceBackT);
+		const float moments[3] = {
+			momentsFront[0] + litDensity * (endT - sliceFrontT),
+			momentsFront[1] + litDensity * (endT * endT - sliceFrontT * sliceFrontT) / 2.0f,
+			momentsFront[2] + litDensity * (endT * endT * endT - sliceFrontT * sliceFrontT * sliceFrontT) / 3.0f,
+		};
+
+		const float weightedLit = moments[0] - moments[1] * (1.0f / Lc + lightDotView / L) + moments[2] * lightDotView / (Lc * L);
+		return computeScattering(lightDotViewSubsurfaceAccuentuated) * std::max(weightedLit, 0.0f) * (float)NB_RAYMARCH_STEPS / Lc;
+	}
+
+	//
+	// Lit fields
+	//
+	std::vector<float> makeLitField(const std::function<float(int)>& litAtSlice)
+	{
+		std::vector<float> litPerSlice(NUM_SLICES);
+		for (int slice = 0; slice < NUM_SLICES; slice++)
+			litPerSlice[slice] = litAtSlice(slice);
+		return litPerSlice;
+	}
+
+	std::vector<std::vector<float>> makeTestLitFields(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<std::vector<float>> litFields;
+		litFields.push_back(makeLitField([](int) { return 1.0f; }));
+		litFields.push_back(makeLitField([](int slice) { return (slice < 30) ? 1.0f : 0.0f; }));					// Shadowed past ~22m
+		litFields.push_back(makeLitField([](int slice) { return (slice >= 20 && slice < 35) ? 0.0f : 1.0f; }));	// A band of shadow
+		litFields.push_back(makeLitField([](int slice) { return (slice >= 45) ? 1.0f : 0.0f; }));					// Only lit far away
+		for (int i = 0; i < 4; i++)
+			litFields.push_back(makeLitField([&](int) { return unit(random); }));										// Partly lit all over (like the history blend does)
+		return litFields;
+	}
+
+	std::vector<float> makeTestRayLengths()
+	{
+		std::vector<float> rayLengths;
+		for (float rayLength = 0.5f; rayLength < FAR_PLANE * 1.5f; rayLength *= 1.17f)
+			rayLengths.push_back(rayLength);
+		rayLengths.push_back(FAR_PLANE);
+		return rayLengths;
+	}
+
+	constexpr float testLightDotViews[] = { -1.0f, -0.6f, 0.0f, 0.35f, 0.8f, 1.0f };
+}
+
+
+TEST(volumetric_froxels_match_a_converged_raymarch)
+{
+	// W/ enough steps the raymarch is the integral that the moments are storing, so this should be really close
+	// (the raymarch still has the step edges of the lit field landing in between its steps)
+	std::mt19937 random(47);
+	size_t numChecked = 0;
+	float worstError = 0.0f;
+	for (const std::vector<float>& litPerSlice : makeTestLitFields(random))
+	{
+		const std::vector<FroxelTexel> column = integrateColumn(litPerSlice, 0.0f);
+		for (float rayLength : makeTestRayLengths())
+		for (float lightDotView : testLightDotViews)
+		{
+			const float froxelFog = applyFroxels(column, rayLength, lightDotView);
+			const float raymarchedFog = raymarch(litPerSlice, rayLength, lightDotView, 0.5f, 20000);
+			worstError = std::max(worstError, std::abs(froxelFog - raymarchedFog) / ACCUMULATION_CEILING);
+			numChecked++;
+		}
+	}
+	CHECK(numChecked > 100);
+	CHECK(worstError < 0.0005f);
+}
+
+TEST(volumetric_froxels_match_the_old_raymarch_on_screen)
+{
+	// The old 10 step raymarch is a pretty rough sum of the same thing, so this is after the remap, averaged
+	// over the dither pattern (like it was on screen), and w/ a looser tolerance
+	std::mt19937 random(470);
+	float worstError = 0.0f;
+	double totalError = 0.0;
+	size_t numChecked = 0;
+	for (const std::vector<float>& litPerSlice : makeTestLitFields(random))
+	{
+		const std::vector<FroxelTexel> column = integrateColumn(litPerSlice, 0.0f);
+		for (float rayLength : makeTestRayLengths())
+		for (float lightDotView : testLightDotViews)
+		{
+			const float error = std::abs(remap(applyFroxels(column, rayLength, lightDotView)) - raymarchDitherAveraged(litPerSlice, rayLength, lightDotView));
+			worstError = std::max(worstError, error);
+			totalError += error;
+			numChecked++;
+		}
+	}
+	CHECK(worstError < 0.1f);
+	CHECK(totalError / numChecked < 0.02);
+}
+
+TEST(volumetric_froxels_all_lit_is_the_same_past_the_far_plane)
+{
+	// Past the shadow far plane the raymarch stops at the far plane, but the falloff towards the light keeps using
+	// the whole ray length. The froxels have to follow that
+	const std::vector<float> litPerSlice(NUM_SLICES, 1.0f);
+	const std::vector<FroxelTexel> column = integrateColumn(litPerSlice, 0.0f);
+	for (float lightDotView : testLightDotViews)
+	{
+		CHECK_NEAR(applyFroxels(column, FAR_PLANE, lightDotView), raymarch(litPerSlice, FAR_PLANE, lightDotView, 0.5f, 20000), 0.01f);
+		const float farther = applyFroxels(column, FAR_PLANE * 3.0f, lightDotView);
+		CHECK_NEAR(farther, raymarch(litPerSlice, FAR_PLANE * 3.0f, lightDotView, 0.5f, 20000), 0.01f);
+		if (lightDotView > 0.0f)
+			CHECK(farther > applyFroxels(column, FAR_PLANE, lightDotView));		// Less light falloff over the same lit distance
+	}
+
+	// Nothing lit, nothing there
+	const std::vector<FroxelTexel> unlitColumn = integrateColumn(std::vector<float>(NUM_SLICES, 0.0f), 0.0f);
+	CHECK(applyFroxels(unlitColumn, 30.0f, 0.5f) == 0.0f);
+	CHECK(applyFroxels(unlitColumn, 0.0f, 0.5f) == 0.0f);
+}
+
+TEST(volumetric_froxels_transmittance)
+{
+	const std::vector<float> litPerSlice(NUM_SLICES, 1.0f);
+
+	// No extinction is no transmittance (the default, same as the old raymarch)
+	for (const FroxelTexel& texel : integrateColumn(litPerSlice, 0.0f))
+		CHECK(texel.transmittance == 1.0f);
+
+	// W/ some, it goes down thru the slices and takes the lit amount down w/ it
+	const std::vector<FroxelTexel> clear = integrateColumn(litPerSlice, 0.0f);
+	const std::vector<FroxelTexel> foggy = integrateColumn(litPerSlice, 0.02f);
+	for (int slice = 0; slice < NUM_SLICES; slice++)
+	{
+		CHECK_NEAR(foggy[slice].transmittance, std::exp(-0.02f * FAR_PLANE * sliceToT((float)(slice + 1), NUM_SLICES)), 1e-6f);
+		if (slice > 0)
+		{
+			CHECK(foggy[slice].transmittance < foggy[slice - 1].transmittance);
+			CHECK(foggy[slice].moments[0] > foggy[slice - 1].moments[0]);
+		}
+		CHECK(foggy[slice].moments[0] <= clear[slice].moments[0]);
+	}
+	CHECK(applyFroxels(foggy, 80.0f, 0.3f) < applyFroxels(clear, 80.0f, 0.3f));
+}